@@ -6,9 +6,15 @@
 #include "scum_radio_bsp.h"
 #include "bucket_o_functions.h"
 #include "sensor_adc/adc_test.h"
+#include "crc32.h"
+#include "optical_loader.h"
+#include "rx_ring.h"
+#include "tx_queue.h"
+#include "log_ring.h"
+#include "uart_tx.h"
+#include "uart_cmd.h"
 
 extern char send_packet[127];
-extern char recv_packet[130];
 
 unsigned int chips[100];
 unsigned int chip_index = 0;
@@ -65,6 +71,8 @@ extern unsigned int expected_RX_arrival;
 extern unsigned int ack_turnaround_time;
 extern unsigned int guard_time;
 extern unsigned short current_RF_channel;
+extern unsigned char radio_tx_source;
+extern unsigned char radio_tx_burst;
 
 extern unsigned short do_debug_print;
 
@@ -73,176 +81,297 @@ extern unsigned short ADC_DATA_VALID;
 extern unsigned short ADC_CONTINUOUS;
 extern unsigned short ADC_STOP;
 
+// Image validation (main.c)
+unsigned int image_block_report(void);
+
+// Optical patch receiver (below)
+void optical_patch_arm(void);
+
 // Sensor ADC: Loopback-specific
 unsigned int cycles_reset = 1000;
 unsigned int cycles_to_start = 1000;
 unsigned int cycles_pga = 1000;
 
-void UART_ISR() {	
-	static char i=0;
-	static char buff[4] = {0x0, 0x0, 0x0, 0x0};
-	static char waiting_for_end_of_copy = 0;
-	char inChar;
+// UART commands, run from the main loop by uart_cmd_poll() (uart_cmd.c)
+
+// Change me: used for small demo code
+void cmd_zzz(const uart_cmd_args* args) {
+	printf("Change me!\n");
+}
+
+// Copies the rest of the line to send_packet and points the radio at it
+void cmd_cpy(const uart_cmd_args* args) {
+	unsigned int j;
+	
+	if(args->text_len > 127) {
+		printf("Input exceeds maximum packet size\n");
+		return;
+	}
+	for(j=0; j<args->text_len; j++)
+		send_packet[j] = args->text[j];
+	printf("copying string of size %u to send_packet: ", args->text_len);
+	for(j=0; j<args->text_len; j++) {
+		printf("%c",send_packet[j]);
+	}
+	printf("\n");
+	RFCONTROLLER_REG__TX_DATA_ADDR = &send_packet[0];
+	RFCONTROLLER_REG__TX_PACK_LEN = args->text_len;
+	radio_tx_source = RADIO_TX_PACKET;
+	// The ack RF_ISR sends is the start of send_packet[], as before the template had its own buffer
+	tx_ack_set(send_packet, TX_ACK_BYTES);
+}
+
+// Sends TX_LOAD signal to radio controller
+void cmd_lod(const uart_cmd_args* args) {
+	RFCONTROLLER_REG__CONTROL = 0x1;
+	printf("TX LOAD\n");
+}
+
+// Sends TX_SEND signal to radio controller
+void cmd_snd(const uart_cmd_args* args) {
+	RFCONTROLLER_REG__CONTROL = 0x2;
+	printf("TX SEND\n");
+}
+
+// Sends RX_START signal to radio controller
+void cmd_rcv(const uart_cmd_args* args) {
+	printf("Recieving\n");
+	DMA_REG__RF_RX_ADDR = rx_ring_dma_addr();
+	RFCONTROLLER_REG__CONTROL = 0x4;
+}
+
+// Sends RX_STOP signal to radio controller
+void cmd_end(const uart_cmd_args* args) {
+	RFCONTROLLER_REG__CONTROL = 0x8;
+	printf("RX STOP\n");
+}
+
+// Sends RF_RESET signal to radio controller
+void cmd_rst(const uart_cmd_args* args) {
+	RFCONTROLLER_REG__CONTROL = 0x10;
+	printf("RF RESET\n");
+}
+
+// Returns the status register of the radio controller, and the bytes the UART RX ring had no room for
+void cmd_sta(const uart_cmd_args* args) {
+	int status = RFCONTROLLER_REG__STATUS;
+	printf("status register is 0x%x\n", status);
+	printf("power=%d, reset=%d, %d\n",ANALOG_CFG_REG__10,ANALOG_CFG_REG__4,doing_initial_packet_search);
+	printf("uart rx drops=%u\n", uart_rx_drops);
+}
+
+void soft_reset(void) {
 	int t;
 	
-	inChar = UART_REG__RX_DATA;
-  	buff[3] = buff[2];
-	buff[2] = buff[1];
-	buff[1] = buff[0];
-	buff[0] = inChar;
-	
-	// If we are still waiting for the end of a load command
-	if (waiting_for_end_of_copy) {
-		if (inChar=='\n'){
-			int j=0;
-			printf("copying string of size %u to send_packet: ", i);
-			for (j=0; j < i; j++) {
-				printf("%c",send_packet[j]);
-			}
-			printf("\n");
-			RFCONTROLLER_REG__TX_PACK_LEN = i;
-			i = 0;
-			waiting_for_end_of_copy = 0;
-		} else if (i < 127) {		
-			send_packet[i] = inChar;			
-			i++;
-		} else {
-			printf("Input exceeds maximum packet size\n");
-		}
-	} else { //If waiting for a command
-		// zzz: Used for small demo code
-		if ( (buff[3]=='z') && (buff[2]=='z') && (buff[1]=='z') && (buff[0]=='\n') ) {
-			printf("Change me!\n");
-		// Copies string from UART to send_packet
-		} else if ( (buff[3]=='c') && (buff[2]=='p') && (buff[1]=='y') && (buff[0]==' ') ) {
-			waiting_for_end_of_copy = 1;
-		// Sends TX_LOAD signal to radio controller
-		} else if ( (buff[3]=='l') && (buff[2]=='o') && (buff[1]=='d') && (buff[0]=='\n') ) {
-		  RFCONTROLLER_REG__CONTROL = 0x1;
-			printf("TX LOAD\n");
-		// Sends TX_SEND signal to radio controller
-	  	} else if ( (buff[3]=='s') && (buff[2]=='n') && (buff[1]=='d') && (buff[0]=='\n') ) {
-		  RFCONTROLLER_REG__CONTROL = 0x2;
-		  printf("TX SEND\n");
-		// Sends RX_START signal to radio controller
-		} else if ( (buff[3]=='r') && (buff[2]=='c') && (buff[1]=='v') && (buff[0]=='\n') ) {
-			printf("Recieving\n");
-	    DMA_REG__RF_RX_ADDR = &recv_packet[0];
-		  RFCONTROLLER_REG__CONTROL = 0x4;
-		// Sends RX_STOP signal to radio controller
-	  	} else if ( (buff[3]=='e') && (buff[2]=='n') && (buff[1]=='d') && (buff[0]=='\n') ) {
-			RFCONTROLLER_REG__CONTROL = 0x8;
-			printf("RX STOP\n");
-		// Sends RF_RESET signal to radio controller
-		} else if ( (buff[3]=='r') && (buff[2]=='s') && (buff[1]=='t') && (buff[0]=='\n') ) {
-		  RFCONTROLLER_REG__CONTROL = 0x10;
-			printf("RF RESET\n");	
-		// Returns the status register of the radio controller
-		} else if ( (buff[3]=='s') && (buff[2]=='t') && (buff[1]=='a') && (buff[0]=='\n') ) {
-		  int status = RFCONTROLLER_REG__STATUS;
-			printf("status register is 0x%x\n", status);	
-		
-			printf("power=%d, reset=%d, %d\n",ANALOG_CFG_REG__10,ANALOG_CFG_REG__4,doing_initial_packet_search);
-		// Trigger a soft reset
-	  	} else if ( (buff[3]=='s') && (buff[2]=='f') && (buff[1]=='t') && (buff[0]=='\n') ) {
-	  		*(unsigned int*)(0xE000ED0C) = 0x05FA0004;
-		// Initiate a single on-chip FSM-driven ADC conversion
-	  	} else if ( (buff[3]=='a') && (buff[2]=='d') && (buff[1]=='1') && (buff[0]=='\n') ) {
-		 	printf("Starting on-chip FSM ADC conversion\n");
-		 	ADC_DATA_VALID = 0;
-		 	onchip_control_adc_shot();
-		// Initiate a single ADC conversion with loopback control of the ADC
-		} else if ( (buff[3]=='a') && (buff[2]=='d') && (buff[1]=='2') && (buff[0]=='\n') ) {
-		 	printf("Starting loopback-controlled ADC conversion\n");
-		 	ADC_DATA_VALID = 0;
-		 	loopback_control_adc_shot(cycles_reset, cycles_to_start, cycles_pga);
-		// Initiate a single ADC conversion with external GPIO control of the ADC
-		} else if ( (buff[3]=='a') && (buff[2]=='d') && (buff[1]=='3') && (buff[0]=='\n') ) {
-			printf("Starting externally-driven GPIO ADC conversion");
-			ADC_DATA_VALID = 0;
-			// TODO
-		// Initiate continuous on-chip FSM-driven ADC conversions
-		} else if ( (buff[3]=='a') && (buff[2]=='d') && (buff[1]=='4') && (buff[0]=='\n') ) {
-			printf("Starting continuous on-chip FSM ADC conversions\n");
-			ADC_DATA_VALID = 0;
-			onchip_control_adc_continuous();
-		// Initiate continuous loopback-controlled ADC conversions 
-		} else if ( (buff[3]=='a') && (buff[2]=='d') && (buff[1]=='5') && (buff[0]=='\n') ) {
-			printf("Starting continuous loopback-controlled ADC conversions\n");
-			ADC_DATA_VALID = 0;
-			loopback_control_adc_continuous(cycles_reset, cycles_to_start, cycles_pga);
-		// Initiate continuous external GPIO-controlled ADC conversions
-		} else if ( (buff[3]=='a') && (buff[2]=='d') && (buff[1]=='6') && (buff[0]=='\n') ) {
-			printf("Starting continuous externally-criven GPIO ADC conversions\n");
-			ADC_DATA_VALID = 0;
-			// TODO
-		// Halt a continuous ADC run, otherwise does nothing
-		} else if ( (buff[3]=='a') && (buff[2]=='d') && (buff[1]=='0') && (buff[0]=='\n') ) {
-			printf("Halting continuous ADC run\n");
-			halt_adc_continuous();
-		// Uses the radio timer to send TX_LOAD in 0.5s, TX_SEND in 1s, capture when SFD is sent and capture when packet is sent
-		} else if ( (buff[3]=='a') && (buff[2]=='t') && (buff[1]=='x') && (buff[0]=='\n') ) {
-			unsigned int t = RFTIMER_REG__COUNTER + 0x3D090;
-			RFTIMER_REG__COMPARE0 = t;
-		  RFTIMER_REG__COMPARE1 = t + 0x3D090;
-		  printf("%x\n", RFTIMER_REG__COMPARE0);
-		  printf("%x\n", RFTIMER_REG__COMPARE1);
-		  RFTIMER_REG__COMPARE0_CONTROL = 0x5;
-		  RFTIMER_REG__COMPARE1_CONTROL = 0x9;
-		  RFTIMER_REG__CAPTURE0_CONTROL = 0x9;
-		  RFTIMER_REG__CAPTURE1_CONTROL = 0x11;
-		  printf("Auto TX\n");
-		// Uses the radio timer to send RX_START in 0.5s, capture when SFD is received and capture when packet is received
-		} else if ( (buff[3]=='a') && (buff[2]=='r') && (buff[1]=='x') && (buff[0]=='\n') ) {
-			RFTIMER_REG__COMPARE0 = RFTIMER_REG__COUNTER + 0x3D090;
-		  RFTIMER_REG__COMPARE0_CONTROL = 0x11;
-		  RFTIMER_REG__CAPTURE0_CONTROL = 0x21;
-		  RFTIMER_REG__CAPTURE1_CONTROL = 0x41;
-			DMA_REG__RF_RX_ADDR = &recv_packet[0];
-			printf("Auto RX\n");
-		// Reset the radio timer compare and capture units
-		} else if ( (buff[3]=='r') && (buff[2]=='r') && (buff[1]=='t') && (buff[0]=='\n') ) {
-			RFTIMER_REG__COMPARE0_CONTROL = 0x0;
-			RFTIMER_REG__COMPARE1_CONTROL = 0x0;
-			RFTIMER_REG__CAPTURE0_CONTROL = 0x0;
-			RFTIMER_REG__CAPTURE1_CONTROL = 0x0;
-		  printf("Radio timer reset\n");				
-			
-		// Attempt to recover if stuck in unprogrammable mode
-		} else if ( (buff[3]=='x') && (buff[2]=='x') && (buff[1]=='1') && (buff[0]=='\n') ) {
-		
-			//for(t=0;t<=38;t++){
-			//	ASC_FPGA[t] = 0;	
-			//}
+	// Let queued output out first
+	uart_tx_flush();
+	for(t=0; t<10000; t++);
+	*(unsigned int*)(0xE000ED0C) = 0x05FA0004;
+}
+
+// Trigger a soft reset
+// The text line is caught by UART_ISR before it gets here, the binary frame runs from the main loop
+void cmd_sft(const uart_cmd_args* args) {
+	soft_reset();
+}
+
+// Initiate a single on-chip FSM-driven ADC conversion
+void cmd_ad1(const uart_cmd_args* args) {
+	printf("Starting on-chip FSM ADC conversion\n");
+	ADC_DATA_VALID = 0;
+	onchip_control_adc_shot();
+}
+
+// Optional [cycles_reset cycles_to_start cycles_pga] for the loopback-controlled conversions, kept for later runs
+void set_loopback_cycles(const uart_cmd_args* args) {
+	cycles_reset = uart_cmd_arg(args, 0, cycles_reset);
+	cycles_to_start = uart_cmd_arg(args, 1, cycles_to_start);
+	cycles_pga = uart_cmd_arg(args, 2, cycles_pga);
+}
+
+// Initiate a single ADC conversion with loopback control of the ADC
+void cmd_ad2(const uart_cmd_args* args) {
+	set_loopback_cycles(args);
+	printf("Starting loopback-controlled ADC conversion\n");
+	ADC_DATA_VALID = 0;
+	loopback_control_adc_shot(cycles_reset, cycles_to_start, cycles_pga);
+}
+
+// Initiate a single ADC conversion with external GPIO control of the ADC
+void cmd_ad3(const uart_cmd_args* args) {
+	printf("Starting externally-driven GPIO ADC conversion");
+	ADC_DATA_VALID = 0;
+	// TODO
+}
+
+// Initiate continuous on-chip FSM-driven ADC conversions
+void cmd_ad4(const uart_cmd_args* args) {
+	printf("Starting continuous on-chip FSM ADC conversions\n");
+	ADC_DATA_VALID = 0;
+	onchip_control_adc_continuous();
+}
+
+// Initiate continuous loopback-controlled ADC conversions
+void cmd_ad5(const uart_cmd_args* args) {
+	set_loopback_cycles(args);
+	printf("Starting continuous loopback-controlled ADC conversions\n");
+	ADC_DATA_VALID = 0;
+	loopback_control_adc_continuous(cycles_reset, cycles_to_start, cycles_pga);
+}
+
+// Initiate continuous external GPIO-controlled ADC conversions
+void cmd_ad6(const uart_cmd_args* args) {
+	printf("Starting continuous externally-criven GPIO ADC conversions\n");
+	ADC_DATA_VALID = 0;
+	// TODO
+}
+
+// Halt a continuous ADC run, otherwise does nothing
+void cmd_ad0(const uart_cmd_args* args) {
+	printf("Halting continuous ADC run\n");
+	halt_adc_continuous();
+}
+
+// Uses the radio timer to send TX_LOAD and TX_SEND, capture when SFD is sent and capture when packet is sent
+// Optional [load delay, send delay after load] in RF timer counts, 0.5 s each by default
+void cmd_atx(const uart_cmd_args* args) {
+	unsigned int t = RFTIMER_REG__COUNTER + uart_cmd_arg(args, 0, 0x3D090);
+	RFTIMER_REG__COMPARE0 = t;
+	RFTIMER_REG__COMPARE1 = t + uart_cmd_arg(args, 1, 0x3D090);
+	printf("%x\n", RFTIMER_REG__COMPARE0);
+	printf("%x\n", RFTIMER_REG__COMPARE1);
+	RFTIMER_REG__COMPARE0_CONTROL = 0x5;
+	RFTIMER_REG__COMPARE1_CONTROL = 0x9;
+	RFTIMER_REG__CAPTURE0_CONTROL = 0x9;
+	RFTIMER_REG__CAPTURE1_CONTROL = 0x11;
+	printf("Auto TX\n");
+}
+
+// Uses the radio timer to send RX_START, capture when SFD is received and capture when packet is received
+// Optional [start delay] in RF timer counts, 0.5 s by default
+void cmd_arx(const uart_cmd_args* args) {
+	RFTIMER_REG__COMPARE0 = RFTIMER_REG__COUNTER + uart_cmd_arg(args, 0, 0x3D090);
+	RFTIMER_REG__COMPARE0_CONTROL = 0x11;
+	RFTIMER_REG__CAPTURE0_CONTROL = 0x21;
+	RFTIMER_REG__CAPTURE1_CONTROL = 0x41;
+	DMA_REG__RF_RX_ADDR = rx_ring_dma_addr();
+	printf("Auto RX\n");
+}
+
+// Reset the radio timer compare and capture units
+void cmd_rrt(const uart_cmd_args* args) {
+	RFTIMER_REG__COMPARE0_CONTROL = 0x0;
+	RFTIMER_REG__COMPARE1_CONTROL = 0x0;
+	RFTIMER_REG__CAPTURE0_CONTROL = 0x0;
+	RFTIMER_REG__CAPTURE1_CONTROL = 0x0;
+	printf("Radio timer reset\n");
+}
+
+// Attempt to recover if stuck in unprogrammable mode
+void cmd_xx1(const uart_cmd_args* args) {
+	int t;
 	
-			for(t=0;t<=38;t++) {ASC[t] = 0;}
-			
-			// Program analog scan chain
-			analog_scan_chain_write(&ASC[0]);
-			analog_scan_chain_load();
-			
-			// Program analog scan chain on SCM3B
-			//analog_scan_chain_write_3B_fromFPGA(&ASC[0]);
-			//analog_scan_chain_load_3B_fromFPGA();
-			
-			printf("Mote re-initialized to default\n");
-			
-			radio_disable_interrupts();
-			
-			rftimer_disable_interrupts();
-			
-		// Debug pring
-		} else if ( (buff[3]=='x') && (buff[2]=='x') && (buff[1]=='2') && (buff[0]=='\n') ) {
-			do_debug_print = 1;
-		// Unknown command
-		} else if (inChar=='\n'){printf("unknown command\n");}
-	}
+	//for(t=0;t<=38;t++){
+	//	ASC_FPGA[t] = 0;	
+	//}
+
+	for(t=0;t<=38;t++) {ASC[t] = 0;}
+	
+	// Program analog scan chain, in full whatever the shadow says
+	analog_scan_chain_invalidate();
+	analog_scan_chain_write(&ASC[0]);
+	analog_scan_chain_load();
+	
+	// Program analog scan chain on SCM3B
+	//analog_scan_chain_write_3B_fromFPGA(&ASC[0]);
+	//analog_scan_chain_load_3B_fromFPGA();
+	
+	printf("Mote re-initialized to default\n");
+	
+	radio_disable_interrupts();
+	
+	rftimer_disable_interrupts();
+}
+
+// Debug print
+void cmd_xx2(const uart_cmd_args* args) {
+	do_debug_print = 1;
+}
+
+// Check the program image against the per-block CRC manifest and list bad blocks
+void cmd_blk(const uart_cmd_args* args) {
+	image_block_report();
+}
+
+// Dump ASC[] as packed binary with a CRC (asc_fields.read_asc_dump)
+void cmd_asc(const uart_cmd_args* args) {
+	asc_dump();
+}
+
+// The scan chain was shifted from outside (Teensy ascwrite/ascread/scantest), so the next write is done in full
+void cmd_inv(const uart_cmd_args* args) {
+	analog_scan_chain_invalidate();
+	printf("ASC shadow invalidated\n");
+}
+
+// Wait for a compressed stage-2 image over the optical link (bootload.py boot_stage2)
+void cmd_ldr(const uart_cmd_args* args) {
+	printf("Waiting for stage 2\n");
+	optical_patch_arm();
+}
+
+// Wait for a delta against the running image over the optical link (bootload.py delta_program)
+void cmd_dlt(const uart_cmd_args* args) {
+	optical_delta_prepare();
+	printf("Waiting for delta\n");
+	optical_patch_arm();
+}
+
+// Command table: name, opcode for binary frames, most numeric arguments, handler
+// Sorted by name; uart_cmd.py reads this list, so keep one entry per line and never reuse an opcode
+const uart_cmd_entry uart_cmds[] = {
+	{ "ad0", 0x10, 0, cmd_ad0 },
+	{ "ad1", 0x0A, 0, cmd_ad1 },
+	{ "ad2", 0x0B, 3, cmd_ad2 },
+	{ "ad3", 0x0C, 0, cmd_ad3 },
+	{ "ad4", 0x0D, 0, cmd_ad4 },
+	{ "ad5", 0x0E, 3, cmd_ad5 },
+	{ "ad6", 0x0F, 0, cmd_ad6 },
+	{ "arx", 0x12, 1, cmd_arx },
+	{ "asc", 0x17, 0, cmd_asc },
+	{ "atx", 0x11, 2, cmd_atx },
+	{ "blk", 0x16, 0, cmd_blk },
+	{ "cpy", 0x02, UART_CMD_TEXT, cmd_cpy },
+	{ "dlt", 0x19, 0, cmd_dlt },
+	{ "end", 0x06, 0, cmd_end },
+	{ "inv", 0x1A, 0, cmd_inv },
+	{ "ldr", 0x18, 0, cmd_ldr },
+	{ "lod", 0x03, 0, cmd_lod },
+	{ "rcv", 0x05, 0, cmd_rcv },
+	{ "rrt", 0x13, 0, cmd_rrt },
+	{ "rst", 0x07, 0, cmd_rst },
+	{ "sft", 0x09, 0, cmd_sft },
+	{ "snd", 0x04, 0, cmd_snd },
+	{ "sta", 0x08, 0, cmd_sta },
+	{ "xx1", 0x14, 0, cmd_xx1 },
+	{ "xx2", 0x15, 0, cmd_xx2 },
+	{ "zzz", 0x01, 0, cmd_zzz },
+};
+const unsigned int uart_num_cmds = sizeof(uart_cmds) / sizeof(uart_cmds[0]);
+
+// Queues the byte for uart_cmd_poll(), or resets at once on "sft"
+void UART_ISR() {
+	unsigned char ch = UART_REG__RX_DATA;
+	
+	if(uart_rx_soft_reset(ch))
+		soft_reset();
+	uart_rx_put(ch);
 }
 
 void ADC_ISR() {
 	ADC_DATA_VALID = 1;
 	// printf("%d\n", (ADC_DATA_VALID&0xFFFF));
-	printf("%d\n", ADC_REG__DATA);
+	log_event(LOG_ADC_DATA, ADC_REG__DATA);
 }
 
 
@@ -250,7 +379,11 @@ void RF_ISR() {
 	unsigned int interrupt = RFCONTROLLER_REG__INT;
 	unsigned int error     = RFCONTROLLER_REG__ERROR;
 	
-  //if (interrupt & 0x00000001) printf("TX LOAD DONE\n");
+	if (interrupt & 0x00000001){ //printf("TX LOAD DONE\n");
+		
+		// Next frame of a burst is in, the transmitter is still on
+		if(radio_tx_burst) radio_txNow();
+	}
 	//if (interrupt & 0x00000002) printf("TX SFD DONE\n");
 	if (interrupt & 0x00000004){ //printf("TX SEND DONE\n");
 		
@@ -259,15 +392,22 @@ void RF_ISR() {
 			GPIO_REG__OUTPUT |= 0x1;
 			GPIO_REG__OUTPUT &= ~(0x1);
 		
-		
-		// Packet sent; turn transmitter off
-		radio_rfOff();
-		
-		// Apply frequency corrections
-		radio_frequency_housekeeping();
-		
-		//printf("TX DONE\n");
-		printf("IF=%d, LQI=%d, CDR=%d, len=%d, SFD=%d, LC=%d\n",IF_estimate,LQI_chip_errors,cdr_tau_value,recv_packet[0],packet_interval,LC_code);
+		// Queued frame sent; load the next one straight away, TX LOAD DONE above sends it
+		if(radio_tx_source == RADIO_TX_QUEUE){
+			RFTIMER_REG__COMPARE5_CONTROL = 0x0;
+			if(!radio_txBurstNext()) radio_rfOff();
+		}
+		else{
+			
+			// Packet sent; turn transmitter off
+			radio_rfOff();
+			
+			// Apply frequency corrections
+			radio_frequency_housekeeping();
+			
+			//printf("TX DONE\n");
+			log_event(LOG_RF_TX_DONE,IF_estimate,LQI_chip_errors,cdr_tau_value,rx_ring_last()->length,packet_interval,LC_code);
+		}
 		
 	}
 	if (interrupt & 0x00000008){// printf("RX SFD DONE\n");
@@ -292,7 +432,9 @@ void RF_ISR() {
 		
 		//int i;
 		unsigned int RX_DONE_timestamp;
-		char num_bytes_rec = recv_packet[0];
+		// Queue the packet for the main loop; the DMA moves on to the next slot
+		rx_packet* rx = rx_ring_rx_done();
+		char num_bytes_rec = rx->length;
 		//char *current_byte_rec = recv_packet+1;
 		//printf("RX DONE\n");
 		//printf("RX'd %d: \n", num_bytes_rec);
@@ -303,9 +445,16 @@ void RF_ISR() {
 		
 		
 		RX_DONE_timestamp = RFTIMER_REG__COUNTER;
+		DMA_REG__RF_RX_ADDR = rx_ring_dma_addr();
 		
 		num_packets_received++;
 		
+		// Packet descriptor, read before the branches below turn the radio off or restart RX
+		rx->crc_ok = (error & 0x00000008) == 0;
+		rx->sfd_timestamp = SFD_timestamp;
+		rx->if_estimate = read_IF_estimate();
+		rx->lqi = ANALOG_CFG_REG__21 & 0xFF;
+		
 		// continuous rx for debug
 		//printf("IF=%d, LQI=%d, CDR=%d, %d\n",read_IF_estimate(),read_LQI(),ANALOG_CFG_REG__25,SFD_timestamp);
 		//radio_rxEnable();
@@ -341,7 +490,7 @@ void RF_ISR() {
 			// Exit RX mode (so can reprogram on FPGA version)
 			//analog_scan_chain_load_3B_fromFPGA();
 			
-			printf("bad crc\n");
+			log_event(LOG_RF_BAD_CRC);
 			
 			// If packet was a failure, turn thfe radio off
 			if(doing_initial_packet_search == 0){
@@ -388,6 +537,9 @@ void RF_ISR() {
 			// Already locked onto packet rate
 			else{
 			
+				// Prepare ack first: the template is staged, only the sequence number is written
+				radio_loadAck(rx->data[RX_SEQ_BYTE]);
+				
 				// Only record IF estimate, LQI, and CDR tau for valid packets
 				IF_estimate = read_IF_estimate();
 				LQI_chip_errors	= ANALOG_CFG_REG__21 & 0xFF; //read_LQI();	
@@ -398,12 +550,8 @@ void RF_ISR() {
 				cdr_tau_value = ANALOG_CFG_REG__25;
 					
 				num_valid_packets_received++;
-				
-				// Prepare ack	
-				// Data is stored in send_packet[]
-				radio_loadPacket(30);
 		
-				// Transmit packet at this time
+				// Transmit ack at this time
 				RFTIMER_REG__COMPARE5 = RX_DONE_timestamp + ack_turnaround_time;	
 				
 				// Turn on transmitter 
@@ -438,6 +586,10 @@ void RF_ISR() {
 	//		rftimer_disable_interrupts();
 
 		}
+		
+		// CDR tau for every packet, good or not, read this late so it has settled
+		// (the register is on the adc clock domain)
+		rx->cdr_tau = ANALOG_CFG_REG__25;
 	}
 	
 	//if (error != 0) {
@@ -556,16 +708,17 @@ void RFTIMER_ISR() {
 		radio_txNow();
 		
 	}
-	if (interrupt & 0x00000040) printf("COMPARE6 MATCH\n");
-	if (interrupt & 0x00000080) printf("COMPARE7 MATCH\n");
-	if (interrupt & 0x00000100) printf("CAPTURE0 TRIGGERED AT: 0x%x\n", RFTIMER_REG__CAPTURE0);
-	if (interrupt & 0x00000200) printf("CAPTURE1 TRIGGERED AT: 0x%x\n", RFTIMER_REG__CAPTURE1);
-	if (interrupt & 0x00000400) printf("CAPTURE2 TRIGGERED AT: 0x%x\n", RFTIMER_REG__CAPTURE2);
-	if (interrupt & 0x00000800) printf("CAPTURE3 TRIGGERED AT: 0x%x\n", RFTIMER_REG__CAPTURE3);
-	if (interrupt & 0x00001000) printf("CAPTURE0 OVERFLOW AT: 0x%x\n", RFTIMER_REG__CAPTURE0);
-	if (interrupt & 0x00002000) printf("CAPTURE1 OVERFLOW AT: 0x%x\n", RFTIMER_REG__CAPTURE1);
-	if (interrupt & 0x00004000) printf("CAPTURE2 OVERFLOW AT: 0x%x\n", RFTIMER_REG__CAPTURE2);
-	if (interrupt & 0x00008000) printf("CAPTURE3 OVERFLOW AT: 0x%x\n", RFTIMER_REG__CAPTURE3);
+	if (interrupt & 0x00000040) log_event(LOG_RFTIMER_COMPARE, 6);
+	// COMPARE7 paces the buffered UART output
+	if (interrupt & 0x00000080) uart_tx_tick();
+	if (interrupt & 0x00000100) log_event(LOG_RFTIMER_CAPTURE, 0, RFTIMER_REG__CAPTURE0);
+	if (interrupt & 0x00000200) log_event(LOG_RFTIMER_CAPTURE, 1, RFTIMER_REG__CAPTURE1);
+	if (interrupt & 0x00000400) log_event(LOG_RFTIMER_CAPTURE, 2, RFTIMER_REG__CAPTURE2);
+	if (interrupt & 0x00000800) log_event(LOG_RFTIMER_CAPTURE, 3, RFTIMER_REG__CAPTURE3);
+	if (interrupt & 0x00001000) log_event(LOG_RFTIMER_OVERFLOW, 0, RFTIMER_REG__CAPTURE0);
+	if (interrupt & 0x00002000) log_event(LOG_RFTIMER_OVERFLOW, 1, RFTIMER_REG__CAPTURE1);
+	if (interrupt & 0x00004000) log_event(LOG_RFTIMER_OVERFLOW, 2, RFTIMER_REG__CAPTURE2);
+	if (interrupt & 0x00008000) log_event(LOG_RFTIMER_OVERFLOW, 3, RFTIMER_REG__CAPTURE3);
 	
 	RFTIMER_REG__INT_CLEAR = interrupt;
 }
@@ -605,6 +758,7 @@ void RAWCHIPS_32_ISR() {
 		chip_index = 0;
 		
 		// Wait for print to complete
+		uart_tx_flush();
 		for(jj=0;jj<10000;jj++);
 		
 		// Execute soft reset
@@ -639,19 +793,139 @@ void RAWCHIPS_STARTVAL_ISR() {
 }
 
 
+// Optical patch receiver
+// Used to re-send individual blocks of the program image without a hard reset (see bootload.py repair_cortex)
+// Once armed, the next optical SFD starts the transfer and each following 32-bit word is handled by OPTICAL_32_ISR
+// Word stream: OPTICAL_PATCH_MAGIC | num_blocks, then per block: byte address, num_words, data words,
+// crc32 of address, num_words and data. The address and length are checked before anything is written:
+// a block must be word aligned, end below the block CRC manifest and hold at most one manifest block
+// (PATCH_MAX_BYTES without a manifest). A header that fails the checks ends the transfer, since the rest
+// of the stream can no longer be followed; it and each bad CRC count in optical_patch_errors.
+// A header of OPTICAL_LOADER_MAGIC or OPTICAL_DELTA_MAGIC instead hands the rest of the stream to optical_loader.c
+#define OPTICAL_PATCH_MAGIC			0x5CA10000
+#define PATCH_MAX_BYTES					4096
+
+#define PATCH_STATE_IDLE			0
+#define PATCH_STATE_HEADER		1
+#define PATCH_STATE_ADDR			2
+#define PATCH_STATE_LEN				3
+#define PATCH_STATE_DATA			4
+#define PATCH_STATE_CRC				5
+#define PATCH_STATE_LOADER		6
+
+unsigned short optical_patch_armed = 0;
+unsigned short optical_patch_done = 0;
+unsigned short optical_patch_state = PATCH_STATE_IDLE;
+unsigned int optical_patch_blocks_left;
+unsigned int optical_patch_words_left;
+unsigned int *optical_patch_addr;
+unsigned int optical_patch_crc;
+unsigned int optical_patch_errors;
+
+// Wait for the next optical SFD to start receiving a patch
+void optical_patch_arm(void) {
+	optical_patch_done = 0;
+	optical_patch_state = PATCH_STATE_IDLE;
+	optical_patch_armed = 1;
+	
+	// Enable optical SFD interrupt
+	ISER = 0x0800;
+}
+
+void optical_patch_finish(void) {
+	// Disable optical 32-bit interrupt
+	ICER = 0x0004;
+	optical_patch_state = PATCH_STATE_IDLE;
+	optical_patch_armed = 0;
+	optical_patch_done = 1;
+}
+
+void optical_patch_word(unsigned int word) {
+	
+	unsigned int addr, max_bytes;
+	
+	switch(optical_patch_state) {
+		case PATCH_STATE_HEADER:
+			if(word == OPTICAL_LOADER_MAGIC) {
+				optical_loader_start();
+				optical_patch_state = PATCH_STATE_LOADER;
+				break;
+			}
+			if(word == OPTICAL_DELTA_MAGIC) {
+				optical_delta_start();
+				optical_patch_state = PATCH_STATE_LOADER;
+				break;
+			}
+			if((word & 0xFFFF0000) != OPTICAL_PATCH_MAGIC || (word & 0xFFFF) == 0) {
+				// Not a patch header; wait for the next SFD
+				optical_patch_state = PATCH_STATE_IDLE;
+				ICER = 0x0004;
+				return;
+			}
+			optical_patch_blocks_left = word & 0xFFFF;
+			optical_patch_errors = 0;
+			optical_patch_state = PATCH_STATE_ADDR;
+			break;
+		
+		case PATCH_STATE_ADDR:
+			optical_patch_addr = (unsigned int *)word;
+			optical_patch_crc = crc_update(crc_init(), (unsigned char *)&word, 4);
+			optical_patch_state = PATCH_STATE_LEN;
+			break;
+		
+		case PATCH_STATE_LEN:
+			max_bytes = block_crc_info & 0xFFFF;
+			if(max_bytes == 0 || max_bytes > PATCH_MAX_BYTES) max_bytes = PATCH_MAX_BYTES;
+			addr = (unsigned int)optical_patch_addr;
+			if((addr & 3) || addr > BLOCK_CRC_TABLE_ADDR || word > max_bytes / 4
+					|| word > (BLOCK_CRC_TABLE_ADDR - addr) / 4) {
+				optical_patch_errors++;
+				optical_patch_finish();
+				return;
+			}
+			optical_patch_words_left = word;
+			optical_patch_crc = crc_update(optical_patch_crc, (unsigned char *)&word, 4);
+			optical_patch_state = word ? PATCH_STATE_DATA : PATCH_STATE_CRC;
+			break;
+		
+		case PATCH_STATE_DATA:
+			*optical_patch_addr = word;
+			optical_patch_crc = crc_update(optical_patch_crc, (unsigned char *)optical_patch_addr, 4);
+			optical_patch_addr++;
+			if(--optical_patch_words_left == 0) optical_patch_state = PATCH_STATE_CRC;
+			break;
+		
+		case PATCH_STATE_CRC:
+			if(crc_final(optical_patch_crc) != word) optical_patch_errors++;
+			if(--optical_patch_blocks_left == 0) optical_patch_finish();
+			else optical_patch_state = PATCH_STATE_ADDR;
+			break;
+		
+		case PATCH_STATE_LOADER:
+			if(optical_loader_word(word)) optical_patch_finish();
+			break;
+		
+		default:
+			break;
+	}
+}
+
 // This interrupt goes off every time 32 new bits of data have been shifted into the optical register
 // Do not recommend trying to do any CPU intensive actions while trying to receive optical data
 // ex, printf will mess up the received data values
 void OPTICAL_32_ISR(){
 	// printf("Optical 32-bit interrupt triggered\n");
 	
-	//unsigned int LSBs, MSBs, optical_shiftreg;
+	unsigned int LSBs, MSBs;
 	//int t;
 	
 	// 32-bit register is analog_rdata[335:304]
-	//LSBs = ANALOG_CFG_REG__19; //16 LSBs
-	//MSBs = ANALOG_CFG_REG__20; //16 MSBs
-	//optical_shiftreg = (MSBs << 16) + LSBs;	
+	LSBs = ANALOG_CFG_REG__19; //16 LSBs
+	MSBs = ANALOG_CFG_REG__20; //16 MSBs
+	
+	if(optical_patch_state != PATCH_STATE_IDLE) {
+		optical_patch_word((MSBs << 16) + LSBs);
+	}
 	
 	// Toggle GPIO 0
 	//GPIO_REG__OUTPUT ^= 0x1;
@@ -664,6 +938,19 @@ void OPTICAL_32_ISR(){
 void OPTICAL_SFD_ISR(){
 	unsigned int rdata_lsb, rdata_msb; 
 	unsigned int count_LC, count_32k, count_2M, count_HFclock, count_IF;
+	
+	// Start of an optical patch transfer rather than a calibration SFD
+	if(optical_patch_armed) {
+		optical_patch_armed = 0;
+		optical_patch_state = PATCH_STATE_HEADER;
+		
+		// Disable this ISR and enable the 32-bit interrupt for the data words
+		ICER = 0x0800;
+		ICPR = 0x0004;
+		ISER = 0x0004;
+		return;
+	}
+	
 	// Disable all counters
 	ANALOG_CFG_REG__0 = 0x007F;
 	
@@ -743,7 +1030,7 @@ void OPTICAL_SFD_ISR(){
 	 
 	//printf("%d\n",count_LC);
 	if(optical_cal_iteration == 25){
-		// Disable this ISR
+		// Disable this ISR; before ICER was fixed it stayed enabled and kept trimming the clocks on every later SFD
 		ICER = 0x0800;
 		optical_cal_iteration = 0;
 		optical_cal_finished = 1;
@@ -782,16 +1069,16 @@ void OPTICAL_SFD_ISR(){
 	
 // ISRs for external interrupts
 void INTERRUPT_GPIO3_ISR(){
-	printf("External Interrupt GPIO3 triggered\n");
+	log_event(LOG_GPIO_INTERRUPT, 3);
 }
 void INTERRUPT_GPIO8_ISR(){
-	printf("External Interrupt GPIO8 triggered\n");
+	log_event(LOG_GPIO_INTERRUPT, 8);
 }
 void INTERRUPT_GPIO9_ISR(){
-	printf("External Interrupt GPIO9 triggered\n");
+	log_event(LOG_GPIO_INTERRUPT, 9);
 }
 void INTERRUPT_GPIO10_ISR(){
-	printf("External Interrupt GPIO10 triggered\n");
+	log_event(LOG_GPIO_INTERRUPT, 10);
 }
 
 
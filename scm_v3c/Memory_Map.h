@@ -203,7 +203,8 @@
 // Interrupt set enable reg		
 #define ISER														*(unsigned int*)(0xE000E100)
 // Interrupt clear enable reg		
-#define ICER														*(unsigned int*)(0x00000000)
+// Used to point at address 0, so ICER writes were no-ops on the NVIC (and overwrote the initial stack pointer)
+#define ICER														*(unsigned int*)(0xE000E180)
 // Interrupt clear pending reg		
 #define ICPR														*(unsigned int*)(0xE000E280)
 // Interrupt set pending reg		
@@ -0,0 +1,448 @@
+# Generated by scan_layout.py from asc_layout.txt, do not edit
+"""
+Encoder for the 1200 bit scan chain described in asc_layout.txt.
+encode() takes the arguments of scan.construct_scan() and returns the same bits.
+"""
+
+CHAIN_BITS = 1200
+CHAIN_BYTES = 150
+
+# name: (list argument, width, default, positions, argument element at each position,
+#	inverted positions, (op, value, chain bits) rules that override the mapping)
+FIELDS = {
+	'gpio_direction': (True, 16, [1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1], (1131, 1132, 1133, 1134, 1135, 1136, 1137, 1138, 1139, 1140, 1141, 1142, 1143, 1144, 1145, 1146, 1115, 1116, 1117, 1118, 1119, 1120, 1121, 1122, 1123, 1124, 1125, 1126, 1127, 1128, 1129, 1130), (0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15), (1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'mux_sel_gpio11': (True, 3, [0, 0, 0], (104, 105, 106), (0, 1, 2), (0, 0, 0), ()),
+	'sel_data': (False, 1, 1, (1,), (0,), (0,), ()),
+	'sel_counter_resets': (True, 7, [1, 1, 1, 1, 1, 1, 1], (2, 3, 4, 5, 6, 7, 8), (0, 1, 2, 3, 4, 5, 6), (0, 0, 0, 0, 0, 0, 0), ()),
+	'counter_resets': (True, 7, [0, 0, 0, 0, 0, 0, 0], (552, 9, 10, 11, 12, 13, 14), (0, 1, 2, 3, 4, 5, 6), (0, 0, 0, 0, 0, 0, 0), ()),
+	'counter_enables': (True, 7, [0, 0, 0, 0, 0, 0, 0], (15, 16, 17, 18, 19, 20, 21), (0, 1, 2, 3, 4, 5, 6), (0, 0, 0, 0, 0, 0, 0), ()),
+	'div_RFTimer_enable': (False, 1, 0, (24,), (0,), (0,), ()),
+	'div_CortexM0_enable': (False, 1, 0, (25,), (0,), (0,), ()),
+	'div_GFSK_enable': (False, 1, 0, (26,), (0,), (0,), ()),
+	'div_ext_GPIO_enable': (False, 1, 0, (27,), (0,), (0,), ()),
+	'div_integ_enable': (False, 1, 0, (28,), (0,), (0,), ()),
+	'div_2MHz_enable': (False, 1, 0, (29,), (0,), (0,), ()),
+	'div_RFTimer_reset': (False, 1, 0, (30,), (0,), (0,), ()),
+	'div_CortexM0_reset': (False, 1, 0, (31,), (0,), (0,), ()),
+	'div_GFSK_reset': (False, 1, 0, (32,), (0,), (0,), ()),
+	'div_ext_GPIO_reset': (False, 1, 0, (33,), (0,), (0,), ()),
+	'div_integ_reset': (False, 1, 0, (34,), (0,), (0,), ()),
+	'div_2MHz_reset': (False, 1, 0, (35,), (0,), (0,), ()),
+	'div_RFTimer_PT': (False, 1, 0, (36,), (0,), (0,), ()),
+	'div_CortexM0_PT': (False, 1, 0, (37,), (0,), (0,), ()),
+	'div_GFSK_PT': (False, 1, 0, (38,), (0,), (0,), ()),
+	'div_ext_GPIO_PT': (False, 1, 0, (39,), (0,), (0,), ()),
+	'div_integ_PT': (False, 1, 0, (40,), (0,), (0,), ()),
+	'div_2MHz_PT': (False, 1, 0, (41,), (0,), (0,), ()),
+	'div_RFTimer_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (49, 48, 47, 46, 45, 44, 43, 42), (0, 1, 2, 3, 4, 5, 6, 7), (1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'div_CortexM0_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (57, 56, 55, 54, 53, 52, 51, 50), (0, 1, 2, 3, 4, 5, 6, 7), (1, 1, 1, 1, 1, 1, 1, 1), (('>=', 4, (0, 0, 0, 0, 0, 0, 0, 0)),)),
+	'div_GFSK_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (65, 64, 63, 62, 61, 60, 59, 58), (0, 1, 2, 3, 4, 5, 6, 7), (1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'div_ext_GPIO_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (73, 72, 71, 70, 69, 68, 67, 66), (0, 1, 2, 3, 4, 5, 6, 7), (1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'div_integ_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (81, 80, 79, 78, 77, 76, 75, 74), (0, 1, 2, 3, 4, 5, 6, 7), (1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'div_2MHz_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (89, 88, 87, 86, 85, 84, 83, 82), (0, 1, 2, 3, 4, 5, 6, 7), (1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'mux_sel_RFTimer': (False, 1, 0, (90,), (0,), (0,), ()),
+	'mux_sel_GFSK_clk': (False, 1, 0, (91,), (0,), (0,), ()),
+	'mux3_sel_CLK2MHz': (True, 2, [0, 0], (92, 93), (0, 1), (0, 0), ()),
+	'mux3_sel_CLK1MHz': (True, 2, [0, 0], (94, 95), (0, 1), (0, 0), ()),
+	'sel_mux3in': (True, 2, [0, 0], (22, 23), (0, 1), (0, 0), ()),
+	'crossbar_HCLK': (True, 4, [0, 0, 0, 0], (), (), (), ()),
+	'crossbar_RFTimer': (True, 4, [0, 0, 0, 0], (1154, 1153, 1152, 1151), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'crossbar_TX_chip_clk_to_cortex': (True, 4, [0, 0, 0, 0], (1158, 1157, 1156, 1155), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'crossbar_symbol_clk_ble': (True, 4, [0, 0, 0, 0], (1162, 1161, 1160, 1159), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'crossbar_divider_out_INTEG': (True, 4, [0, 0, 0, 0], (1166, 1165, 1164, 1163), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'crossbar_GFSK_CLK': (True, 4, [0, 0, 0, 0], (1170, 1169, 1168, 1167), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'crossbar_EXT_CLK_GPIO': (True, 4, [0, 0, 0, 0], (1174, 1173, 1172, 1171), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'crossbar_EXT_CLK_GPIO2': (True, 4, [0, 0, 0, 0], (1178, 1177, 1176, 1175), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'crossbar_BLE_PDA': (True, 4, [0, 0, 0, 0], (1182, 1181, 1180, 1179), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'cdr_clk_sel': (False, 1, 0, (0,), (0,), (0,), ()),
+	'IQ_select': (True, 2, [0, 0], (96, 97), (0, 1), (0, 0), ()),
+	'op_mode': (True, 2, [0, 0], (98, 99), (0, 1), (0, 0), ()),
+	'agc_overload': (False, 1, 0, (100,), (0,), (0,), ()),
+	'agc_ext_or_int': (False, 1, 0, (101,), (0,), (0,), ()),
+	'vga_select': (False, 1, 0, (102,), (0,), (0,), ()),
+	'mf_data_sign': (False, 1, 0, (103,), (0,), (0,), ()),
+	'COUNT_THRESH': (True, 16, [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0], (107, 108, 109, 110, 111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'FB_EN': (False, 1, 0, (123,), (0,), (0,), ()),
+	'CLK_DIV_ext': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (124, 125, 126, 127, 128, 129, 130, 131), (0, 1, 2, 3, 4, 5, 6, 7), (0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'DEMOD_EN': (False, 1, 0, (132,), (0,), (0,), ()),
+	'INIT_INTEG': (True, 11, [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0], (133, 134, 135, 136, 137, 138, 139, 140, 141, 142, 143), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10), (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'sel_FREQ_CTRL_WORD': (False, 1, 0, (192,), (0,), (0,), ()),
+	'SACLIENT_ext': (True, 16, [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0], (193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'EARLY_DECISION_MARGIN_ext': (True, 16, [0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0], (209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222, 223, 224), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'mux_sel_FREQ_CTRL_WORD_SCAN': (True, 2, [0, 0], (225, 226), (0, 1), (0, 0), ()),
+	'FREQ_CTRL_WORD_SCAN': (True, 11, [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0], (227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10), (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'sel_dbb_ring_data_in': (False, 1, 1, (238,), (0,), (0,), ()),
+	'sel_dbb_ring_clk_in': (False, 1, 1, (239,), (0,), (0,), ()),
+	'sel_resetb': (False, 1, 1, (240,), (0,), (0,), ()),
+	'resetb': (False, 1, 1, (241,), (0,), (0,), ()),
+	'GPO_row1_sel': (True, 4, [0, 1, 1, 0], (245, 246, 247, 248), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'GPO_row2_sel': (True, 4, [0, 0, 0, 0], (249, 250, 251, 252), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'GPO_row3_sel': (True, 4, [0, 0, 0, 0], (253, 254, 255, 256), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'GPO_row4_sel': (True, 4, [0, 0, 0, 0], (257, 258, 259, 260), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'GPI_row1_sel': (True, 2, [0, 0], (261, 262), (0, 1), (0, 0), ()),
+	'GPI_row2_sel': (True, 2, [0, 0], (263, 264), (0, 1), (0, 0), ()),
+	'GPI_row3_sel': (True, 2, [1, 1], (265, 266), (0, 1), (0, 0), ()),
+	'GPI_row4_sel': (True, 2, [0, 0], (267, 268), (0, 1), (0, 0), ()),
+	'cortex_clk_sel': (False, 1, 0, (269,), (0,), (0,), ()),
+	'cortex_data_sel': (False, 1, 0, (270,), (0,), (0,), ()),
+	'mix_bias_In_ndac': (True, 4, [0, 0, 0, 0], (294, 295, 296, 297), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'mix_bias_Ip_ndac': (True, 4, [0, 0, 0, 0], (299, 300, 301, 302), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'mix_bias_Qn_ndac': (True, 4, [0, 0, 0, 0], (303, 304, 305, 306), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'mix_bias_Qp_ndac': (True, 4, [0, 0, 0, 0], (308, 309, 310, 311), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'mix_bias_In_pdac': (True, 4, [0, 0, 0, 0], (312, 313, 314, 315), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'mix_bias_Ip_pdac': (True, 4, [0, 0, 0, 0], (316, 317, 318, 319), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'mix_bias_Qn_pdac': (True, 4, [0, 0, 0, 0], (320, 321, 322, 323), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'mix_bias_Qp_pdac': (True, 4, [0, 0, 0, 0], (324, 325, 326, 327), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'mix_off_i': (False, 1, 0, (298,), (0,), (0,), ()),
+	'mix_off_q': (False, 1, 0, (307,), (0,), (0,), ()),
+	'Q_agc_gain_mode': (False, 1, 0, (271,), (0,), (0,), ()),
+	'Q_code_scan': (True, 6, [1, 1, 1, 1, 1, 1], (272, 273, 274, 275, 276, 277), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'Q_stg3_gm_tune': (True, 13, [1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1], (278, 279, 280, 281, 282, 283, 284, 285, 286, 287, 288, 289, 290), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12), (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'Q_dbg_bias_en_Q': (False, 1, 0, (291,), (0,), (0,), ()),
+	'Q_dbg_out_en_Q': (False, 1, 0, (292,), (0,), (0,), ()),
+	'Q_dbg_input_en_Q': (False, 1, 0, (293,), (0,), (0,), ()),
+	'Q_tia_cap_on': (True, 4, [0, 0, 0, 0], (328, 329, 330, 331), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'Q_tia_pulldown': (False, 1, 1, (332,), (0,), (0,), ()),
+	'Q_tia_enn': (False, 1, 0, (333,), (0,), (0,), ()),
+	'Q_tia_enp': (False, 1, 1, (334,), (0,), (0,), ()),
+	'Q_pctrl': (True, 5, [0, 0, 0, 0, 0], (335, 336, 337, 338, 339), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'Q_nctrl': (True, 5, [0, 0, 0, 0, 0], (340, 341, 342, 343, 344), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'Q_mode_1bit': (False, 1, 1, (345,), (0,), (0,), ()),
+	'Q_adc_comp_en': (False, 1, 1, (346,), (0,), (0,), ()),
+	'Q_stg3_amp_en': (False, 1, 0, (347,), (0,), (0,), ()),
+	'Q_dbg_out_on_stg3': (False, 1, 0, (348,), (0,), (0,), ()),
+	'Q_dbg_input_on_stg3': (False, 1, 0, (349,), (0,), (0,), ()),
+	'Q_dbg_bias_en_stg3': (False, 1, 0, (350,), (0,), (0,), ()),
+	'Q_stg2_amp_en': (False, 1, 0, (351,), (0,), (0,), ()),
+	'Q_dbg_out_on_stg2': (False, 1, 0, (352,), (0,), (0,), ()),
+	'Q_dbg_input_on_stg2': (False, 1, 0, (353,), (0,), (0,), ()),
+	'Q_dbg_bias_en_stg2': (False, 1, 0, (354,), (0,), (0,), ()),
+	'Q_stg1_amp_en': (False, 1, 0, (355,), (0,), (0,), ()),
+	'Q_dbg_out_on_stg1': (False, 1, 0, (356,), (0,), (0,), ()),
+	'Q_dbg_input_on_stg1': (False, 1, 0, (357,), (0,), (0,), ()),
+	'Q_dbg_bias_en_stg1': (False, 1, 0, (358,), (0,), (0,), ()),
+	'Q_vcm_amp_en': (False, 1, 0, (359,), (0,), (0,), ()),
+	'Q_vcm_vdiv_sel': (True, 2, [0, 0], (361, 360), (0, 1), (0, 0), ()),
+	'Q_vcm_clk_en': (False, 1, 0, (362,), (0,), (0,), ()),
+	'Q_vref_amp_en': (False, 1, 0, (366,), (0,), (0,), ()),
+	'Q_vref_vdiv_sel': (True, 2, [1, 1], (364, 365), (0, 1), (0, 0), ()),
+	'Q_vref_clk_en': (False, 1, 0, (363,), (0,), (0,), ()),
+	'Q_adc_fsm_en': (False, 1, 0, (367,), (0,), (0,), ()),
+	'Q_adc_dbg_en': (False, 1, 0, (368,), (0,), (0,), ()),
+	'Q_stg3_clk_en': (False, 1, 0, (369,), (0,), (0,), ()),
+	'Q_stg3_C2': (True, 3, [0, 0, 1], (370, 371, 372), (0, 1, 2), (0, 0, 0), ()),
+	'Q_stg3_C1': (True, 3, [0, 0, 1], (373, 374, 375), (0, 1, 2), (0, 0, 0), ()),
+	'Q_stg2_clk_en': (False, 1, 0, (376,), (0,), (0,), ()),
+	'Q_stg2_C2': (True, 3, [0, 0, 1], (377, 378, 379), (0, 1, 2), (0, 0, 0), ()),
+	'Q_stg2_C1': (True, 3, [0, 0, 1], (380, 381, 382), (0, 1, 2), (0, 0, 0), ()),
+	'Q_stg1_clk_en': (False, 1, 0, (383,), (0,), (0,), ()),
+	'Q_stg1_C2': (True, 3, [0, 0, 1], (384, 385, 386), (0, 1, 2), (0, 0, 0), ()),
+	'Q_stg1_C1': (True, 3, [0, 0, 1], (387, 388, 389), (0, 1, 2), (0, 0, 0), ()),
+	'I_agc_gain_mode': (False, 1, 0, (491,), (0,), (0,), ()),
+	'I_code_scan': (True, 6, [1, 1, 1, 1, 1, 1], (490, 489, 488, 487, 486, 485), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'I_stg3_gm_tune': (True, 13, [1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1], (484, 483, 482, 481, 480, 479, 478, 477, 476, 475, 474, 473, 472), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12), (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'I_dbg_bias_en_I': (False, 1, 0, (471,), (0,), (0,), ()),
+	'I_dbg_out_en_I': (False, 1, 0, (470,), (0,), (0,), ()),
+	'I_dbg_input_en_I': (False, 1, 0, (469,), (0,), (0,), ()),
+	'I_tia_cap_on': (True, 4, [0, 0, 0, 0], (465, 466, 467, 468), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'I_tia_pulldown': (False, 1, 1, (464,), (0,), (0,), ()),
+	'I_tia_enn': (False, 1, 0, (463,), (0,), (0,), ()),
+	'I_tia_enp': (False, 1, 1, (462,), (0,), (0,), ()),
+	'I_pctrl': (True, 5, [0, 0, 0, 0, 0], (461, 460, 459, 458, 457), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'I_nctrl': (True, 5, [0, 0, 0, 0, 0], (456, 455, 454, 453, 452), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'I_mode_1bit': (False, 1, 1, (451,), (0,), (0,), ()),
+	'I_adc_comp_en': (False, 1, 1, (450,), (0,), (0,), ()),
+	'I_stg3_amp_en': (False, 1, 0, (449,), (0,), (0,), ()),
+	'I_dbg_out_on_stg3': (False, 1, 0, (448,), (0,), (0,), ()),
+	'I_dbg_input_on_stg3': (False, 1, 0, (447,), (0,), (0,), ()),
+	'I_dbg_bias_en_stg3': (False, 1, 0, (446,), (0,), (0,), ()),
+	'I_stg2_amp_en': (False, 1, 0, (445,), (0,), (0,), ()),
+	'I_dbg_out_on_stg2': (False, 1, 0, (444,), (0,), (0,), ()),
+	'I_dbg_input_on_stg2': (False, 1, 0, (443,), (0,), (0,), ()),
+	'I_dbg_bias_en_stg2': (False, 1, 0, (442,), (0,), (0,), ()),
+	'I_stg1_amp_en': (False, 1, 0, (441,), (0,), (0,), ()),
+	'I_dbg_out_on_stg1': (False, 1, 0, (440,), (0,), (0,), ()),
+	'I_dbg_input_on_stg1': (False, 1, 0, (439,), (0,), (0,), ()),
+	'I_dbg_bias_en_stg1': (False, 1, 0, (438,), (0,), (0,), ()),
+	'I_vcm_amp_en': (False, 1, 0, (390,), (0,), (0,), ()),
+	'I_vcm_vdiv_sel': (True, 2, [0, 0], (392, 391), (0, 1), (0, 0), ()),
+	'I_vcm_clk_en': (False, 1, 0, (393,), (0,), (0,), ()),
+	'I_vref_amp_en': (False, 1, 0, (397,), (0,), (0,), ()),
+	'I_vref_vdiv_sel': (True, 2, [1, 1], (395, 396), (0, 1), (0, 0), ()),
+	'I_vref_clk_en': (False, 1, 0, (394,), (0,), (0,), ()),
+	'I_adc_fsm_en': (False, 1, 0, (398,), (0,), (0,), ()),
+	'I_adc_dbg_en': (False, 1, 0, (399,), (0,), (0,), ()),
+	'I_stg3_clk_en': (False, 1, 0, (400,), (0,), (0,), ()),
+	'I_stg3_C2': (True, 3, [0, 0, 1], (401, 402, 403), (0, 1, 2), (0, 0, 0), ()),
+	'I_stg3_C1': (True, 3, [0, 0, 1], (404, 405, 406), (0, 1, 2), (0, 0, 0), ()),
+	'I_stg2_clk_en': (False, 1, 0, (407,), (0,), (0,), ()),
+	'I_stg2_C2': (True, 3, [0, 0, 1], (408, 409, 410), (0, 1, 2), (0, 0, 0), ()),
+	'I_stg2_C1': (True, 3, [0, 0, 1], (411, 412, 413), (0, 1, 2), (0, 0, 0), ()),
+	'I_stg1_clk_en': (False, 1, 0, (414,), (0,), (0,), ()),
+	'I_stg1_C2': (True, 3, [0, 0, 1], (415, 416, 417), (0, 1, 2), (0, 0, 0), ()),
+	'I_stg1_C1': (True, 3, [0, 0, 1], (418, 419, 420), (0, 1, 2), (0, 0, 0), ()),
+	'adc_dbg_en': (False, 1, 0, (421,), (0,), (0,), ()),
+	'adc_phi_en': (False, 1, 0, (422,), (0,), (0,), ()),
+	'filt_phi_en': (False, 1, 0, (423,), (0,), (0,), ()),
+	'clk_select': (True, 2, [0, 1], (424, 425), (0, 1), (0, 0), ()),
+	'filt_dbg_en': (False, 1, 0, (432,), (0,), (0,), ()),
+	'RC_clk_en': (False, 1, 0, (426,), (0,), (0,), ()),
+	'RC_coarse': (True, 5, [0, 0, 0, 0, 0], (427, 428, 429, 430, 431), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'RC_fine': (True, 5, [0, 0, 0, 0, 0], (433, 434, 435, 436, 437), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'if_ldo_rdac': (True, 7, [0, 0, 0, 0, 0, 0, 0], (498, 497, 496, 495, 494, 493, 492), (0, 1, 2, 3, 4, 5, 6), (0, 0, 0, 0, 0, 0, 0), ()),
+	'if_por_disable': (False, 1, 0, (499,), (0,), (0,), ()),
+	'if_scan_reset': (False, 1, 1, (500,), (0,), (0,), ()),
+	'scan_pon_if': (False, 1, 0, (501,), (0,), (0,), ()),
+	'scan_pon_lo': (False, 1, 0, (502,), (0,), (0,), ()),
+	'scan_pon_pa': (False, 1, 0, (503,), (0,), (0,), ()),
+	'scan_pon_div': (False, 1, 0, (513,), (0,), (0,), ()),
+	'gpio_pon_en_if': (False, 1, 0, (504,), (0,), (0,), ()),
+	'gpio_pon_en_lo': (False, 1, 0, (506,), (0,), (0,), ()),
+	'gpio_pon_en_pa': (False, 1, 0, (508,), (0,), (0,), ()),
+	'gpio_pon_en_div': (False, 1, 0, (514,), (0,), (0,), ()),
+	'fsm_pon_en_if': (False, 1, 0, (505,), (0,), (0,), ()),
+	'fsm_pon_en_lo': (False, 1, 0, (507,), (0,), (0,), ()),
+	'fsm_pon_en_pa': (False, 1, 0, (509,), (0,), (0,), ()),
+	'fsm_pon_en_div': (False, 1, 0, (515,), (0,), (0,), ()),
+	'master_ldo_en_if': (False, 1, 0, (510,), (0,), (0,), ()),
+	'master_ldo_en_lo': (False, 1, 0, (511,), (0,), (0,), ()),
+	'master_ldo_en_pa': (False, 1, 0, (512,), (0,), (0,), ()),
+	'master_ldo_en_div': (False, 1, 0, (516,), (0,), (0,), ()),
+	'TIMER32k_enable': (False, 1, 0, (623,), (0,), (0,), ()),
+	'TIMER32k_counter_reset': (False, 1, 0, (), (), (), ()),
+	'vddd_bgr_tune': (True, 7, [0, 1, 1, 1, 1, 1, 1], (792, 793, 794, 795, 796, 797), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'por_bypass': (False, 1, 0, (799,), (0,), (0,), ()),
+	'alwayson_ldo_bgr_tune': (True, 6, [0, 0, 0, 0, 0, 0], (924, 925, 926, 927, 928, 929), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'mux_select_aux_ldo_enable': (False, 1, 0, (914,), (0,), (0,), ()),
+	'aux_ldo_enable': (False, 1, 0, (916,), (0,), (0,), ()),
+	'aux_ldo_bgr_tune': (True, 7, [1, 0, 0, 0, 0, 0, 0], (923, 922, 921, 920, 919, 918, 917), (0, 1, 2, 3, 4, 5, 6), (0, 0, 0, 0, 0, 0, 0), ()),
+	'ring_20MHz_tune': (True, 9, [0, 0, 0, 0, 0, 0, 0, 0, 0], (932, 933, 934, 935, 936, 937, 938, 939, 940), (0, 1, 2, 3, 4, 5, 6, 7, 8), (0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'ring_20MHz_enable': (False, 1, 0, (941,), (0,), (0,), ()),
+	'mux_sel_sensorADC_reset': (False, 1, 0, (242,), (0,), (0,), ()),
+	'mux_sel_sensorADC_convert': (False, 1, 0, (243,), (0,), (0,), ()),
+	'mux_sel_sensorADC_pga_amplify': (False, 1, 0, (244,), (0,), (0,), ()),
+	'sensorADC_pga_gain': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (766, 767, 768, 769, 770, 771, 800, 773), (0, 1, 2, 3, 4, 5, 6, 7), (0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'sensorADC_settle': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (816, 817, 818, 819, 820, 821, 822, 823), (0, 1, 2, 3, 4, 5, 6, 7), (0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'sensorADC_ldo_bgr_tune': (True, 7, [0, 0, 0, 0, 0, 0, 0], (778, 784, 783, 782, 781, 780, 779), (0, 1, 2, 3, 4, 5, 6), (0, 0, 0, 0, 0, 0, 0), ()),
+	'sensorADC_constgm_tune': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (765, 764, 763, 762, 761, 760, 759, 758), (0, 1, 2, 3, 4, 5, 6, 7), (0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'sensorADC_vbatDiv4_en': (False, 1, 0, (798,), (0,), (0,), ()),
+	'sensorADC_ldo_en': (False, 1, 0, (801,), (0,), (0,), ()),
+	'sensorADC_mux_sel': (True, 2, [0, 0], (915, 1087), (0, 1), (0, 0), ()),
+	'sensorADC_pga_bypass': (False, 1, 0, (1088,), (0,), (0,), ()),
+	'lo_fine_tune': (True, 6, [0, 0, 0, 0, 0, 0], (946, 947, 948, 949, 950, 951), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'lo_mid_tune': (True, 6, [0, 0, 0, 0, 0, 0], (952, 953, 954, 955, 956, 957), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'lo_coarse_tune': (True, 6, [0, 0, 0, 0, 0, 0], (958, 959, 960, 961, 962, 963), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'lo_current_tune': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (988, 989, 990, 991, 992, 993, 994, 995), (0, 1, 2, 3, 4, 5, 6, 7), (0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'lo_tune_select': (False, 1, 1, (964,), (0,), (0,), ()),
+	'polyphase_enable': (False, 1, 1, (971,), (0,), (0,), ()),
+	'lo_panic': (False, 1, 0, (980,), (0,), (0,), ()),
+	'pa_panic': (False, 1, 0, (972,), (0,), (0,), ()),
+	'div_panic': (False, 1, 0, (1004,), (0,), (0,), ()),
+	'bg_panic': (False, 1, 0, (1082,), (0,), (0,), ()),
+	'lo_ldo': (True, 6, [0, 0, 0, 0, 0, 0], (981, 982, 983, 984, 985, 986), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'pa_ldo': (True, 6, [0, 0, 0, 0, 0, 0], (973, 974, 975, 976, 977, 978), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'div_ldo': (True, 6, [0, 0, 0, 0, 0, 0], (1005, 1006, 1007, 1008, 1009, 1010), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'test_bg': (True, 6, [0, 0, 0, 0, 0, 0], (965, 966, 967, 968, 969, 970), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'mod_logic': (True, 4, [0, 1, 1, 0], (996, 997, 998, 999), (0, 1, 2, 3), (0, 0, 0, 0), ()),
+	'mod_15_4_tune': (True, 3, [1, 0, 1], (1002, 1001, 1000), (0, 1, 2), (0, 0, 0), ()),
+	'mod_15_4_tune_d': (False, 1, 0, (1003,), (0,), (0,), ()),
+	'sel_1mhz_2mhz': (False, 1, 1, (1012,), (0,), (0,), ()),
+	'pre_dyn_dummy_b': (False, 1, 0, (1013,), (0,), (0,), ()),
+	'pre_dyn_b': (True, 6, [0, 0, 0, 0, 0, 0], (1014, 1015, 1016, 1017, 1018, 1019), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'pre_dyn_en_b': (False, 1, 0, (1020,), (0,), (0,), ()),
+	'pre_2_backup_en': (False, 1, 0, (1021, 1022), (0, 0), (1, 0), ()),
+	'pre_5_backup_en': (False, 1, 1, (1023, 1024), (0, 0), (0, 1), ()),
+	'pre_dyn_sel': (False, 1, 0, (1025, 1026, 1027, 1028, 1029, 1030), None, (0, 0, 0, 0, 0, 0), (('=', 0, (1, 1, 1, 0, 0, 0)), ('=', 1, (0, 1, 1, 0, 0, 0)), ('=', 2, (1, 0, 1, 0, 0, 0)), ('=', 3, (1, 1, 0, 0, 0, 0)), ('*', 0, (1, 1, 1, 0, 0, 0)))),
+	'pre_dyn_dummy': (False, 1, 0, (1031,), (0,), (0,), ()),
+	'div_64mhz_enable': (False, 1, 0, (1032,), (0,), (0,), ()),
+	'div_20mhz_enable': (False, 1, 0, (1033,), (0,), (0,), ()),
+	'div_static_code': (True, 16, [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0], (1054, 1053, 1052, 1051, 1050, 1049, 1060, 1059, 1058, 1057, 1056, 1055, 1066, 1065, 1064, 1063), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), (1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'div_static_rst_b': (False, 1, 1, (1062,), (0,), (1,), ()),
+	'div_static_en': (False, 1, 1, (1061,), (0,), (1,), ()),
+	'dyn_div_N': (True, 13, [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0], (1079, 1078, 1077, 1076, 1075, 1074, 1073, 1072, 1071, 1070, 1069, 1068, 1067), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12), (0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'div_dynamic_en_b': (False, 1, 1, (1080,), (0,), (0,), ()),
+	'div_tune_select': (False, 1, 1, (1081,), (0,), (0,), ()),
+	'source_select_2mhz': (True, 2, [0, 0], (1083, 1084), (0, 1), (0, 0), ()),
+	'rc_2mhz_tune_coarse_1': (True, 5, [1, 1, 1, 1, 1], (1093, 1092, 1091, 1090, 1089), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'rc_2mhz_tune_coarse_2': (True, 5, [1, 1, 1, 1, 1], (1098, 1097, 1096, 1095, 1094), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'rc_2mhz_tune_coarse_3': (True, 5, [0, 0, 0, 1, 1], (1103, 1102, 1101, 1100, 1099), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'rc_2mhz_tune_fine': (True, 5, [0, 1, 1, 1, 1], (1108, 1107, 1106, 1105, 1104), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'rc_2mhz_tune_superfine': (True, 5, [0, 0, 1, 1, 0], (1113, 1112, 1111, 1110, 1109), (0, 1, 2, 3, 4), (0, 0, 0, 0, 0), ()),
+	'rc_2mhz_enable': (False, 1, 0, (1114,), (0,), (0,), ()),
+	'scan_io_reset': (False, 1, 1, (1034,), (0,), (0,), ()),
+	'scan_5mhz_select': (True, 2, [0, 0], (1035, 1036), (0, 1), (0, 0), ()),
+	'scan_1mhz_select': (True, 2, [0, 0], (1037, 1038), (0, 1), (0, 0), ()),
+	'scan_20mhz_select': (True, 2, [0, 0], (1039, 1040), (0, 1), (0, 0), ()),
+	'scan_async_bypass': (False, 1, 0, (1041,), (0,), (0,), ()),
+	'scan_mod_bypass': (False, 1, 1, (1042,), (0,), (0,), ()),
+	'scan_fine_trim': (True, 6, [1, 1, 1, 0, 0, 0], (1043, 1044, 1045, 1046, 1047, 1048), (0, 1, 2, 3, 4, 5), (0, 0, 0, 0, 0, 0), ()),
+	'scan_data_in_valid': (False, 1, 1, (1085,), (0,), (0,), ()),
+	'scan_ble_select': (False, 1, 0, (1086,), (0,), (0,), ()),
+	'sel_ble_packetassembler_clk': (False, 1, 0, (550,), (0,), (0,), ()),
+	'sel_ble_packetdisassembler_clk': (False, 1, 0, (551,), (0,), (0,), ()),
+	'sel_ble_cdr_fifo_clk': (True, 2, [0, 0], (555, 554), (0, 1), (0, 0), ()),
+	'sel_ble_arm_fifo_clk': (False, 1, 0, (556,), (0,), (0,), ()),
+	'div_symbol_clk_ble_dis': (False, 1, 1, (517,), (0,), (0,), ()),
+	'div_BLE_PDA_dis': (False, 1, 1, (518,), (0,), (0,), ()),
+	'div_EXT_CLK_GPIO2_dis': (False, 1, 1, (519,), (0,), (0,), ()),
+	'div_symbol_clk_ble_reset': (False, 1, 0, (520,), (0,), (0,), ()),
+	'div_BLE_PDA_reset': (False, 1, 0, (521,), (0,), (0,), ()),
+	'div_EXT_CLK_GPIO2_reset': (False, 1, 0, (522,), (0,), (0,), ()),
+	'div_symbol_clk_ble_PT': (False, 1, 0, (523,), (0,), (0,), ()),
+	'div_BLE_PDA_PT': (False, 1, 0, (524,), (0,), (0,), ()),
+	'div_EXT_CLK_GPIO2_PT': (False, 1, 0, (525,), (0,), (0,), ()),
+	'div_symbol_clk_ble_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (533, 532, 531, 530, 529, 528, 527, 526), (0, 1, 2, 3, 4, 5, 6, 7), (0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'div_BLE_PDA_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (541, 540, 539, 538, 537, 536, 535, 534), (0, 1, 2, 3, 4, 5, 6, 7), (0, 0, 0, 0, 0, 0, 0, 0), ()),
+	'div_EXT_CLK_GPIO2_Nin': (True, 8, [0, 0, 0, 0, 0, 0, 0, 0], (549, 548, 547, 546, 545, 544, 543, 542), (0, 1, 2, 3, 4, 5, 6, 7), (0, 0, 0, 0, 0, 0, 0, 0), ()),
+}
+
+# Chain bits with every field at its default
+DEFAULT = [0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 1, 1,
+	1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0,
+	0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1,
+	1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0,
+	1, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0]
+
+def _field(name):
+	try:
+		return FIELDS[name]
+	except KeyError:
+		raise TypeError("No scan chain field {!r}".format(name))
+
+def value_bits(name, value):
+	"""Element bits of a field value, given as construct_scan() takes it or as an integer (MSB first)."""
+	is_list, width = _field(name)[:2]
+	if not is_list:
+		return [value]
+	if isinstance(value, int):
+		return [(value >> (width - 1 - ii)) & 1 for ii in range(width)]
+	if len(value) != width:
+		raise ValueError("{} takes {} bits, got {}".format(name, width, len(value)))
+	return list(value)
+
+def _number(name, value):
+	if _field(name)[0] and not isinstance(value, int):
+		return int(''.join(map(str, value)), 2)
+	return int(value)
+
+def _chain_bits(name, value):
+	_, _, _, _, elements, inverts, rules = _field(name)
+	number = _number(name, value)
+	for op, v, bits in rules:
+		if op == '*' or (op == '=' and number == v) or (op == '>=' and number >= v):
+			return bits
+	vbits = value_bits(name, value)
+	return [vbits[e] ^ i for e, i in zip(elements, inverts)]
+
+def encode(**fields):
+	"""
+	Inputs:
+		Any arguments of the reference function, as lists of bits or
+		integers (MSB first).
+	Outputs:
+		Returns the same list of chain bits in shift order: the default
+		image with the given fields written.
+	"""
+	bits = list(DEFAULT)
+	for name, value in fields.items():
+		for p, b in zip(_field(name)[3], _chain_bits(name, value)):
+			bits[p] = b
+	return bits
+
+# The chain as one integer, position 0 in the MSB of the first byte, and per field the mask of its
+# positions and the bit of each, so encode_bytes() touches only the given fields
+_PAD = 8 * CHAIN_BYTES - CHAIN_BITS
+_DEFAULT_INT = int(''.join(map(str, DEFAULT)), 2) << _PAD
+_BITS = {}
+for _name, _field_info in FIELDS.items():
+	_shifts = [8 * CHAIN_BYTES - 1 - p for p in _field_info[3]]
+	_BITS[_name] = (sum(1 << s for s in _shifts), _shifts)
+del _name, _field_info, _shifts
+
+def encode_bytes(**fields):
+	"""Same as encode(), packed 8 bits per byte MSB first as sent to the Teensy (scan.pack_bits)."""
+	image = _DEFAULT_INT
+	for name, value in fields.items():
+		chain = _chain_bits(name, value)
+		mask, shifts = _BITS[name]
+		image &= ~mask
+		for s, b in zip(shifts, chain):
+			if b:
+				image |= 1 << s
+	return image.to_bytes(CHAIN_BYTES, 'big')
+
+def encode_batch(count, **fields):
+	"""
+	Inputs:
+		count: Integer. Number of variants.
+		fields: Arguments of the reference function. A list or integer is
+			used for every variant. A numpy array gives one value per
+			variant, either count integers (MSB first) or a (count, width)
+			array of bits.
+	Outputs:
+		Returns a (count, CHAIN_BYTES) uint8 numpy array, row k packed
+		like encode_bytes() for variant k.
+	"""
+	import numpy as np
+
+	bits = np.tile(np.array(DEFAULT, dtype=np.uint8), (count, 1))
+	for name, value in fields.items():
+		is_list, width, _, positions, elements, inverts, rules = _field(name)
+		if isinstance(value, np.ndarray) and value.ndim == 2:
+			vbits = value.astype(np.uint8)
+			numbers = vbits.astype(np.int64).dot(1 << np.arange(width - 1, -1, -1, dtype=np.int64))
+		elif isinstance(value, np.ndarray):
+			numbers = value.astype(np.int64)
+			vbits = ((numbers[:, None] >> np.arange(width - 1, -1, -1)) & 1).astype(np.uint8)
+		else:
+			vbits = np.tile(np.array(value_bits(name, value), dtype=np.uint8), (count, 1))
+			numbers = np.full(count, _number(name, value), dtype=np.int64)
+
+		if elements is not None:
+			chain = vbits[:, list(elements)] ^ np.array(inverts, dtype=np.uint8)
+		else:
+			chain = np.zeros((count, len(positions)), dtype=np.uint8)
+		# Applied last to first so the first matching rule wins
+		for op, v, rule in reversed(rules):
+			if op == '*':
+				match = np.ones(count, dtype=bool)
+			elif op == '=':
+				match = numbers == v
+			else:
+				match = numbers >= v
+			chain = np.where(match[:, None], np.array(rule, dtype=np.uint8), chain)
+		bits[:, list(positions)] = chain
+
+	return np.packbits(bits, axis=1)
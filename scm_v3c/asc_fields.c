@@ -0,0 +1,41 @@
+#include "scm3_hardware_interface.h"
+#include "asc_fields.h"
+
+// Multi-bit analog scan chain fields
+// Positions, bit order and inversions of each field come from the ASC_FIELDS table in asc_fields.py,
+// which generates asc_fields.h. A write is one masked merge into the ASC[] word(s) holding the field
+// instead of a set_asc_bit()/clear_asc_bit() call per bit.
+
+extern unsigned int ASC[38];
+
+const asc_field asc_fields[ASC_NUM_FIELDS] = { ASC_FIELD_TABLE };
+
+void asc_field_write(unsigned int field, unsigned int value) {
+
+	const asc_field* f = &asc_fields[field];
+
+	value ^= f->invert;
+	if(f->flags & ASC_FIELD_REVERSED)
+		value = reverse(value) >> (32 - f->width);
+
+	ASC[f->word] = (ASC[f->word] & ~f->mask) | ((value << f->shift) & f->mask);
+
+	// Field continues in the previous word
+	if(f->mask_hi)
+		ASC[f->word-1] = (ASC[f->word-1] & ~f->mask_hi) | ((value >> (32 - f->shift)) & f->mask_hi);
+}
+
+unsigned int asc_field_read(unsigned int field) {
+
+	const asc_field* f = &asc_fields[field];
+	unsigned int value;
+
+	value = (ASC[f->word] & f->mask) >> f->shift;
+	if(f->mask_hi)
+		value |= (ASC[f->word-1] & f->mask_hi) << (32 - f->shift);
+
+	if(f->flags & ASC_FIELD_REVERSED)
+		value = reverse(value) >> (32 - f->width);
+
+	return value ^ f->invert;
+}
@@ -0,0 +1,88 @@
+// Generated by asc_fields.py from its ASC_FIELDS table, do not edit
+
+#ifndef asc_field_map   /* Include guard */
+#define asc_field_map
+
+// A field is up to 16 contiguous scan chain bits. After inverting the 'invert' bits (and reversing
+// the bit order for ASC_FIELD_REVERSED), the value LSB is at bit 'shift' of ASC[word]; the bits that
+// do not fit continue at the bottom of ASC[word-1] (mask_hi).
+typedef struct {
+	unsigned char word;
+	unsigned char shift;
+	unsigned char width;
+	unsigned char flags;
+	unsigned int invert;
+	unsigned int mask;
+	unsigned int mask_hi;
+} asc_field;
+
+#define ASC_FIELD_REVERSED		0x1
+
+#define ASC_FIELD_GPO_ROW1	0	// ASC<245:248>
+#define ASC_FIELD_GPO_ROW2	1	// ASC<249:252>
+#define ASC_FIELD_GPO_ROW3	2	// ASC<253:256>
+#define ASC_FIELD_GPO_ROW4	3	// ASC<257:260>
+#define ASC_FIELD_GPI_ROW1	4	// ASC<261:262>
+#define ASC_FIELD_GPI_ROW2	5	// ASC<263:264>
+#define ASC_FIELD_GPI_ROW3	6	// ASC<265:266>
+#define ASC_FIELD_GPI_ROW4	7	// ASC<267:268>
+#define ASC_FIELD_ZCC_DEMOD_THRESH	8	// ASC<107:122>
+#define ASC_FIELD_ZCC_CLKDIV	9	// ASC<124:131>
+#define ASC_FIELD_ZCC_EARLY	10	// ASC<209:224>
+#define ASC_FIELD_IF_GAIN_I	11	// ASC<485:490>
+#define ASC_FIELD_IF_GAIN_Q	12	// ASC<272:277>
+#define ASC_FIELD_IF_COMP_TRIM_I_N	13	// ASC<452:456>
+#define ASC_FIELD_IF_COMP_TRIM_I_P	14	// ASC<457:461>
+#define ASC_FIELD_IF_COMP_TRIM_Q_N	15	// ASC<340:344>
+#define ASC_FIELD_IF_COMP_TRIM_Q_P	16	// ASC<335:339>
+#define ASC_FIELD_IF_RC_COARSE	17	// ASC<427:431>
+#define ASC_FIELD_IF_RC_FINE	18	// ASC<433:437>
+#define ASC_FIELD_IF_RC_HIGH_RANGE	19	// ASC<726:726>
+#define ASC_FIELD_IF_LDO	20	// ASC<492:498>
+#define ASC_FIELD_VDDD_LDO	21	// ASC<791:797>
+#define ASC_FIELD_AUX_LDO	22	// ASC<917:923>
+#define ASC_FIELD_ALWAYSON_LDO	23	// ASC<924:929>
+#define ASC_FIELD_ALWAYSON_LDO_PANIC	24	// ASC<557:557>
+#define ASC_FIELD_SYS_CLK2_COARSE_LO	25	// ASC<860:861>
+#define ASC_FIELD_SYS_CLK2_COARSE_HI	26	// ASC<875:877>
+#define ASC_FIELD_SYS_CLK2_FINE	27	// ASC<870:874>
+#define ASC_NUM_FIELDS	28
+
+// Initializer for asc_fields[] in asc_fields.c, in ASC_FIELD_* order
+#define ASC_FIELD_TABLE \
+	{ 7,  7,  4, 1, 0x00, 0x00000780, 0x00000000}, \
+	{ 7,  3,  4, 1, 0x00, 0x00000078, 0x00000000}, \
+	{ 8, 31,  4, 1, 0x00, 0x80000000, 0x00000007}, \
+	{ 8, 27,  4, 1, 0x00, 0x78000000, 0x00000000}, \
+	{ 8, 25,  2, 1, 0x00, 0x06000000, 0x00000000}, \
+	{ 8, 23,  2, 1, 0x00, 0x01800000, 0x00000000}, \
+	{ 8, 21,  2, 1, 0x00, 0x00600000, 0x00000000}, \
+	{ 8, 19,  2, 1, 0x00, 0x00180000, 0x00000000}, \
+	{ 3,  5, 16, 1, 0x00, 0x001FFFE0, 0x00000000}, \
+	{ 4, 28,  8, 1, 0x00, 0xF0000000, 0x0000000F}, \
+	{ 7, 31, 16, 1, 0x00, 0x80000000, 0x00007FFF}, \
+	{15, 21,  6, 1, 0x00, 0x07E00000, 0x00000000}, \
+	{ 8, 10,  6, 0, 0x00, 0x0000FC00, 0x00000000}, \
+	{14, 23,  5, 1, 0x00, 0x0F800000, 0x00000000}, \
+	{14, 18,  5, 1, 0x00, 0x007C0000, 0x00000000}, \
+	{10,  7,  5, 0, 0x00, 0x00000F80, 0x00000000}, \
+	{10, 12,  5, 0, 0x00, 0x0001F000, 0x00000000}, \
+	{13, 16,  5, 0, 0x00, 0x001F0000, 0x00000000}, \
+	{13, 10,  5, 0, 0x00, 0x00007C00, 0x00000000}, \
+	{22,  9,  1, 0, 0x00, 0x00000200, 0x00000000}, \
+	{15, 13,  7, 1, 0x00, 0x000FE000, 0x00000000}, \
+	{24,  2,  7, 0, 0x60, 0x000001FC, 0x00000000}, \
+	{28,  4,  7, 1, 0x60, 0x000007F0, 0x00000000}, \
+	{29, 30,  6, 0, 0x20, 0xC0000000, 0x0000000F}, \
+	{17, 18,  1, 0, 0x01, 0x00040000, 0x00000000}, \
+	{26,  2,  2, 1, 0x00, 0x0000000C, 0x00000000}, \
+	{27, 18,  3, 1, 0x07, 0x001C0000, 0x00000000}, \
+	{27, 21,  5, 1, 0x10, 0x03E00000, 0x00000000}
+
+extern const asc_field asc_fields[ASC_NUM_FIELDS];
+
+// Read-modify-write of one field in ASC[]; value bits above the field width are ignored
+void asc_field_write(unsigned int field, unsigned int value);
+unsigned int asc_field_read(unsigned int field);
+
+#endif
@@ -0,0 +1,202 @@
+"""
+Multi-bit fields of the SCM3C analog scan chain, shared by the Python
+tools and the firmware.
+
+Positions are chip scan chain positions: the index into the list returned
+by scan.construct_scan() and the argument of set_asc_bit() in the firmware.
+Each field lists the positions of its value bits LSB first, the value bits
+that are stored inverted, and the construct_scan() argument that covers the
+same bits (None where construct_scan() has no such argument or disagrees).
+
+read_asc_dump() reads the whole of ASC[] from the chip in one transfer
+(UART command 'asc').
+
+Running this file regenerates asc_fields.h for asc_field_write() and
+asc_field_read() in asc_fields.c:
+	python asc_fields.py
+"""
+
+import os
+
+from scan import read_packed, unpack_bits
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+HEADER = os.path.join(HERE, 'asc_fields.h')
+
+# Descriptor flag for fields stored LSB first
+ASC_FIELD_REVERSED = 0x1
+
+def msb_first(first, last):
+	"""Positions, LSB first, of a field stored MSB:LSB over first..last."""
+	return list(range(last, first - 1, -1))
+
+def lsb_first(first, last):
+	"""Positions, LSB first, of a field stored LSB:MSB over first..last."""
+	return list(range(first, last + 1))
+
+# (name, positions LSB first, inverted value bits, construct_scan() argument)
+ASC_FIELDS = [
+	# GPIO bank selections for each row of GPO/GPI pins
+	('GPO_ROW1', lsb_first(245, 248), 0x0, 'GPO_row1_sel'),
+	('GPO_ROW2', lsb_first(249, 252), 0x0, 'GPO_row2_sel'),
+	('GPO_ROW3', lsb_first(253, 256), 0x0, 'GPO_row3_sel'),
+	('GPO_ROW4', lsb_first(257, 260), 0x0, 'GPO_row4_sel'),
+	('GPI_ROW1', lsb_first(261, 262), 0x0, 'GPI_row1_sel'),
+	('GPI_ROW2', lsb_first(263, 264), 0x0, 'GPI_row2_sel'),
+	('GPI_ROW3', lsb_first(265, 266), 0x0, 'GPI_row3_sel'),
+	('GPI_ROW4', lsb_first(267, 268), 0x0, 'GPI_row4_sel'),
+
+	# ZCC demod
+	('ZCC_DEMOD_THRESH', lsb_first(107, 122), 0x0, 'COUNT_THRESH'),
+	('ZCC_CLKDIV', lsb_first(124, 131), 0x0, 'CLK_DIV_ext'),
+	('ZCC_EARLY', lsb_first(209, 224), 0x0, 'EARLY_DECISION_MARGIN_ext'),
+
+	# IF gain and comparator offset trims
+	('IF_GAIN_I', lsb_first(485, 490), 0x0, 'I_code_scan'),
+	('IF_GAIN_Q', msb_first(272, 277), 0x0, 'Q_code_scan'),
+	('IF_COMP_TRIM_I_N', lsb_first(452, 456), 0x0, 'I_nctrl'),
+	('IF_COMP_TRIM_I_P', lsb_first(457, 461), 0x0, 'I_pctrl'),
+	('IF_COMP_TRIM_Q_N', msb_first(340, 344), 0x0, 'Q_nctrl'),
+	('IF_COMP_TRIM_Q_P', msb_first(335, 339), 0x0, 'Q_pctrl'),
+
+	# IF RC clock
+	('IF_RC_COARSE', msb_first(427, 431), 0x0, 'RC_coarse'),
+	('IF_RC_FINE', msb_first(433, 437), 0x0, 'RC_fine'),
+	('IF_RC_HIGH_RANGE', [726], 0x0, None),
+
+	# LDO reference voltages; the panic bits are inverted
+	('IF_LDO', lsb_first(492, 498), 0x0, 'if_ldo_rdac'),
+	# construct_scan() puts vddd_bgr_tune one position higher than the firmware has always used
+	('VDDD_LDO', msb_first(791, 797), 0x60, None),
+	('AUX_LDO', lsb_first(917, 923), 0x60, 'aux_ldo_bgr_tune'),
+	('ALWAYSON_LDO', msb_first(924, 929), 0x20, 'alwayson_ldo_bgr_tune'),
+	('ALWAYSON_LDO_PANIC', [557], 0x1, None),
+
+	# 20 MHz secondary system clock: coarse<1:0>, coarse<4:2> and fine<4:0>
+	('SYS_CLK2_COARSE_LO', lsb_first(860, 861), 0x0, None),
+	('SYS_CLK2_COARSE_HI', lsb_first(875, 877), 0x7, None),
+	('SYS_CLK2_FINE', lsb_first(870, 874), 0x10, None),
+]
+
+def field_words(positions):
+	"""
+	Inputs:
+		positions: Positions of the value bits, LSB first. Must be contiguous.
+	Outputs:
+		Returns (word, shift, width, reversed, mask, mask_hi) for the C
+		descriptor. ASC position p is bit 31-(p%32) of ASC[p//32]. After
+		bit reversal (if reversed), the value LSB is at bit 'shift' of
+		ASC[word]; bits that do not fit go to the bottom of ASC[word-1].
+	Raises:
+		ValueError if the positions are not contiguous or exceed 16 bits.
+	"""
+	width = len(positions)
+	first, last = min(positions), max(positions)
+	if sorted(positions) != list(range(first, last + 1)) or width > 16:
+		raise ValueError("Field positions must be contiguous and at most 16 bits")
+	is_reversed = width > 1 and positions[0] == first
+	word = last >> 5
+	shift = 31 - (last & 31)
+	field_mask = (1 << width) - 1
+	mask = (field_mask << shift) & 0xFFFFFFFF
+	mask_hi = field_mask >> (32 - shift) if shift + width > 32 else 0
+	return word, shift, width, is_reversed, mask, mask_hi
+
+def encode_field(asc, name, value):
+	"""Writes value into field 'name' of a construct_scan() style bit list."""
+	_, positions, invert, _ = field_by_name(name)
+	value ^= invert
+	for ii, pos in enumerate(positions):
+		asc[pos] = (value >> ii) & 1
+	return asc
+
+def decode_field(asc, name):
+	"""Reads field 'name' back from a construct_scan() style bit list."""
+	_, positions, invert, _ = field_by_name(name)
+	value = 0
+	for ii, pos in enumerate(positions):
+		value |= asc[pos] << ii
+	return value ^ invert
+
+def field_by_name(name):
+	for field in ASC_FIELDS:
+		if field[0] == name:
+			return field
+	raise KeyError(name)
+
+def asc_bytes_to_bits(data):
+	"""Scan chain bits, position 0 first, of ASC[] sent MSB first as by asc_dump()."""
+	return unpack_bits(data)
+
+def read_asc_dump(uart_ser, send_command=True):
+	"""
+	Inputs:
+		uart_ser: Open serial port (or file-like object) to the SCM UART.
+		send_command: Boolean. True to send the 'asc' command first.
+	Outputs:
+		Returns the 1216 bits of ASC[] on the chip, position 0 first, as
+		sent by asc_dump() in scm3_hardware_interface.c.
+	Raises:
+		ValueError if no dump arrives or its CRC does not match.
+	"""
+	if send_command:
+		uart_ser.write(b'asc\n')
+	return asc_bytes_to_bits(read_packed(uart_ser, b'ASC'))
+
+def diff_asc(expected, actual):
+	"""Positions where two bit lists (e.g. construct_scan() and read_asc_dump()) differ."""
+	return [ii for ii in range(min(len(expected), len(actual))) if expected[ii] != actual[ii]]
+
+def generate_header():
+	"""Returns the text of asc_fields.h."""
+	lines = [
+		"// Generated by asc_fields.py from its ASC_FIELDS table, do not edit",
+		"",
+		"#ifndef asc_field_map   /* Include guard */",
+		"#define asc_field_map",
+		"",
+		"// A field is up to 16 contiguous scan chain bits. After inverting the 'invert' bits (and reversing",
+		"// the bit order for ASC_FIELD_REVERSED), the value LSB is at bit 'shift' of ASC[word]; the bits that",
+		"// do not fit continue at the bottom of ASC[word-1] (mask_hi).",
+		"typedef struct {",
+		"	unsigned char word;",
+		"	unsigned char shift;",
+		"	unsigned char width;",
+		"	unsigned char flags;",
+		"	unsigned int invert;",
+		"	unsigned int mask;",
+		"	unsigned int mask_hi;",
+		"} asc_field;",
+		"",
+		"#define ASC_FIELD_REVERSED		0x1",
+		"",
+	]
+	table = []
+	for ii, (name, positions, invert, _) in enumerate(ASC_FIELDS):
+		word, shift, width, is_reversed, mask, mask_hi = field_words(positions)
+		lines.append("#define ASC_FIELD_{}	{}	// ASC<{}:{}>".format(
+			name, ii, min(positions), max(positions)))
+		table.append("	{{{:>2}, {:>2}, {:>2}, {}, 0x{:02X}, 0x{:08X}, 0x{:08X}}}, \\".format(
+			word, shift, width, ASC_FIELD_REVERSED if is_reversed else 0, invert, mask, mask_hi))
+	lines += [
+		"#define ASC_NUM_FIELDS	{}".format(len(ASC_FIELDS)),
+		"",
+		"// Initializer for asc_fields[] in asc_fields.c, in ASC_FIELD_* order",
+		"#define ASC_FIELD_TABLE \\",
+	] + table[:-1] + [table[-1][:-3]] + [
+		"",
+		"extern const asc_field asc_fields[ASC_NUM_FIELDS];",
+		"",
+		"// Read-modify-write of one field in ASC[]; value bits above the field width are ignored",
+		"void asc_field_write(unsigned int field, unsigned int value);",
+		"unsigned int asc_field_read(unsigned int field);",
+		"",
+		"#endif",
+		"",
+	]
+	return "\n".join(lines)
+
+if __name__ == "__main__":
+	with open(HEADER, 'w') as f:
+		f.write(generate_header())
+	print("Wrote {} ({} fields)".format(HEADER, len(ASC_FIELDS)))
@@ -0,0 +1,20 @@
+// Generated by scan_layout.py from asc_layout.txt, do not edit
+
+#ifndef asc_image   /* Include guard */
+#define asc_image
+
+// Analog scan chain images as ASC[] words: position p is bit 31-(p&31) of word p>>5, as for set_asc_bit()
+#define ASC_IMAGE_BITS		1200
+#define ASC_IMAGE_WORDS		38
+
+// Every scan.construct_scan() argument at its default, e.g. unsigned int image[ASC_IMAGE_WORDS] = ASC_IMAGE_DEFAULT;
+#define ASC_IMAGE_DEFAULT { \
+	0x7F800000, 0x003FFFFF, 0xFFFFFFC0, 0x000001C0, 0x00000000, 0x00000000, \
+	0x00000022, 0x0003C300, 0x0060FFFF, 0xE3DFEFFF, 0xFF0A0060, 0x000C0912, \
+	0x24181224, 0x48400000, 0x300280FF, 0xFFE00800, 0x07000000, 0x00000000, \
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, \
+	0x0000007C, 0x00000000, 0x00000000, 0x00000000, 0x00000010, 0x00000000, \
+	0x08100000, 0x06A00805, 0x70203C7F, 0xF9E000C4, 0x7FF8F300, 0x00000000, \
+	0x00000000, 0x00000000 }
+
+#endif
@@ -0,0 +1,147 @@
+#include <string.h>
+#include "Memory_Map.h"
+#include "scm3_hardware_interface.h"
+#include "scm3C_hardware_interface.h"
+#include "asc_profile.h"
+
+// Radio mode switching with precomputed ASC profiles
+// setFrequencyRX()/setFrequencyTX() and build_channel_table() used to rebuild the mode with a few dozen
+// set_asc_bit()/clear_asc_bit() calls each time. The same bit changes are now made once here for every
+// mode; only the bits that differ between any two modes are kept (asc_profile_mask) and switching is a
+// masked copy of those words into ASC[].
+// On SCM3C the RF ISRs only pulse the scan chain load at the RX/TX turnaround; the writes that would
+// shift a mode in (analog_scan_chain_write_3B_fromFPGA() in setFrequencyRX()/setFrequencyTX()) are
+// FPGA-only and stay commented out, so selecting a profile only updates ASC[] for the next full write.
+// The LO frequency for a channel is set through ANALOG_CFG_REG__7/8 (LC_apply_cfg() with the per-channel words), not the scan chain,
+// so it does not have to be patched into the profiles.
+// The memory mapped demod settings (correlation threshold, CDR, AGC) are not in the scan chain either;
+// they are left as set by the radio_init_rx_*() function for rx_profile.
+
+extern unsigned int ASC[38];
+extern unsigned int IF_coarse;
+extern unsigned int IF_fine;
+
+unsigned int asc_profile_mask[38];
+unsigned int asc_profile_bits[ASC_NUM_PROFILES][38];
+// Indices of the words with a non-zero mask
+unsigned char asc_profile_words[38];
+unsigned int asc_profile_num_words = 0;
+unsigned short asc_profiles_ready = 0;
+unsigned int asc_rx_profile = ASC_PROFILE_RX_MF;
+
+// Same bit changes setFrequencyRX() made for RX
+void asc_rx_mode_bits(void) {
+
+	// On FPGA, have to use the chip's GPIO outputs for radio signals
+	GPO_control(2,10,1,1);
+
+	// Turn polyphase on for RX
+	set_asc_bit(971);
+
+	// Enable mixer for RX
+	clear_asc_bit(298);
+	clear_asc_bit(307);
+
+	// Analog scan chain setup for radio LDOs for RX
+	set_asc_bit(504); // = gpio_pon_en_if
+	set_asc_bit(506); // = gpio_pon_en_lo
+	clear_asc_bit(508); // = gpio_pon_en_pa
+	clear_asc_bit(514); // = gpio_pon_en_div
+}
+
+// Same bit changes setFrequencyRX() made for the TX ack
+void asc_tx_mode_bits(void) {
+
+	// Set GPIOs back
+	GPO_control(0,10,8,10);
+
+	// Turn polyphase off for TX
+	clear_asc_bit(971);
+
+	// Hi-Z mixer wells for TX
+	set_asc_bit(298);
+	set_asc_bit(307);
+
+	// Analog scan chain setup for radio LDOs for TX
+	clear_asc_bit(504); // = gpio_pon_en_if
+	set_asc_bit(506); // = gpio_pon_en_lo
+	set_asc_bit(508); // = gpio_pon_en_pa
+	clear_asc_bit(514); // = gpio_pon_en_div
+}
+
+// TX setup with no radio LDO enabled from the GPIOs
+void asc_idle_mode_bits(void) {
+
+	asc_tx_mode_bits();
+	clear_asc_bit(506); // = gpio_pon_en_lo
+	clear_asc_bit(508); // = gpio_pon_en_pa
+}
+
+// Runs the IF/demod setup for an RX profile on ASC[] and adds the RX mode bits
+void asc_build_rx(unsigned int profile) {
+
+	if(profile == ASC_PROFILE_RX_ZCC) radio_init_rx_ZCC();
+	else radio_init_rx_MF();
+
+	// Both overwrite the IF clock bits, put back the calibrated values as initialize_mote() does
+	set_IF_clock_frequency(IF_coarse, IF_fine, 0);
+
+	asc_rx_mode_bits();
+	memcpy(asc_profile_bits[profile], ASC, sizeof(ASC));
+}
+
+void asc_profiles_init(unsigned int rx_profile) {
+
+	unsigned int base[38];
+	unsigned int i, k;
+	// Only the RX profile in use is built: the other one would add its IF/demod bits to the mask,
+	// and every select would then overwrite those words
+	unsigned int used[3];
+
+	used[0] = ASC_PROFILE_IDLE;
+	used[1] = rx_profile;
+	used[2] = ASC_PROFILE_TX;
+
+	memcpy(base, ASC, sizeof(ASC));
+	asc_rx_profile = rx_profile;
+	asc_build_rx(rx_profile);
+
+	// TX and idle keep the IF setup of the RX profile in use
+	asc_tx_mode_bits();
+	memcpy(asc_profile_bits[ASC_PROFILE_TX], ASC, sizeof(ASC));
+	asc_idle_mode_bits();
+	memcpy(asc_profile_bits[ASC_PROFILE_IDLE], ASC, sizeof(ASC));
+
+	memcpy(ASC, base, sizeof(ASC));
+
+	// Keep only what differs between modes
+	asc_profile_num_words = 0;
+	for(i=0; i<38; i++) {
+		asc_profile_mask[i] = 0;
+		for(k=1; k<3; k++) {
+			asc_profile_mask[i] |= asc_profile_bits[used[k]][i] ^ asc_profile_bits[used[0]][i];
+		}
+		for(k=0; k<3; k++) {
+			asc_profile_bits[used[k]][i] &= asc_profile_mask[i];
+		}
+		if(asc_profile_mask[i]) asc_profile_words[asc_profile_num_words++] = i;
+	}
+
+	asc_profiles_ready = 1;
+}
+
+void asc_profile_select(unsigned int profile) {
+
+	unsigned int i, k;
+
+	if(asc_profiles_ready == 0) asc_profiles_init(asc_rx_profile);
+	if(profile >= ASC_NUM_PROFILES) return;
+	// The RX profile that was not built
+	if((profile == ASC_PROFILE_RX_MF || profile == ASC_PROFILE_RX_ZCC) && profile != asc_rx_profile) return;
+
+	for(k=0; k<asc_profile_num_words; k++) {
+		i = asc_profile_words[k];
+		ASC[i] = (ASC[i] & ~asc_profile_mask[i]) | asc_profile_bits[profile][i];
+	}
+}
+
@@ -0,0 +1,23 @@
+#ifndef asc_profile   /* Include guard */
+#define asc_profile
+
+// Analog scan chain profiles for the radio modes
+// Each profile holds only the ASC bits that differ between modes (mixer, polyphase, radio LDO enables,
+// GPIO banks, IF/demod setup), so switching touches a few words and keeps every other setting in ASC[],
+// including calibration done after the profiles were built. See asc_profile.c.
+#define ASC_PROFILE_IDLE			0
+#define ASC_PROFILE_RX_MF			1
+#define ASC_PROFILE_RX_ZCC		2
+#define ASC_PROFILE_TX				3
+#define ASC_NUM_PROFILES			4
+
+// Profile used for RX by setFrequencyRX()/setFrequencyTX(), set by asc_profiles_init()
+extern unsigned int asc_rx_profile;
+
+// Builds the idle, TX and rx_profile profiles from the current ASC[]; rx_profile picks the demod
+// Call once the radio is set up (end of initialize_mote()) and again after changing a mode setting
+void asc_profiles_init(unsigned int rx_profile);
+// Puts the mode bits of profile into ASC[] without programming the chip; the RX profile not built is ignored
+void asc_profile_select(unsigned int profile);
+
+#endif
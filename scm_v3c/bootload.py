@@ -1,54 +1,579 @@
 import serial
 import random
+import re
+import struct
+import time
+import zlib
 
-def program_cortex(teensy_port="COM15", uart_port="COM18", file_binary="./code.bin",
-		boot_mode='optical', skip_reset=False, insert_CRC=False,
-		pad_random_payload=False):
+# Image trailer layout, must match main.c
+# 0xFFFC = CRC over code_length bytes, 0xFFF8 = code_length
+# 0xFFF4 = block CRC info ((num_blocks << 16) | block_size), 0xFEF4 = table of block CRCs
+BLOCK_CRC_INFO_ADDR = 0xFFF4
+BLOCK_CRC_TABLE_ADDR = 0xFEF4
+BLOCK_CRC_MAX_BLOCKS = 64
+
+# Framed host to Teensy transfer, must match transfer_sram_framed() in teensy_uC_programmer.ino
+# Frame: header (sync, type, seq, offset, length), payload, crc32 of header and payload
+# Response: sync, status, seq; DATA frames are acked in order, anything else is NAKed
+# with the sequence number the Teensy expects next (go-back-N)
+XFER_HEADER = '<BBHIH'
+XFER_HEADER_SIZE = struct.calcsize(XFER_HEADER)
+XFER_RESPONSE = '<BBH'
+XFER_RESPONSE_SIZE = struct.calcsize(XFER_RESPONSE)
+XFER_SYNC = 0xA5
+XFER_RESPONSE_SYNC = 0x5A
+XFER_DATA = 0x01
+XFER_END = 0x02
+XFER_ACK = 0x00
+XFER_NAK_CRC = 0x01
+XFER_NAK_RANGE = 0x02
+XFER_END_OK = 0x03
+XFER_END_BAD = 0x04
+XFER_MAX_PAYLOAD = 1024
+
+def xfer_frame(ftype, seq, offset, payload):
+	"""
+	Inputs:
+		ftype: Integer. XFER_DATA or XFER_END.
+		seq: Integer. Frame sequence number.
+		offset: Integer. Destination offset in the Teensy ram[] for DATA,
+			total length for END.
+		payload: Bytes. Data, or the crc32 of the whole transfer for END.
+	Outputs:
+		Bytes of one frame.
+	"""
+	header = struct.pack(XFER_HEADER, XFER_SYNC, ftype, seq & 0xFFFF, offset, len(payload))
+	crc = zlib.crc32(header + payload) & 0xFFFFFFFF
+	return header + payload + crc.to_bytes(4, 'little')
+
+def teensy_transfer(teensy_ser, data, chunk_size=XFER_MAX_PAYLOAD, window=8, max_timeouts=20):
+	"""
+	Inputs:
+		teensy_ser: Open serial port to the Teensy. Its read timeout is used
+			to detect lost frames.
+		data: Bytes. Payload for the Teensy ram[], starting at offset 0.
+		chunk_size: Integer. Payload bytes per frame, at most XFER_MAX_PAYLOAD.
+		window: Integer. Frames sent ahead of the last acknowledgement.
+		max_timeouts: Integer. Give up after this many timeouts in a row.
+	Outputs:
+		Copies data into the Teensy ram[] with the framed protocol ("xfer"
+		command). Returns the number of frames that had to be re-sent.
+	Raises:
+		IOError if the Teensy stops responding or the final CRC does not match.
+	"""
+	frames = []
+	for offset in range(0, len(data), chunk_size):
+		frames.append(xfer_frame(XFER_DATA, len(frames), offset, bytes(data[offset:offset + chunk_size])))
+	crc = zlib.crc32(bytes(data)) & 0xFFFFFFFF
+	frames.append(xfer_frame(XFER_END, len(frames), len(data), crc.to_bytes(4, 'little')))
+
+	teensy_ser.write(b'xfer\n')
+
+	base = 0
+	next_frame = 0
+	rewound_to = None
+	timeouts = 0
+	resent = 0
+	while base < len(frames):
+		# Keep the window full
+		burst = b''.join(frames[next_frame:min(base + window, len(frames))])
+		if burst:
+			teensy_ser.write(burst)
+			next_frame = min(base + window, len(frames))
+
+		response = teensy_ser.read(XFER_RESPONSE_SIZE)
+		if len(response) < XFER_RESPONSE_SIZE or response[0] != XFER_RESPONSE_SYNC:
+			# Lost or garbled; start again from the oldest unacknowledged frame
+			timeouts += 1
+			if timeouts > max_timeouts:
+				raise IOError("Teensy not responding during transfer")
+			teensy_ser.reset_input_buffer()
+			resent += next_frame - base
+			next_frame = base
+			continue
+		timeouts = 0
+
+		_, status, seq = struct.unpack(XFER_RESPONSE, response)
+		if status == XFER_ACK:
+			base = max(base, seq + 1)
+		elif status in (XFER_NAK_CRC, XFER_NAK_RANGE):
+			if status == XFER_NAK_RANGE:
+				raise IOError("Frame {} does not fit in Teensy memory".format(seq))
+			base = max(base, seq)
+			# Frames after a bad one are all NAKed with the same number; rewind only once
+			if seq != rewound_to:
+				rewound_to = seq
+				resent += next_frame - seq
+				next_frame = seq
+		elif status == XFER_END_OK:
+			base = len(frames)
+		else:
+			raise IOError("Teensy CRC over the transfer does not match")
+
+		if rewound_to is not None and base > rewound_to:
+			rewound_to = None
+
+	return resent
+
+def insert_block_CRCs(bindata, code_length, block_size=1024):
+	"""
+	Inputs:
+		bindata: bytearray. Full 64kB payload, modified in place.
+		code_length: Integer. Number of bytes covered by the image CRC.
+		block_size: Integer. Bytes per block, 1024 to 4096 is sensible.
+	Outputs:
+		Returns the number of blocks. Writes one CRC per block and the
+		block info word into the image trailer so SCM can report which
+		blocks were corrupted during optical programming.
+	Raises:
+		ValueError if the code overlaps the manifest or needs too many blocks.
+	"""
+	if code_length > BLOCK_CRC_TABLE_ADDR:
+		raise ValueError("Code length {} overlaps the block CRC table at 0x{:X}".format(
+			code_length, BLOCK_CRC_TABLE_ADDR))
+
+	num_blocks = (code_length + block_size - 1) // block_size
+	if num_blocks > BLOCK_CRC_MAX_BLOCKS:
+		raise ValueError("{} blocks of {} bytes exceeds the manifest size; use larger blocks".format(
+			num_blocks, block_size))
+
+	for i in range(num_blocks):
+		start = i * block_size
+		end = min(start + block_size, code_length)
+		crc = zlib.crc32(bytes(bindata[start:end])) & 0xFFFFFFFF
+		addr = BLOCK_CRC_TABLE_ADDR + 4 * i
+		bindata[addr:addr + 4] = crc.to_bytes(4, 'little')
+
+	info = (num_blocks << 16) | block_size
+	bindata[BLOCK_CRC_INFO_ADDR:BLOCK_CRC_INFO_ADDR + 4] = info.to_bytes(4, 'little')
+
+	return num_blocks
+
+def parse_bad_blocks(line):
+	"""
+	Inputs:
+		line: Bytes or string. One line of SCM UART output.
+	Outputs:
+		List of bad block numbers if the line is a block report from
+		image_block_report(), otherwise None.
+	"""
+	if isinstance(line, bytes):
+		line = line.decode('ascii', 'replace')
+	m = re.search(r'Bad blocks:([\d ]*)\(', line)
+	if m is None:
+		return None
+	return [int(b) for b in m.group(1).split()]
+
+def repair_cortex(teensy_port="COM15", bad_blocks=(), block_size=1024, uart_port=None):
 	"""
 	Inputs:
 		teensy_port: String. Name of the COM port that the Teensy
-			is connected to.
-		uart_port: String. Name of the COM port that the UART 
-			is connected to. If None, does not attempt to connect
-			to SCM via UART.
-		file_binary: String. Path to the binary file to 
-			feed to Teensy to program SCM. This binary file shold be
-			compiled using whatever software is meant to end up 
-			on the Cortex. This group tends to compile it using Keil
-			projects.
-		boot_mode: String. 'optical' or '3wb'. The former will assume an
-			optical bootload, whereas the latter will use the 3-wire
-			bus.
-		skip_reset: Boolean. True: Skip hard reset before optical 
-			programming. False: Perform hard reset before optical programming.
-		insert_CRC: Boolean. True = insert CRC for payload integrity 
-			checking. False = do not insert CRC. Note that SCM C code 
-			must also be set up for CRC check for this to work.
-		pad_random_payload: Boolean. True = pad unused payload space with 
-			random data and check it with CRC. False = pad with zeros, do 
-			not check integrity of padding. This is useful to check for 
-			programming errors over full 64kB payload.
+			is connected to. The Teensy must still hold the image from
+			the last program_cortex() call.
+		bad_blocks: List of block numbers to re-send, as returned by
+			program_cortex().
+		block_size: Integer. Must match the block_size used when programming.
+		uart_port: String. If not None, reads SCM's response and returns the
+			blocks that are still bad.
+	Outputs:
+		Re-sends only the listed blocks over the optical link without a
+		hard reset. SCM must be waiting for a patch, which it does by itself
+		after a failed CRC check. Returns the remaining bad blocks, or None
+		if uart_port is None or SCM did not report.
+	"""
+	teensy_ser = serial.Serial(
+		port=teensy_port,
+		baudrate=19200,
+		parity=serial.PARITY_NONE,
+		stopbits=serial.STOPBITS_ONE,
+		bytesize=serial.EIGHTBITS)
+
+	uart_ser = None
+	if uart_port != None:
+		uart_ser = serial.Serial(
+			port=uart_port,
+			baudrate=19200,
+			parity=serial.PARITY_NONE,
+			stopbits=serial.STOPBITS_ONE,
+			bytesize=serial.EIGHTBITS,
+			timeout=.5)
+
+	teensy_ser.write(b'optpatch\n')
+	teensy_ser.write('{}\n'.format(block_size).encode())
+	teensy_ser.write('{}\n'.format(len(bad_blocks)).encode())
+	for block in bad_blocks:
+		teensy_ser.write('{}\n'.format(block).encode())
+	print(teensy_ser.readline())
+	teensy_ser.close()
+
+	remaining = None
+	if uart_ser != None:
+		for _ in range(10):
+			line = uart_ser.readline()
+			print(line)
+			if parse_bad_blocks(line) is not None:
+				remaining = parse_bad_blocks(line)
+				break
+		uart_ser.close()
+
+	return remaining
+
+# Compressed stage-2 boot, must match optical_loader.c
+OPTICAL_LOADER_MAGIC = 0x5CA20000
+LOADER_MAX_IMAGE = 0x7F80
+LZ_MAX_OFFSET = 4096
+LZ_MIN_MATCH = 3
+LZ_MAX_MATCH = 18
+
+# Delta reprogramming, must match optical_loader.c and the Teensy fingerprint
+OPTICAL_DELTA_MAGIC = 0x5CA30000
+DELTA_BASE_LENGTH = LOADER_MAX_IMAGE
+DELTA_MAX_RUNS = 64
+
+def compress_lzss(data):
+	"""
+	Inputs:
+		data: Bytes. Uncompressed image.
+	Outputs:
+		Bytes in the LZSS format decoded by optical_loader.c: a flag byte
+		before every 8 items (LSB first), 0 = literal byte, 1 = match of
+		two bytes holding a 12-bit offset-1 and a 4-bit length-3.
+	"""
+	out = bytearray()
+	chains = {}
+	flags_pos = 0
+	num_items = 8
+	i = 0
+
+	while i < len(data):
+		if num_items == 8:
+			flags_pos = len(out)
+			out.append(0)
+			num_items = 0
+
+		# Longest match among recent positions with the same 3-byte prefix
+		best_len, best_off = 0, 0
+		key = bytes(data[i:i + LZ_MIN_MATCH])
+		for j in reversed(chains.get(key, [])):
+			if i - j > LZ_MAX_OFFSET:
+				break
+			n = 0
+			while n < LZ_MAX_MATCH and i + n < len(data) and data[j + n] == data[i + n]:
+				n += 1
+			if n > best_len:
+				best_len, best_off = n, i - j
+				if n == LZ_MAX_MATCH:
+					break
+
+		if best_len >= LZ_MIN_MATCH:
+			out[flags_pos] |= 1 << num_items
+			out.append((best_off - 1) & 0xFF)
+			out.append((((best_off - 1) >> 4) & 0xF0) | (best_len - LZ_MIN_MATCH))
+			step = best_len
+		else:
+			out.append(data[i])
+			step = 1
+
+		for k in range(i, i + step):
+			chain = chains.setdefault(bytes(data[k:k + LZ_MIN_MATCH]), [])
+			chain.append(k)
+			if len(chain) > 64:
+				del chain[0]
+		i += step
+		num_items += 1
+
+	return bytes(out)
+
+def decompress_lzss(comp, length):
+	"""
+	Inputs:
+		comp: Bytes. Output of compress_lzss().
+		length: Integer. Uncompressed length.
+	Outputs:
+		Bytes. Reference decoder mirroring lz_byte() in optical_loader.c.
+	"""
+	out = bytearray()
+	i = 0
+	while i < len(comp) and len(out) < length:
+		flags = comp[i]
+		i += 1
+		for bit in range(8):
+			if i >= len(comp) or len(out) >= length:
+				break
+			if flags & (1 << bit):
+				offset = (((comp[i + 1] & 0xF0) << 4) | comp[i]) + 1
+				n = (comp[i + 1] & 0x0F) + LZ_MIN_MATCH
+				for _ in range(n):
+					out.append(out[-offset])
+				i += 2
+			else:
+				out.append(comp[i])
+				i += 1
+	return bytes(out)
+
+def build_stage2_stream(code):
+	"""
+	Inputs:
+		code: Bytes. Program image from Keil, without padding or trailer.
 	Outputs:
-		No return value. Feeds the input from file_binary to the Teensy to program SCM
-		and programs SCM. 
+		Bytes to be sent after the optical SFD: header words followed by
+		the compressed image, padded to a whole number of words.
 	Raises:
-		ValueError if the boot_mode isn't 'optical' or '3wb'.
-	Notes:
-		When setting optical parameters, all values can be toggled to improve
-		success when programming. In particular, too small a third value can
-		cause the optical programmer to lose/eat the short pulses.
+		ValueError if the image does not fit in the stage-2 buffer.
 	"""
-	# Open COM port to Teensy
+	image = bytearray(code)
+	image.extend(bytes(-len(image) % 4))
+	if len(image) > LOADER_MAX_IMAGE:
+		raise ValueError("Image of {} bytes exceeds the {} byte stage-2 buffer".format(
+			len(image), LOADER_MAX_IMAGE))
+
+	comp = compress_lzss(image)
+	stream = bytearray()
+	for word in (OPTICAL_LOADER_MAGIC, len(image), len(comp), zlib.crc32(bytes(image)) & 0xFFFFFFFF):
+		stream += word.to_bytes(4, 'little')
+	stream += comp
+	stream.extend(bytes(-len(stream) % 4))
+	return bytes(stream)
+
+def boot_stage2(teensy_port="COM15", uart_port="COM18", file_binary="./code.bin"):
+	"""
+	Inputs:
+		teensy_port: String. Name of the COM port that the Teensy
+			is connected to.
+		uart_port: String. Name of the COM port that the UART
+			is connected to. Used to tell SCM to wait for the image.
+		file_binary: String. Path to the binary file from Keil.
+	Outputs:
+		Sends file_binary compressed over the optical data path to an
+		already running SCM (stage 1, booted once with program_cortex()),
+		which decompresses it, checks the CRC and soft resets into it.
+		Transfer time scales with the compressed size rather than 64kB.
+	"""
+	with open(file_binary, 'rb') as f:
+		code = f.read()
+	stream = build_stage2_stream(code)
+	print("Stage 2: {} bytes compressed to {}".format(len(code), len(stream)))
+
+	uart_ser = serial.Serial(
+		port=uart_port,
+		baudrate=19200,
+		parity=serial.PARITY_NONE,
+		stopbits=serial.STOPBITS_ONE,
+		bytesize=serial.EIGHTBITS,
+		timeout=.5)
+	uart_ser.write(b'ldr\n')
+	print(uart_ser.readline())
+
 	teensy_ser = serial.Serial(
 		port=teensy_port,
 		baudrate=19200,
 		parity=serial.PARITY_NONE,
 		stopbits=serial.STOPBITS_ONE,
 		bytesize=serial.EIGHTBITS)
+	teensy_ser.write(b'optstage2\n')
+	teensy_ser.write('{}\n'.format(len(stream)).encode())
+	teensy_ser.write(stream)
+	print(teensy_ser.readline())
+	teensy_ser.close()
 
-	# Open binary file from Keil
+	# SCM reports the result and then restarts into the new image
+	for _ in range(10):
+		print(uart_ser.readline())
+	uart_ser.close()
+
+def image_fingerprint(base):
+	"""
+	Inputs:
+		base: Bytes. 64kB payload last flashed by the Teensy.
+	Outputs:
+		Integer fingerprint, same as the one reported by the Teensy
+		'fingerprint' command.
+	"""
+	return zlib.crc32(bytes(base[:DELTA_BASE_LENGTH])) & 0xFFFFFFFF
+
+def delta_runs(base, image, max_gap=8):
+	"""
+	Inputs:
+		base: Bytes. Memory contents SCM is currently running.
+		image: Bytes. New image, a whole number of words.
+		max_gap: Integer. Unchanged bytes to include rather than start a
+			new run; each run costs 8 bytes of header.
+	Outputs:
+		List of (offset, data) word-aligned runs that turn base into image.
+	"""
+	runs = []
+	start = None
+	last = None
+	for i in range(0, len(image), 4):
+		if image[i:i + 4] == base[i:i + 4]:
+			continue
+		if start is not None and i - last > max_gap:
+			runs.append((start, bytes(image[start:last])))
+			start = None
+		if start is None:
+			start = i
+		last = i + 4
+	if start is not None:
+		runs.append((start, bytes(image[start:last])))
+	return runs
+
+def build_delta_stream(base, code):
+	"""
+	Inputs:
+		base: Bytes. 64kB payload last flashed by the Teensy.
+		code: Bytes. New program image from Keil.
+	Outputs:
+		Bytes to be sent after the optical SFD: header words followed by
+		the changed runs.
+	Raises:
+		ValueError if the image does not fit in the stage-2 buffer.
+	"""
+	image = bytearray(code)
+	image.extend(bytes(-len(image) % 4))
+	if len(image) > DELTA_BASE_LENGTH:
+		raise ValueError("Image of {} bytes exceeds the {} byte stage-2 buffer".format(
+			len(image), DELTA_BASE_LENGTH))
+
+	# The Teensy has room for DELTA_MAX_RUNS run headers; merge runs until it fits
+	max_gap = 8
+	runs = delta_runs(base, image, max_gap)
+	while len(runs) > DELTA_MAX_RUNS:
+		max_gap *= 2
+		runs = delta_runs(base, image, max_gap)
+	stream = bytearray()
+	for word in (OPTICAL_DELTA_MAGIC, len(image), zlib.crc32(bytes(image)) & 0xFFFFFFFF, len(runs)):
+		stream += word.to_bytes(4, 'little')
+	for offset, data in runs:
+		stream += offset.to_bytes(4, 'little')
+		stream += (len(data) // 4).to_bytes(4, 'little')
+		stream += data
+	return bytes(stream)
+
+def apply_delta_stream(base, stream):
+	"""
+	Inputs:
+		base: Bytes. Memory contents before the delta.
+		stream: Bytes. Output of build_delta_stream().
+	Outputs:
+		Bytearray of the memory contents after SCM applies the delta
+		and copies the new image over instruction memory.
+	"""
+	words = lambda n: int.from_bytes(stream[n:n + 4], 'little')
+	mem = bytearray(base)
+	length, num_runs = words(4), words(12)
+	n = 16
+	for _ in range(num_runs):
+		offset, num_words = words(n), words(n + 4)
+		mem[offset:offset + 4 * num_words] = stream[n + 8:n + 8 + 4 * num_words]
+		n += 8 + 4 * num_words
+	return mem
+
+def delta_program(teensy_port="COM15", uart_port="COM18", file_binary="./code.bin",
+		base_file="./code_last.bin"):
+	"""
+	Inputs:
+		teensy_port: String. Name of the COM port that the Teensy
+			is connected to.
+		uart_port: String. Name of the COM port that the UART
+			is connected to. Used to tell SCM to wait for the delta.
+		file_binary: String. Path to the new binary file from Keil.
+		base_file: String. Payload saved by the last program_cortex()
+			or delta_program() call with the same base_file.
+	Outputs:
+		Sends only the words that differ from the last flashed image over
+		the optical data path to the running SCM, which patches a copy of
+		its image, checks the CRC and soft resets into it. Returns True on
+		success and saves the new image as base_file. Returns False if
+		the Teensy no longer holds the base image or SCM did not accept
+		the delta; base_file is left as it was, and since the Teensy has
+		already moved on, program_cortex() has to be used.
+	"""
+	with open(base_file, 'rb') as f:
+		base = f.read()
 	with open(file_binary, 'rb') as f:
-		bindata = bytearray(f.read())
+		code = f.read()
+
+	teensy_ser = serial.Serial(
+		port=teensy_port,
+		baudrate=19200,
+		parity=serial.PARITY_NONE,
+		stopbits=serial.STOPBITS_ONE,
+		bytesize=serial.EIGHTBITS)
+
+	# The delta is only valid against the image the Teensy last flashed
+	teensy_ser.write(b'fingerprint\n')
+	fingerprint = int(teensy_ser.readline())
+	if fingerprint != image_fingerprint(base):
+		print("Teensy fingerprint 0x{:08X} does not match {}".format(fingerprint, base_file))
+		teensy_ser.close()
+		return False
+
+	stream = build_delta_stream(base, code)
+	print("Delta: {} bytes for a {} byte image".format(len(stream), len(code)))
+
+	uart_ser = serial.Serial(
+		port=uart_port,
+		baudrate=19200,
+		parity=serial.PARITY_NONE,
+		stopbits=serial.STOPBITS_ONE,
+		bytesize=serial.EIGHTBITS,
+		timeout=.5)
+	uart_ser.write(b'dlt\n')
+	print(uart_ser.readline())
+
+	teensy_ser.write(b'optdelta\n')
+	teensy_ser.write('{}\n'.format(len(stream)).encode())
+	teensy_ser.write(stream)
+	print(teensy_ser.readline())
+	teensy_ser.close()
+
+	# SCM reports the result and then restarts into the new image
+	ok = None
+	for _ in range(10):
+		line = uart_ser.readline()
+		print(line)
+		ok = parse_loader_result(line)
+		if ok is not None:
+			break
+	uart_ser.close()
+
+	# Only an image SCM accepted can be the base of the next delta
+	if not ok:
+		print("SCM did not accept the delta, {} is unchanged".format(base_file))
+		return False
+	with open(base_file, 'wb') as f:
+		f.write(apply_delta_stream(base, stream))
+
+	return True
+
+def parse_loader_result(line):
+	"""
+	Inputs:
+		line: Bytes or string. One line of SCM UART output.
+	Outputs:
+		True if the line reports a new image that passed its checks
+		(optical_loader_poll() then boots it), False if it reports a
+		failed one, otherwise None.
+	"""
+	if isinstance(line, bytes):
+		line = line.decode('ascii', 'replace')
+	if line.startswith('New image OK'):
+		return True
+	if line.startswith('New image'):
+		return False
+	return None
+
+def build_payload(code, insert_CRC=False, pad_random_payload=False, block_size=None):
+	"""
+	Inputs:
+		code: Bytes. Binary image from Keil.
+		insert_CRC, pad_random_payload, block_size: See program_cortex().
+	Outputs:
+		Returns the full 64kB payload as a bytearray. With insert_CRC
+		the code length, the block CRC manifest and the image CRC are
+		filled in on the host, so the Teensy's insertcrc only confirms it.
+	"""
+	bindata = bytearray(code)
 
 	# Need to know how long the binary payload is for computing CRC
 	code_length = len(bindata) - 1
@@ -61,22 +586,41 @@ def program_cortex(teensy_port="COM15", uart_port="COM18", file_binary="./code.b
 			bindata.append(random.randint(0,255))
 		code_length = len(bindata) - 1 - 8
 	else:
-		for i in range(pad_length):
-			bindata.append(0)
+		bindata += bytes(pad_length)
 
 	if insert_CRC:
 	    # Insert code length at address 0x0000FFF8 for CRC calculation
 	    # Teensy will use this length value for calculating CRC
+		if block_size != None:
+			# Random padding must stop below the block CRC manifest; real code
+			# running into it is an error (insert_block_CRCs raises)
+			if pad_random_payload:
+				code_length = min(code_length, BLOCK_CRC_TABLE_ADDR)
+			insert_block_CRCs(bindata, code_length, block_size)
 		bindata[65528] = code_length % 256 
 		bindata[65529] = code_length // 256
 		bindata[65530] = 0
 		bindata[65531] = 0
-	
-	# Transfer payload to Teensy
-	teensy_ser.write(b'transfersram\n')
-	print(teensy_ser.readline())
-	# Send the binary data over uart
-	teensy_ser.write(bindata)
+
+		# Same value the Teensy computes for insertcrc
+		crc = zlib.crc32(bytes(bindata[:code_length])) & 0xFFFFFFFF
+		bindata[65532:65536] = crc.to_bytes(4, 'little')
+
+	return bindata
+
+def start_boot(teensy_ser, boot_mode='optical', skip_reset=False, insert_CRC=False,
+		optical_timing=(80, 80, 2, 80), wb_half_period_ns=None, wb_skip_bits=1):
+	"""
+	Inputs:
+		teensy_ser: Open serial port to a Teensy that holds the payload.
+		Others: See program_cortex().
+	Outputs:
+		Boots SCM from the payload in the Teensy and returns the
+		confirmation lines the Teensy printed.
+	Raises:
+		ValueError if the boot_mode isn't 'optical' or '3wb'.
+	"""
+	lines = []
 
 	if insert_CRC:
 	    # Have Teensy calculate 32-bit CRC over the code length 
@@ -86,13 +630,10 @@ def program_cortex(teensy_port="COM15", uart_port="COM18", file_binary="./code.b
 	if boot_mode == 'optical':
 	    # Configure parameters for optical TX
 		teensy_ser.write(b'configopt\n')
-		teensy_ser.write(b'80\n')
-		teensy_ser.write(b'80\n')
-		teensy_ser.write(b'2\n')
-		teensy_ser.write(b'80\n')
+		for p in optical_timing:
+			teensy_ser.write(str(p).encode() + b'\n')
 		
-	    # Encode the payload into 4B5B for optical transmission
-		teensy_ser.write(b'encode4b5b\n')
+		# The Teensy encodes the payload into 4B5B while sending it
 
 		if not skip_reset:
 	        # Do a hard reset and then optically boot
@@ -101,23 +642,145 @@ def program_cortex(teensy_port="COM15", uart_port="COM18", file_binary="./code.b
 	        # Skip the hard reset before booting
 			teensy_ser.write(b'bootopt4b5bnorst\n')
 
-	    # Display confirmation message from Teensy
-		print(teensy_ser.readline())
-		teensy_ser.write(b'opti_cal\n');
+		lines.append(teensy_ser.readline())
+		teensy_ser.write(b'opti_cal\n')
 	elif boot_mode == '3wb':
+		if wb_half_period_ns != None:
+			teensy_ser.write(b'config3wb\n')
+			teensy_ser.write(str(wb_half_period_ns).encode() + b'\n')
+			teensy_ser.write(str(wb_skip_bits).encode() + b'\n')
+
 	    # Execute 3-wire bus bootloader on Teensy
 		teensy_ser.write(b'boot3wb\n')
 
-	    # Display confirmation message from Teensy
-		print(teensy_ser.readline())
-		print(teensy_ser.readline())
+		lines.append(teensy_ser.readline())
+		lines.append(teensy_ser.readline())
 		teensy_ser.write(b'3wb_cal\n')
 	else:
 		raise ValueError("Boot mode '{}' invalid.".format(boot_mode))
 
+	return lines
+
+def read_boot_report(uart_ser, max_lines=10, stop_at_result=False):
+	"""
+	Inputs:
+		uart_ser: Open serial port to the SCM UART, opened before booting.
+		max_lines: Integer. Most lines to read.
+		stop_at_result: Boolean. Stop as soon as the CRC result (and on a
+			failure, the block report) is in instead of reading max_lines.
+	Outputs:
+		Tuple (crc_ok, bad_blocks, lines): crc_ok is True or False once SCM
+		printed its CRC check, None if it never did; bad_blocks is the list
+		from the block report or None; lines is what was read.
+	"""
+	crc_ok = None
+	bad_blocks = None
+	block_report = False
+	lines = []
+
+	for _ in range(max_lines):
+		line = uart_ser.readline()
+		lines.append(line)
+		if b'CRC OK' in line:
+			crc_ok = True
+		elif b'CRC DOES NOT MATCH' in line:
+			crc_ok = False
+		elif parse_bad_blocks(line) is not None:
+			bad_blocks = parse_bad_blocks(line)
+			block_report = True
+		elif b'No block CRC manifest' in line:
+			block_report = True
+
+		if stop_at_result and (crc_ok or (crc_ok == False and block_report)):
+			break
+
+	return crc_ok, bad_blocks, lines
+
+def program_cortex(teensy_port="COM15", uart_port="COM18", file_binary="./code.bin",
+		boot_mode='optical', skip_reset=False, insert_CRC=False,
+		pad_random_payload=False, block_size=None, base_file=None,
+		wb_half_period_ns=None, wb_skip_bits=1, optical_timing=(80, 80, 2, 80)):
+	"""
+	Inputs:
+		teensy_port: String. Name of the COM port that the Teensy
+			is connected to.
+		uart_port: String. Name of the COM port that the UART 
+			is connected to. If None, does not attempt to connect
+			to SCM via UART.
+		file_binary: String. Path to the binary file to 
+			feed to Teensy to program SCM. This binary file shold be
+			compiled using whatever software is meant to end up 
+			on the Cortex. This group tends to compile it using Keil
+			projects.
+		boot_mode: String. 'optical' or '3wb'. The former will assume an
+			optical bootload, whereas the latter will use the 3-wire
+			bus.
+		skip_reset: Boolean. True: Skip hard reset before optical 
+			programming. False: Perform hard reset before optical programming.
+		insert_CRC: Boolean. True = insert CRC for payload integrity 
+			checking. False = do not insert CRC. Note that SCM C code 
+			must also be set up for CRC check for this to work.
+		pad_random_payload: Boolean. True = pad unused payload space with 
+			random data and check it with CRC. False = pad with zeros, do 
+			not check integrity of padding. This is useful to check for 
+			programming errors over full 64kB payload.
+		block_size: Integer or None. If not None (and insert_CRC is True),
+			also insert a per-block CRC manifest so SCM can report which
+			blocks are bad. Those can then be re-sent with repair_cortex().
+		base_file: String or None. If not None, save the flashed payload
+			there as the base for later delta_program() calls.
+		wb_half_period_ns: Integer or None. 3-wire bus clock half period
+			in ns. If None, the Teensy keeps its current setting.
+		wb_skip_bits: Integer. Clocks the 3-wire bus spends on each word
+			between code_length (at least the 0x7F80 bytes a delta can
+			change) and the CRC trailer (only with insert_CRC). 32 sends
+			every word in full.
+		optical_timing: Tuple of 4 integers. Optical pulse widths p1..p4 in
+			units of 25 ns (long high, long low, short high, short low).
+			optical_sim/optical_tune finds the fastest safe setting.
+	Outputs:
+		Feeds the input from file_binary to the Teensy to program SCM
+		and programs SCM. Returns the list of bad blocks reported by SCM
+		over UART, or None if there was no block report. 
+	Raises:
+		ValueError if the boot_mode isn't 'optical' or '3wb'.
+	Notes:
+		When setting optical parameters, all values can be toggled to improve
+		success when programming. In particular, too small a third value can
+		cause the optical programmer to lose/eat the short pulses.
+	"""
+	# Open COM port to Teensy
+	teensy_ser = serial.Serial(
+		port=teensy_port,
+		baudrate=19200,
+		parity=serial.PARITY_NONE,
+		stopbits=serial.STOPBITS_ONE,
+		bytesize=serial.EIGHTBITS,
+		timeout=.5)
+
+	# Open binary file from Keil
+	with open(file_binary, 'rb') as f:
+		bindata = build_payload(f.read(), insert_CRC, pad_random_payload, block_size)
+
+	# Transfer payload to Teensy
+	start = time.time()
+	resent = teensy_transfer(teensy_ser, bindata)
+	print("Transferred {} bytes to Teensy in {:.0f} ms ({} frames re-sent)".format(
+		len(bindata), 1000 * (time.time() - start), resent))
+
+	if base_file != None:
+		with open(base_file, 'wb') as f:
+			f.write(bindata)
+
+	for line in start_boot(teensy_ser, boot_mode, skip_reset, insert_CRC, optical_timing,
+			wb_half_period_ns, wb_skip_bits):
+		# Display confirmation message from Teensy
+		print(line)
+
 	teensy_ser.close()
 
 	# Open UART connection to SCM
+	bad_blocks = None
 	if uart_port != None:
 		uart_ser = serial.Serial(
 			port=uart_port,
@@ -128,12 +791,14 @@ def program_cortex(teensy_port="COM15", uart_port="COM18", file_binary="./code.b
 			timeout=.5)
 
 		# After programming, several lines are sent from SCM over UART
-		for _ in range(10):
-			print(uart_ser.readline())
+		# A failed CRC check is followed by the list of bad blocks
+		_, bad_blocks, lines = read_boot_report(uart_ser)
+		for line in lines:
+			print(line)
 
 		uart_ser.close()
 
-	return
+	return bad_blocks
 
 if __name__ == "__main__":
 	programmer_port = "COM15"
@@ -145,5 +810,14 @@ if __name__ == "__main__":
 									boot_mode="optical",
 									skip_reset=False,
 									insert_CRC=True,
-									pad_random_payload=False,)
-	program_cortex(**program_cortex_specs)
\ No newline at end of file
+									pad_random_payload=False,
+									block_size=1024,
+									base_file="./code_last.bin",)
+	bad_blocks = program_cortex(**program_cortex_specs)
+
+	# Re-send only the corrupted blocks instead of reprogramming everything
+	for _ in range(3):
+		if not bad_blocks:
+			break
+		bad_blocks = repair_cortex(teensy_port=programmer_port, bad_blocks=bad_blocks,
+			block_size=1024, uart_port=scm_port)
\ No newline at end of file
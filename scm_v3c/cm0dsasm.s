@@ -313,11 +313,118 @@ optical_sfd_interrupt	PROC
 		MSR	PRIMASK, R0
 		
 		POP	{R0,PC}
-		
+
 			ENDP
 
+; Shifts R1 words into the analog scan chain, from R0[R1-1] down to R0[0], each LSB first
+; Used by analog_scan_chain_write() in scm3_hardware_interface.c
+; Writes ANALOG_CFG_REG__22 in the same order as the old C loop did for each bit:
+; scan_in with phi1 low (twice), phi2 high, phi2 low, phi1 high; scan_in is inverted and cfg<357> stays high
+; The register values are formed in registers instead of going through the stack, 17 cycles per bit
+; plus bus wait states (tests/m0_model.py)
+; Same writes, but the phases are several times shorter than the -O0 C loop made them. Between writes, without
+; wait states: phi1 low to phi2 high 5 cycles, phi2 high 2 cycles (400 ns at 5 MHz), phi2 low to phi1 high 3,
+; phi1 high 6. Each bus wait state adds one cycle. Set asc_shift_hold to shift with longer phases instead
+asc_shift_words	PROC
+		EXPORT	asc_shift_words
+
+		PUSH	{R4-R7,LR}
+		LDR		R2, =0x52580000			;ANALOG_CFG_REG__22
+		MOVS	R7, #0x21
+		LSLS	R1, R1, #2
+		BEQ		asc_shift_done
+		ADDS	R0, R0, R1
+asc_word_loop
+		SUBS	R0, R0, #4
+		LDR		R3, [R0]
+		MOVS	R4, #8
+asc_bit_loop
+		MOVS	R5, #1
+		ANDS	R5, R3
+		EORS	R5, R7					;R5 = scan_in (inverted) with phi1 low
+		STR		R5, [R2]
+		STR		R5, [R2]
+		ADDS	R6, R5, #4
+		STR		R6, [R2]				;phi2 high
+		STR		R5, [R2]				;phi2 low
+		ADDS	R6, R5, #2
+		STR		R6, [R2]				;phi1 high
+		LSRS	R3, R3, #1
+
+		MOVS	R5, #1
+		ANDS	R5, R3
+		EORS	R5, R7					;R5 = scan_in (inverted) with phi1 low
+		STR		R5, [R2]
+		STR		R5, [R2]
+		ADDS	R6, R5, #4
+		STR		R6, [R2]				;phi2 high
+		STR		R5, [R2]				;phi2 low
+		ADDS	R6, R5, #2
+		STR		R6, [R2]				;phi1 high
+		LSRS	R3, R3, #1
+
+		MOVS	R5, #1
+		ANDS	R5, R3
+		EORS	R5, R7					;R5 = scan_in (inverted) with phi1 low
+		STR		R5, [R2]
+		STR		R5, [R2]
+		ADDS	R6, R5, #4
+		STR		R6, [R2]				;phi2 high
+		STR		R5, [R2]				;phi2 low
+		ADDS	R6, R5, #2
+		STR		R6, [R2]				;phi1 high
+		LSRS	R3, R3, #1
+
+		MOVS	R5, #1
+		ANDS	R5, R3
+		EORS	R5, R7					;R5 = scan_in (inverted) with phi1 low
+		STR		R5, [R2]
+		STR		R5, [R2]
+		ADDS	R6, R5, #4
+		STR		R6, [R2]				;phi2 high
+		STR		R5, [R2]				;phi2 low
+		ADDS	R6, R5, #2
+		STR		R6, [R2]				;phi1 high
+		LSRS	R3, R3, #1
+		SUBS	R4, R4, #1
+		BNE		asc_bit_loop
+		SUBS	R1, R1, #4
+		BNE		asc_word_loop
+asc_shift_done
+		POP		{R4-R7,PC}
+
+		LTORG
+			ENDP
+
+; Copies R2 bytes (multiple of 4) from R0 to R1 and then soft resets
+; Used by optical_loader.c to replace the running image, so it must be copied
+; to data memory and run from there (position independent, no stack, literals kept inside)
+loader_copy_and_reset	PROC
+		EXPORT	loader_copy_and_reset
+
+		CPSID	I
+loader_copy_loop
+		LDR		R3, [R0]
+		STR		R3, [R1]
+		ADDS	R0, R0, #4
+		ADDS	R1, R1, #4
+		SUBS	R2, R2, #4
+		BNE		loader_copy_loop
+
+		DSB
+		LDR		R0, =0xE000ED0C			;Application Interrupt and Reset Control Register
+		LDR		R1, =0x05FA0004			;SYSRESETREQ
+		STR		R1, [R0]
+loader_reset_wait
+		B		loader_reset_wait
+
+		LTORG
+			ENDP
+loader_copy_and_reset_end
+		EXPORT	loader_copy_and_reset_end
+
 		ALIGN 4
-			 
+
 ; User Initial Stack & Heap
                 IF      :DEF:__MICROLIB
                 EXPORT  __initial_sp
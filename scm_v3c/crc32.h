@@ -1,7 +1,18 @@
 #ifndef crc32   /* Include guard */
 #define crc32
 
-unsigned reverse(unsigned x);
+// Size of the lookup table used by the CRC engine: 256, 16 or 0 (bitwise)
+// Override from the project defines to trade code memory for speed
+#ifndef CRC32_TABLE_SIZE
+#define CRC32_TABLE_SIZE 256
+#endif
+
+// Incremental interface: crc = crc_init(); crc = crc_update(crc, buf, len); ... result = crc_final(crc);
+unsigned int crc_init(void);
+unsigned int crc_update(unsigned int crc, unsigned char *message, unsigned int length);
+unsigned int crc_final(unsigned int crc);
+
+// One-shot crc over a whole buffer
 unsigned int crc32c(unsigned char *message, unsigned int length);
 	
 #endif 
@@ -0,0 +1,418 @@
+import os
+import select
+import struct
+import threading
+import time
+import tty
+import zlib
+
+import bootload
+import scan
+
+# Stand-in for the Teensy programmer on a Linux pseudo-terminal, so the host
+# side of bootload.py can be tested without hardware. It answers the same
+# serial commands as teensy_uC_programmer.ino for the parts that only touch
+# the Teensy itself (ram[], framed transfer, CRC insertion, fingerprint).
+# Given a FakeScum, the boot commands hand ram[] to it and it prints the
+# image check on its own UART pty like main.c does. The analog and digital
+# scan chains are modelled for the ASCII and packed scan chain commands.
+#
+# Usage:
+#	teensy = FakeTeensy()
+#	ser = open_port(teensy.port)
+#	bootload.teensy_transfer(ser, data)
+#	teensy.close()
+
+class PtyPort:
+	"""
+	Minimal stand-in for serial.Serial on a pty when pyserial is not installed.
+	"""
+	def __init__(self, path, timeout=1.0):
+		self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+		tty.setraw(self.fd)
+		self.timeout = timeout
+
+	def write(self, data):
+		view = memoryview(bytes(data))
+		while len(view):
+			n = os.write(self.fd, view)
+			view = view[n:]
+		return len(data)
+
+	def read(self, size=1):
+		out = bytearray()
+		while len(out) < size:
+			ready, _, _ = select.select([self.fd], [], [], self.timeout)
+			if not ready:
+				break
+			out += os.read(self.fd, size - len(out))
+		return bytes(out)
+
+	def readline(self):
+		out = bytearray()
+		while not out.endswith(b'\n'):
+			c = self.read(1)
+			if not c:
+				break
+			out += c
+		return bytes(out)
+
+	@property
+	def in_waiting(self):
+		ready, _, _ = select.select([self.fd], [], [], 0)
+		return 1 if ready else 0
+
+	def reset_input_buffer(self):
+		while self.in_waiting:
+			os.read(self.fd, 4096)
+
+	def close(self):
+		os.close(self.fd)
+
+def open_port(path, timeout=1.0):
+	"""
+	Inputs:
+		path: String. Serial device, e.g. FakeTeensy().port.
+		timeout: Float. Read timeout in seconds.
+	Outputs:
+		serial.Serial if pyserial is installed, otherwise a PtyPort.
+	"""
+	try:
+		import serial
+		return serial.Serial(port=path, baudrate=19200, timeout=timeout)
+	except (ImportError, AttributeError):
+		return PtyPort(path, timeout)
+
+class FakeScum:
+	"""
+	Inputs:
+		corrupt_bytes: Iterable of image addresses that get flipped when
+			booting, as if the optical link had dropped a bit there.
+	Outputs:
+		UART output of a booting SCM on a pty; the slave device path is
+		in .port and the last booted image in .image.
+	"""
+	def __init__(self, corrupt_bytes=()):
+		self.corrupt_bytes = list(corrupt_bytes)
+		self.image = None
+		self.boots = 0
+
+		self.master, slave = os.openpty()
+		tty.setraw(self.master)
+		tty.setraw(slave)
+		self.port = os.ttyname(slave)
+		self._slave = slave
+
+	def close(self):
+		os.close(self.master)
+		os.close(self._slave)
+
+	def println(self, text):
+		os.write(self.master, (str(text) + '\n').encode())
+
+	def boot(self, image):
+		"""Runs the image check from main.c on image (64kB) and prints the result."""
+		image = bytearray(image[:65536])
+		for addr in self.corrupt_bytes:
+			image[addr] ^= 0x01
+		self.image = image
+		self.boots += 1
+
+		code_length = int.from_bytes(image[0xFFF8:0xFFFC], 'little')
+		crc_value = int.from_bytes(image[0xFFFC:0x10000], 'little')
+		self.println("Initializing...")
+		self.println("-------------------")
+		if zlib.crc32(bytes(image[:code_length])) & 0xFFFFFFFF == crc_value:
+			self.println("Validating program integrity...CRC OK")
+			return
+
+		self.println("Validating program integrity...")
+		self.println("Programming Error - CRC DOES NOT MATCH - Halting Execution")
+		self.println(self.block_report(image, code_length))
+
+	def block_report(self, image, code_length):
+		info = int.from_bytes(image[bootload.BLOCK_CRC_INFO_ADDR:bootload.BLOCK_CRC_INFO_ADDR + 4], 'little')
+		num_blocks, block_size = info >> 16, info & 0xFFFF
+		if num_blocks == 0 or num_blocks > bootload.BLOCK_CRC_MAX_BLOCKS or block_size == 0:
+			return "No block CRC manifest"
+		bad = []
+		for block in range(num_blocks):
+			start = block * block_size
+			end = min(start + block_size, code_length)
+			addr = bootload.BLOCK_CRC_TABLE_ADDR + 4 * block
+			if zlib.crc32(bytes(image[start:end])) & 0xFFFFFFFF != int.from_bytes(image[addr:addr + 4], 'little'):
+				bad.append(block)
+		return "Bad blocks:{} ({} of {}, {} bytes each)".format(
+			''.join(' {}'.format(b) for b in bad), len(bad), num_blocks, block_size)
+
+class FakeTeensy:
+	"""
+	Inputs:
+		corrupt_frames: Iterable of frame sequence numbers whose payload is
+			corrupted the first time they arrive, to exercise retransmission.
+		scum: FakeScum or None. Board that the boot commands program.
+		boot_time: Float. Seconds a boot command takes, as on hardware.
+		asc_stuck: Dict of analog scan chain position (shift order) to the
+			value that position always reads back, to model a bad chain.
+		corrupt_scan_writes: Integer. Number of packed scan chain writes
+			that get a flipped bit on arrival, to exercise the CRC check.
+		scan_min_phase_ns: Integer. Shortest ASC clock phase that shifts
+			correctly; scantest fails at faster rates.
+	Outputs:
+		Runs a thread serving the programmer commands on a pty; the slave
+		device path is in .port and the programmer memory in .ram.
+	"""
+	def __init__(self, corrupt_frames=(), scum=None, boot_time=0, asc_stuck=None, corrupt_scan_writes=0,
+			scan_min_phase_ns=0):
+		self.ram = bytearray(85000)
+		self.fingerprint = 0
+		self.corrupt_frames = set(corrupt_frames)
+		self.frames_received = 0
+		self.log = []
+		self.scum = scum
+		self.boot_time = boot_time
+		self.optical_timing = None
+
+		# Scan chains: bits in the order they were shifted in, and the latched ASC
+		self.asc = [0] * scan.ASC_BITS
+		self.asc_latched = None
+		self.asc_stuck = dict(asc_stuck or {})
+		self.dsc = [(ii * 7 // 3) & 1 for ii in range(scan.DSC_BITS)]
+		self.corrupt_scan_writes = corrupt_scan_writes
+		self.scan_bytes_received = 0
+		self.scan_min_phase_ns = scan_min_phase_ns
+		self.scan_clock = (1000, 250, 1000)
+
+		self.master, slave = os.openpty()
+		tty.setraw(self.master)
+		tty.setraw(slave)
+		self.port = os.ttyname(slave)
+		self._slave = slave
+		self._buf = bytearray()
+		self._stop = False
+
+		self._thread = threading.Thread(target=self._serve, daemon=True)
+		self._thread.start()
+
+	def close(self):
+		self._stop = True
+		self._thread.join()
+		os.close(self.master)
+		os.close(self._slave)
+
+	# Serial helpers on the master side
+	def _fill(self, timeout):
+		ready, _, _ = select.select([self.master], [], [], timeout)
+		if not ready:
+			return False
+		try:
+			self._buf += os.read(self.master, 65536)
+		except OSError:
+			return False
+		return True
+
+	def read_bytes(self, size, timeout=0.05):
+		"""Like Serial.readBytes() on the Teensy: returns what arrived before the timeout."""
+		while len(self._buf) < size:
+			if not self._fill(timeout):
+				break
+		out = bytes(self._buf[:size])
+		del self._buf[:size]
+		return out
+
+	def read_line(self):
+		while b'\n' not in self._buf:
+			if self._stop:
+				return None
+			self._fill(0.05)
+		line, _, rest = bytes(self._buf).partition(b'\n')
+		self._buf = bytearray(rest)
+		return line.decode('ascii', 'replace') + '\n'
+
+	def write(self, data):
+		os.write(self.master, data)
+
+	def println(self, text):
+		self.write((str(text) + '\r\n').encode())
+
+	# Command interpreter, same strings as loop() in teensy_uC_programmer.ino
+	def _serve(self):
+		while not self._stop:
+			line = self.read_line()
+			if line is None:
+				return
+			self.log.append(line)
+			handler = self.commands().get(line)
+			if handler is not None:
+				handler()
+
+	def commands(self):
+		return {
+			"transfersram\n": self.transfer_sram,
+			"xfer\n": self.transfer_sram_framed,
+			"insertcrc\n": self.insert_crc,
+			"fingerprint\n": lambda: self.println(self.fingerprint),
+			"configopt\n": self.config_opt,
+			"config3wb\n": lambda: [self.read_line() for _ in range(2)],
+			"bootopt4b5b\n": lambda: self.boot("Optical Boot Complete"),
+			"bootopt4b5bnorst\n": lambda: self.boot("Optical Boot Complete - No Reset"),
+			"boot3wb\n": lambda: self.boot("3WB Bootload Complete"),
+			"ascwrite\n": self.asc_write,
+			"ascwriteb\n": self.asc_write_packed,
+			"ascload\n": self.asc_load,
+			"ascread\n": lambda: self.print_bits(self.asc_read_bits()),
+			"ascreadb\n": lambda: self.send_packed(b'ASC', self.asc_read_bits()),
+			"dscread\n": lambda: self.print_bits(self.dsc),
+			"dscreadb\n": lambda: self.send_packed(b'DSC', self.dsc),
+			"configscan\n": self.config_scan,
+			"scantest\n": self.scan_test,
+		}
+
+	# Scan chains, same replies as the asc_*/dsc_* functions in the sketch
+	def asc_write(self):
+		self.println("Executing ASC Write")
+		chars = self.read_bytes(scan.ASC_BITS, timeout=1)
+		self.scan_bytes_received += len(chars)
+		if len(chars) != scan.ASC_BITS or chars.strip(b'01'):
+			self.println("Error in ASC Write")
+		self.asc = [1 if c == ord('1') else 0 for c in chars.ljust(scan.ASC_BITS, b'0')]
+		self.println("ASC Write Complete")
+
+	def asc_write_packed(self):
+		self.println("Executing ASC Write")
+		num_bytes = (scan.ASC_BITS + 7) // 8
+		data = bytearray(self.read_bytes(num_bytes + 4, timeout=1))
+		self.scan_bytes_received += len(data)
+		if len(data) != num_bytes + 4:
+			self.println("Error in ASC Write: timeout")
+			return
+		if self.corrupt_scan_writes:
+			self.corrupt_scan_writes -= 1
+			data[0] ^= 0x01
+		if zlib.crc32(bytes(data[:num_bytes])) != int.from_bytes(data[num_bytes:], 'big'):
+			self.println("Error in ASC Write: CRC")
+			return
+		self.asc = scan.unpack_bits(data[:num_bytes], scan.ASC_BITS)
+		self.println("ASC Write Complete")
+
+	def asc_load(self):
+		self.println("Executing ASC Load")
+		self.asc_latched = list(self.asc)
+
+	def config_scan(self):
+		values = tuple(int(self.read_line()) for _ in range(3))
+		if min(values) > 0:
+			self.scan_clock = values
+
+	def scan_test(self):
+		# Same steps and margin as scan_test() in the sketch
+		steps = [50, 100, 200, 500, 1000, 2000, 5000, 10000, 40000]
+		for step, phase_ns in enumerate(steps):
+			passed = phase_ns >= self.scan_min_phase_ns and not self.asc_stuck
+			self.println("SCAN {} {} {}".format(phase_ns, phase_ns // 4, "PASS" if passed else "FAIL"))
+			if passed:
+				phase_ns = steps[min(step + 1, len(steps) - 1)]
+				self.scan_clock = (phase_ns, phase_ns // 4, self.scan_clock[2])
+				self.asc = [ii & 1 for ii in range(scan.ASC_BITS)]
+				self.println("SCAN RATE {} {}".format(phase_ns, phase_ns // 4))
+				return
+		self.println("SCAN TEST FAILED")
+
+	def asc_read_bits(self):
+		# The chain returns the last bit shifted in first (scan.compare_scan)
+		bits = list(self.asc)
+		for position, value in self.asc_stuck.items():
+			bits[position] = value
+		return bits[::-1]
+
+	def print_bits(self, bits):
+		self.println(''.join(map(str, bits)))
+
+	def send_packed(self, tag, bits):
+		data = scan.pack_bits(bits)
+		self.println("{} {}".format(tag.decode(), len(data)))
+		self.write(data + zlib.crc32(data).to_bytes(4, 'big'))
+
+	def transfer_sram(self):
+		self.println("Executing SRAM Transfer - SCM3B Rev 2")
+		self.ram[:65536] = self.read_bytes(65536, timeout=5)
+
+	def insert_crc(self):
+		code_length = self.ram[65528] + 256 * self.ram[65529]
+		crc = zlib.crc32(bytes(self.ram[:code_length])) & 0xFFFFFFFF
+		self.ram[65532:65536] = crc.to_bytes(4, 'little')
+
+	def config_opt(self):
+		self.optical_timing = [int(self.read_line()) for _ in range(4)]
+
+	def boot(self, message):
+		time.sleep(self.boot_time)
+		self.fingerprint = zlib.crc32(bytes(self.ram[:bootload.DELTA_BASE_LENGTH])) & 0xFFFFFFFF
+		if self.scum is not None:
+			self.scum.boot(self.ram)
+		self.println(message)
+
+	def transfer_sram_framed(self):
+		"""Receiver side of bootload.teensy_transfer(), mirrors transfer_sram_framed() on the Teensy."""
+		expected = 0
+		idle = 0
+		while not self._stop:
+			sync = self.read_bytes(1)
+			if len(sync) == 0:
+				# Give up if the host goes quiet
+				idle += 1
+				if idle > 40:
+					return
+				continue
+			idle = 0
+			if sync[0] != bootload.XFER_SYNC:
+				continue
+
+			header = sync + self.read_bytes(bootload.XFER_HEADER_SIZE - 1)
+			if len(header) < bootload.XFER_HEADER_SIZE:
+				self._respond(bootload.XFER_NAK_CRC, expected)
+				continue
+			_, ftype, seq, offset, length = struct.unpack(bootload.XFER_HEADER, header)
+			if length > bootload.XFER_MAX_PAYLOAD:
+				self._respond(bootload.XFER_NAK_CRC, expected)
+				continue
+
+			rest = self.read_bytes(length + 4)
+			if len(rest) < length + 4:
+				self._respond(bootload.XFER_NAK_CRC, expected)
+				continue
+			payload, crc = rest[:length], int.from_bytes(rest[length:], 'little')
+
+			self.frames_received += 1
+			if seq in self.corrupt_frames and length:
+				self.corrupt_frames.discard(seq)
+				payload = bytes([payload[0] ^ 0xFF]) + payload[1:]
+
+			if zlib.crc32(header + payload) & 0xFFFFFFFF != crc or seq != expected:
+				self._respond(bootload.XFER_NAK_CRC, expected)
+				continue
+
+			if ftype == bootload.XFER_DATA:
+				if offset + length > len(self.ram):
+					self._respond(bootload.XFER_NAK_RANGE, expected)
+					continue
+				self.ram[offset:offset + length] = payload
+				self._respond(bootload.XFER_ACK, seq)
+				expected += 1
+			elif ftype == bootload.XFER_END:
+				total_crc = zlib.crc32(bytes(self.ram[:offset])) & 0xFFFFFFFF
+				ok = total_crc == int.from_bytes(payload, 'little')
+				self._respond(bootload.XFER_END_OK if ok else bootload.XFER_END_BAD, seq)
+				return
+
+	def _respond(self, status, seq):
+		self.write(struct.pack(bootload.XFER_RESPONSE, bootload.XFER_RESPONSE_SYNC, status, seq))
+
+if __name__ == "__main__":
+	teensy = FakeTeensy()
+	print("Fake Teensy on {}, Ctrl-C to stop".format(teensy.port))
+	try:
+		while True:
+			threading.Event().wait(1)
+	except KeyboardInterrupt:
+		teensy.close()
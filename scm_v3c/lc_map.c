@@ -0,0 +1,58 @@
+#include "lc_map.h"
+
+// LC_monotonic() code to LO DAC register mapping without division
+// The M0 has no divider, so the /155 and /25 splits of the LC code were library calls on every channel
+// change and calibration step. For codes up to LC_CODE_FAST_MAX they are done as multiply and shift by
+// the rounded up reciprocals, which give the exact quotient over that range (tests/lc_map_host.c
+// checks every code against the original). The DAC codes are bit reversed into the register layout
+// with a table instead of three flipChar() calls.
+
+// Coarse/mid split of LC_monotonic(), see there for the boards these fit
+#define LC_COARSE_DIVS		155
+#define LC_MID_DIVS			25
+
+// floor(x/155) == (x*LC_COARSE_RECIP) >> 24 for x <= LC_CODE_FAST_MAX
+#define LC_COARSE_RECIP		108241
+// floor(r/25) == (r*LC_MID_RECIP) >> 10 for r < 155
+#define LC_MID_RECIP		41
+
+// 5-bit bit reversal
+static const unsigned char rev5[32] = {
+	0x00, 0x10, 0x08, 0x18, 0x04, 0x14, 0x0C, 0x1C, 0x02, 0x12, 0x0A, 0x1A, 0x06, 0x16, 0x0E, 0x1E,
+	0x01, 0x11, 0x09, 0x19, 0x05, 0x15, 0x0D, 0x1D, 0x03, 0x13, 0x0B, 0x1B, 0x07, 0x17, 0x0F, 0x1F
+};
+
+unsigned int LC_dac_cfg(int coarse, int mid, int fine) {
+	
+	unsigned int fine_r = rev5[fine & 0x1F];
+	
+	// ACFG_LO_ADDR   = [ f1 | f2 | f3 | f4 | md | m0 | m1 | m2 | m3 | m4 | cd | c0 | c1 | c2 | c3 | c4 ]
+	// ACFG_LO_ADDR_2 = [ xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | fd | f0 ]
+	return rev5[coarse & 0x1F] | (rev5[mid & 0x1F] << 6) | ((fine_r & 0xF) << 12) | ((fine_r >> 4) << 16);
+}
+
+unsigned int LC_code_cfg(int LC_code) {
+	
+	unsigned int coarse, rem, mid, fine;
+	
+	if((unsigned int)LC_code > LC_CODE_FAST_MAX) {
+		// Out of the reciprocal's range (or negative), same arithmetic as LC_monotonic() always did
+		coarse = (unsigned int)(LC_code/LC_COARSE_DIVS + 19);
+		LC_code = LC_code % LC_COARSE_DIVS;
+		mid = (unsigned int)((LC_code/LC_MID_DIVS)*3);
+		fine = (unsigned int)(LC_code % LC_MID_DIVS);
+	}
+	else {
+		coarse = ((unsigned int)LC_code * LC_COARSE_RECIP) >> 24;
+		rem = (unsigned int)LC_code - coarse*LC_COARSE_DIVS;
+		coarse += 19;
+		mid = (rem * LC_MID_RECIP) >> 10;
+		fine = rem - mid*LC_MID_DIVS;
+		mid *= 3;
+	}
+	
+	// Fine codes above 15 skip one
+	if((fine & 0xFF) > 15) fine++;
+	
+	return LC_dac_cfg(coarse, mid, fine);
+}
@@ -0,0 +1,18 @@
+#ifndef lc_map   /* Include guard */
+#define lc_map
+
+// LO frequency settings as register words
+// A setting is held as one word, ANALOG_CFG_REG__7 in bits 15:0 and ANALOG_CFG_REG__8 in bits 31:16,
+// so retuning is two stores (LC_apply_cfg() in scm3C_hardware_interface.c). See lc_map.c.
+#define LC_CFG_REG7(cfg)	((cfg) & 0xFFFF)
+#define LC_CFG_REG8(cfg)	((cfg) >> 16)
+
+// LC codes up to this are mapped without dividing
+#define LC_CODE_FAST_MAX	0x7FFF
+
+// Words LC_FREQCHANGE(coarse, mid, fine) writes
+unsigned int LC_dac_cfg(int coarse, int mid, int fine);
+// Words LC_monotonic(LC_code) writes
+unsigned int LC_code_cfg(int LC_code);
+
+#endif
@@ -0,0 +1,137 @@
+"""
+Host side of the firmware's deferred logging (log_ring.c).
+
+Interrupt handlers on the chip queue binary records instead of calling
+printf(), and the main loop sends them as frames:
+	"LOG <num_bytes> <drops>\n", num_bytes of records, CRC-32 MSB first
+Each record is a format id byte, the RF timer count and the arguments
+(4 bytes each, MSB first). The formats come from the LOG_FORMATS list in
+log_ring.h, so the text printed here is what the firmware used to print.
+
+Print the UART output with the log records turned back into text:
+	python log_decode.py COM5 [--timestamps]
+"""
+
+import os
+import re
+import struct
+import sys
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+HEADER = os.path.join(HERE, 'log_ring.h')
+
+FORMAT_RE = re.compile(r'LOG_FORMAT\((\w+),\s*"((?:[^"\\]|\\.)*)",\s*(\d+)\)')
+CONVERSION_RE = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?([diuxXc%])')
+
+def load_formats(path=HEADER):
+	"""
+	Inputs:
+		path: String. Header holding the LOG_FORMATS list.
+	Outputs:
+		Returns a list, indexed by format id, of (name, format, number of
+		arguments) with the C escapes in format resolved.
+	"""
+	with open(path) as f:
+		text = f.read()
+	formats = []
+	for name, fmt, nargs in FORMAT_RE.findall(text):
+		fmt = fmt.encode('latin-1').decode('unicode_escape')
+		formats.append((name, fmt, int(nargs)))
+	return formats
+
+def format_record(fmt, args):
+	"""printf() of fmt with 32-bit int arguments, as the firmware's C library would."""
+	values = []
+	for conversion in CONVERSION_RE.findall(fmt):
+		if conversion == '%':
+			continue
+		value = args[len(values)]
+		if conversion in 'di':
+			value = value - (1 << 32) if value & 0x80000000 else value
+		elif conversion == 'c':
+			value = chr(value & 0xFF)
+		values.append(value)
+	return fmt.replace('%u', '%d') % tuple(values)
+
+def decode_records(data, formats):
+	"""
+	Inputs:
+		data: Bytes. Records of one LOG frame.
+		formats: List from load_formats().
+	Outputs:
+		Returns a list of (RF timer count, text) per record.
+	Raises:
+		ValueError if a record has an unknown format id or is cut short.
+	"""
+	records = []
+	pos = 0
+	while pos < len(data):
+		fmt_id = data[pos]
+		if fmt_id >= len(formats):
+			raise ValueError("Unknown log format id {} at byte {}".format(fmt_id, pos))
+		_, fmt, nargs = formats[fmt_id]
+		end = pos + 5 + 4 * nargs
+		if end > len(data):
+			raise ValueError("Log record cut short at byte {}".format(pos))
+		words = struct.unpack('>{}I'.format(nargs + 1), data[pos + 1:end])
+		records.append((words[0], format_record(fmt, words[1:])))
+		pos = end
+	return records
+
+def decode_stream(ser, formats=None, timestamps=False, idle=False):
+	"""
+	Inputs:
+		ser: Open serial port (or file-like object) to the SCM UART.
+		formats: List from load_formats(), read from log_ring.h if None.
+		timestamps: Boolean. Start each log line with its RF timer count.
+		idle: Boolean. Yield None when a read returns nothing (a timeout)
+			and keep going, instead of stopping.
+	Outputs:
+		Yields the UART output as text, one line at a time, with LOG frames
+		replaced by their records' text. A line reports records the
+		firmware dropped since the previous frame; a corrupted frame is
+		reported and skipped. Stops at the end of the input.
+		Keep one generator per port: a new one would lose the rest of a
+		frame and report the drops again.
+	"""
+	if formats is None:
+		formats = load_formats()
+	drops = 0
+	while True:
+		line = ser.readline()
+		if not line:
+			if not idle:
+				return
+			yield None
+			continue
+		if not line.startswith(b'LOG '):
+			yield line.decode('latin-1')
+			continue
+
+		fields = line.split()
+		num_bytes, total_drops = int(fields[1]), int(fields[2])
+		data = ser.read(num_bytes + 4)
+		if len(data) != num_bytes + 4 or \
+				zlib.crc32(data[:num_bytes]) != int.from_bytes(data[num_bytes:], 'big'):
+			yield "log: bad frame of {} bytes\n".format(num_bytes)
+			continue
+		if total_drops != drops:
+			yield "log: {} records dropped\n".format(total_drops - drops)
+			drops = total_drops
+		for timestamp, text in decode_records(data[:num_bytes], formats):
+			yield "[{:10d}] {}".format(timestamp, text) if timestamps else text
+
+if __name__ == "__main__":
+	import serial
+
+	if len(sys.argv) < 2:
+		print(__doc__)
+		sys.exit(1)
+	uart = serial.Serial(port=sys.argv[1], baudrate=19200, timeout=None)
+	try:
+		for text in decode_stream(uart, timestamps='--timestamps' in sys.argv[2:]):
+			sys.stdout.write(text)
+			sys.stdout.flush()
+	finally:
+		uart.close()
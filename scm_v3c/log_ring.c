@@ -0,0 +1,90 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include "log_ring.h"
+#include "crc32.h"
+#include "spsc.h"
+
+#ifndef LOG_TIMESTAMP
+#include "Memory_Map.h"
+#define LOG_TIMESTAMP()		RFTIMER_REG__COUNTER
+#endif
+
+// Deferred logging
+// printf() from an ISR holds the interrupt for as long as the UART takes to send the line, a few ms per
+// line at 19200 baud, which throws off the radio timing. log_event() instead stores a record of
+// 1 + 4 + 4*nargs bytes: the format id, the RF timer count, then the arguments, all MSB first.
+// The record bytes are kept exactly as sent, so log_drain() only has to add a header line and a CRC:
+//   "LOG <num_bytes> <drops>\n", num_bytes of records, CRC-32 of the records MSB first
+// (the same framing as asc_dump()). Formatting is left to log_decode.py.
+// The ISRs are the only producer: they all run at the default NVIC priority, so they do not preempt
+// each other. The main loop is the only consumer. log_event() only publishes a record by storing
+// log_head after writing it, and log_drain() only frees space by storing log_tail (spsc.h).
+
+#define LOG_RING_MASK		(LOG_RING_BYTES - 1)
+
+unsigned char log_buffer[LOG_RING_BYTES];
+volatile unsigned int log_head = 0;
+volatile unsigned int log_tail = 0;
+volatile unsigned int log_drops = 0;
+
+#define LOG_FORMAT(id, format, nargs) nargs,
+static const unsigned char log_nargs[LOG_NUM_FORMATS] = { LOG_FORMATS };
+#undef LOG_FORMAT
+
+// retarget.c
+int uart_out(int ch);
+
+static unsigned int log_put_word(unsigned int at, unsigned int word) {
+	log_buffer[at & LOG_RING_MASK] = word >> 24;
+	log_buffer[(at + 1) & LOG_RING_MASK] = word >> 16;
+	log_buffer[(at + 2) & LOG_RING_MASK] = word >> 8;
+	log_buffer[(at + 3) & LOG_RING_MASK] = word;
+	return at + 4;
+}
+
+void log_event(unsigned int id, ...) {
+	
+	va_list args;
+	unsigned int nargs = log_nargs[id];
+	unsigned int head = log_head;
+	unsigned int i;
+	
+	if(SPSC_SPACE(head, log_tail, LOG_RING_BYTES) < 5 + 4*nargs) {
+		log_drops++;
+		return;
+	}
+	
+	log_buffer[head & LOG_RING_MASK] = id;
+	head = log_put_word(head + 1, LOG_TIMESTAMP());
+	va_start(args, id);
+	for(i=0; i<nargs; i++)
+		head = log_put_word(head, va_arg(args, unsigned int));
+	va_end(args);
+	
+	log_head = head & LOG_RING_MASK;
+}
+
+void log_drain(void) {
+	
+	unsigned int tail = log_tail;
+	unsigned int num_bytes = SPSC_COUNT(log_head, tail, LOG_RING_BYTES);
+	unsigned int first = LOG_RING_BYTES - tail;
+	unsigned int crc, i;
+	
+	if(num_bytes == 0)
+		return;
+	
+	// The records may wrap around the end of the buffer
+	if(first > num_bytes)
+		first = num_bytes;
+	crc = crc_update(crc_init(), &log_buffer[tail], first);
+	crc = crc_final(crc_update(crc, &log_buffer[0], num_bytes - first));
+	
+	printf("LOG %u %u\n", num_bytes, log_drops);
+	for(i=0; i<num_bytes; i++)
+		uart_out(log_buffer[(tail + i) & LOG_RING_MASK]);
+	for(i=0; i<4; i++)
+		uart_out(crc >> (24 - (i << 3)));
+	
+	log_tail = (tail + num_bytes) & LOG_RING_MASK;
+}
@@ -0,0 +1,40 @@
+#ifndef log_ring   /* Include guard */
+#define log_ring
+
+// Deferred logging for interrupt handlers
+// An ISR calls log_event() with a format id and its int arguments; the record (id, RF timer count,
+// arguments) goes into a ring buffer and the main loop sends the records to the UART in binary frames
+// (log_drain()). log_decode.py on the host formats them with the strings below. See log_ring.c.
+
+// Ring size in bytes, a power of two
+#define LOG_RING_BYTES		1024
+#if (LOG_RING_BYTES & (LOG_RING_BYTES - 1)) != 0
+#error LOG_RING_BYTES must be a power of two
+#endif
+// Most arguments a record can have
+#define LOG_MAX_ARGS		6
+
+// Record formats: LOG_FORMAT(id, printf format, number of arguments)
+// The chip only stores the id; log_decode.py reads this list, so keep one entry per line and only add at the end
+#define LOG_FORMATS \
+	LOG_FORMAT(LOG_RF_TX_DONE,			"IF=%d, LQI=%d, CDR=%d, len=%d, SFD=%d, LC=%d\n", 6) \
+	LOG_FORMAT(LOG_RF_BAD_CRC,			"bad crc\n", 0) \
+	LOG_FORMAT(LOG_ADC_DATA,			"%d\n", 1) \
+	LOG_FORMAT(LOG_RFTIMER_COMPARE,		"COMPARE%d MATCH\n", 1) \
+	LOG_FORMAT(LOG_RFTIMER_CAPTURE,		"CAPTURE%d TRIGGERED AT: 0x%x\n", 2) \
+	LOG_FORMAT(LOG_RFTIMER_OVERFLOW,	"CAPTURE%d OVERFLOW AT: 0x%x\n", 2) \
+	LOG_FORMAT(LOG_GPIO_INTERRUPT,		"External Interrupt GPIO%d triggered\n", 1)
+
+#define LOG_FORMAT(id, format, nargs) id,
+enum { LOG_FORMATS LOG_NUM_FORMATS };
+#undef LOG_FORMAT
+
+// Records lost because the ring was full, also sent in each frame header
+extern volatile unsigned int log_drops;
+
+// From interrupt handlers only: queues a record with the arguments of format id
+void log_event(unsigned int id, ...);
+// From the main loop: sends everything queued as one "LOG <num_bytes> <drops>" frame, does nothing if empty
+void log_drain(void);
+
+#endif
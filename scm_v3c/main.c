@@ -14,6 +14,11 @@
 #include "bucket_o_functions.h"
 #include <math.h>
 #include "scum_radio_bsp.h"
+#include "crc32.h"
+#include "optical_loader.h"
+#include "rx_ring.h"
+#include "log_ring.h"
+#include "uart_cmd.h"
 #include "test_code.h"
 #include "./sensor_adc/adc_test.h"
 
@@ -26,6 +31,8 @@ extern unsigned int ASC[38];
 #define crc_value         (*((unsigned int *) 0x0000FFFC))
 #define code_length       (*((unsigned int *) 0x0000FFF8))
 
+// Per-block CRC manifest: block_crc_info and BLOCK_CRC_TABLE_ADDR in optical_loader.h
+
 // Target LC freq = 2.405G
 // Divide ratio is currently 480
 unsigned int LC_target = 501042; 
@@ -52,35 +59,139 @@ unsigned int num_packets_to_test = 1;
 unsigned short optical_cal_iteration = 0;
 unsigned short optical_cal_finished = 0;
 
+// Image validation is done in chunks so that it does not hold up startup
+// It is drained from the idle loops below; execution halts if the CRC does not match
+#define IMAGE_CRC_CHUNK_BYTES 1024
+unsigned int image_crc;
+unsigned int image_crc_offset;
+unsigned short image_crc_done = 0;
+
+unsigned int image_block_report(void);
+
 unsigned short doing_initial_packet_search;
 unsigned short current_RF_channel;
 unsigned short do_debug_print = 0;
 
+//////////////////////////////////////////////////////////////////
+// Received Packets
+//////////////////////////////////////////////////////////////////
+
+// Handles the packets RF_ISR queued in the RX ring, outside interrupt context
+// Call from the main loop
+void rx_packet_poll(void) {
+	rx_packet* rx;
+	
+	while((rx = rx_ring_peek()) != 0) {
+		if(do_debug_print)
+			printf("RX len=%d, crc=%d, IF=%d, LQI=%d, CDR=%d, SFD=%d\n",rx->length,rx->crc_ok,rx->if_estimate,rx->lqi,rx->cdr_tau,rx->sfd_timestamp);
+		rx_ring_release();
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+// Image Validation
+//////////////////////////////////////////////////////////////////
+
+void image_crc_start(void) {
+	image_crc = crc_init();
+	image_crc_offset = 0;
+	image_crc_done = 0;
+}
+
+// Runs the CRC over the next chunk of the program image
+// Call repeatedly from idle/wait loops; does nothing once the whole image has been checked
+void image_crc_poll(void) {
+	unsigned int num_bytes;
+	
+	if(image_crc_done) return;
+	
+	num_bytes = code_length - image_crc_offset;
+	if(num_bytes > IMAGE_CRC_CHUNK_BYTES) num_bytes = IMAGE_CRC_CHUNK_BYTES;
+	
+	image_crc = crc_update(image_crc, (unsigned char *)image_crc_offset, num_bytes);
+	image_crc_offset += num_bytes;
+	
+	if(image_crc_offset < code_length) return;
+	
+	image_crc_done = 1;
+
+	if(crc_final(image_crc) == crc_value){
+		printf("CRC OK\n");
+	}
+	else {
+		printf("\nProgramming Error - CRC DOES NOT MATCH - Halting Execution\n");
+		image_block_report();
+		
+		// Wait for the bad blocks to be re-sent over the optical link (bootload.py repair_cortex)
+		// then check the whole image again
+		while(1) {
+			optical_patch_arm();
+			while(optical_patch_done == 0) {
+				uart_cmd_poll();
+			}
+			
+			if(image_block_report() == 0) {
+				image_crc_start();
+				return;
+			}
+		}
+	}
+}
+
+// Checks each block of the image against the manifest and prints the failing block numbers
+// Returns the number of bad blocks
+unsigned int image_block_report(void) {
+	unsigned int *block_crcs = (unsigned int *)BLOCK_CRC_TABLE_ADDR;
+	unsigned int num_blocks = block_crc_info >> 16;
+	unsigned int block_size = block_crc_info & 0xFFFF;
+	unsigned int num_bad = 0;
+	unsigned int block, start, num_bytes;
+	
+	if(num_blocks == 0 || num_blocks > BLOCK_CRC_MAX_BLOCKS || block_size == 0) {
+		printf("No block CRC manifest\n");
+		return 0;
+	}
+	
+	// A patch block with a bad CRC or a refused header leaves its block bad, so it also shows up below
+	if(optical_patch_errors)
+		printf("Patch errors: %d\n", optical_patch_errors);
+	
+	printf("Bad blocks:");
+	for(block = 0; block < num_blocks; block++) {
+		start = block * block_size;
+		num_bytes = code_length - start;
+		if(num_bytes > block_size) num_bytes = block_size;
+		
+		if(crc32c((unsigned char *)start, num_bytes) != block_crcs[block]) {
+			printf(" %d", block);
+			num_bad++;
+		}
+	}
+	printf(" (%d of %d, %d bytes each)\n", num_bad, num_blocks, block_size);
+	
+	return num_bad;
+}
+
 //////////////////////////////////////////////////////////////////
 // Main Function
 //////////////////////////////////////////////////////////////////
 
 int main(void) {
 	int t;
-	unsigned int calc_crc;
 	
 	// Set up mote configuration
 	printf("Initializing...");
 	initialize_mote();
 	
+	// Received packets go to the first RX ring slot
+	DMA_REG__RF_RX_ADDR = rx_ring_init();
+	
 	// Check CRC
+	// The image is validated in the background from the idle loops below,
+	// so calibration and radio setup do not have to wait for it
 	printf("\n-------------------\n");
 	printf("Validating program integrity..."); 
-	
-	calc_crc = crc32c(0x0000,code_length);
-
-	if(calc_crc == crc_value){
-		printf("CRC OK\n");
-	}
-	else {
-		printf("\nProgramming Error - CRC DOES NOT MATCH - Halting Execution\n");
-		while(1);
-	}
+	image_crc_start();
 	
 	if (0) {
 		printf("Calibrating frequencies...\n");
@@ -90,7 +201,11 @@ int main(void) {
 		ISER = 0x0800;
 		
 		// Wait for optical cal to finish
-		while(optical_cal_finished == 0) {}
+		while(optical_cal_finished == 0) {
+			image_crc_poll();
+			uart_cmd_poll();
+			log_drain();
+		}
 		optical_cal_finished = 0;
 
 		printf("Cal complete\n");
@@ -100,6 +215,11 @@ int main(void) {
 
 
 	while(1) {
+		image_crc_poll();
+		optical_loader_poll();
+		rx_packet_poll();
+		uart_cmd_poll();
+		log_drain();
 		for(t=0; t<10000; t++);
 	}
 }
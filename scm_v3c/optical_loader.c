@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <string.h>
+#include "Memory_Map.h"
+#include "crc32.h"
+#include "optical_loader.h"
+#include "uart_tx.h"
+
+// Two-stage optical boot
+// The running program acts as stage 1: it receives an LZSS-compressed stage-2 image over the
+// optical SFD/OPTICAL_32_ISR data path, decompresses it into data memory while it arrives,
+// checks its CRC and then copies it over instruction memory and soft resets into it.
+// Only the compressed bytes go over the optical link, so load time scales with the real code
+// size instead of the full 64kB the hardware bootloader needs.
+//
+// Word stream after the SFD (see bootload.py compress_lzss / boot_stage2):
+//   OPTICAL_LOADER_MAGIC, image length in bytes, compressed length in bytes, crc32 of image,
+//   then the compressed bytes packed little-endian into words
+//
+// Delta reprogramming uses the same path (see bootload.py build_delta_stream / delta_program):
+// the running image is first copied into the buffer (UART command "dlt"), then the stream
+//   OPTICAL_DELTA_MAGIC, image length in bytes, crc32 of image, number of runs,
+//   then per run: byte offset, num_words, data words
+// overwrites only the changed words before the same CRC check and copy, so reprogramming
+// time tracks the size of the change.
+//
+// Compressed format: a flag byte precedes every 8 items, LSB first; 0 = literal byte,
+// 1 = match of two bytes b0, b1: offset = ((b1 & 0xF0) << 4 | b0) + 1, length = (b1 & 0x0F) + 3
+
+// Must match main.c / bootload.py
+#define LOADER_CRC_VALUE				(*((unsigned int *) 0x0000FFFC))
+#define LOADER_CODE_LENGTH			(*((unsigned int *) 0x0000FFF8))
+#define LOADER_BLOCK_CRC_INFO		(*((unsigned int *) 0x0000FFF4))
+
+#define LOADER_STATE_LENGTH			0
+#define LOADER_STATE_COMP_LENGTH	1
+#define LOADER_STATE_CRC				2
+#define LOADER_STATE_DATA				3
+#define LOADER_STATE_DONE				4
+#define DELTA_STATE_LENGTH			5
+#define DELTA_STATE_CRC					6
+#define DELTA_STATE_RUNS				7
+#define DELTA_STATE_OFFSET			8
+#define DELTA_STATE_WORDS				9
+#define DELTA_STATE_DATA				10
+
+#define LZ_FLAGS				0
+#define LZ_ITEM					1
+#define LZ_MATCH				2
+
+// In cm0dsasm.s
+extern void loader_copy_and_reset(unsigned int src, unsigned int dst, unsigned int num_bytes);
+extern unsigned char loader_copy_and_reset_end;
+
+unsigned short loader_state;
+unsigned short loader_received = 0;
+unsigned int loader_image_length;
+unsigned int loader_comp_length;
+unsigned int loader_image_crc;
+unsigned int loader_comp_count;
+unsigned int loader_out_count;
+unsigned int loader_errors;
+unsigned int delta_runs_left;
+unsigned int delta_words_left;
+unsigned int *delta_addr;
+
+unsigned char lz_state;
+unsigned char lz_flags;
+unsigned char lz_flag_count;
+unsigned char lz_match_lo;
+
+void optical_loader_start(void) {
+	loader_state = LOADER_STATE_LENGTH;
+	loader_received = 0;
+	loader_comp_count = 0;
+	loader_out_count = 0;
+	loader_errors = 0;
+	lz_state = LZ_FLAGS;
+}
+
+void optical_delta_prepare(void) {
+	memcpy((void *)LOADER_IMAGE_ADDR, (void *)0x0, LOADER_MAX_IMAGE);
+}
+
+void optical_delta_start(void) {
+	optical_loader_start();
+	loader_state = DELTA_STATE_LENGTH;
+}
+
+// Decodes one compressed byte into the image buffer
+void lz_byte(unsigned char data) {
+
+	unsigned char *out = (unsigned char *)LOADER_IMAGE_ADDR;
+	unsigned int offset, length;
+
+	if(lz_state == LZ_FLAGS) {
+		lz_flags = data;
+		lz_flag_count = 8;
+		lz_state = LZ_ITEM;
+		return;
+	}
+
+	if(lz_state == LZ_ITEM && (lz_flags & 0x1)) {
+		// First byte of a match
+		lz_match_lo = data;
+		lz_state = LZ_MATCH;
+		return;
+	}
+
+	if(lz_state == LZ_ITEM) {
+		if(loader_out_count < loader_image_length) out[loader_out_count++] = data;
+		else loader_errors++;
+	} else {
+		offset = (((data & 0xF0) << 4) | lz_match_lo) + 1;
+		length = (data & 0x0F) + 3;
+		if(offset > loader_out_count || loader_out_count + length > loader_image_length) {
+			loader_errors++;
+		} else {
+			// Byte by byte since a match may overlap its own output (runs)
+			while(length--) {
+				out[loader_out_count] = out[loader_out_count - offset];
+				loader_out_count++;
+			}
+		}
+	}
+
+	// Item complete, move to the next flag
+	lz_flags >>= 1;
+	lz_state = (--lz_flag_count == 0) ? LZ_FLAGS : LZ_ITEM;
+}
+
+unsigned int optical_loader_word(unsigned int word) {
+
+	unsigned int ii;
+
+	switch(loader_state) {
+		case LOADER_STATE_LENGTH:
+			loader_image_length = word;
+			loader_state = LOADER_STATE_COMP_LENGTH;
+			break;
+
+		case LOADER_STATE_COMP_LENGTH:
+			loader_comp_length = word;
+			loader_state = LOADER_STATE_CRC;
+			break;
+
+		case LOADER_STATE_CRC:
+			loader_image_crc = word;
+			if(loader_image_length == 0 || loader_image_length > LOADER_MAX_IMAGE || (loader_image_length & 0x3)) {
+				loader_errors++;
+				loader_state = LOADER_STATE_DONE;
+				loader_received = 1;
+				return 1;
+			}
+			loader_state = LOADER_STATE_DATA;
+			break;
+
+		case LOADER_STATE_DATA:
+			for(ii=0; ii<4 && loader_comp_count < loader_comp_length; ii++) {
+				lz_byte(word & 0xFF);
+				word >>= 8;
+				loader_comp_count++;
+			}
+			if(loader_comp_count == loader_comp_length) {
+				loader_state = LOADER_STATE_DONE;
+				loader_received = 1;
+				return 1;
+			}
+			break;
+
+		case DELTA_STATE_LENGTH:
+			loader_image_length = word;
+			loader_state = DELTA_STATE_CRC;
+			break;
+
+		case DELTA_STATE_CRC:
+			loader_image_crc = word;
+			loader_state = DELTA_STATE_RUNS;
+			break;
+
+		case DELTA_STATE_RUNS:
+			delta_runs_left = word;
+			if(loader_image_length == 0 || loader_image_length > LOADER_MAX_IMAGE || (loader_image_length & 0x3)) {
+				loader_errors++;
+				loader_state = LOADER_STATE_DONE;
+			} else {
+				loader_state = word ? DELTA_STATE_OFFSET : LOADER_STATE_DONE;
+			}
+			break;
+
+		case DELTA_STATE_OFFSET:
+			delta_addr = (unsigned int *)(LOADER_IMAGE_ADDR + word);
+			loader_state = DELTA_STATE_WORDS;
+			break;
+
+		case DELTA_STATE_WORDS:
+			delta_words_left = word;
+			if(((unsigned int)delta_addr & 0x3) || (unsigned int)(delta_addr + word) > LOADER_IMAGE_ADDR + loader_image_length) {
+				loader_errors++;
+				loader_state = LOADER_STATE_DONE;
+			} else if(word) {
+				loader_state = DELTA_STATE_DATA;
+			} else {
+				loader_state = (--delta_runs_left == 0) ? LOADER_STATE_DONE : DELTA_STATE_OFFSET;
+			}
+			break;
+
+		case DELTA_STATE_DATA:
+			*delta_addr++ = word;
+			loader_comp_count += 4;
+			if(--delta_words_left == 0) {
+				loader_state = (--delta_runs_left == 0) ? LOADER_STATE_DONE : DELTA_STATE_OFFSET;
+			}
+			break;
+
+		default:
+			return 1;
+	}
+
+	// A delta is applied in place, so the whole image is there once the last run is in
+	if(loader_state == LOADER_STATE_DONE) {
+		loader_comp_length = loader_comp_count;
+		loader_out_count = loader_image_length;
+		loader_received = 1;
+		return 1;
+	}
+
+	return 0;
+}
+
+void optical_loader_poll(void) {
+
+	unsigned int crc, tramp_length, ii;
+	void (*copy_and_reset)(unsigned int, unsigned int, unsigned int);
+
+	if(loader_received == 0) return;
+	loader_received = 0;
+
+	if(loader_errors || loader_out_count != loader_image_length) {
+		printf("New image decode failed (%d of %d bytes)\n", loader_out_count, loader_image_length);
+		return;
+	}
+
+	crc = crc32c((unsigned char *)LOADER_IMAGE_ADDR, loader_image_length);
+	if(crc != loader_image_crc) {
+		printf("New image CRC failed: 0x%X != 0x%X\n", crc, loader_image_crc);
+		return;
+	}
+
+	// The copy routine overwrites instruction memory, so run it from data memory
+	tramp_length = (unsigned int)&loader_copy_and_reset_end - ((unsigned int)loader_copy_and_reset & ~0x1);
+	if(tramp_length > LOADER_IMAGE_ADDR + 0x8000 - LOADER_TRAMPOLINE_ADDR) {
+		printf("New image not booted: loader copy routine too large\n");
+		return;
+	}
+
+	printf("New image OK (%d bytes from %d), booting\n", loader_image_length, loader_comp_length);
+
+	// Wait for print to complete
+	uart_tx_flush();
+	for(ii=0; ii<10000; ii++);
+
+	// New trailer so the image check after reset covers the new image; no block manifest
+	LOADER_CODE_LENGTH = loader_image_length;
+	LOADER_CRC_VALUE = loader_image_crc;
+	LOADER_BLOCK_CRC_INFO = 0;
+
+	memcpy((void *)LOADER_TRAMPOLINE_ADDR, (void *)((unsigned int)loader_copy_and_reset & ~0x1), tramp_length);
+
+	copy_and_reset = (void (*)(unsigned int, unsigned int, unsigned int))(LOADER_TRAMPOLINE_ADDR | 0x1);
+	// No interrupt may run while the vectors and handlers are being overwritten; the RF timer runs from
+	// boot (initialize_mote()) and may still have COMPARE7 armed
+	__disable_irq();
+	copy_and_reset(LOADER_IMAGE_ADDR, 0x0, loader_image_length);
+}
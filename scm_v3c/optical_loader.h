@@ -0,0 +1,34 @@
+#ifndef optical_loader   /* Include guard */
+#define optical_loader
+
+// Header word of a compressed stage-2 image, shares the optical patch receiver in Int_Handlers.h
+#define OPTICAL_LOADER_MAGIC		0x5CA20000
+// Header word of a delta against the running image
+#define OPTICAL_DELTA_MAGIC			0x5CA30000
+
+// Optional per-block CRC manifest inserted by bootload.py below the length/CRC words
+// block_crc_info = (number of blocks << 16) | block size in bytes; zero if no manifest
+// The table holds one CRC per block starting at address 0, code must end below BLOCK_CRC_TABLE_ADDR
+#define block_crc_info    (*((unsigned int *) 0x0000FFF4))
+#define BLOCK_CRC_TABLE_ADDR  0x0000FEF4
+#define BLOCK_CRC_MAX_BLOCKS  64
+
+// Stage-2 image is decompressed into the upper half of data memory
+// The copy routine is placed at LOADER_TRAMPOLINE_ADDR just above it
+// The project's IRAM1 is only the lower half (0x20000000, size 0x8000 in code.uvprojx), so the linker
+// places all data, the heap and the stack below LOADER_IMAGE_ADDR and fails the link if they do not fit
+#define LOADER_IMAGE_ADDR				0x20008000
+#define LOADER_MAX_IMAGE				0x7F80
+#define LOADER_TRAMPOLINE_ADDR	0x2000FF80
+
+// Called from optical_patch_word() after the header word
+void optical_loader_start(void);
+void optical_delta_start(void);
+// Copies the running image into the buffer as the base for a delta; call before arming
+void optical_delta_prepare(void);
+// Feeds one received word to the decompressor, returns 1 once the transfer is complete
+unsigned int optical_loader_word(unsigned int word);
+// Call from the main loop; checks a completed transfer and boots it
+void optical_loader_poll(void);
+
+#endif
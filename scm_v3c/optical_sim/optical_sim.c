@@ -0,0 +1,235 @@
+#include <math.h>
+#include <string.h>
+#include "optical_sim.h"
+#include "../teensy_uC_programmer/encoder_4b5b.h"
+
+// See optical_sim.h for what is modelled
+
+#define CAL_PULSES			16
+
+// {169, 176, 167, 50} sent LSB first, as it lands in a right-shifting register
+#define START_WORD			0x32A7B0A9
+
+#define RX_SETTLE				0
+#define RX_CAL					1
+#define RX_HUNT					2
+#define RX_SKIP					3
+#define RX_DATA					4
+#define RX_DONE					5
+
+static const unsigned char start_symbol[4] = {169, 176, 167, 50};
+
+// 5-bit code to nibble, 0xFF for codes the encoder never sends
+static unsigned char decode_4b5b[32];
+
+struct rx_state {
+	const struct optical_rx_params *rx;
+	const unsigned char *image;
+	struct optical_sim_result *result;
+	unsigned int rand;
+	int state;
+	int count;
+	int cal_sum;
+	double threshold_ns;
+	unsigned int shift;
+	unsigned int code;
+	int code_bits;
+	int nibble;
+	unsigned int out_count;
+	double pending_rise, pending_fall;
+	int pending;
+};
+
+void optical_rx_defaults(struct optical_rx_params *rx) {
+	rx->sample_ns = 50;
+	rx->min_high_ns = 100;
+	rx->min_low_ns = 200;
+	rx->stretch_ns = 50;
+	rx->jitter_ns = 20;
+	rx->settle_pulses = 64;
+}
+
+static int p_to_ticks(int p) {
+	int ticks = p * SIM_NS_PER_P * SIM_F_BUS_MHZ / 1000;
+	return ticks < SIM_MIN_TICKS ? SIM_MIN_TICKS : ticks;
+}
+
+double optical_p_to_ns(int p) {
+	return p_to_ticks(p) * 1000.0 / SIM_F_BUS_MHZ;
+}
+
+int optical_min_p(void) {
+	int p = 1;
+	while (p * SIM_NS_PER_P * SIM_F_BUS_MHZ / 1000 < SIM_MIN_TICKS) p++;
+	return p;
+}
+
+// Uniform in [-1, 1)
+static double noise(struct rx_state *s) {
+	s->rand ^= s->rand << 13;
+	s->rand ^= s->rand >> 17;
+	s->rand ^= s->rand << 5;
+	return s->rand / 2147483648.0 - 1.0;
+}
+
+static void slack(struct rx_state *s, double ns) {
+	if (ns < s->result->slack_ns) s->result->slack_ns = ns;
+}
+
+static void rx_byte(struct rx_state *s, int value) {
+	if (s->out_count < SIM_IMAGE_BYTES) {
+		if (value < 0 || value != s->image[s->out_count]) s->result->bytes_bad++;
+		s->out_count++;
+	}
+	if (s->out_count == SIM_IMAGE_BYTES) s->state = RX_DONE;
+}
+
+// Decoder, runs once per pulse that made it through the front end
+static void rx_pulse(struct rx_state *s, double rise, double fall) {
+	double width = fall - rise;
+	int samples = (int)((width + s->rx->sample_ns * (noise(s) + 1) / 2) / s->rx->sample_ns);
+	int bit, nibble;
+
+	switch (s->state) {
+		case RX_SETTLE:
+			if (++s->count == s->rx->settle_pulses) {
+				s->count = 0;
+				s->state = RX_CAL;
+			}
+			return;
+
+		case RX_CAL:
+			s->cal_sum += samples;
+			if (++s->count == CAL_PULSES) {
+				s->threshold_ns = (double)s->cal_sum * s->rx->sample_ns / CAL_PULSES;
+				s->state = RX_HUNT;
+			}
+			return;
+
+		case RX_DONE:
+			return;
+	}
+
+	bit = samples * CAL_PULSES >= s->cal_sum;
+	// One receiver clock of uncertainty in where the pulse is measured
+	slack(s, fabs(width - s->threshold_ns) - s->rx->sample_ns);
+
+	switch (s->state) {
+		case RX_HUNT:
+			s->shift = (s->shift >> 1) | ((unsigned int)bit << 31);
+			if (s->shift == START_WORD) {
+				s->result->start_found = 1;
+				s->count = SIM_REBOOT_BYTES * 8;
+				s->state = RX_SKIP;
+			}
+			break;
+
+		case RX_SKIP:
+			if (--s->count == 0) {
+				s->code = 0;
+				s->code_bits = 0;
+				s->nibble = -1;
+				s->state = RX_DATA;
+			}
+			break;
+
+		case RX_DATA:
+			s->code |= bit << s->code_bits;
+			if (++s->code_bits < 5) break;
+
+			nibble = decode_4b5b[s->code];
+			s->code = 0;
+			s->code_bits = 0;
+			if (s->nibble == -1) {
+				// Low nibble first, remember a bad code as -2
+				s->nibble = nibble == 0xFF ? -2 : nibble;
+			} else {
+				rx_byte(s, (s->nibble < 0 || nibble == 0xFF) ? -1 : (nibble << 4) | s->nibble);
+				s->nibble = -1;
+			}
+			break;
+	}
+}
+
+// Front end, runs once per transmitted pulse
+static void rx_edge_pair(struct rx_state *s, double rise, double fall) {
+	if (fall - rise < s->rx->min_high_ns) {
+		s->result->lost_pulses++;
+		return;
+	}
+	if (s->pending && rise - s->pending_fall < s->rx->min_low_ns) {
+		s->result->lost_pulses++;
+		if (fall > s->pending_fall) s->pending_fall = fall;
+		return;
+	}
+	if (s->pending) {
+		if (s->state > RX_CAL) slack(s, rise - s->pending_fall - s->rx->min_low_ns);
+		rx_pulse(s, s->pending_rise, s->pending_fall);
+	}
+	if (s->state > RX_CAL) slack(s, fall - rise - s->rx->min_high_ns);
+	s->pending_rise = rise;
+	s->pending_fall = fall;
+	s->pending = 1;
+}
+
+// Transmitter: same bit order and pulse widths as opt_next_bit() / opt_fill() on the Teensy
+static void tx_bits(struct rx_state *s, const unsigned char *data, unsigned char fill, unsigned int num_bytes,
+	const double *high_ns, const double *low_ns, double *t) {
+
+	unsigned int ii;
+	int jj, bit;
+	double j = s->rx->jitter_ns;
+
+	for (ii = 0; ii < num_bytes; ii++) {
+		unsigned char value = data ? data[ii] : fill;
+		for (jj = 0; jj < 8; jj++) {
+			bit = (value >> jj) & 0x1;
+			rx_edge_pair(s, *t + j * noise(s), *t + high_ns[bit] + s->rx->stretch_ns + j * noise(s));
+			*t += high_ns[bit] + low_ns[bit];
+		}
+	}
+}
+
+void optical_sim_boot(const unsigned char *image, const int *p, const struct optical_rx_params *rx,
+	unsigned int seed, struct optical_sim_result *result) {
+
+	struct rx_state s;
+	struct encoder_4b5b enc;
+	unsigned char group[5];
+	double high_ns[2], low_ns[2], t = 0;
+	int ii, jj;
+
+	for (ii = 0; ii < 32; ii++) decode_4b5b[ii] = 0xFF;
+	for (ii = 0; ii < 16; ii++) decode_4b5b[table_4b5b[ii] & 0x1F] = ii;
+
+	high_ns[1] = optical_p_to_ns(p[0]);
+	low_ns[1] = optical_p_to_ns(p[1]);
+	high_ns[0] = optical_p_to_ns(p[2]);
+	low_ns[0] = optical_p_to_ns(p[3]);
+
+	memset(&s, 0, sizeof(s));
+	memset(result, 0, sizeof(*result));
+	result->slack_ns = 1e9;
+	s.rx = rx;
+	s.image = image;
+	s.result = result;
+	s.rand = seed * 2654435761u + 12345;
+	if (s.rand == 0) s.rand = 1;
+	s.state = rx->settle_pulses > 0 ? RX_SETTLE : RX_CAL;
+
+	// bootload_opt_4b5b()
+	tx_bits(&s, NULL, 0x55, SIM_PREAMBLE_LENGTH, high_ns, low_ns, &t);
+	tx_bits(&s, start_symbol, 0, 4, high_ns, low_ns, &t);
+	tx_bits(&s, NULL, 0x55, SIM_REBOOT_BYTES, high_ns, low_ns, &t);
+	encoder_4b5b_start(&enc, image);
+	for (ii = 0; ii < SIM_IMAGE_BYTES / 4; ii++) {
+		for (jj = 0; jj < 5; jj++) group[jj] = encoder_4b5b_next(&enc);
+		tx_bits(&s, group, 0, 5, high_ns, low_ns, &t);
+	}
+	tx_bits(&s, NULL, 0xFF, SIM_TAIL_BYTES, high_ns, low_ns, &t);
+
+	if (s.pending) rx_pulse(&s, s.pending_rise, s.pending_fall);
+
+	result->bytes_bad += SIM_IMAGE_BYTES - s.out_count;
+	result->duration_ns = t;
+}
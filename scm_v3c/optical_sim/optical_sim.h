@@ -0,0 +1,54 @@
+#ifndef optical_sim   /* Include guard */
+#define optical_sim
+
+// Host-side model of the optical bootload link, used by optical_tune.c to pick p1..p4
+//
+// Transmitter: the edge schedule bootload_opt_4b5b() in teensy_uC_programmer.ino plays out of its
+// FTM3/DMA pulse engine, with the same tick rounding and minimum pulse width.
+// Receiver: a model of the SCuM optical front end and decoder, not a netlist. Pulses shorter than
+// min_high_ns are eaten, gaps shorter than min_low_ns merge their neighbours, and every surviving
+// high pulse is measured in sample_ns clock periods. The 0x55 preamble sets the 1/0 threshold to
+// the mean of CAL_PULSES pulse widths once settle_pulses have passed. The decoder then looks for the
+// start symbol, skips REBOOT_BYTES of preamble and 4B5B decodes the image.
+// The receiver numbers are guesses until measured on a board, which is why they are parameters.
+
+// Must match teensy_uC_programmer.ino
+#define SIM_F_BUS_MHZ				60
+#define SIM_NS_PER_P				25
+#define SIM_MIN_TICKS				20
+#define SIM_PREAMBLE_LENGTH	100
+#define SIM_REBOOT_BYTES		200
+#define SIM_TAIL_BYTES			75
+#define SIM_IMAGE_BYTES			65536
+
+struct optical_rx_params {
+	double sample_ns;			// Receiver clock period used to measure pulse widths
+	double min_high_ns;		// Shorter light pulses do not make it through the front end
+	double min_low_ns;		// Shorter dark gaps do not make it through the front end
+	double stretch_ns;		// Front end fall time, added to every light pulse
+	double jitter_ns;			// Every edge moves by up to +-jitter_ns
+	int settle_pulses;		// Preamble pulses before the threshold is measured
+};
+
+struct optical_sim_result {
+	int start_found;			// Start symbol seen after calibration
+	unsigned int bytes_bad;	// Decoded image bytes that differ, including missing ones
+	unsigned int lost_pulses;	// Pulses eaten or merged by the front end
+	double slack_ns;			// Smallest distance of any edge from causing a wrong decision
+	double duration_ns;		// Length of the whole transmission
+};
+
+// Default receiver model
+void optical_rx_defaults(struct optical_rx_params *rx);
+
+// Teensy pulse width in ns for a configopt value, with the pulse engine's rounding
+double optical_p_to_ns(int p);
+
+// Smallest configopt value that is not rounded up to SIM_MIN_TICKS
+int optical_min_p(void);
+
+// Sends image[SIM_IMAGE_BYTES] with p[0..3] = p1..p4 through the link, seed picks the jitter
+void optical_sim_boot(const unsigned char *image, const int *p, const struct optical_rx_params *rx,
+	unsigned int seed, struct optical_sim_result *result);
+
+#endif
@@ -0,0 +1,128 @@
+// Finds the fastest optical pulse widths (configopt p1..p4) that still boot through the link model
+// in optical_sim.c with margin, for bootload.py program_cortex(optical_timing=...)
+//
+// Build: cc -O2 optical_tune.c optical_sim.c -o optical_tune -lm
+// Usage: optical_tune [options] code.bin           tune, starting from 80 80 2 80
+//        optical_tune [options] -c p1 p2 p3 p4 code.bin   only check those values
+// Options (ns): -j jitter, -m margin, -s receiver sample period, -h minimum light pulse,
+//               -l minimum dark gap, -t pulse stretch; -n trials per candidate, -p settle pulses
+// Prints "p1 p2 p3 p4 boot_ms" of the result; exits 1 if no safe setting was found
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "optical_sim.h"
+
+static unsigned char image[SIM_IMAGE_BYTES];
+static struct optical_rx_params rx;
+static double margin_ns = 50;
+static int trials = 4;
+
+// Returns 1 if p decodes without errors and with margin in every trial, duration in *ms
+static int safe(const int *p, double *ms, int verbose) {
+	struct optical_sim_result result;
+	int trial;
+
+	for (trial = 0; trial < trials; trial++) {
+		optical_sim_boot(image, p, &rx, trial, &result);
+		if (verbose) {
+			printf("trial %d: start %s, %u bad bytes, %u lost pulses, slack %.0f ns\n", trial,
+				result.start_found ? "found" : "missed", result.bytes_bad, result.lost_pulses, result.slack_ns);
+		}
+		if (!result.start_found || result.bytes_bad || result.slack_ns < margin_ns) return 0;
+	}
+	*ms = result.duration_ns / 1e6;
+	return 1;
+}
+
+// Coordinate descent: lower each width in turn as far as it stays safe, until nothing moves
+static int tune(int *p, double *ms) {
+	int ii, lo, hi, mid, round, moved, start;
+	double mid_ms;
+
+	// Widen everything until the starting point works
+	for (ii = 0; !safe(p, ms, 0); ii++) {
+		if (ii == 6) return 0;
+		for (lo = 0; lo < 4; lo++) p[lo] *= 2;
+	}
+
+	for (round = 0, moved = 1; moved && round < 8; round++) {
+		moved = 0;
+		for (ii = 0; ii < 4; ii++) {
+			// Invariant: p[ii] = hi is safe, anything below lo is not worth trying
+			start = p[ii];
+			lo = optical_min_p();
+			hi = p[ii];
+			while (lo < hi) {
+				mid = (lo + hi) / 2;
+				p[ii] = mid;
+				if (safe(p, &mid_ms, 0)) {
+					hi = mid;
+					*ms = mid_ms;
+				} else {
+					lo = mid + 1;
+				}
+			}
+			p[ii] = hi;
+			if (hi != start) moved = 1;
+		}
+	}
+	return safe(p, ms, 0);
+}
+
+int main(int argc, char **argv) {
+	int p[4] = {80, 80, 2, 80};
+	int check = 0, ii;
+	double ms;
+	FILE *f;
+
+	optical_rx_defaults(&rx);
+
+	for (ii = 1; ii < argc - 1; ii++) {
+		if (strcmp(argv[ii], "-c") == 0 && ii + 4 < argc - 1) {
+			check = 1;
+			p[0] = atoi(argv[++ii]);
+			p[1] = atoi(argv[++ii]);
+			p[2] = atoi(argv[++ii]);
+			p[3] = atoi(argv[++ii]);
+		}
+		else if (strcmp(argv[ii], "-j") == 0) rx.jitter_ns = atof(argv[++ii]);
+		else if (strcmp(argv[ii], "-m") == 0) margin_ns = atof(argv[++ii]);
+		else if (strcmp(argv[ii], "-s") == 0) rx.sample_ns = atof(argv[++ii]);
+		else if (strcmp(argv[ii], "-h") == 0) rx.min_high_ns = atof(argv[++ii]);
+		else if (strcmp(argv[ii], "-l") == 0) rx.min_low_ns = atof(argv[++ii]);
+		else if (strcmp(argv[ii], "-t") == 0) rx.stretch_ns = atof(argv[++ii]);
+		else if (strcmp(argv[ii], "-n") == 0) trials = atoi(argv[++ii]);
+		else if (strcmp(argv[ii], "-p") == 0) rx.settle_pulses = atoi(argv[++ii]);
+		else {
+			printf("Unknown option %s\n", argv[ii]);
+			return 2;
+		}
+	}
+	if (argc < 2) {
+		printf("Usage: optical_tune [-c p1 p2 p3 p4] [-j -m -s -h -l -t ns] [-n trials] [-p pulses] code.bin\n");
+		return 2;
+	}
+
+	// Zero padded to 64kB like program_cortex()
+	f = fopen(argv[argc - 1], "rb");
+	if (f == NULL) {
+		printf("Cannot open %s\n", argv[argc - 1]);
+		return 2;
+	}
+	fread(image, 1, SIM_IMAGE_BYTES, f);
+	fclose(f);
+
+	if (check) {
+		if (!safe(p, &ms, 1)) {
+			printf("FAIL\n");
+			return 1;
+		}
+	} else if (!tune(p, &ms)) {
+		printf("No safe setting found\n");
+		return 1;
+	}
+
+	printf("%d %d %d %d %.1f\n", p[0], p[1], p[2], p[3], ms);
+	return 0;
+}
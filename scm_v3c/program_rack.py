@@ -0,0 +1,136 @@
+import concurrent.futures
+import time
+
+import serial
+
+import bootload
+
+# Programs a rack of Teensy/SCM pairs at the same time instead of one by one.
+# Each board runs the same steps as bootload.program_cortex() in its own thread:
+# open both ports, transfer the payload, boot, then wait for the image check on
+# the SCM UART. Payloads are built (padding, block manifest, CRC) on a separate
+# pool, so boards already open their ports while that is going on, and one board's
+# transfer overlaps with the others' boots. Serial reads block in the OS, so
+# threads are enough here.
+#
+# Usage:
+#	results = program_boards([("COM15", "COM18"), ("COM21", "COM22")], file_binary="./code.bin")
+#	print_results(results)
+
+def open_serial(port):
+	return serial.Serial(
+		port=port,
+		baudrate=19200,
+		parity=serial.PARITY_NONE,
+		stopbits=serial.STOPBITS_ONE,
+		bytesize=serial.EIGHTBITS,
+		timeout=.5)
+
+def load_payload(file_binary, insert_CRC, block_size):
+	with open(file_binary, 'rb') as f:
+		return bootload.build_payload(f.read(), insert_CRC, False, block_size)
+
+def program_board(teensy_port, uart_port, payload, open_port, boot_options, uart_lines):
+	"""
+	Inputs:
+		teensy_port, uart_port: Strings. Ports of one board, uart_port may be None.
+		payload: concurrent.futures.Future of the 64kB payload.
+		open_port: Function taking a port name and returning an open serial port.
+		boot_options: Dictionary of keyword arguments for bootload.start_boot().
+		uart_lines: Integer. Most UART lines to read while waiting for the CRC result.
+	Outputs:
+		Dictionary with the ports, crc_ok (True, False or None if SCM never
+		reported), bad_blocks, resent frames, UART lines, error (None or
+		the exception text) and seconds taken.
+	"""
+	result = dict(teensy_port=teensy_port, uart_port=uart_port, crc_ok=None,
+		bad_blocks=None, resent=0, lines=[], error=None, seconds=0)
+	start = time.time()
+	teensy_ser = None
+	uart_ser = None
+
+	try:
+		teensy_ser = open_port(teensy_port)
+		# Open before booting so none of the boot output is missed
+		if uart_port != None:
+			uart_ser = open_port(uart_port)
+
+		result['resent'] = bootload.teensy_transfer(teensy_ser, payload.result())
+		bootload.start_boot(teensy_ser, **boot_options)
+
+		if uart_ser != None:
+			result['crc_ok'], result['bad_blocks'], result['lines'] = bootload.read_boot_report(
+				uart_ser, uart_lines, stop_at_result=True)
+	except Exception as e:
+		result['error'] = "{}: {}".format(type(e).__name__, e)
+	finally:
+		for ser in (teensy_ser, uart_ser):
+			if ser != None:
+				ser.close()
+
+	result['seconds'] = time.time() - start
+	return result
+
+def program_boards(boards, file_binary="./code.bin", boot_mode='optical', skip_reset=False,
+		insert_CRC=True, block_size=None, optical_timing=(80, 80, 2, 80),
+		wb_half_period_ns=None, wb_skip_bits=1, max_workers=None,
+		open_port=open_serial, uart_lines=10):
+	"""
+	Inputs:
+		boards: List of (teensy_port, uart_port) or (teensy_port, uart_port,
+			file_binary) tuples. uart_port may be None to skip the CRC check.
+		file_binary: String. Binary for boards that do not name their own.
+		boot_mode, skip_reset, insert_CRC, block_size, optical_timing,
+			wb_half_period_ns, wb_skip_bits: See bootload.program_cortex().
+		max_workers: Integer or None. Boards programmed at once, all if None.
+		open_port: Function taking a port name and returning an open
+			serial port, e.g. fake_teensy.open_port for testing.
+		uart_lines: Integer. Most UART lines to read per board.
+	Outputs:
+		List of program_board() results, in the order of boards.
+		A board that fails does not stop the others.
+	"""
+	boot_options = dict(boot_mode=boot_mode, skip_reset=skip_reset, insert_CRC=insert_CRC,
+		optical_timing=optical_timing, wb_half_period_ns=wb_half_period_ns, wb_skip_bits=wb_skip_bits)
+
+	prep_pool = concurrent.futures.ThreadPoolExecutor(max_workers=2)
+	board_pool = concurrent.futures.ThreadPoolExecutor(max_workers=max_workers or max(len(boards), 1))
+	try:
+		# One payload per distinct binary
+		payloads = {}
+		for board in boards:
+			name = board[2] if len(board) > 2 else file_binary
+			if name not in payloads:
+				payloads[name] = prep_pool.submit(load_payload, name, insert_CRC, block_size)
+
+		futures = []
+		for board in boards:
+			name = board[2] if len(board) > 2 else file_binary
+			futures.append(board_pool.submit(program_board, board[0], board[1], payloads[name],
+				open_port, boot_options, uart_lines))
+
+		return [f.result() for f in futures]
+	finally:
+		board_pool.shutdown()
+		prep_pool.shutdown()
+
+def print_results(results):
+	for r in results:
+		if r['error'] != None:
+			status = "ERROR " + r['error']
+		elif r['crc_ok'] == None:
+			status = "no CRC report"
+		elif r['crc_ok']:
+			status = "CRC OK"
+		else:
+			status = "CRC BAD, bad blocks {}".format(r['bad_blocks'])
+		print("{} / {}: {} ({:.1f} s, {} frames re-sent)".format(
+			r['teensy_port'], r['uart_port'], status, r['seconds'], r['resent']))
+
+if __name__ == "__main__":
+	boards = [("COM15", "COM18"),
+			("COM21", "COM22")]
+
+	results = program_boards(boards, file_binary="./code.bin", boot_mode="optical",
+		insert_CRC=True, block_size=1024)
+	print_results(results)
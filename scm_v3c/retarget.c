@@ -2,6 +2,7 @@
 #include <time.h>
 #include <rt_misc.h>
 #include "Memory_Map.h" 
+#include "uart_tx.h"
 
  
 #pragma import(__use_no_semihosting)
@@ -13,12 +14,10 @@ struct __FILE {
 FILE __stdout = 	{(unsigned char *)	APB_UART_BASE};
 FILE __stdin = 		{(unsigned char *)	APB_UART_BASE};
 
+// Queued, see uart_tx.c
 int uart_out(int ch)
 {
-	unsigned char* UARTPtr;
-	UARTPtr = (unsigned char*)APB_UART_BASE;
-	*UARTPtr = (char)ch;
-	return(ch);
+	return(uart_tx_put(ch));
 }
 
 int uart_in()
@@ -57,6 +56,7 @@ void _ttywrch(int ch)
 void _sys_exit(void) {
 
 	printf("\nTEST DONE\n");
+	uart_tx_flush();
 	while(1); 
 	
 }
@@ -0,0 +1,63 @@
+#include "rx_ring.h"
+#include "spsc.h"
+
+// RX packet ring
+// rx_slots[rx_head] is the buffer the DMA receives into. Slots rx_tail up to rx_head are queued packets,
+// oldest first, and stay untouched until the main loop releases them, so nothing is copied out of the
+// DMA buffer. RF_ISR only moves rx_head and the main loop only moves rx_tail (spsc.h); both are single
+// byte stores.
+
+char rx_slots[RX_RING_SLOTS][RX_SLOT_BYTES] __attribute__ ((aligned (4)));
+rx_packet rx_desc[RX_RING_SLOTS];
+
+volatile unsigned char rx_head = 0;
+volatile unsigned char rx_tail = 0;
+unsigned char rx_last = 0;
+
+unsigned int rx_ring_drops = 0;
+
+char* rx_ring_init(void) {
+	rx_head = 0;
+	rx_tail = 0;
+	rx_last = 0;
+	rx_desc[0].data = rx_slots[0];
+	rx_desc[0].length = 0;
+	return rx_slots[0];
+}
+
+char* rx_ring_dma_addr(void) {
+	return rx_slots[rx_head];
+}
+
+rx_packet* rx_ring_rx_done(void) {
+	
+	unsigned char slot = rx_head;
+	rx_packet* desc = &rx_desc[slot];
+	
+	desc->data = rx_slots[slot];
+	desc->length = (unsigned char)rx_slots[slot][0];
+	rx_last = slot;
+	
+	// Full: keep receiving into this slot
+	if(SPSC_FULL(slot, rx_tail, RX_RING_SLOTS))
+		rx_ring_drops++;
+	else
+		rx_head = SPSC_NEXT(slot, RX_RING_SLOTS);
+	
+	return desc;
+}
+
+rx_packet* rx_ring_last(void) {
+	return &rx_desc[rx_last];
+}
+
+rx_packet* rx_ring_peek(void) {
+	if(SPSC_EMPTY(rx_head, rx_tail))
+		return 0;
+	return &rx_desc[rx_tail];
+}
+
+void rx_ring_release(void) {
+	if(!SPSC_EMPTY(rx_head, rx_tail))
+		rx_tail = SPSC_NEXT(rx_tail, RX_RING_SLOTS);
+}
@@ -0,0 +1,46 @@
+#ifndef rx_ring   /* Include guard */
+#define rx_ring
+
+// Ring of RX packet buffers for the radio DMA
+// RF_ISR queues the slot the DMA just filled and points the DMA at the next free one, so the radio can
+// receive again before the packet is handled. Packets are read in place from the main loop. See rx_ring.c.
+
+// Number of slots, a power of two; one is always left for the DMA
+#define RX_RING_SLOTS		4
+#if (RX_RING_SLOTS & (RX_RING_SLOTS - 1)) != 0
+#error RX_RING_SLOTS must be a power of two
+#endif
+// Length byte, up to 127 bytes of payload and CRC, rounded up to whole words
+#define RX_SLOT_BYTES		132
+
+typedef struct {
+	char* data;							// packet as written by the DMA, data[0] is the length byte
+	unsigned char length;				// data[0]
+	unsigned char crc_ok;				// 0 if the radio flagged a CRC error
+	unsigned char lqi;					// LQI chip errors
+	signed short cdr_tau;				// CDR tau at the end of the packet
+	unsigned short if_estimate;
+	signed int sfd_timestamp;			// RF timer count at SFD
+} rx_packet;
+
+// Packets dropped because every slot was still queued
+extern unsigned int rx_ring_drops;
+
+// Empties the ring and returns the slot for the DMA
+char* rx_ring_init(void);
+// Buffer the next packet is received into, for DMA_REG__RF_RX_ADDR
+char* rx_ring_dma_addr(void);
+
+// From RF_ISR at RX done: queues the packet the DMA just wrote and moves the DMA to the next slot.
+// Returns its descriptor with data and length set, for the ISR to fill in the rest. If the ring is
+// full the packet is dropped: the descriptor is still returned but not queued and its slot is reused.
+rx_packet* rx_ring_rx_done(void);
+// Most recent packet given out by rx_ring_rx_done(), whether or not it was queued
+rx_packet* rx_ring_last(void);
+
+// From the main loop: oldest queued packet or 0 if none. data stays valid until rx_ring_release().
+rx_packet* rx_ring_peek(void);
+// Frees the packet returned by rx_ring_peek() for the DMA
+void rx_ring_release(void);
+
+#endif
@@ -1,3 +1,8 @@
+import time
+import zlib
+
+import serial
+
 def construct_scan(
 	#############
 	### NOTES ###
@@ -395,6 +400,7 @@ def construct_scan(
 								# 01: VBAT/4
 								# 10: External pad
 								# 11: Floating
+	sensorADC_pga_bypass=0,		# 1: Bypass the PGA
 
 	###############################
 	### LC Tuning + Transmitter ###
@@ -779,7 +785,7 @@ def construct_scan(
 	ASC[940] = ring_20MHz_enable
 	
 	ASC[1086] = sensorADC_mux_sel[1]
-	ASC[1087] = sensorADC_pga_bypas
+	ASC[1087] = sensorADC_pga_bypass
 
 	ASC[945:951] = lo_fine_tune
 	ASC[951:957] = lo_mid_tune
@@ -924,6 +930,174 @@ def construct_scan(
 
 	return ASC
 
+# Scan chain lengths on SCM3C, in bits
+ASC_BITS = 1200
+DSC_BITS = 2157
+
+def pack_bits(bits):
+	"""
+	Inputs:
+		bits: List of 0/1 integers in shift order.
+	Outputs:
+		Returns the bits packed 8 per byte, bit k in bit 7-(k%8) of byte
+		k//8, zero padded to a whole byte. This is the layout of the packed
+		scan chain commands on the Teensy and of asc_dump() on SCM.
+	"""
+	data = bytearray((len(bits) + 7) // 8)
+	for ii, bit in enumerate(bits):
+		if bit:
+			data[ii >> 3] |= 0x80 >> (ii & 7)
+	return bytes(data)
+
+def unpack_bits(data, num_bits=None):
+	"""Inverse of pack_bits(); returns num_bits bits (default all of data)."""
+	bits = [(byte >> (7 - ii)) & 1 for byte in bytearray(data) for ii in range(8)]
+	return bits if num_bits is None else bits[:num_bits]
+
+def read_packed(ser, tag):
+	"""
+	Inputs:
+		ser: Open serial port (or file-like object).
+		tag: Bytes. Start of the header line, e.g. b'ASC' or b'DSC'.
+	Outputs:
+		Returns the payload bytes of a "<tag> <num_bytes>" frame followed by
+		num_bytes bytes and their CRC-32, MSB first.
+	Raises:
+		ValueError if no frame arrives, it is cut short or its CRC does not
+		match.
+	"""
+	for _ in range(10):
+		line = ser.readline()
+		if line.startswith(tag + b' '):
+			break
+	else:
+		raise ValueError("No {} frame received".format(tag.decode()))
+	num_bytes = int(line.split()[1])
+	data = ser.read(num_bytes + 4)
+	if len(data) != num_bytes + 4:
+		raise ValueError("{} frame cut short ({} of {} bytes)".format(tag.decode(), len(data), num_bytes + 4))
+	if zlib.crc32(data[:num_bytes]) != int.from_bytes(data[num_bytes:], 'big'):
+		raise ValueError("{} frame CRC mismatch".format(tag.decode()))
+	return data[:num_bytes]
+
+def scan_write_packed(ser, bits, command=b'ascwriteb\n'):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy.
+		bits: List of 0/1 integers in shift order (e.g. construct_scan()).
+		command: Bytes. Teensy command that takes the packed bits.
+	Outputs:
+		Sends the bits packed with a CRC-32 instead of one character per bit
+		and returns the Teensy's completion line.
+	Raises:
+		ValueError if the Teensy reports a timeout or CRC error.
+	"""
+	ser.write(command)
+	ser.readline()
+	data = pack_bits(bits)
+	ser.write(data + zlib.crc32(data).to_bytes(4, 'big'))
+	reply = ser.readline()
+	if not reply.startswith(b'ASC Write Complete'):
+		raise ValueError("Scan chain write failed: {}".format(reply.decode('ascii', 'replace').strip()))
+	return reply
+
+def scan_read_packed(ser, num_bits=ASC_BITS, command=b'ascreadb\n', tag=b'ASC'):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy.
+		num_bits: Integer. Length of the chain.
+		command, tag: Bytes. Teensy read command and the tag of its reply,
+			b'dscreadb\n' and b'DSC' for the digital scan chain.
+	Outputs:
+		Returns the bits in the order they were shifted out.
+	"""
+	ser.write(command)
+	return unpack_bits(read_packed(ser, tag), num_bits)
+
+def config_scan_clock(ser, phase_ns, gap_ns, dsc_phase_ns=1000):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy.
+		phase_ns: Integer. How long the ASC PHI and PHIb clocks are high.
+		gap_ns: Integer. Non-overlap between one of them falling and the
+			other rising.
+		dsc_phase_ns: Integer. Length of each step of the DSC clock.
+	Outputs:
+		None. Sets the scan chain clocks on the Teensy; this also stops it
+		running scantest by itself before the first ASC write.
+	"""
+	ser.write(b'configscan\n')
+	for value in (phase_ns, gap_ns, dsc_phase_ns):
+		ser.write(str(int(value)).encode() + b'\n')
+
+def scan_selftest(ser, max_lines=20):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy.
+		max_lines: Integer. Most lines to read before giving up.
+	Outputs:
+		Runs scantest, which loops test patterns through the ASC from the
+		fastest clock down and keeps one step slower than the fastest that
+		passes. Returns (phase_ns, gap_ns) of the clock now in use. The ASC
+		holds the last test pattern afterwards, so program it again.
+	Raises:
+		ValueError if no clock rate passed.
+	"""
+	ser.write(b'scantest\n')
+	for _ in range(max_lines):
+		line = ser.readline().decode('ascii', 'replace').split()
+		if line[:2] == ['SCAN', 'RATE']:
+			return int(line[2]), int(line[3])
+		if line[:3] == ['SCAN', 'TEST', 'FAILED'] or not line:
+			break
+	raise ValueError("Scan chain self test failed at every clock rate")
+
+def compare_scan(written, read_back):
+	"""
+	Inputs:
+		written: Bits in the order they were shifted in.
+		read_back: Bits in the order they were shifted out.
+	Outputs:
+		Returns the positions (index into written) that did not read back.
+		The chain returns the last bit shifted in first.
+	"""
+	read_back = read_back[::-1]
+	return [ii for ii in range(len(written)) if ii >= len(read_back) or written[ii] != read_back[ii]]
+
+def asc_invalidate(uart_ser):
+	"""
+	Inputs:
+		uart_ser: Open serial port to the SCM UART.
+	Outputs:
+		Sends the "inv" command, so the firmware's next analog scan chain
+		write shifts the whole chain even if it matches the last one it
+		wrote. Needed after anything on the Teensy shifts the chain
+		(ascwrite, ascread, scantest) while the firmware runs. Returns the
+		reply line.
+	"""
+	uart_ser.write(b'inv\n')
+	return uart_ser.readline()
+
+def program_asc(ser, ASC, uart_ser=None):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy.
+		ASC: List of ASC_BITS 0/1 integers, e.g. from construct_scan().
+		uart_ser: Open serial port to the SCM UART, or None if no firmware
+			is running. Told to invalidate its scan chain copy afterwards.
+	Outputs:
+		Writes, loads and reads back the analog scan chain with the packed
+		commands. Returns the positions that read back wrong (empty if the
+		chain holds ASC).
+	"""
+	scan_write_packed(ser, ASC)
+	ser.write(b'ascload\n')
+	ser.readline()
+	mismatches = compare_scan(ASC, scan_read_packed(ser, len(ASC)))
+	if uart_ser is not None:
+		asc_invalidate(uart_ser)
+	return mismatches
+
 def program_scan(
 		scan_settings, com_port='COM10', 
 		vdda_pcb_tune=[0]*4, vddd_pcb_tune=[0]*4,
@@ -981,30 +1155,13 @@ def program_scan(
 	time.sleep(0.1)
 	ser.write(b'clockon\n')
 
-	# Send ASC string to uC and program to chip
+	# Send the scan chain packed to uC, program it to chip and latch it
 	ASC = construct_scan(**scan_settings)
-	ASC_str = ''.join(map(str,ASC))
-	ser.write(b'ascwrite\n')
-	print(ser.readline())
-	ser.write(ASC_str.encode())
-	print(ser.readline())
-	
-	# Execute the load command to latch values in the chip
-	ser.write(b'ascload\n')
-	print(ser.readline())
-
-	# Read back the scan chain contents
-	ser.write('ascread\n')
-	scan_out_rev = ser.readline()
-	scan_out = scan_out_rev[::-1]
-	print("Scan In: {}".format(ASC_str))
-	print("Scan Out: {}".format(scan_out.decode()))
-
-	# Check if scan in matches scan out
-	if int(ASC_string) == int(scan_out.decode()):
-		print("Read Matches Write")
+	mismatches = program_asc(ser, ASC)
+	if mismatches:
+		print("Read/Write Comparison Incorrect at positions {}".format(mismatches))
 	else:
-		print("Read/Write Comparison Incorrect")
+		print("Read Matches Write")
 
 	# Due diligence of closing the serial
 	ser.close()
@@ -0,0 +1,388 @@
+"""
+Compiles a declarative scan chain layout (asc_layout.txt here, one per chip
+revision) into a Python encoder module and, if the layout names one, a C
+header with the default image as ASC[] words. The layout format is
+described at the top of asc_layout.txt.
+
+The generated encoder starts from the precomputed default image and only
+writes the fields it is given, instead of rebuilding every field list and
+concatenating them. Its encode_batch() builds many variants at once with
+numpy for sweep scripts.
+
+	python scan_layout.py asc_layout.txt ../scm_v4/asc_layout.txt
+	python scan_layout.py --benchmark
+"""
+
+import os
+import pprint
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+LAYOUTS = [
+	os.path.join(HERE, 'asc_layout.txt'),
+	os.path.join(HERE, '..', 'scm_v4', 'asc_layout.txt'),
+]
+
+class Layout:
+	"""
+	Parsed layout file.
+		chain: Integer. Number of bits in the chain.
+		encoder, header: Output file names next to the layout (header may be None).
+		reference: Name of the Python function the layout describes.
+		constants: List of (positions, bit) for chain bits no argument drives.
+		fields: List of (name, is_list, width, default, positions, elements,
+			inverts, rules) in file order. elements[k] is the argument element
+			that drives positions[k] (None when the rules cover every value),
+			inverts[k] is 1 where it is stored inverted. rules are
+			(op, value, bits) with op '=', '>=' or '*'.
+	"""
+	def __init__(self, path):
+		self.path = path
+		self.chain = None
+		self.encoder = None
+		self.header = None
+		self.reference = None
+		self.constants = []
+		self.fields = []
+
+		with open(path) as f:
+			for line_number, line in enumerate(f, 1):
+				words = line.split('#')[0].split(';')[0].split()
+				if not words:
+					continue
+				try:
+					if words[0] == 'chain':
+						self.chain = int(words[1])
+					elif words[0] in ('encoder', 'header', 'reference'):
+						setattr(self, words[0], words[1])
+					elif words[0] == 'const':
+						positions = [p for token in words[2:] for slot in expand_token(token) for p, _ in slot]
+						self.constants.append((positions, int(words[1])))
+					else:
+						self.fields.append(parse_field(line.split('#')[0]))
+				except (ValueError, IndexError) as e:
+					raise ValueError("{}:{}: {}".format(path, line_number, e))
+		self.check()
+
+	def check(self):
+		"""Raises ValueError if two fields drive one position or a position is past the chain."""
+		owner = {}
+		drivers = [('const', positions) for positions, _ in self.constants]
+		drivers += [(field[0], field[4]) for field in self.fields]
+		for name, positions in drivers:
+			for p in positions:
+				if p >= self.chain:
+					raise ValueError("{}: position {} is past the {} bit chain".format(name, p, self.chain))
+				if p in owner:
+					raise ValueError("{}: position {} is also driven by {}".format(name, p, owner[p]))
+				owner[p] = name
+
+	def default_image(self):
+		"""Chain bits with every field at its default."""
+		bits = [0] * self.chain
+		for positions, bit in self.constants:
+			for p in positions:
+				bits[p] = bit
+		for field in self.fields:
+			for p, b in zip(field[4], field_chain_bits(field, field[3])):
+				bits[p] = b
+		return bits
+
+def parse_field(text):
+	"""One field line of a layout file, see Layout.fields."""
+	parts = text.split(';')
+	words = parts[0].split()
+	name, default, tokens = words[0], words[1], words[2:]
+
+	is_list = default.startswith('[')
+	if is_list:
+		default = [int(c) for c in default.strip('[]')]
+		width = len(default)
+	else:
+		default = int(default)
+		width = 1
+
+	positions, elements, inverts = [], [], []
+	element = 0
+	for token in tokens:
+		for slot in expand_token(token):
+			for p, inv in slot:
+				positions.append(p)
+				elements.append(element)
+				inverts.append(inv)
+			element += 1
+
+	rules = []
+	for part in parts[1:]:
+		part = part.strip()
+		op = '>=' if part.startswith('>=') else '='
+		value, bits = (part[2:] if op == '>=' else part).split('=')
+		bits = tuple(int(c) for c in bits.strip())
+		if len(bits) != len(positions):
+			raise ValueError("{}: rule has {} bits for {} positions".format(name, len(bits), len(positions)))
+		if value.strip() == '*':
+			rules.append(('*', 0, bits))
+		else:
+			rules.append((op, int(value), bits))
+
+	if element != width:
+		if not any(op == '*' for op, _, _ in rules):
+			raise ValueError("{}: {} elements mapped for a width of {}".format(name, element, width))
+		elements = None
+	return (name, is_list, width, default, tuple(positions),
+		None if elements is None else tuple(elements), tuple(inverts), tuple(rules))
+
+def expand_token(token):
+	"""Positions of one layout token as a list of elements, each a list of (position, inverted)."""
+	if token == '-':
+		return [[]]
+	if '..' in token:
+		inv = int(token.startswith('~'))
+		first, last = (int(x) for x in token.lstrip('~').split('..'))
+		step = 1 if last >= first else -1
+		return [[(p, inv)] for p in range(first, last + step, step)]
+	return [[(int(p.lstrip('~')), int(p.startswith('~'))) for p in token.split('|')]]
+
+def field_number(field, value):
+	"""Value of a field as used by its rules: a list's bits MSB first, or the scalar itself."""
+	if field[1] and not isinstance(value, int):
+		return int(''.join(map(str, value)), 2)
+	return int(value)
+
+def field_chain_bits(field, value):
+	"""Chain bits for positions of field when set to value (list or integer)."""
+	_, is_list, width, _, positions, elements, inverts, rules = field
+	number = field_number(field, value)
+	for op, v, bits in rules:
+		if op == '*' or (op == '=' and number == v) or (op == '>=' and number >= v):
+			return list(bits)
+	if is_list:
+		vbits = [(number >> (width - 1 - ii)) & 1 for ii in range(width)]
+	else:
+		vbits = [value]
+	return [vbits[e] ^ i for e, i in zip(elements, inverts)]
+
+def to_words(bits):
+	"""ASC[] style words: position p is bit 31-(p&31) of word p>>5."""
+	bits = bits + [0] * (-len(bits) % 32)
+	return [int(''.join(map(str, bits[ii:ii + 32])), 2) for ii in range(0, len(bits), 32)]
+
+ENCODER_CODE = '''
+def _field(name):
+	try:
+		return FIELDS[name]
+	except KeyError:
+		raise TypeError("No scan chain field {!r}".format(name))
+
+def value_bits(name, value):
+	"""Element bits of a field value, given as construct_scan() takes it or as an integer (MSB first)."""
+	is_list, width = _field(name)[:2]
+	if not is_list:
+		return [value]
+	if isinstance(value, int):
+		return [(value >> (width - 1 - ii)) & 1 for ii in range(width)]
+	if len(value) != width:
+		raise ValueError("{} takes {} bits, got {}".format(name, width, len(value)))
+	return list(value)
+
+def _number(name, value):
+	if _field(name)[0] and not isinstance(value, int):
+		return int(''.join(map(str, value)), 2)
+	return int(value)
+
+def _chain_bits(name, value):
+	_, _, _, _, elements, inverts, rules = _field(name)
+	number = _number(name, value)
+	for op, v, bits in rules:
+		if op == '*' or (op == '=' and number == v) or (op == '>=' and number >= v):
+			return bits
+	vbits = value_bits(name, value)
+	return [vbits[e] ^ i for e, i in zip(elements, inverts)]
+
+def encode(**fields):
+	"""
+	Inputs:
+		Any arguments of the reference function, as lists of bits or
+		integers (MSB first).
+	Outputs:
+		Returns the same list of chain bits in shift order: the default
+		image with the given fields written.
+	"""
+	bits = list(DEFAULT)
+	for name, value in fields.items():
+		for p, b in zip(_field(name)[3], _chain_bits(name, value)):
+			bits[p] = b
+	return bits
+
+# The chain as one integer, position 0 in the MSB of the first byte, and per field the mask of its
+# positions and the bit of each, so encode_bytes() touches only the given fields
+_PAD = 8 * CHAIN_BYTES - CHAIN_BITS
+_DEFAULT_INT = int(''.join(map(str, DEFAULT)), 2) << _PAD
+_BITS = {}
+for _name, _field_info in FIELDS.items():
+	_shifts = [8 * CHAIN_BYTES - 1 - p for p in _field_info[3]]
+	_BITS[_name] = (sum(1 << s for s in _shifts), _shifts)
+del _name, _field_info, _shifts
+
+def encode_bytes(**fields):
+	"""Same as encode(), packed 8 bits per byte MSB first as sent to the Teensy (scan.pack_bits)."""
+	image = _DEFAULT_INT
+	for name, value in fields.items():
+		chain = _chain_bits(name, value)
+		mask, shifts = _BITS[name]
+		image &= ~mask
+		for s, b in zip(shifts, chain):
+			if b:
+				image |= 1 << s
+	return image.to_bytes(CHAIN_BYTES, 'big')
+
+def encode_batch(count, **fields):
+	"""
+	Inputs:
+		count: Integer. Number of variants.
+		fields: Arguments of the reference function. A list or integer is
+			used for every variant. A numpy array gives one value per
+			variant, either count integers (MSB first) or a (count, width)
+			array of bits.
+	Outputs:
+		Returns a (count, CHAIN_BYTES) uint8 numpy array, row k packed
+		like encode_bytes() for variant k.
+	"""
+	import numpy as np
+
+	bits = np.tile(np.array(DEFAULT, dtype=np.uint8), (count, 1))
+	for name, value in fields.items():
+		is_list, width, _, positions, elements, inverts, rules = _field(name)
+		if isinstance(value, np.ndarray) and value.ndim == 2:
+			vbits = value.astype(np.uint8)
+			numbers = vbits.astype(np.int64).dot(1 << np.arange(width - 1, -1, -1, dtype=np.int64))
+		elif isinstance(value, np.ndarray):
+			numbers = value.astype(np.int64)
+			vbits = ((numbers[:, None] >> np.arange(width - 1, -1, -1)) & 1).astype(np.uint8)
+		else:
+			vbits = np.tile(np.array(value_bits(name, value), dtype=np.uint8), (count, 1))
+			numbers = np.full(count, _number(name, value), dtype=np.int64)
+
+		if elements is not None:
+			chain = vbits[:, list(elements)] ^ np.array(inverts, dtype=np.uint8)
+		else:
+			chain = np.zeros((count, len(positions)), dtype=np.uint8)
+		# Applied last to first so the first matching rule wins
+		for op, v, rule in reversed(rules):
+			if op == '*':
+				match = np.ones(count, dtype=bool)
+			elif op == '=':
+				match = numbers == v
+			else:
+				match = numbers >= v
+			chain = np.where(match[:, None], np.array(rule, dtype=np.uint8), chain)
+		bits[:, list(positions)] = chain
+
+	return np.packbits(bits, axis=1)
+'''
+
+def generate_encoder(layout):
+	"""Returns the text of the encoder module for layout."""
+	name = os.path.basename(layout.path)
+	fields = ["\t{!r}: {!r},".format(f[0], f[1:]) for f in layout.fields]
+	default = pprint.pformat(layout.default_image(), width=100, compact=True)
+	lines = [
+		"# Generated by scan_layout.py from {}, do not edit".format(name),
+		'"""',
+		"Encoder for the {} bit scan chain described in {}.".format(layout.chain, name),
+		"encode() takes the arguments of {}() and returns the same bits.".format(layout.reference),
+		'"""',
+		"",
+		"CHAIN_BITS = {}".format(layout.chain),
+		"CHAIN_BYTES = {}".format((layout.chain + 7) // 8),
+		"",
+		"# name: (list argument, width, default, positions, argument element at each position,",
+		"#	inverted positions, (op, value, chain bits) rules that override the mapping)",
+		"FIELDS = {",
+	] + fields + [
+		"}",
+		"",
+		"# Chain bits with every field at its default",
+		"DEFAULT = " + default.replace('\n ', '\n\t'),
+	]
+	return "\n".join(lines) + "\n" + ENCODER_CODE
+
+def generate_header(layout):
+	"""Returns the text of the C header with the default image."""
+	name = os.path.basename(layout.path)
+	guard = os.path.splitext(layout.header)[0]
+	words = to_words(layout.default_image())
+	rows = ["\t" + ", ".join("0x{:08X}".format(w) for w in words[ii:ii + 6]) for ii in range(0, len(words), 6)]
+	lines = [
+		"// Generated by scan_layout.py from {}, do not edit".format(name),
+		"",
+		"#ifndef {}   /* Include guard */".format(guard),
+		"#define {}".format(guard),
+		"",
+		"// Analog scan chain images as ASC[] words: position p is bit 31-(p&31) of word p>>5, as for set_asc_bit()",
+		"#define ASC_IMAGE_BITS		{}".format(layout.chain),
+		"#define ASC_IMAGE_WORDS		{}".format(len(words)),
+		"",
+		"// Every {}() argument at its default, e.g. unsigned int image[ASC_IMAGE_WORDS] = ASC_IMAGE_DEFAULT;".format(
+			layout.reference),
+		"#define ASC_IMAGE_DEFAULT { \\",
+	] + [row + ", \\" for row in rows[:-1]] + [rows[-1] + " }", "", "#endif", ""]
+	return "\n".join(lines)
+
+def outputs(layout):
+	"""(path, text) of every file generated from layout."""
+	out_dir = os.path.dirname(os.path.abspath(layout.path))
+	files = [(os.path.join(out_dir, layout.encoder), generate_encoder(layout))]
+	if layout.header:
+		files.append((os.path.join(out_dir, layout.header), generate_header(layout)))
+	return files
+
+def rate(function, seconds):
+	"""Calls function repeatedly for about seconds, returns the calls per second."""
+	count = 0
+	start = time.time()
+	while time.time() - start < seconds:
+		function(count)
+		count += 1
+	return count / (time.time() - start)
+
+def benchmark(seconds=1.0):
+	"""
+	Prints how many SCM3C ASC variants per second (packed for the Teensy)
+	construct_scan() and the generated encoder build for an LO tuning sweep.
+	"""
+	sys.path.insert(0, HERE)
+	import scan
+	import asc_encoder
+
+	def lo_bits(ii, width=6):
+		return [(ii >> (width - 1 - jj)) & 1 for jj in range(width)]
+
+	print("construct_scan + pack_bits:  {:10.0f} variants/s".format(rate(
+		lambda ii: scan.pack_bits(scan.construct_scan(lo_fine_tune=lo_bits(ii), lo_mid_tune=lo_bits(ii >> 6))),
+		seconds)))
+	print("asc_encoder.encode_bytes:    {:10.0f} variants/s".format(rate(
+		lambda ii: asc_encoder.encode_bytes(lo_fine_tune=ii & 63, lo_mid_tune=(ii >> 6) & 63), seconds)))
+
+	try:
+		import numpy as np
+	except ImportError:
+		print("asc_encoder.encode_batch:    numpy not installed")
+		return
+	batch = 4096
+	sweep = np.arange(batch)
+	per_batch = rate(lambda ii: asc_encoder.encode_batch(batch, lo_fine_tune=sweep & 63, lo_mid_tune=sweep >> 6),
+		seconds)
+	print("asc_encoder.encode_batch:    {:10.0f} variants/s".format(per_batch * batch))
+
+if __name__ == "__main__":
+	if sys.argv[1:] == ['--benchmark']:
+		benchmark()
+		sys.exit(0)
+
+	for path in sys.argv[1:] or LAYOUTS:
+		for out_path, text in outputs(Layout(path)):
+			with open(out_path, 'w') as f:
+				f.write(text)
+			print("Wrote {}".format(out_path))
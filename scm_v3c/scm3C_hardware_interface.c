@@ -3,11 +3,13 @@
 #include "scm3_hardware_interface.h"
 #include "bucket_o_functions.h"
 #include "scum_radio_bsp.h"
+#include "asc_profile.h"
+#include "asc_fields.h"
+#include "lc_map.h"
 #include "sensor_adc/adc_config.h"
 
 extern unsigned int ASC[38];
 extern unsigned int cal_iteration;
-extern char recv_packet[130];
 
 extern unsigned int LC_target;
 extern unsigned int IF_clk_target;
@@ -25,6 +27,11 @@ extern unsigned int RC2M_superfine;
 unsigned int RX_channel_codes[16] = {0};
 unsigned int TX_channel_codes[16] = {0};
 
+// LO register words for each channel code (see lc_map.h), so a retune does not redo the code mapping
+// Refilled by the channel table builds and update_channel_cfg()
+unsigned int RX_channel_cfg[16] = {0};
+unsigned int TX_channel_cfg[16] = {0};
+
 // Timer parameters 
 // Assuming RF timer frequency = 500 kHz
 unsigned int packet_interval = 62500; // 125ms
@@ -34,27 +41,6 @@ unsigned int expected_RX_arrival = 25000;		// must be > 30ms
 unsigned int ack_turnaround_time = 96;	//192 us
 
 
-// Computes 32-bit crc from a starting address over 'length' dwords
-unsigned int crc32c(unsigned char *message, unsigned int length) {
-	int i, j;
-   unsigned int byte, crc;
-	
-	i = 0;
-   crc = 0xFFFFFFFF;
-   while (i < length) {
-      byte = message[i];            // Get next byte.
-      byte = reverse(byte);         // 32-bit reversal.
-      for (j = 0; j <= 7; j++) {    // Do eight times.
-         if ((int)(crc ^ byte) < 0)
-              crc = (crc << 1) ^ 0x04C11DB7;
-         else crc = crc << 1;
-         byte = byte << 1;          // Ready next msg bit.
-      }
-      i = i + 1;
-   }
-   return reverse(~crc);
-}
-
 unsigned char flipChar(unsigned char b) {
 	b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
 	b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
@@ -64,76 +50,20 @@ unsigned char flipChar(unsigned char b) {
 
 void GPO_control(unsigned char row1, unsigned char row2, unsigned char row3, unsigned char row4) {
 	
-	int j;
-	
-	for (j = 0; j <= 3; j++) { 
-	
-		if((row1 >> j) & 0x1)
-			set_asc_bit(245+j);
-		else	
-			clear_asc_bit(245+j);
-	}
-	
-	for (j = 0; j <= 3; j++) { 
-	
-		if((row2 >> j) & 0x1)
-			set_asc_bit(249+j);
-		else	
-			clear_asc_bit(249+j);
-	}
-	
-	for (j = 0; j <= 3; j++) { 
-	
-		if((row3 >> j) & 0x1)
-			set_asc_bit(253+j);
-		else	
-			clear_asc_bit(253+j);
-	}
-	
-	for (j = 0; j <= 3; j++) { 
-	
-		if((row4 >> j) & 0x1)
-			set_asc_bit(257+j);
-		else	
-			clear_asc_bit(257+j);
-	}
+	// ASC<245:260>, 4 bits per row (LSB:MSB)
+	asc_field_write(ASC_FIELD_GPO_ROW1, row1);
+	asc_field_write(ASC_FIELD_GPO_ROW2, row2);
+	asc_field_write(ASC_FIELD_GPO_ROW3, row3);
+	asc_field_write(ASC_FIELD_GPO_ROW4, row4);
 }
 
 void GPI_control(char row1, char row2, char row3, char row4) {
 	
-	int j;
-	
-	for (j = 0; j <= 1; j++) { 
-	
-		if((row1 >> j) & 0x1)
-			set_asc_bit(261+j);
-		else	
-			clear_asc_bit(261+j);
-	}
-	
-	for (j = 0; j <= 1; j++) { 
-	
-		if((row2 >> j) & 0x1)
-			set_asc_bit(263+j);
-		else	
-			clear_asc_bit(263+j);
-	}
-	
-	for (j = 0; j <= 1; j++) { 
-	
-		if((row3 >> j) & 0x1)
-			set_asc_bit(265+j);
-		else	
-			clear_asc_bit(265+j);
-	}
-	
-	for (j = 0; j <= 1; j++) { 
-	
-		if((row4 >> j) & 0x1)
-			set_asc_bit(267+j);
-		else	
-			clear_asc_bit(267+j);
-	}
+	// ASC<261:268>, 2 bits per row (LSB:MSB)
+	asc_field_write(ASC_FIELD_GPI_ROW1, row1);
+	asc_field_write(ASC_FIELD_GPI_ROW2, row2);
+	asc_field_write(ASC_FIELD_GPI_ROW3, row3);
+	asc_field_write(ASC_FIELD_GPI_ROW4, row4);
 }
 
 // Enable output drivers for GPIO based on 'mask'
@@ -223,30 +153,10 @@ unsigned char get_GPI_control(unsigned short rowNum) {
 	Notes:
 		Untested.
 	*/
-	int start_idx;
-	int i;
-	unsigned char row_value;
-	switch (rowNum) {
-		case 0:
-			start_idx = 261;
-			break;
-		case 1:
-			start_idx = 263;
-			break;
-		case 2:
-			start_idx = 265;
-			break;
-		case 3:
-			start_idx = 267;
-			break;
-		default:
-			// Do nothing
-			return 0xFF;
-	}
-	for(i=0; i<2; i++) {
-		row_value |= (get_asc_bit(start_idx+i) << i);
-	}
-	return row_value;
+	// The four row fields are numbered consecutively in asc_fields.h
+	if(rowNum > 3)
+		return 0xFF;
+	return asc_field_read(ASC_FIELD_GPI_ROW1 + rowNum);
 }
 
 unsigned char get_GPO_control(unsigned short rowNum) {
@@ -262,30 +172,10 @@ unsigned char get_GPO_control(unsigned short rowNum) {
 	Notes:
 		Untested.
 	*/
-	int start_idx;
-	int i;
-	unsigned char row_value;
-	switch (rowNum) {
-		case 0:
-			start_idx = 245;
-			break;
-		case 1:
-			start_idx = 249;
-			break;
-		case 2:
-			start_idx = 253;
-			break;
-		case 3:
-			start_idx = 257;
-			break;
-		default:
-			// Do nothing
-			return 0xFF;
-	}
-	for(i=0; i<4; i++) {
-		row_value |= (get_asc_bit(start_idx+i) << i);
-	}
-	return row_value;
+	// The four row fields are numbered consecutively in asc_fields.h
+	if(rowNum > 3)
+		return 0xFF;
+	return asc_field_read(ASC_FIELD_GPO_ROW1 + rowNum);
 }
 
 // Configure how radio and AUX LDOs are turned on and off
@@ -452,93 +342,36 @@ unsigned int sram_test(unsigned int * baseAddress, unsigned int num_dwords) {
 // Change the reference voltage for the IF LDO
 // 0 <= code <= 127
 void set_IF_LDO_voltage(int code){
-
-	unsigned int j;
 	
 	// ASC<492:498> = if_ldo_rdac<0:6> (<0:6(MSB)>)
-	
-	for(j=0; j<=6; j++){
-		if((code >> j) & 0x1)
-			set_asc_bit(492+j);
-		else
-			clear_asc_bit(492+j);
-	}
+	asc_field_write(ASC_FIELD_IF_LDO, code);
 }
 
 // Change the reference voltage for the VDDD LDO
 // 0 <= code <= 127
 void set_VDDD_LDO_voltage(int code){
-
-	unsigned int j;
 	
-	// ASC(791:1:797) (LSB:MSB)
-	
-	for(j=0; j<=4; j++){
-		if((code >> j) & 0x1)
-			set_asc_bit(797-j);
-		else
-			clear_asc_bit(797-j);
-	}
-
-	// Two MSBs are inverted
-	for(j=5; j<=6; j++){
-	if((code >> j) & 0x1)
-		clear_asc_bit(797-j);
-	else
-		set_asc_bit(797-j);
-	}
+	// ASC(791:1:797) (LSB:MSB), two MSBs are inverted
+	asc_field_write(ASC_FIELD_VDDD_LDO, code);
 }
 
 // Change the reference voltage for the AUX LDO
 // 0 <= code <= 127
 void set_AUX_LDO_voltage(int code){
 
-	unsigned int j;
-
-	// ASC(923:-1:917) (MSB:LSB)
-	
-	for(j=0; j<=4; j++){
-		if((code >> j) & 0x1)
-			set_asc_bit(917+j);
-		else
-			clear_asc_bit(917+j);
-	}
-	
-	// Two MSBs are inverted
-	for(j=5; j<=6; j++){
-		if((code >> j) & 0x1)
-			clear_asc_bit(917+j);
-		else
-			set_asc_bit(917+j);
-	}
+	// ASC(923:-1:917) (MSB:LSB), two MSBs are inverted
+	asc_field_write(ASC_FIELD_AUX_LDO, code);
 }
 	
 // Change the reference voltage for the always-on LDO
 // 0 <= code <= 127
 void set_ALWAYSON_LDO_voltage(int code){
 
-	unsigned int j;
-
-	// ASC(924:929) (MSB:LSB)
-	
-	for(j=0; j<=4; j++){
-		if((code >> j) & 0x1)
-			set_asc_bit(929-j);
-		else
-			clear_asc_bit(929-j);
-	}
-	
-	// MSB of normal DAC is inverted
-	if((code >> 5) & 0x1)
-			clear_asc_bit(924);
-		else
-			set_asc_bit(924);
+	// ASC(924:929) (MSB:LSB), MSB of normal DAC is inverted
+	asc_field_write(ASC_FIELD_ALWAYSON_LDO, code);
 	
 	// Panic bit was added for 3B (inverted)
-	if((code >> 6) & 0x1)
-			clear_asc_bit(557);
-		else
-			set_asc_bit(557);
+	asc_field_write(ASC_FIELD_ALWAYSON_LDO_PANIC, code >> 6);
 }
 
 
@@ -546,44 +379,23 @@ void set_ALWAYSON_LDO_voltage(int code){
 
 void set_zcc_demod_threshold(unsigned int thresh){
 
-	int j;
-	
 	//counter threshold 122:107 MSB:LSB
-	for(j=0; j<=15; j++){
-		if((thresh >> j) & 0x1)
-			set_asc_bit(107+j);
-		else
-			clear_asc_bit(107+j);
-	}	
+	asc_field_write(ASC_FIELD_ZCC_DEMOD_THRESH, thresh);
 }	
 
 // Set the divider value for ZCC demod
 // Should be equal to (IF_clock_rate / 2 MHz)
 void set_IF_ZCC_clkdiv(unsigned int div_value){
 	
-	int j;
-	
 	//CLK_DIV = ASC<131:124> MSB:LSB
-	for(j=0; j<=7; j++){
-		if((div_value >> j) & 0x1)
-			set_asc_bit(124+j);
-		else
-			clear_asc_bit(124+j);
-	}		
+	asc_field_write(ASC_FIELD_ZCC_CLKDIV, div_value);
 }
 
 // Set the early decision value for ZCC demod
 void set_IF_ZCC_early(unsigned int early_value){
 	
-	int j;
-	
 	//ASC<224:209> MSB:LSB
-	for(j=0; j<=15; j++){
-		if((early_value >> j) & 0x1)
-			set_asc_bit(209+j);
-		else
-			clear_asc_bit(209+j);
-	}		
+	asc_field_write(ASC_FIELD_ZCC_EARLY, early_value);
 }
 
 // Untested function
@@ -612,69 +424,33 @@ void set_IF_stg3gm_ASC(unsigned int Igm, unsigned int Qgm){
 // Valid input range 0-31
 void set_IF_comparator_trim_I(unsigned int ptrim, unsigned int ntrim){
 	
-	int j;
-	
 	// I comparator N side = 452:456 LSB:MSB
-	for(j=0; j<=4; j++){
-		if((ntrim >> j) & 0x1)
-			set_asc_bit(452+j);
-		else
-			clear_asc_bit(452+j);
-	}	
+	asc_field_write(ASC_FIELD_IF_COMP_TRIM_I_N, ntrim);
 	
 	// I comparator P side = 457:461 LSB:MSB
-	for(j=0; j<=4; j++){
-		if((ptrim >> j) & 0x1)
-			set_asc_bit(457+j);
-		else
-			clear_asc_bit(457+j);
-	}	
+	asc_field_write(ASC_FIELD_IF_COMP_TRIM_I_P, ptrim);
 }
 
 // Adjust the comparator offset trim for Q channel
 // Valid input range 0-31
 void set_IF_comparator_trim_Q(unsigned int ptrim, unsigned int ntrim){
 	
-	int j;
-	
-	// I comparator N side = 340:344 MSB:LSB
-	for(j=0; j<=4; j++){
-		if((ntrim >> j) & 0x1)
-			set_asc_bit(344-j);
-		else
-			clear_asc_bit(344-+j);
-	}	
+	// Q comparator N side = 340:344 MSB:LSB
+	asc_field_write(ASC_FIELD_IF_COMP_TRIM_Q_N, ntrim);
 	
-	// I comparator P side = 335:339 MSB:LSB
-	for(j=0; j<=4; j++){
-		if((ptrim >> j) & 0x1)
-			set_asc_bit(339-j);
-		else
-			clear_asc_bit(339-j);
-	}	
+	// Q comparator P side = 335:339 MSB:LSB
+	asc_field_write(ASC_FIELD_IF_COMP_TRIM_Q_P, ptrim);
 }
 
 
 // Untested function
 void set_IF_gain_ASC(unsigned int Igain, unsigned int Qgain){
 	
-	int j;
-	
 	// 485:490 = I code 0:5
-	for(j=0; j<=4; j++){
-		if((Igain >> j) & 0x1)
-			set_asc_bit(485+j);
-		else
-			clear_asc_bit(485+j);
-	}	
+	asc_field_write(ASC_FIELD_IF_GAIN_I, Igain);
 	
 	// 272:277 = Q code 5:0
-	for(j=0; j<=5; j++){
-		if((Qgain >> j) & 0x1)
-			set_asc_bit(277-j);
-		else
-			clear_asc_bit(277-j);
-	}
+	asc_field_write(ASC_FIELD_IF_GAIN_Q, Qgain);
 }
 
 void radio_init_rx_MF(){
@@ -1090,31 +866,13 @@ void set_IF_clock_frequency(int coarse, int fine, int high_range){
 	//Coarse and fine frequency tune, binary weighted
 	//ASC<427:431> = RC_coarse<4:0> (<4(MSB):0>)
 	//ASC<433:437> = RC_fine<4:0>   (<4(MSB):0>)
-
-	unsigned int j;
-
-	for(j=0; j<=4; j++){
-		if((coarse >> j) & 0x1)
-			set_asc_bit(431-j);
-		else
-			clear_asc_bit(431-j);
-	}
-	
-	for(j=0; j<=4; j++){
-		if((fine >> j) & 0x1)
-			set_asc_bit(437-j);
-		else
-			clear_asc_bit(437-j);
-	}
+	asc_field_write(ASC_FIELD_IF_RC_COARSE, coarse);
+	asc_field_write(ASC_FIELD_IF_RC_FINE, fine);
 	
 	//Switch between high and low speed ranges for IF RC:
 	//'1' = high range
 	//ASC<726> = RC_high_speed_mode 
-	if(high_range==1)
-		set_asc_bit(726);
-	else
-		clear_asc_bit(726);
-
+	asc_field_write(ASC_FIELD_IF_RC_HIGH_RANGE, high_range==1);
 }
 
 
@@ -1122,33 +880,9 @@ void set_IF_clock_frequency(int coarse, int fine, int high_range){
 void set_sys_clk_secondary_freq(unsigned int coarse, unsigned int fine){
 	//coarse 0:4 = 860 861 875b 876b 877b
 	//fine 0:4 870 871 872 873 874b
-	
-	int j;
-	
-	for(j=0; j<=3; j++){
-		if((fine >> j) & 0x1)
-			set_asc_bit(870+j);
-		else
-			clear_asc_bit(870+j);
-	}	
-	if((fine >> 4) & 0x1)
-			clear_asc_bit(874);
-		else
-			set_asc_bit(874);
-	
-	
-		for(j=0; j<=1; j++){
-			if((coarse >> j) & 0x1)
-				set_asc_bit(860+j);
-			else
-				clear_asc_bit(860+j);
-		}
-		for(j=2; j<=4; j++){
-			if((coarse >> j) & 0x1)
-				clear_asc_bit(873+j);
-			else
-				set_asc_bit(873+j);
-	}			
+	asc_field_write(ASC_FIELD_SYS_CLK2_FINE, fine);
+	asc_field_write(ASC_FIELD_SYS_CLK2_COARSE_LO, coarse);
+	asc_field_write(ASC_FIELD_SYS_CLK2_COARSE_HI, coarse >> 2);
 }
 
 
@@ -1192,6 +926,14 @@ void initialize_mote(){
 //	
 //	// Disable RF timer interrupts
 //	rftimer_disable_interrupts();
+
+	// Run the RF timer from here on, its COMPARE7 drains the buffered UART output (uart_tx.c)
+	// It counts freely until housekeeping sets MAX_COUNT to the packet interval after the first acks;
+	// uart_tx re-arms COMPARE7 if that leaves it past the new MAX_COUNT. Only COMPARE7 interrupts
+	// until the radio code enables its own compares.
+	RFTIMER_REG__MAX_COUNT = 0xFFFFFFFF;
+	RFTIMER_REG__CONTROL = RFTIMER_REG__CONTROL_ENABLE | RFTIMER_REG__CONTROL_INTERRUPT_ENABLE | RFTIMER_REG__CONTROL_COUNT_RESET;
+	rftimer_enable_interrupts();
 	
 	//--------------------------------------------------------
 	// SCM3C Analog Scan Chain Initialization
@@ -1296,6 +1038,9 @@ void initialize_mote(){
 						input_mux_sel, pga_byp);
 	}
 
+	// Precompute the ASC for each radio mode from this setup
+	asc_profiles_init(ASC_PROFILE_RX_MF);
+
 	// Program analog scan chain
 	analog_scan_chain_write(&ASC[0]);
 	analog_scan_chain_load();
@@ -1360,6 +1105,9 @@ unsigned int build_RX_channel_table(unsigned int channel_11_LC_code){
 	//	printf("\nRX ch=%d,  count_LC=%d,  count_targets=%d,  RX_channel_codes=%d",ii+11,count_LC[ii],count_targets[ii],RX_channel_codes[ii]);
 	//}
 	
+	for(ii=0; ii<16; ii++)
+		RX_channel_cfg[ii] = LC_code_cfg(RX_channel_codes[ii]);
+	
 	return count_LC[0];
 }
 
@@ -1421,6 +1169,14 @@ void build_TX_channel_table(unsigned int channel_11_LC_code, unsigned int count_
 	//	printf("\nTX ch=%d,  count_LC=%d,  count_targets=%d,  TX_channel_codes=%d",ii+11,count_LC[ii],count_targets[ii],TX_channel_codes[ii]);
 	//}
 	
+	for(ii=0; ii<16; ii++)
+		TX_channel_cfg[ii] = LC_code_cfg(TX_channel_codes[ii]);
+}
+
+// Call after changing RX_channel_codes[ii] or TX_channel_codes[ii]
+void update_channel_cfg(unsigned int ii){
+	RX_channel_cfg[ii] = LC_code_cfg(RX_channel_codes[ii]);
+	TX_channel_cfg[ii] = LC_code_cfg(TX_channel_codes[ii]);
 }
 
 void build_channel_table(unsigned int channel_11_LC_code){
@@ -1434,18 +1190,7 @@ void build_channel_table(unsigned int channel_11_LC_code){
 		//printf("--\n");
 	
 		// Switch over to TX mode
-	
-		// Turn polyphase off for TX
-		clear_asc_bit(971);
-
-		// Hi-Z mixer wells for TX
-		set_asc_bit(298);
-		set_asc_bit(307);
-
-		// Analog scan chain setup for radio LDOs for RX
-		clear_asc_bit(504); // = gpio_pon_en_if
-		set_asc_bit(506); // = gpio_pon_en_lo
-		set_asc_bit(508); // = gpio_pon_en_pa
+		asc_profile_select(ASC_PROFILE_TX);
 
 		build_TX_channel_table(channel_11_LC_code,count_LC_RX_ch11);
 		
@@ -1494,74 +1239,29 @@ void LC_FREQCHANGE(int coarse, int mid, int fine){
 	//		fine: 5-bit code (0-31) to control the ~100 kHz step frequency DAC
 	//  Outputs:
 	//		none, it programs the LC radio frequency immediately
-    
-  // mask to ensure that the coarse, mid, and fine are actually 5-bit
-  char coarse_m = (char)(coarse & 0x1F);
-  char mid_m = (char)(mid & 0x1F);
-  char fine_m = (char)(fine & 0x1F);
-	
-	// flip the bit order to make it fit more easily into the ACFG registers
-	unsigned int coarse_f = (unsigned int)(flipChar(coarse_m));
-	unsigned int mid_f = (unsigned int)(flipChar(mid_m));
-	unsigned int fine_f = (unsigned int)(flipChar(fine_m));
-
-  // initialize registers
-  unsigned int fcode = 0x00000000;   // contains everything but LSB of the fine DAC
-  unsigned int fcode2 = 0x00000000;  // contains the LSB of the fine DAC
-	
-	fine_f &= 0x000000FF;
-	mid_f &= 0x000000FF;
-	coarse_f &= 0x000000FF;
-	
-	//printf("%d\n",fine_m);
-	//printf("%d\n",mid_m);
-	//printf("%d\n",coarse_m);
-	    
-  fcode |= (unsigned int)((fine_f & 0x78) << 9);
-	fcode |= (unsigned int)(mid_f << 3);
-  fcode |= (unsigned int)(coarse_f >> 3);
-    
-  fcode2 |= (unsigned int)((fine_f&0x80) >> 7);
-	
-	//printf("%X\n",fcode);
-	//printf("%X\n",fcode2);
-		
-	// ACFG_LO_ADDR   = [ f1 | f2 | f3 | f4 | md | m0 | m1 | m2 | m3 | m4 | cd | c0 | c1 | c2 | c3 | c4 ]
-	// ACFG_LO_ADDR_2 = [ xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | xx | fd | f0 ]
-	    
-  // set the memory and prevent any overwriting of other analog config
-  ANALOG_CFG_REG__7 = fcode;
-  ANALOG_CFG_REG__8 = fcode2;
-		
+	
+	// Codes are masked to 5 bits and bit reversed into the ACFG registers, see lc_map.c
+	LC_apply_cfg(LC_dac_cfg(coarse, mid, fine));
+}
+
+// Programs the LO from a word made by LC_dac_cfg()/LC_code_cfg()
+void LC_apply_cfg(unsigned int cfg){
+	
+	// set the memory and prevent any overwriting of other analog config
+	ANALOG_CFG_REG__7 = LC_CFG_REG7(cfg);
+	ANALOG_CFG_REG__8 = LC_CFG_REG8(cfg);
 }
+
 void LC_monotonic(int LC_code){
 
 	//int coarse_divs = 440;
 	//int mid_divs = 31; // For full fine code sweeps
 	
-	int fine_fix = 0;
-	int mid_fix = 0;
-	//int coarse_divs = 136;
-	int mid_divs = 25; // works for Ioana's board, Fil's board, Brad's other board
-	
-	//int coarse_divs = 167;
-		int coarse_divs = 155;
-	//int mid_divs = 27; // works for Brad's board // 25 and 155 worked really well @ low frequency, 27 167 worked great @ high frequency (Brad's board)
-	
-	int mid;
-	int fine;
-	int coarse = (((LC_code/coarse_divs + 19) & 0x000000FF));
-	
-	LC_code = LC_code % coarse_divs;
-	//mid = ((((LC_code/mid_divs)*4 + mid_fix) & 0x000000FF)); // works for boards (a)
-	 mid = ((((LC_code/mid_divs)*3 + mid_fix) & 0x000000FF));
-	//mid = ((((LC_code/mid_divs) + mid_fix) & 0x000000FF));
-	if (LC_code/mid_divs >= 2) {fine_fix = 0;};
-	fine = (((LC_code % mid_divs + fine_fix) & 0x000000FF));
-	if (fine > 15){fine++;};
-	
-	LC_FREQCHANGE(coarse,mid,fine);
-	
+	// Coarse steps every 155 codes and mid every 25 (x3) within that, fine codes above 15 skip one
+	// 25 and 155 work for Ioana's board, Fil's board, Brad's other board
+	// 25 and 155 worked really well @ low frequency, 27 167 worked great @ high frequency (Brad's board)
+	// The split is done without dividing in LC_code_cfg(), see lc_map.c
+	LC_apply_cfg(LC_code_cfg(LC_code));
 }
 
 
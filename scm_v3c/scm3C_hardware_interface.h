@@ -1,4 +1,3 @@
-unsigned int crc32c(unsigned char *message, unsigned int length);
 unsigned char flipChar(unsigned char b);
 void init_ldo_control(void);
 unsigned int sram_test(unsigned int * baseAddress, unsigned int num_dwords);
@@ -45,4 +44,5 @@ void set_sys_clk_secondary_freq(unsigned int coarse, unsigned int fine);
 unsigned int build_RX_channel_table(unsigned int channel_11_LC_code);
 void build_TX_channel_table(unsigned int channel_11_LC_code,unsigned int count_LC_RX_ch11);
 void build_channel_table(unsigned int channel_11_LC_code);
+void update_channel_cfg(unsigned int ii);
 unsigned int estimate_temperature_2M_32k(void);
@@ -1,9 +1,14 @@
 #include <stdio.h>
 #include "Memory_Map.h"
+#include "crc32.h"
+#include "scum_radio_bsp.h"
 
 unsigned int ASC[38] = {0};
 extern char send_packet[127];
 
+// retarget.c
+int uart_out(int ch);
+
 unsigned int current_lfsr = 0x12345678;
 
 // coarse1, coarse2, coarse3, fine, superfine dac settings
@@ -38,17 +43,28 @@ unsigned int flip_lsb8(unsigned int in){
 	return out;
 }
 
-void analog_scan_chain_write(unsigned int* scan_bits) {
+// Last contents shifted into the analog scan chain
+// The chain holds its bits, so writing the same contents again can be skipped
+unsigned int ASC_shadow[38];
+unsigned short ASC_shadow_valid = 0;
+unsigned int asc_writes_skipped = 0;
+
+// Delay loop count after each phi1 and phi2 edge, for a chain that needs longer phases than asc_shift_words gives
+// 0 shifts with asc_shift_words at full speed
+unsigned int asc_shift_hold = 0;
+
+// In cm0dsasm.s
+extern void asc_shift_words(unsigned int *scan_bits, unsigned int num_words);
+
+// The old C loop with asc_shift_hold added to each phase, same register writes as asc_shift_words
+static void asc_shift_words_held(unsigned int *scan_bits, unsigned int num_words) {
 	
-	int i = 0;
-	int j = 0;
+	int i;
+	int j;
+	unsigned int k;
 	unsigned int asc_reg;
 	
-	// analog_cfg<357> is resetb for chip shift register, so leave that high
-	
-	for (i=37; i>=0; i--) {
-		
-		//printf("\n%d,%lX\n",i,scan_bits[i]);
+	for (i=num_words-1; i>=0; i--) {
 		
 		for (j=0; j<32; j++) {
 
@@ -64,21 +80,58 @@ void analog_scan_chain_write(unsigned int* scan_bits) {
 		// Lower phi1
 		asc_reg &= ~(0x2);
 		ANALOG_CFG_REG__22 = asc_reg;
+		for(k=0; k<asc_shift_hold; k++);
 
 		// Toggle phi2
 		asc_reg |= 0x4;
 		ANALOG_CFG_REG__22 = asc_reg;
+		for(k=0; k<asc_shift_hold; k++);
 		asc_reg &= ~(0x4);
 		ANALOG_CFG_REG__22 = asc_reg;
+		for(k=0; k<asc_shift_hold; k++);
 
 		// Raise phi1
 		asc_reg |= 0x2;
 		ANALOG_CFG_REG__22 = asc_reg;
+		for(k=0; k<asc_shift_hold; k++);
 		
 		}	
 	}
 }
 
+void analog_scan_chain_write(unsigned int* scan_bits) {
+	
+	int i;
+	
+	// analog_cfg<357> is resetb for chip shift register, so leave that high
+	
+	if(ASC_shadow_valid) {
+		for(i=0; i<38; i++) {
+			if(scan_bits[i] != ASC_shadow[i]) break;
+		}
+		if(i == 38) {
+			asc_writes_skipped++;
+			return;
+		}
+	}
+	
+	// Bits go out from scan_bits[37] down to scan_bits[0], LSB first
+	if(asc_shift_hold)
+		asc_shift_words_held(scan_bits, 38);
+	else
+		asc_shift_words(scan_bits, 38);
+	
+	for(i=0; i<38; i++) ASC_shadow[i] = scan_bits[i];
+	ASC_shadow_valid = 1;
+}
+
+// Makes the next analog_scan_chain_write() shift the whole chain
+// Call if anything else has written the chip shift register: the Teensy's ascwrite, ascread and scantest
+// all leave other bits in it. The "inv" UART command does this (scan.py program_asc() sends it)
+void analog_scan_chain_invalidate() {
+	ASC_shadow_valid = 0;
+}
+
 void analog_scan_chain_load() {
 	
 	// Assert load signal (and cfg<357>)
@@ -194,8 +247,7 @@ void TX_load_PN_data(unsigned int num_bytes){
 		send_packet[i] = (char)(current_lfsr & 0xFF);
 	}
 	
-	RFCONTROLLER_REG__TX_PACK_LEN = num_bytes + 2;
-	RFCONTROLLER_REG__CONTROL = 0x1; // "lod"	
+	radio_loadPacket(num_bytes); // "lod"
 }
 
 void TX_load_counter_data(unsigned int num_bytes){
@@ -204,8 +256,7 @@ void TX_load_counter_data(unsigned int num_bytes){
 		send_packet[i] = (char)(0x30 + i);
 	}
 	
-	RFCONTROLLER_REG__TX_PACK_LEN = num_bytes + 2;	
-	RFCONTROLLER_REG__CONTROL = 0x1; // "lod"
+	radio_loadPacket(num_bytes); // "lod"
 }
 
 void set_asc_bit(unsigned int position){
@@ -241,11 +292,33 @@ unsigned int get_asc_bit(unsigned int position) {
 		position: The position in the ASC to get the bit value.
 	Outputs:
 		The bit (the LSB of unsigned int form) at the particular
-		position in the analog scan chain.
+		position in the analog scan chain. Same MSB-first layout as
+		set_asc_bit(): position 0 is bit 31 of ASC[0].
+	*/
+	return (ASC[position >> 5] >> (31 - (position & 31))) & 0x1;
+}
+
+void asc_dump(void) {
+	/*
+	Inputs:
+		None.
+	Outputs:
+		No return value. Sends ASC[] over the UART in one transfer:
+		"ASC 152\n", the 38 words MSB first (byte 0 bit 7 is scan chain
+		position 0), then the CRC-32 of those 152 bytes MSB first.
+		asc_fields.read_asc_dump() parses it on the host.
 	*/
-	unsigned int word_index = position >> 5;
-	unsigned int ASC_word_rev = reverse(ASC[word_index]);
-	unsigned int ASC_bit = (ASC_word_rev >> (position - (word_index<<5))) 
-							& 0x1;
-	return ASC_bit;
+	unsigned char bytes[sizeof(ASC)];
+	unsigned int crc;
+	unsigned int i;
+
+	for(i=0; i<sizeof(ASC); i++)
+		bytes[i] = ASC[i >> 2] >> (24 - ((i & 3) << 3));
+	crc = crc32c(bytes, sizeof(bytes));
+
+	printf("ASC %u\n", (unsigned int)sizeof(bytes));
+	for(i=0; i<sizeof(bytes); i++)
+		uart_out(bytes[i]);
+	for(i=0; i<4; i++)
+		uart_out(crc >> (24 - (i << 3)));
 }
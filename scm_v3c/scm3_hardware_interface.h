@@ -2,6 +2,7 @@ unsigned reverse(unsigned x);
 // Functions written by Brad, originally for 3B
 void analog_scan_chain_write(unsigned int* scan_bits);
 void analog_scan_chain_load(void);
+void analog_scan_chain_invalidate(void);
 void initialize_2M_DAC(void);
 void set_2M_RC_frequency(int coarse1, int coarse2, int coarse3, int fine, int superfine);
 void read_counters(unsigned int* count_2M, unsigned int* count_LC, unsigned int* count_32k);
@@ -12,6 +13,7 @@ void TX_load_counter_data(unsigned int num_bytes);
 void set_asc_bit(unsigned int position);
 void clear_asc_bit(unsigned int position);
 unsigned int get_asc_bit(unsigned int position);
+void asc_dump(void);
 
 // Functions written by Fil, mostly for 3
 void enable_polyphase_ASC(void);
@@ -29,4 +31,5 @@ void set_DIV_supply(unsigned int code, unsigned char panic);
 void prescaler(int code);
 void LC_monotonic(int LC_code);
 void LC_FREQCHANGE(int coarse, int mid, int fine);
+void LC_apply_cfg(unsigned int cfg);
 void divProgram(unsigned int div_ratio, unsigned int reset, unsigned int enable);
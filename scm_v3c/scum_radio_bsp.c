@@ -3,14 +3,20 @@
 #include "scm3_hardware_interface.h"
 #include "scm3C_hardware_interface.h"
 #include "bucket_o_functions.h"
+#include "asc_profile.h"
+#include "scum_radio_bsp.h"
+#include "rx_ring.h"
+#include "tx_queue.h"
+#include "uart_tx.h"
 
 extern unsigned int ASC[38];
 //extern unsigned int ASC_FPGA[38];
 extern unsigned int cal_iteration;
-extern char recv_packet[130];
 
 extern unsigned int RX_channel_codes[16]; 
 extern unsigned int TX_channel_codes[16];
+extern unsigned int RX_channel_cfg[16];
+extern unsigned int TX_channel_cfg[16];
 extern unsigned short current_RF_channel;
 
 extern char send_packet[127];
@@ -34,6 +40,12 @@ unsigned short frequency_update_cooldown_timer;
 extern unsigned int packet_interval;
 extern unsigned int expected_RX_arrival;
 extern signed int SFD_timestamp;
+extern unsigned int radio_startup_time;
+
+// What the RF controller was last loaded with (RADIO_TX_*), for RF_ISR at TX done
+unsigned char radio_tx_source = RADIO_TX_PACKET;
+// Set while a burst of queued frames is going out; each TX LOAD DONE then sends the loaded frame
+unsigned char radio_tx_burst = 0;
 	
 //When any of these occur, execute an ASC load:
 //-TX completed
@@ -48,49 +60,23 @@ extern signed int SFD_timestamp;
 void setFrequencyRX(unsigned int channel){
 	
 	// Set LO code for RX channel
-	LC_monotonic(RX_channel_codes[channel-11]);
+	LC_apply_cfg(RX_channel_cfg[channel-11]);
 	
 	//printf("chan code = %d\n", RX_channel_codes[channel-11]);
 	
-	// On FPGA, have to use the chip's GPIO outputs for radio signals
+	// GPIO banks, polyphase, mixer and radio LDOs for RX (see asc_profile.c)
 	// Note that can't reprogram while the RX is active
-	GPO_control(2,10,1,1);
-
-	// Turn polyphase on for RX
-	set_asc_bit(971);
-
-	// Enable mixer for RX
-	clear_asc_bit(298);
-	clear_asc_bit(307);
-
-	// Analog scan chain setup for radio LDOs for RX
-	set_asc_bit(504); // = gpio_pon_en_if
-	set_asc_bit(506); // = gpio_pon_en_lo
-	clear_asc_bit(508); // = gpio_pon_en_pa
-	clear_asc_bit(514); // = gpio_pon_en_div
+	asc_profile_select(asc_rx_profile);
 
 	// Write and load analog scan chain
 	//analog_scan_chain_write_3B_fromFPGA(&ASC[0]);
 	//analog_scan_chain_load_3B_fromFPGA();
 
 	// Set LO code for TX ack
-	LC_monotonic(TX_channel_codes[channel-11]);
+	LC_apply_cfg(TX_channel_cfg[channel-11]);
 	
-	// Set GPIOs back
-	GPO_control(0,10,8,10);
-
-	// Turn polyphase off for TX
-	clear_asc_bit(971);
-
-	// Hi-Z mixer wells for TX
-	set_asc_bit(298);
-	set_asc_bit(307);
-
-	// Analog scan chain setup for radio LDOs for TX
-	clear_asc_bit(504); // = gpio_pon_en_if
-	set_asc_bit(506); // = gpio_pon_en_lo
-	set_asc_bit(508); // = gpio_pon_en_pa
-	clear_asc_bit(514); // = gpio_pon_en_div
+	// Same for TX
+	asc_profile_select(ASC_PROFILE_TX);
 
 	// Write analog scan chain (do not load yet)
 	//analog_scan_chain_write_3B_fromFPGA(&ASC[0]);
@@ -102,44 +88,21 @@ void setFrequencyRX(unsigned int channel){
 void setFrequencyTX(unsigned int channel){
 
 	// Set LO code for TX channel
-	LC_monotonic(TX_channel_codes[channel-11]);
-
-	// Turn polyphase off for TX
-	clear_asc_bit(971);
+	LC_apply_cfg(TX_channel_cfg[channel-11]);
 
-	// Hi-Z mixer wells for TX
-	set_asc_bit(298);
-	set_asc_bit(307);
-
-	// Analog scan chain setup for radio LDOs for TX
-	clear_asc_bit(504); // = gpio_pon_en_if
-	set_asc_bit(506); // = gpio_pon_en_lo
-	set_asc_bit(508); // = gpio_pon_en_pa
-	clear_asc_bit(514); // = gpio_pon_en_div
+	// Polyphase, mixer and radio LDOs for TX (see asc_profile.c)
+	asc_profile_select(ASC_PROFILE_TX);
 
 	// Write and load analog scan chain
 	//analog_scan_chain_write_3B_fromFPGA(&ASC[0]);
 	//analog_scan_chain_load_3B_fromFPGA();
 
 	// Set LO code for RX ack
-	LC_monotonic(RX_channel_codes[channel-11]);
+	LC_apply_cfg(RX_channel_cfg[channel-11]);
 	
-	// On FPGA, have to use the chip's GPIO outputs for radio signals
+	// Same for RX
 	// Note that can't reprogram while the RX is active
-	GPO_control(2,10,1,1);
-
-	// Turn polyphase on for RX
-	set_asc_bit(971);
-
-	// Enable mixer for RX
-	clear_asc_bit(298);
-	clear_asc_bit(307);
-
-	// Analog scan chain setup for radio LDOs for RX
-	set_asc_bit(504); // = gpio_pon_en_if
-	set_asc_bit(506); // = gpio_pon_en_lo
-	clear_asc_bit(508); // = gpio_pon_en_pa
-	clear_asc_bit(514); // = gpio_pon_en_div
+	asc_profile_select(asc_rx_profile);
 
 	// Write analog scan chain (do not load yet)
 	//analog_scan_chain_write_3B_fromFPGA(&ASC[0]);
@@ -148,9 +111,9 @@ void setFrequencyTX(unsigned int channel){
 
 
 
-void radio_loadPacket(unsigned int len){
+void radio_loadFrame(char* data, unsigned int len){
 
-	RFCONTROLLER_REG__TX_DATA_ADDR = &send_packet[0];
+	RFCONTROLLER_REG__TX_DATA_ADDR = data;
 			
 	// Set length field (should include +2 for CRC in length)
 	RFCONTROLLER_REG__TX_PACK_LEN = len + 2;
@@ -159,6 +122,59 @@ void radio_loadPacket(unsigned int len){
 	RFCONTROLLER_REG__CONTROL = 0x1;
 }
 
+void radio_loadPacket(unsigned int len){
+	
+	// The ack has always been the start of send_packet[], keep the template in step
+	tx_ack_set(send_packet, TX_ACK_BYTES);
+	radio_tx_source = RADIO_TX_PACKET;
+	radio_loadFrame(&send_packet[0], len);
+}
+
+// Loads the pre-staged ack with the sequence number of the packet being acked
+void radio_loadAck(char seq){
+	
+	radio_tx_source = RADIO_TX_ACK;
+	radio_loadFrame(tx_ack_stage(seq), tx_ack_length());
+}
+
+// Loads the oldest queued frame, returns 0 if there is none
+unsigned int radio_loadQueued(){
+	
+	unsigned int len;
+	char* frame = tx_queue_peek(&len);
+	
+	if(frame == 0)
+		return 0;
+	radio_tx_source = RADIO_TX_QUEUE;
+	radio_loadFrame(frame, len);
+	return 1;
+}
+
+// Sends the queued frames back to back, returns 0 if there are none
+// Call with the radio idle and the TX frequency set (setFrequencyTX())
+unsigned int radio_txBurst(){
+	
+	if(!radio_loadQueued())
+		return 0;
+	
+	// Turn on RF for TX and send the first frame once the LO has settled (COMPARE5 in RFTIMER_ISR)
+	// RF_ISR sends the rest as each one finishes
+	radio_txEnable();
+	RFTIMER_REG__COMPARE5 = RFTIMER_REG__COUNTER + radio_startup_time;
+	RFTIMER_REG__COMPARE5_CONTROL = 0x3;
+	rftimer_enable_interrupts();
+	return 1;
+}
+
+// From RF_ISR at TX SEND DONE of a queued frame: frees it and loads the next one
+// Returns 0 once the queue is empty and the burst is over
+unsigned int radio_txBurstNext(){
+	
+	tx_queue_sent();
+	radio_tx_burst = radio_loadQueued();
+	return radio_tx_burst;
+}
+
 // Turn on the radio for transmit
 // This should be done at least X us before txNow()
 void radio_txEnable(){
@@ -183,8 +199,8 @@ void radio_rxEnable(){
 	// Reset radio FSM
 	RFCONTROLLER_REG__CONTROL = 0x10;
 	
-	// Where packet will be stored in memory
-	DMA_REG__RF_RX_ADDR = &recv_packet[0];
+	// Where packet will be stored in memory, the next free slot of the RX ring
+	DMA_REG__RF_RX_ADDR = rx_ring_dma_addr();
 }
 
 // Radio will begin searching for start of packet
@@ -228,7 +244,7 @@ void radio_frequency_housekeeping(){
 	unsigned short packet_len;
 	signed int timing_correction;
 	
-	packet_len = recv_packet[0];
+	packet_len = rx_ring_last()->length;
 				
 	
 	// Update the expected number of RF timer counts that corresponds to the packet rate
@@ -329,6 +345,7 @@ void radio_frequency_housekeeping(){
 				RX_channel_codes[current_RF_channel - 11]--; 
 				TX_channel_codes[current_RF_channel - 11]--; 
 			}
+			update_channel_cfg(current_RF_channel - 11);
 			
 			//printf("--%d - %d\n",IF_estimate,IF_est_filtered);
 
@@ -347,8 +364,8 @@ void radio_enable_interrupts(){
 	// Enable all interrupts and pulses to radio timer
 	//RFCONTROLLER_REG__INT_CONFIG = 0x3FF;   
 		
-	// Enable TX_SEND_DONE, RX_SFD_DONE, RX_DONE
-	RFCONTROLLER_REG__INT_CONFIG = 0x1C;
+	// Enable TX_LOAD_DONE, TX_SEND_DONE, RX_SFD_DONE, RX_DONE
+	RFCONTROLLER_REG__INT_CONFIG = 0x1D;
 	
 	// Enable all errors
 	//RFCONTROLLER_REG__ERROR_CONFIG = 0x1F;  
@@ -372,7 +389,9 @@ void rftimer_enable_interrupts(){
 
 
 void rftimer_disable_interrupts(){
-	// Enable RF timer interrupts in NVIC
+	// COMPARE7 drains the UART TX FIFO, send what is queued while it still can
+	uart_tx_flush();
+	// Disable RF timer interrupts in NVIC
 	ICER = 0x80;
 }
 
@@ -1,6 +1,16 @@
 void setFrequencyRX(unsigned int channel);
 void setFrequencyTX(unsigned int channel);
+// What the RF controller is loaded with
+#define RADIO_TX_PACKET		0		// send_packet[], radio_loadPacket()
+#define RADIO_TX_ACK		1		// ack template, radio_loadAck()
+#define RADIO_TX_QUEUE		2		// oldest frame of the TX queue, radio_loadQueued()
+
+void radio_loadFrame(char* data, unsigned int len);
 void radio_loadPacket(unsigned int len);
+void radio_loadAck(char seq);
+unsigned int radio_loadQueued(void);
+unsigned int radio_txBurst(void);
+unsigned int radio_txBurstNext(void);
 void radio_txEnable(void);
 void radio_txNow(void);
 void radio_rxEnable(void);
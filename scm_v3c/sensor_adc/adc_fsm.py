@@ -1,3 +1,10 @@
+import os
+import sys
+
+# The ADC values come back as log records, decoded by log_decode.py one directory up
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+import log_decode
+
 def trigger_spot(uart_ser, mode='uart'):
 	"""
 	Inputs:
@@ -55,30 +62,42 @@ def halt_continuous(uart_ser):
 	return
 
 
+def log_stream(uart_ser):
+	"""
+	Inputs:
+		uart_ser: The serial connection (type Serial) associated with the UART
+			serial connection.
+	Outputs:
+		Returns the log_decode.decode_stream() generator for uart_ser, made on
+		the first call and kept on uart_ser, so the records after the one
+		read_uart() returns are read by the next call.
+	"""
+	if getattr(uart_ser, 'log_stream', None) is None:
+		uart_ser.log_stream = log_decode.decode_stream(uart_ser, idle=True)
+	return uart_ser.log_stream
+
 def read_uart(uart_ser):
 	"""
 	Inputs:
 		uart_ser: The serial connection (type Serial) associated with the UART
 			serial connection. This is _not_ a string!
 	Outputs:
-		Returns the integer ADC output. Reads the ADC value via UART. This prints
-		out some of the intermediate excess that gets sent over UART. A return value of
-		2048 indicates a blank string read. 4096 indicates an inability to convert the 
-		non-empty read value to an integer.
-	"""
-	print(uart_ser.readline())
-	adc_out_raw = uart_ser.readline()
-	if adc_out_raw.decode('utf-8') == '':
-		return 2048
-	else:
-		adc_out_str = adc_out_raw.decode('utf-8').replace('\n', '')
-	try:
-		adc_out = int(adc_out_str)
-	except ValueError:
-		print("WARNING: {} not an int".format(adc_out_str))
-		return 4096
-
-	return adc_out
+		Returns the integer ADC output. Reads the ADC value via UART, where ADC_ISR
+		sends it as a LOG_ADC_DATA record in a binary LOG frame (see log_decode.py).
+		This prints out the other text that gets sent over UART before it. A return
+		value of 2048 indicates nothing was read. 4096 indicates the LOG frame holding
+		the value was corrupted.
+	"""
+	for text in log_stream(uart_ser):
+		if text is None:
+			break
+		try:
+			return int(text)
+		except ValueError:
+			print(text.rstrip('\n'))
+			if text.startswith('log: bad frame'):
+				return 4096
+	return 2048
 
 def read_gpo(teensy_ser):
 	"""
@@ -0,0 +1,20 @@
+#ifndef spsc   /* Include guard */
+#define spsc
+
+// Index arithmetic for the single producer, single consumer rings: rx_ring, tx_queue, log_ring and the
+// uart_cmd RX ring. uart_tx uses it too, with a lock, as the main loop and the ISRs all write to it
+// The producer only stores head, after filling the entry there, and the consumer only stores tail, after
+// reading the entry there, so neither side needs a lock. Both indexes run from 0 to size - 1. Size is a
+// power of two so wrapping is a mask; each ring's header checks that with #error. head == tail means
+// empty, so a ring holds at most size - 1 entries: one more would make it look empty.
+
+// Index after i
+#define SPSC_NEXT(i, size)				(((i) + 1) & ((size) - 1))
+// Entries queued
+#define SPSC_COUNT(head, tail, size)	(((head) - (tail)) & ((size) - 1))
+// Entries the producer can still add
+#define SPSC_SPACE(head, tail, size)	((size) - 1 - SPSC_COUNT(head, tail, size))
+#define SPSC_FULL(head, tail, size)		(SPSC_NEXT(head, size) == (tail))
+#define SPSC_EMPTY(head, tail)			((head) == (tail))
+
+#endif
@@ -0,0 +1,82 @@
+// 4B5B encoder for the optical bootloader
+// Shared by teensy_uC_programmer.ino and the host test (tests/test_encoder_4b5b.py)
+//
+// Every byte becomes two 5-bit codes, low nibble first, and every 4 input bytes become a 5-byte
+// group holding the 8 codes packed LSB first. This is the same output as the old encode_4b5b(),
+// but groups are produced on demand while the transmitter drains them, so no encoded copy
+// of the image has to be kept.
+
+#ifndef ENCODER_4B5B_H
+#define ENCODER_4B5B_H
+
+// Both codes for a byte, low nibble in bits 0..4 and high nibble in bits 5..9
+static const unsigned short table_4b5b[256] = {
+  0x3DE, 0x3C9, 0x3D4, 0x3D5, 0x3CA, 0x3CB, 0x3CE, 0x3CF,
+  0x3D2, 0x3D3, 0x3D6, 0x3D7, 0x3DA, 0x3DB, 0x3DC, 0x3DD,
+  0x13E, 0x129, 0x134, 0x135, 0x12A, 0x12B, 0x12E, 0x12F,
+  0x132, 0x133, 0x136, 0x137, 0x13A, 0x13B, 0x13C, 0x13D,
+  0x29E, 0x289, 0x294, 0x295, 0x28A, 0x28B, 0x28E, 0x28F,
+  0x292, 0x293, 0x296, 0x297, 0x29A, 0x29B, 0x29C, 0x29D,
+  0x2BE, 0x2A9, 0x2B4, 0x2B5, 0x2AA, 0x2AB, 0x2AE, 0x2AF,
+  0x2B2, 0x2B3, 0x2B6, 0x2B7, 0x2BA, 0x2BB, 0x2BC, 0x2BD,
+  0x15E, 0x149, 0x154, 0x155, 0x14A, 0x14B, 0x14E, 0x14F,
+  0x152, 0x153, 0x156, 0x157, 0x15A, 0x15B, 0x15C, 0x15D,
+  0x17E, 0x169, 0x174, 0x175, 0x16A, 0x16B, 0x16E, 0x16F,
+  0x172, 0x173, 0x176, 0x177, 0x17A, 0x17B, 0x17C, 0x17D,
+  0x1DE, 0x1C9, 0x1D4, 0x1D5, 0x1CA, 0x1CB, 0x1CE, 0x1CF,
+  0x1D2, 0x1D3, 0x1D6, 0x1D7, 0x1DA, 0x1DB, 0x1DC, 0x1DD,
+  0x1FE, 0x1E9, 0x1F4, 0x1F5, 0x1EA, 0x1EB, 0x1EE, 0x1EF,
+  0x1F2, 0x1F3, 0x1F6, 0x1F7, 0x1FA, 0x1FB, 0x1FC, 0x1FD,
+  0x25E, 0x249, 0x254, 0x255, 0x24A, 0x24B, 0x24E, 0x24F,
+  0x252, 0x253, 0x256, 0x257, 0x25A, 0x25B, 0x25C, 0x25D,
+  0x27E, 0x269, 0x274, 0x275, 0x26A, 0x26B, 0x26E, 0x26F,
+  0x272, 0x273, 0x276, 0x277, 0x27A, 0x27B, 0x27C, 0x27D,
+  0x2DE, 0x2C9, 0x2D4, 0x2D5, 0x2CA, 0x2CB, 0x2CE, 0x2CF,
+  0x2D2, 0x2D3, 0x2D6, 0x2D7, 0x2DA, 0x2DB, 0x2DC, 0x2DD,
+  0x2FE, 0x2E9, 0x2F4, 0x2F5, 0x2EA, 0x2EB, 0x2EE, 0x2EF,
+  0x2F2, 0x2F3, 0x2F6, 0x2F7, 0x2FA, 0x2FB, 0x2FC, 0x2FD,
+  0x35E, 0x349, 0x354, 0x355, 0x34A, 0x34B, 0x34E, 0x34F,
+  0x352, 0x353, 0x356, 0x357, 0x35A, 0x35B, 0x35C, 0x35D,
+  0x37E, 0x369, 0x374, 0x375, 0x36A, 0x36B, 0x36E, 0x36F,
+  0x372, 0x373, 0x376, 0x377, 0x37A, 0x37B, 0x37C, 0x37D,
+  0x39E, 0x389, 0x394, 0x395, 0x38A, 0x38B, 0x38E, 0x38F,
+  0x392, 0x393, 0x396, 0x397, 0x39A, 0x39B, 0x39C, 0x39D,
+  0x3BE, 0x3A9, 0x3B4, 0x3B5, 0x3AA, 0x3AB, 0x3AE, 0x3AF,
+  0x3B2, 0x3B3, 0x3B6, 0x3B7, 0x3BA, 0x3BB, 0x3BC, 0x3BD
+};
+
+// Encodes in[0..3] into out[0..4]
+static inline void encode_4b5b_group(const unsigned char *in, unsigned char *out) {
+  unsigned int lo = table_4b5b[in[0]] | (table_4b5b[in[1]] << 10) | (table_4b5b[in[2]] << 20);
+  unsigned int hi = table_4b5b[in[3]];
+
+  out[0] = lo;
+  out[1] = lo >> 8;
+  out[2] = lo >> 16;
+  out[3] = (lo >> 24) | (hi << 6);
+  out[4] = hi >> 2;
+}
+
+// Streaming state: one 5-byte group is buffered at a time
+struct encoder_4b5b {
+  const unsigned char *src;
+  unsigned char group[5];
+  unsigned int pos;
+};
+
+static inline void encoder_4b5b_start(struct encoder_4b5b *enc, const unsigned char *src) {
+  enc->src = src;
+  enc->pos = 5;
+}
+
+// Returns the next encoded byte; the source must be a whole number of 4-byte groups
+static inline unsigned char encoder_4b5b_next(struct encoder_4b5b *enc) {
+  if (enc->pos == 5) {
+    encode_4b5b_group(enc->src, enc->group);
+    enc->src += 4;
+    enc->pos = 0;
+  }
+  return enc->group[enc->pos++];
+}
+
+#endif
@@ -49,6 +49,40 @@
 //  Open-drain for hard reset to prevent SCM damage (that pin can't handle 3.3V)
 //  Add support to 3wb for doing initial frequency calibration after programming
 
+//  SCM3C - v4
+//  Add optical patch transfer for re-sending individual image blocks without a reset
+
+//  SCM3C - v5
+//  Add compressed stage-2 image transfer to a running SCM (bootload.py boot_stage2)
+//  Keep a fingerprint of the last flashed image and add delta transfer against it (bootload.py delta_program)
+
+//  SCM3C - v6
+//  Replace the NOP loop pulse timing with one FTM3 + DMA pulse engine, interrupts stay on during transfers
+//  p1..p4 are now in units of 25 ns
+
+//  SCM3C - v7
+//  Encode 4B5B on the fly from ram[] while sending (encoder_4b5b.h), payload4b5b[] removed
+//  Patch and delta frames are sent straight from ram[]; encode4b5b is kept as a no-op
+
+//  SCM3C - v8
+//  Add framed binary transfer into ram[] with CRCs and acks (bootload.py teensy_transfer)
+
+//  SCM3C - v9
+//  3wb bootloader uses digitalWriteFast with cycle-counter timing and a configurable clock (config3wb)
+//  Words past code_length are written with one clock instead of 32
+
+//  SCM3C - v10
+//  Packed binary scan chain commands with crc32 (ascwriteb, ascreadb, dscreadb; scan.py)
+//  ASCII scan chain read/write go through the same packed buffer instead of building Strings
+
+//  SCM3C - v11
+//  Scan chain clocks use digitalWriteFast with cycle-counter timing instead of 100 us per bit
+//  phi/phib high time and non-overlap are configurable (configscan); scantest finds the fastest rate that
+//  loops a pattern through the ASC intact, and runs once by itself before the first ASC write
+
+
+#include <DMAChannel.h>
+#include "encoder_4b5b.h"
 
 // PIN MAPPINGS (Teensy 3.6)
 // ---------------
@@ -85,6 +119,12 @@ const int aSCANOUT = 36;
 // Clock output
 const int clock_out = 20;
 
+// Scan chain lengths and the buffer for packed transfers (bit k is bit 7-(k%8) of byte k/8, then a crc32)
+#define ASC_BITS          1200
+#define DSC_BITS          2157
+#define SCAN_BYTES(bits)  (((bits) + 7) / 8)
+byte scan_packed[SCAN_BYTES(DSC_BITS) + 4];
+
 // Variables for command interpreter
 String inputString = "";
 boolean stringComplete = false;
@@ -93,8 +133,15 @@ boolean stringComplete = false;
 int iindex;
 byte ram[85000];
 
-// Array to hold program data after 4B5B conversion
-byte payload4b5b[85000];
+// Small header words of patch and delta frames, the data itself is sent from ram[]
+#define FRAME_MAX_WORDS   200
+#define DELTA_MAX_RUNS    64
+unsigned int frame_words[FRAME_MAX_WORDS];
+
+// Fingerprint of the image last flashed from ram[], 0 if unknown
+// crc32 over the first DELTA_BASE_LENGTH bytes, which is the part a delta can change
+const unsigned int DELTA_BASE_LENGTH = 0x7F80;
+unsigned int flashed_fingerprint = 0;
 
 // Optical programmer variables
 int PREAMBLE_LENGTH = 100;  // How many 0x55 bytes to send to allow RX to settle
@@ -105,6 +152,27 @@ int dig_data_bytes = 1500;//4*2000 + 1;
 // Delay times for high/low, long/short optical pulses
 int p1, p2, p3, p4;
 
+// 3wb clock half period in ns, and clocks used for words past code_length (32 = send everything)
+int wb_half_ns = 250;
+int wb_skip_bits = 1;
+uint32_t wb_half_cycles;
+// Code length from the last insertcrc, 0 until then (3wb then sends every word in full)
+unsigned int wb_code_length = 0;
+
+// Scan chain clocks in ns: how long PHI/PHIb are high and the non-overlap between one falling and the
+// other rising. The DSC uses one phase time for both. Set with configscan or found by scantest.
+int scan_phase_ns = 1000;
+int scan_gap_ns = 250;
+int dsc_phase_ns = 1000;
+uint32_t scan_phase_cycles, scan_gap_cycles, dsc_phase_cycles;
+// Cleared once scantest has run or the timing was configured
+boolean scan_untested = true;
+
+// ASC phase times tried by scantest, fastest first, non-overlap is a quarter of the phase (as the old 40/10 us)
+const int scan_test_phase_ns[] = {50, 100, 200, 500, 1000, 2000, 5000, 10000, 40000};
+#define SCAN_TEST_STEPS   (sizeof(scan_test_phase_ns) / sizeof(scan_test_phase_ns[0]))
+#define SCAN_TEST_PASSES  3
+
 // Runs once at power-on
 void setup() {
   // Open USB serial port; baud doesn't matter; 12Mbps regardless of setting
@@ -113,6 +181,11 @@ void setup() {
   // Reserve 200 bytes for the inputString:
   inputString.reserve(200);
 
+  // Cycle counter used to time the 3wb and scan chain clocks
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+  scan_set_clock(scan_phase_ns, scan_gap_ns, dsc_phase_ns);
+
   // Setup pins for 3wb output
   pinMode(clkPin, OUTPUT); // CLK
   pinMode(enablePin, OUTPUT); // EN
@@ -162,7 +235,11 @@ void loop() {
   // Do nothing until a '\n' terminated string is received
   if (stringComplete) {
 
-    if (inputString == "transfersram\n") {
+    if (inputString == "xfer\n") {
+      transfer_sram_framed();
+    }
+
+    else if (inputString == "transfersram\n") {
       transfer_sram();
     }
 
@@ -186,6 +263,10 @@ void loop() {
       transmit_chips();
     }
 
+    else if (inputString == "config3wb\n") {
+      config_3wb();
+    }
+
     else if (inputString == "boot3wb\n") {
       bootload_3wb();
     }
@@ -202,6 +283,22 @@ void loop() {
       optical_data_transfer(p1, p2, p3, p4);
     }
 
+    else if (inputString == "optpatch\n") {
+      optical_patch(p1, p2, p3, p4);
+    }
+
+    else if (inputString == "optstage2\n") {
+      optical_stage2(p1, p2, p3, p4);
+    }
+
+    else if (inputString == "optdelta\n") {
+      optical_delta(p1, p2, p3, p4);
+    }
+
+    else if (inputString == "fingerprint\n") {
+      Serial.println(flashed_fingerprint);
+    }
+
     else if (inputString == "bootopt4b5b\n") {
       bootload_opt_4b5b(p1, p2, p3, p4);
     }
@@ -238,6 +335,22 @@ void loop() {
       asc_read();
     }
 
+    else if (inputString == "ascwriteb\n") {
+      asc_write_packed();
+    }
+
+    else if (inputString == "ascreadb\n") {
+      asc_read_packed();
+    }
+
+    else if (inputString == "configscan\n") {
+      config_scan();
+    }
+
+    else if (inputString == "scantest\n") {
+      scan_test(true);
+    }
+
     else if (inputString == "toggle3wbclk\n") {
       toggle_3wb_enable();
     }
@@ -245,6 +358,10 @@ void loop() {
     else if (inputString == "dscread\n") {
       dsc_read();
     }
+
+    else if (inputString == "dscreadb\n") {
+      dsc_read_packed();
+    }
     
     else if (inputString == "dscdebug\n") {
       dsc_debug();
@@ -277,6 +394,7 @@ void transfer_sram() {
   Serial.println("Executing SRAM Transfer - SCM3B Rev 2");
   int doneflag = 0;
   iindex = 0;
+  wb_code_length = 0;
 
   // Loop until entire 64kB received over serial
   while (!doneflag) {
@@ -294,6 +412,110 @@ void transfer_sram() {
   }
 }
 
+// Framed binary transfer into ram[], host side is bootload.py teensy_transfer()
+// Frame: header (sync, type, seq, offset, length), payload, crc32 of header and payload, all little-endian
+// Each frame is answered with (sync, status, seq): in-order DATA frames are acked, anything else is
+// NAKed with the sequence number expected next and the host goes back to it
+// Frames are read with Serial.readBytes() so the USB link runs at full speed
+#define XFER_SYNC           0xA5
+#define XFER_RESPONSE_SYNC  0x5A
+#define XFER_DATA           0x01
+#define XFER_END            0x02
+#define XFER_ACK            0x00
+#define XFER_NAK_CRC        0x01
+#define XFER_NAK_RANGE      0x02
+#define XFER_END_OK         0x03
+#define XFER_END_BAD        0x04
+#define XFER_HEADER_SIZE    10
+#define XFER_MAX_PAYLOAD    1024
+
+byte xfer_frame[XFER_HEADER_SIZE + XFER_MAX_PAYLOAD + 4];
+
+void transfer_sram_framed() {
+  unsigned short expected = 0;
+  unsigned short seq, length;
+  unsigned int offset, crc;
+  byte type;
+  int idle = 0;
+
+  // A lost byte shows up as a short read rather than a hang
+  Serial.setTimeout(50);
+  wb_code_length = 0;
+
+  while (idle < 40) {
+    if (Serial.readBytes((char *)xfer_frame, 1) == 0) {
+      // Give up if the host goes quiet
+      idle++;
+      continue;
+    }
+    idle = 0;
+    if (xfer_frame[0] != XFER_SYNC) {
+      continue;
+    }
+
+    if (Serial.readBytes((char *)&xfer_frame[1], XFER_HEADER_SIZE - 1) != XFER_HEADER_SIZE - 1) {
+      xfer_respond(XFER_NAK_CRC, expected);
+      continue;
+    }
+    type = xfer_frame[1];
+    seq = xfer_frame[2] | (xfer_frame[3] << 8);
+    offset = get_word(xfer_frame, 4);
+    length = xfer_frame[8] | (xfer_frame[9] << 8);
+    if (length > XFER_MAX_PAYLOAD) {
+      xfer_respond(XFER_NAK_CRC, expected);
+      continue;
+    }
+
+    if (Serial.readBytes((char *)&xfer_frame[XFER_HEADER_SIZE], length + 4) != length + 4) {
+      xfer_respond(XFER_NAK_CRC, expected);
+      continue;
+    }
+    crc = get_word(xfer_frame, XFER_HEADER_SIZE + length);
+    if (crc32_buf(xfer_frame, XFER_HEADER_SIZE + length) != crc || seq != expected) {
+      xfer_respond(XFER_NAK_CRC, expected);
+      continue;
+    }
+
+    if (type == XFER_DATA) {
+      if (offset + length > sizeof(ram)) {
+        xfer_respond(XFER_NAK_RANGE, expected);
+        continue;
+      }
+      memcpy(&ram[offset], &xfer_frame[XFER_HEADER_SIZE], length);
+      xfer_respond(XFER_ACK, seq);
+      expected++;
+    }
+    else if (type == XFER_END) {
+      // offset is the total length, the payload its crc32
+      if (offset <= sizeof(ram) && crc32_buf(ram, offset) == get_word(xfer_frame, XFER_HEADER_SIZE)) {
+        xfer_respond(XFER_END_OK, seq);
+      }
+      else {
+        xfer_respond(XFER_END_BAD, seq);
+      }
+      break;
+    }
+  }
+
+  Serial.setTimeout(1000);
+}
+
+void xfer_respond(byte status, unsigned short seq) {
+  byte response[4] = {XFER_RESPONSE_SYNC, status, (byte)(seq & 0xFF), (byte)(seq >> 8)};
+  Serial.write(response, 4);
+  Serial.send_now();
+}
+
+// Reads a 32-bit little-endian value from buf[n]
+unsigned int get_word(byte *buf, int n) {
+  return buf[n] | (buf[n + 1] << 8) | (buf[n + 2] << 16) | ((unsigned int)buf[n + 3] << 24);
+}
+
+// Big-endian word, as in the packed scan chain transfers
+unsigned int get_word_msb(byte *buf, int n) {
+  return ((unsigned int)buf[n] << 24) | (buf[n + 1] << 16) | (buf[n + 2] << 8) | buf[n + 3];
+}
+
 void transfer_sram_4b5b() {
   Serial.println("Executing SRAM Transfer");
   int doneflag = 0;
@@ -315,15 +537,6 @@ void transfer_sram_4b5b() {
   }
 
 
-  // For checking if Teensy-based 4b5b encoding matches matlab
-  //  for (int i = 0; i < 81920; i++) {
-  //    if (ram[i] != payload4b5b[i]) {
-  //      Serial.println("ram = " + String(ram[i]) + ", 4b5b = " + String(payload4b5b[i]) + ", i =" + String(i));
-  //    }
-  //  }
-  //Serial.println("OK");
-
-
 
 
 }
@@ -442,153 +655,242 @@ void optical_config() {
 }
 
 
-void bootload_opt_4b5b(int p1, int p2, int p3, int p4) {
-
-#define NOP1 "nop\n\t"
+// Optical pulse engine
+// Pulses are timed by FTM3 channel 0 in output compare mode instead of NOP loops.
+// Each compare match raises a DMA request: the first channel loads the time of the next edge from
+// opt_ring[] into FTM3_C0V and then links to a second channel that toggles optical_out.
+// The ring holds OPT_RING_SIZE edge times and is refilled half at a time from the DMA interrupt,
+// so the edge schedule for a 64kB payload never has to exist in memory all at once.
+// Timing no longer depends on the compiler or on interrupts being off, and USB serial keeps running.
+//
+// Every bit is a high pulse followed by a low gap: 1 = p1 high, p2 low (long), 0 = p3 high, p4 low (short)
+// p1..p4 are in units of OPT_NS_PER_P, about one iteration of the old NOP loop at 180 MHz
+#define OPT_NS_PER_P      25
+#define OPT_MIN_TICKS     20      // Two DMA transfers must finish before the next edge
+#define OPT_START_TICKS   600     // Delay from starting the timer to the first edge
+#define OPT_RING_SIZE     512
+#define OPT_MAX_SEGMENTS  136     // Enough for a patch of 64 blocks
+
+// A run of bits sent LSB first; data == NULL repeats fill, encoded sends data through the 4B5B encoder
+struct opt_segment {
+  const byte *data;
+  unsigned int num_bits;
+  byte fill;
+  byte encoded;
+};
+
+opt_segment opt_segments[OPT_MAX_SEGMENTS];
+int opt_num_segments = 0;
+int opt_segment_index;
+unsigned int opt_bit_index;
+byte opt_byte;
+struct encoder_4b5b opt_encoder;
+
+// Pulse widths in FTM ticks indexed by bit value
+uint16_t opt_high_ticks[2], opt_low_ticks[2];
+uint16_t opt_edge_time;
+
+volatile uint32_t opt_ring[OPT_RING_SIZE];
+int opt_refill_half;
+
+// The DMA engine cannot use the bit-band alias behind digitalWriteFast(), so toggle through GPIO PTOR
+// optical_out (pin 24) is PTE26
+const uint32_t opt_pin_mask = CORE_PIN24_BITMASK;
+volatile uint32_t opt_edges_left;
+volatile boolean opt_busy = false;
+
+DMAChannel opt_dma_time;
+DMAChannel opt_dma_pin;
+
+uint16_t opt_ticks(int p) {
+  uint32_t ticks = (uint32_t)p * OPT_NS_PER_P * (F_BUS / 1000000) / 1000;
+  return ticks < OPT_MIN_TICKS ? OPT_MIN_TICKS : ticks;
+}
 
-  int bitmask = 0x01;
-  noInterrupts();
-  int xx;
+// Start a new transmission with the given pulse widths
+void opt_begin(int p1, int p2, int p3, int p4) {
+  opt_high_ticks[1] = opt_ticks(p1);
+  opt_low_ticks[1] = opt_ticks(p2);
+  opt_high_ticks[0] = opt_ticks(p3);
+  opt_low_ticks[0] = opt_ticks(p4);
+  opt_num_segments = 0;
+}
 
-  int start_symbol[4] = {169, 176, 167, 50};
-  int start_symbol_without_hard_reset[4] = {184, 84, 89, 40};
-  int preamble = 85;
+void opt_add_bits(const byte *data, unsigned int num_bits) {
+  if (opt_num_segments == OPT_MAX_SEGMENTS) {
+    return;
+  }
+  opt_segments[opt_num_segments].data = data;
+  opt_segments[opt_num_segments].num_bits = num_bits;
+  opt_segments[opt_num_segments].encoded = 0;
+  opt_num_segments++;
+}
 
-  // Send Preamble of 101010 to allow optical RX to settle
-  for (int i = 0; i < PREAMBLE_LENGTH; i++) {
-    for (int j = 0; j < 8; j++) {
+void opt_add_bytes(const byte *data, unsigned int num_bytes) {
+  opt_add_bits(data, num_bytes * 8);
+}
 
-      //data = 1, long pulse
-      if (preamble & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
-      }
-    }
+void opt_add_fill(byte fill, unsigned int num_bytes) {
+  if (opt_num_segments == OPT_MAX_SEGMENTS) {
+    return;
   }
+  opt_segments[opt_num_segments].data = NULL;
+  opt_segments[opt_num_segments].num_bits = num_bytes * 8;
+  opt_segments[opt_num_segments].fill = fill;
+  opt_segments[opt_num_segments].encoded = 0;
+  opt_num_segments++;
+}
 
-  // Send start symbol to intiate hard reset
-  for (int i = 0; i < 4; i++) {
-    for (int j = 0; j < 8; j++) {
+// num_bytes of data (a multiple of 4) go out as 5/4 as many 4B5B encoded bytes
+void opt_add_encoded(const byte *data, unsigned int num_bytes) {
+  opt_add_bits(data, num_bytes / 4 * 5 * 8);
+  opt_segments[opt_num_segments - 1].encoded = 1;
+}
 
-      //data = 1, long pulse
-      if (start_symbol[i] & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
+// Returns the next bit of the queued segments, or 1 (a long pulse to clock data through) once they run out
+int opt_next_bit() {
+  while (opt_segment_index < opt_num_segments && opt_bit_index >= opt_segments[opt_segment_index].num_bits) {
+    opt_segment_index++;
+    opt_bit_index = 0;
+  }
+  if (opt_segment_index >= opt_num_segments) {
+    return 1;
+  }
+
+  opt_segment *seg = &opt_segments[opt_segment_index];
+  if ((opt_bit_index & 0x7) == 0) {
+    if (seg->encoded) {
+      if (opt_bit_index == 0) {
+        encoder_4b5b_start(&opt_encoder, seg->data);
       }
+      opt_byte = encoder_4b5b_next(&opt_encoder);
+    }
+    else {
+      opt_byte = seg->data ? seg->data[opt_bit_index >> 3] : seg->fill;
     }
   }
+  int bit = (opt_byte >> (opt_bit_index & 0x7)) & 0x1;
+  opt_bit_index++;
+  return bit;
+}
 
-  // Send REBOOT_BYTES worth of preamble to give cortex time to do hard reset
-  // The REBOOT_BYTES variable must be the same value as in the verilog
-  for (int i = 0; i < REBOOT_BYTES; i++) {
-    for (int j = 0; j < 8; j++) {
+// Each entry is the time of the edge after the one it is loaded on; two edges per bit
+void opt_fill(int start, int count) {
+  for (int ii = start; ii < start + count; ii += 2) {
+    int bit = opt_next_bit();
+    opt_edge_time += opt_high_ticks[bit];
+    opt_ring[ii] = opt_edge_time;
+    opt_edge_time += opt_low_ticks[bit];
+    opt_ring[ii + 1] = opt_edge_time;
+  }
+}
 
-      //data = 1, long pulse
-      if (preamble & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
-      }
-    }
+// Runs every OPT_RING_SIZE / 2 edges
+void opt_isr() {
+  opt_dma_time.clearInterrupt();
+
+  if (opt_edges_left <= OPT_RING_SIZE / 2) {
+    // Done; anything sent after the last edge was extra long pulses
+    // An even number of edges has been played, let the last toggle land before forcing the pin low
+    FTM3_C0SC = 0;
+    opt_dma_time.disable();
+    opt_dma_pin.disable();
+    delayMicroseconds(1);
+    digitalWriteFast(optical_out, LOW);
+    opt_edges_left = 0;
+    opt_busy = false;
+    return;
   }
+  opt_edges_left -= OPT_RING_SIZE / 2;
 
-  // Send program data encoded in 4b5b format
-  for (int i = 0; i < 81920; i++) {
-    for (int j = 0; j < 8; j++) {
+  // The half that was just played is free again
+  opt_fill(opt_refill_half * OPT_RING_SIZE / 2, OPT_RING_SIZE / 2);
+  opt_refill_half ^= 1;
+}
 
-      //data = 1, long pulse
-      if (payload4b5b[i] & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
-      }
-    }
+// Plays the queued segments and returns when they have been sent
+// Blocks, but with interrupts on so USB serial stays alive
+void opt_run() {
+  uint32_t num_bits = 0;
+  uint32_t ftm_sc = FTM3_SC, ftm_mod = FTM3_MOD;
+
+  for (int ii = 0; ii < opt_num_segments; ii++) {
+    num_bits += opt_segments[ii].num_bits;
   }
+  opt_segment_index = 0;
+  opt_bit_index = 0;
+  opt_edges_left = 2 * num_bits;
+
+  // First edge happens at OPT_START_TICKS, the ring starts with the edge after it
+  opt_edge_time = OPT_START_TICKS;
+  opt_fill(0, OPT_RING_SIZE);
+  opt_refill_half = 0;
+
+  digitalWriteFast(optical_out, LOW);
+
+  opt_dma_time.sourceBuffer(opt_ring, sizeof(opt_ring));
+  opt_dma_time.destination(FTM3_C0V);
+  opt_dma_time.triggerAtHardwareEvent(DMAMUX_SOURCE_FTM3_CH0);
+  opt_dma_time.interruptAtHalf();
+  opt_dma_time.interruptAtCompletion();
+  opt_dma_time.attachInterrupt(opt_isr);
+
+  opt_dma_pin.source(opt_pin_mask);
+  opt_dma_pin.destination(GPIOE_PTOR);
+  opt_dma_pin.transferCount(1);
+  opt_dma_pin.triggerAtTransfersOf(opt_dma_time);
+  opt_dma_pin.triggerAtCompletionOf(opt_dma_time);
+
+  // Free-running 16-bit counter at F_BUS, software output compare on channel 0 with DMA requests
+  FTM3_SC = 0;
+  FTM3_CNT = 0;
+  FTM3_MOD = 0xFFFF;
+  FTM3_C0SC = FTM_CSC_MSA | FTM_CSC_CHIE | FTM_CSC_DMA;
+  FTM3_C0V = OPT_START_TICKS;
+
+  opt_busy = true;
+  opt_dma_pin.enable();
+  opt_dma_time.enable();
+  FTM3_SC = FTM_SC_CLKS(1) | FTM_SC_PS(0);
+
+  while (opt_busy) {
+    yield();
+  }
+
+  // Give FTM3 back to analogWrite()
+  FTM3_SC = 0;
+  FTM3_MOD = ftm_mod;
+  FTM3_SC = ftm_sc;
+}
+
+// Bits sent before an optical transfer
+const byte preamble[1] = {85};
+const byte start_symbol[4] = {169, 176, 167, 50};
+const byte start_symbol_without_hard_reset[4] = {184, 84, 89, 40};
+const byte sfd[4] = {221, 176, 231, 47};
+
+void bootload_opt_4b5b(int p1, int p2, int p3, int p4) {
+
+  opt_begin(p1, p2, p3, p4);
+
+  // Send Preamble of 101010 to allow optical RX to settle
+  opt_add_fill(preamble[0], PREAMBLE_LENGTH);
+
+  // Send start symbol to intiate hard reset
+  opt_add_bytes(start_symbol, 4);
+
+  // Send REBOOT_BYTES worth of preamble to give cortex time to do hard reset
+  // The REBOOT_BYTES variable must be the same value as in the verilog
+  opt_add_fill(preamble[0], REBOOT_BYTES);
+
+  // Send program data encoded in 4b5b format
+  opt_add_encoded(ram, 65536);
 
   // Need to send 5 extra bits to clock last value through
-//  for (int j = 0; j < 6; j++) {
-  for (int j = 0; j < 600; j++) {
-    digitalWriteFast(optical_out, HIGH);
-    for (xx = 0; xx < p1; xx++) {
-      __asm__(NOP1);
-    }
-    digitalWriteFast(optical_out, LOW);
-    for (xx = 0; xx < p2; xx++) {
-      __asm__(NOP1);
-    }
-  }
+  opt_add_fill(0xFF, 75);
 
-  interrupts();
+  opt_run();
+  flashed_fingerprint = crc32_buf(ram, DELTA_BASE_LENGTH);
   Serial.println("Optical Boot Complete");
 }
 
@@ -597,255 +899,218 @@ void bootload_opt_4b5b(int p1, int p2, int p3, int p4) {
 
 void bootload_opt_4b5b_no_reset(int p1, int p2, int p3, int p4) {
 
-#define NOP1 "nop\n\t"
-
-  int bitmask = 0x01;
-  noInterrupts();
-  int xx;
-
-  int start_symbol[4] = {169, 176, 167, 50};
-  int start_symbol_without_hard_reset[4] = {184, 84, 89, 40};
-  int preamble = 85;
+  opt_begin(p1, p2, p3, p4);
 
   // Send Preamble of 101010 to allow optical RX to settle
-  for (int i = 0; i < PREAMBLE_LENGTH; i++) {
-    for (int j = 0; j < 8; j++) {
-
-      //data = 1, long pulse
-      if (preamble & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
-      }
-    }
-  }
+  opt_add_fill(preamble[0], PREAMBLE_LENGTH);
 
   // Send start symbol to intiate boot without hard reset
-  for (int i = 0; i < 4; i++) {
-    for (int j = 0; j < 8; j++) {
-
-      //data = 1, long pulse
-      if (start_symbol_without_hard_reset[i] & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
-      }
-    }
-  }
+  opt_add_bytes(start_symbol_without_hard_reset, 4);
 
   // Send program data encoded in 4b5b format
-  for (int i = 0; i < 81920; i++) {
-    for (int j = 0; j < 8; j++) {
-
-      //data = 1, long pulse
-      if (payload4b5b[i] & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
-      }
-    }
-  }
+  opt_add_encoded(ram, 65536);
 
   // Need to send 5 extra bits to clock last value through
-  for (int j = 0; j < 6; j++) {
-
-    digitalWriteFast(optical_out, HIGH);
-    for (xx = 0; xx < p1; xx++) {
-      __asm__(NOP1);
-    }
-    digitalWriteFast(optical_out, LOW);
-    for (xx = 0; xx < p2; xx++) {
-      __asm__(NOP1);
-    }
-  }
+  opt_add_fill(0xFF, 1);
 
-  interrupts();
+  opt_run();
+  flashed_fingerprint = crc32_buf(ram, DELTA_BASE_LENGTH);
   Serial.println("Optical Boot Complete - No Reset");
 }
 
 
 void optical_data_transfer(int p1, int p2, int p3, int p4) {
+  optical_send(ram, dig_data_bytes, p1, p2, p3, p4);
+}
 
-#define NOP1 "nop\n\t"
 
-  int bitmask = 0x01;
-  noInterrupts();
-  int xx;
+// Sends SFD followed by num_bytes of raw binary (no 4B5B) from data[]
+void optical_send(byte *data, int num_bytes, int p1, int p2, int p3, int p4) {
 
-  int sfd[4] = {221, 176, 231, 47};
-  int preamble = 85;
+  optical_frame_begin(data, p1, p2, p3, p4);
 
-  // Send Preamble of 101010 to allow optical RX to settle
-  for (int i = 0; i < PREAMBLE_LENGTH; i++) {
-    for (int j = 0; j < 8; j++) {
+  // Send payload in raw binary (no 4B5B done in hardware)
+  opt_add_bytes(data, num_bytes);
 
-      //data = 1, long pulse
-      if (preamble & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
-      }
-    }
-  }
+  opt_run();
+}
+
+// Queues preamble and SFD for a raw data transfer that starts with first[]
+// The frame itself is queued with opt_add_bytes(), then sent with opt_run()
+void optical_frame_begin(const byte *first, int p1, int p2, int p3, int p4) {
+
+  opt_begin(p1, p2, p3, p4);
+
+  // Send Preamble of 101010 to allow optical RX to settle
+  opt_add_fill(preamble[0], PREAMBLE_LENGTH);
 
   // Send start symbol to throw interrupt for aligning data
-  for (int i = 0; i < 4; i++) {
-    for (int j = 0; j < 8; j++) {
+  opt_add_bytes(sfd, 4);
 
-      //data = 1, long pulse
-      if (sfd[i] & (bitmask << j)) {
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
-      }
-    }
+  // The very first data bit gets lost so send it twice to re-align
+  opt_add_bits(first, 1);
+}
+
+
+// Re-sends selected blocks of the image in ram[] to a running SCM without a hard reset
+// SCM must be waiting in optical_patch_arm() (it does this by itself after a failed CRC check)
+// Reads the block size, the number of blocks and then each block number as '\n' terminated lines
+// Frame is a stream of 32-bit little-endian words:
+//   0x5CA10000 | num_blocks, then per block: byte address, num_words, data words, crc32 of address, num_words and data
+void optical_patch(int p1, int p2, int p3, int p4) {
+
+  unsigned int block_size, num_blocks, block, address, num_words, crc;
+  unsigned int code_length = 256 * ram[65529] + ram[65528];
+  unsigned int frame_bytes;
+  int n = 0;
+  int start;
+
+  block_size = read_serial_int();
+  num_blocks = read_serial_int();
+  if (num_blocks > 64) {
+    Serial.println("Optical Patch Failed - too many blocks");
+    return;
   }
 
-  // The very first data bit gets lost so send it twice to re-align
-  if (ram[0] & (bitmask)) {
+  // Header words go in frame_words[], block data is sent straight from ram[]
+  frame_words[n++] = 0x5CA10000 | num_blocks;
+  optical_frame_begin((byte *)frame_words, p1, p2, p3, p4);
+  start = 0;
+  frame_bytes = 0;
+
+  for (unsigned int ii = 0; ii < num_blocks; ii++) {
+    block = read_serial_int();
+    address = block * block_size;
+
+    // Last block may be partial; always send whole words
+    num_words = block_size / 4;
+    if (address + block_size > code_length) {
+      num_words = (code_length - address + 3) / 4;
+    }
+
+    frame_words[n++] = address;
+    frame_words[n++] = num_words;
+    opt_add_bytes((byte *)&frame_words[start], 4 * (n - start));
+    opt_add_bytes(&ram[address], num_words * 4);
+    frame_bytes += num_words * 4;
+
+    // SCM checks the address and length against the CRC too
+    crc = crc32_update(0xFFFFFFFF, (byte *)&frame_words[n - 2], 8);
+    crc = crc32_update(crc, &ram[address], num_words * 4);
+    frame_words[n++] = reverse(~crc);
+    start = n - 1;
+  }
+  opt_add_bytes((byte *)&frame_words[start], 4 * (n - start));
+  frame_bytes += 4 * n;
 
-    digitalWriteFast(optical_out, HIGH);
-    for (xx = 0; xx < p1; xx++) {
-      __asm__(NOP1);
-    }
-    digitalWriteFast(optical_out, LOW);
-    for (xx = 0; xx < p2; xx++) {
-      __asm__(NOP1);
-    }
+  // A few extra bits to clock the last word through
+  opt_add_fill(0xFF, 1);
+  opt_run();
+
+  Serial.println("Optical Patch Complete - " + String(num_blocks) + " blocks, " + String(frame_bytes) + " bytes");
+}
+
+// Sends a compressed stage-2 image to a running SCM without a hard reset
+// SCM must be waiting for it (UART command "ldr"); the frame is built by bootload.py build_stage2_stream
+// Reads the frame length as a '\n' terminated line followed by the raw frame bytes
+// The frame is held in ram[], which then no longer matches the image on SCM
+void optical_stage2(int p1, int p2, int p3, int p4) {
+
+  int num_bytes = read_serial_int();
+
+  flashed_fingerprint = 0;
+  read_serial_bytes(ram, num_bytes);
+
+  optical_frame_begin(ram, p1, p2, p3, p4);
+  opt_add_bytes(ram, num_bytes);
+
+  // A few extra bits to clock the last word through
+  opt_add_fill(0xFF, 1);
+  opt_run();
+
+  Serial.println("Optical Stage 2 Complete - " + String(num_bytes) + " bytes");
+}
+
+// Sends a delta against the last flashed image to a running SCM without a hard reset
+// SCM must be waiting for it (UART command "dlt"); the frame is built by bootload.py build_delta_stream
+// Reads the frame length as a '\n' terminated line followed by the raw frame bytes
+// Frame is a stream of 32-bit little-endian words:
+//   0x5CA30000, image length, crc32 of image, num_runs, then per run: byte offset, num_words, data words
+// The runs are applied to ram[] as they arrive and sent from there, so the fingerprint follows the image on SCM
+void optical_delta(int p1, int p2, int p3, int p4) {
+
+  int num_bytes = read_serial_int();
+  unsigned int num_runs, offset, num_words;
+  int n = 16;
+  int start = 0;
+
+  read_serial_bytes((byte *)frame_words, 16);
+  num_runs = frame_words[3];
+  if (num_bytes < 16 || frame_words[0] != 0x5CA30000 || num_runs > DELTA_MAX_RUNS) {
+    read_serial_bytes(NULL, num_bytes - 16);
+    Serial.println("Optical Delta Failed - bad frame");
+    return;
   }
-  else {    // data = 0, short pulse
 
-    digitalWriteFast(optical_out, HIGH);
-    for (xx = 0; xx < p3; xx++) {
-      __asm__(NOP1);
-    }
-    digitalWriteFast(optical_out, LOW);
-    for (xx = 0; xx < p4; xx++) {
-      __asm__(NOP1);
+  optical_frame_begin((byte *)frame_words, p1, p2, p3, p4);
+
+  for (unsigned int ii = 0; ii < num_runs; ii++) {
+    read_serial_bytes((byte *)&frame_words[4 + 2 * ii], 8);
+    offset = frame_words[4 + 2 * ii];
+    num_words = frame_words[5 + 2 * ii];
+    n += 8 + 4 * num_words;
+    if (offset + 4 * num_words > DELTA_BASE_LENGTH) {
+      read_serial_bytes(NULL, num_bytes - n + 4 * num_words);
+      flashed_fingerprint = 0;
+      Serial.println("Optical Delta Failed - bad run");
+      return;
     }
+    read_serial_bytes(&ram[offset], 4 * num_words);
+
+    opt_add_bytes((byte *)&frame_words[start], 4 * (4 + 2 * ii + 2 - start));
+    opt_add_bytes(&ram[offset], 4 * num_words);
+    start = 4 + 2 * ii + 2;
   }
+  opt_add_bytes((byte *)&frame_words[start], 4 * (4 + 2 * num_runs - start));
 
+  // A few extra bits to clock the last word through
+  opt_add_fill(0xFF, 1);
+  opt_run();
 
+  flashed_fingerprint = crc32_buf(ram, DELTA_BASE_LENGTH);
 
-  // Send payload in raw binary (no 4B5B done in hardware)
-  for (int i = 0; i < dig_data_bytes; i++) {
-    for (int j = 0; j < 8; j++) {
+  Serial.println("Optical Delta Complete - " + String(num_runs) + " runs, " + String(num_bytes) + " bytes");
+}
 
-      //data = 1, long pulse
-      if (ram[i] & (bitmask << j)) {
+// Blocks until num_bytes raw bytes have been received over serial, NULL discards them
+void read_serial_bytes(byte *data, int num_bytes) {
+  int n = 0;
 
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p1; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p2; xx++) {
-          __asm__(NOP1);
-        }
-      }
-      else {    // data = 0, short pulse
-
-        digitalWriteFast(optical_out, HIGH);
-        for (xx = 0; xx < p3; xx++) {
-          __asm__(NOP1);
-        }
-        digitalWriteFast(optical_out, LOW);
-        for (xx = 0; xx < p4; xx++) {
-          __asm__(NOP1);
-        }
+  while (n < num_bytes) {
+    if (Serial.available()) {
+      byte value = (byte)Serial.read();
+      if (data != NULL) {
+        data[n] = value;
       }
+      n++;
     }
   }
+}
 
+// Blocks until a '\n' terminated integer is received over serial
+int read_serial_int() {
+  inputString = "";
+  stringComplete = false;
 
-  interrupts();
-}
+  while (stringComplete == false) {
+    serialEvent();
+  }
+  int value = inputString.toInt();
 
+  inputString = "";
+  stringComplete = false;
+  return value;
+}
 
 
 void output_digital_data() {
@@ -882,42 +1147,77 @@ void output_digital_data() {
 }
 
 
-// Receives 1200 analog scan chain bits over serial
+// Receives 1200 analog scan chain bits over serial as '0'/'1' characters
 // Then bitbangs them out to ASC
 void asc_write() {
+  if (scan_untested)
+    scan_test(false);
+
   Serial.println("Executing ASC Write");
   int count = 0;
-  char scanbits[1200];
+  boolean bad_char = false;
+  char c;
 
-  // Set scan chain source as external
-  digitalWrite(asc_source_select, HIGH);
+  memset(scan_packed, 0, SCAN_BYTES(ASC_BITS));
 
   // Loop until all 1200 scan chain bits received over serial
-  while (count != 1200) {
+  while (count != ASC_BITS) {
 
     // Read one bit at a time over serial
     if (Serial.available()) {
-      scanbits[count] = Serial.read();
+      c = Serial.read();
+      if (c == '1')
+        scan_packed[count >> 3] |= 0x80 >> (count & 7);
+      else if (c != '0')
+        bad_char = true;
       count++;
     }
   }
 
-  // Once all bits are received, bitbang to ASC input
-  for (int x = 0; x < 1200; x++) {
-    if (scanbits[x] == '1') {
-      digitalWrite(aSCANIN, HIGH);
-    }
-    else if (scanbits[x] == '0') {
-      digitalWrite(aSCANIN, LOW);
-    }
-    else {
-      // There was an error reading in the bits over uart
-      Serial.println("Error in ASC Write");
-    }
+  // There was an error reading in the bits over uart
+  if (bad_char) {
+    Serial.println("Error in ASC Write");
+  }
+
+  asc_shift_packed();
+  Serial.println("ASC Write Complete");
+}
+
+// Receives the analog scan chain packed 8 bits per byte with a crc32 (scan.py scan_write_packed)
+// Then bitbangs them out to ASC
+void asc_write_packed() {
+  int num_bytes = SCAN_BYTES(ASC_BITS);
+
+  // The chain is about to be overwritten, so this is the time to find its clock rate
+  // The self test uses scan_packed[], the bytes wait in the USB buffer meanwhile
+  if (scan_untested)
+    scan_test(false);
+
+  Serial.println("Executing ASC Write");
+  if (Serial.readBytes((char *)scan_packed, num_bytes + 4) != num_bytes + 4) {
+    Serial.println("Error in ASC Write: timeout");
+    return;
+  }
+  if (crc32_buf(scan_packed, num_bytes) != get_word_msb(scan_packed, num_bytes)) {
+    Serial.println("Error in ASC Write: CRC");
+    return;
+  }
+
+  asc_shift_packed();
+  Serial.println("ASC Write Complete");
+}
+
+// Bitbangs ASC_BITS bits from scan_packed[] to ASC input, bit 0 first
+void asc_shift_packed() {
+
+  // Set scan chain source as external
+  digitalWrite(asc_source_select, HIGH);
+
+  for (int x = 0; x < ASC_BITS; x++) {
+    digitalWriteFast(aSCANIN, (scan_packed[x >> 3] >> (7 - (x & 7))) & 1);
     // Pulse PHI and PHIB
     atick();
   }
-  Serial.println("ASC Write Complete");
 }
 
 // Latches the loaded data to the outputs of the scan chain
@@ -937,70 +1237,28 @@ void asc_load() {
 void bootload_3wb_4b5b()  {
   Serial.println("Executing 3wb Bootload");
 
-  int start_symbol[4] = {169, 176, 167, 50};
-  int preamble = 85;
+  byte start_symbol[4] = {169, 176, 167, 50};
+  uint32_t t;
 
-  // Send start symbol
-  for (int i = 0; i < 4; i++) {
-    // Loop through one byte at a time
-    for (int j = 0; j < 8; j++) {
-      digitalWrite(dataPin, (start_symbol[i] >> j) & 1);
+  wb_half_cycles = (uint64_t)wb_half_ns * F_CPU / 1000000000;
+  t = ARM_DWT_CYCCNT;
 
-      // Toggle the clock
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 1);
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 0);
-      delayMicroseconds(1);
-    }
-  }
+  // Send start symbol
+  t = wb_send_bits(get_word(start_symbol, 0), 32, false, t);
 
   // Send dummy bytes to wait for reset to finish
   for (int i = 0; i < REBOOT_BYTES; i++) {
-    // Loop through one byte at a time
-    for (int j = 0; j < 8; j++) {
-      digitalWrite(dataPin, (preamble >> j) & 1);
-
-      // Toggle the clock
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 1);
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 0);
-      delayMicroseconds(1);
-    }
+    t = wb_send_bits(0x55, 8, false, t);
   }
 
   // Need to send at least 64*1024 bytes to get cortex to reset
-  for (int i = 1; i < 81921; i++) {
-    // Loop through one byte at a time
-    for (int j = 0; j < 8; j++) {
-      digitalWrite(dataPin, (ram[i - 1] >> j) & 1);
-      delayMicroseconds(1);
-
-      // Toggle the clock
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 1);
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 0);
-      delayMicroseconds(1);
-    }
+  for (int i = 0; i < 81920; i += 4) {
+    t = wb_send_bits(get_word(ram, i), 32, false, t);
   }
 
   // Send 5 extra bits to cycle last 4b5b value through
-  for (int j = 0; j < 6; j++) {
-    digitalWrite(dataPin, 0);
-
-    // Toggle the clock
-    delayMicroseconds(1);
-    digitalWrite(clkPin, 1);
-    delayMicroseconds(1);
-    digitalWrite(clkPin, 0);
-    delayMicroseconds(1);
-  }
-
-
+  t = wb_send_bits(0, 6, false, t);
 }
-
 void toggle_3wb_enable()  {
   for (int i = 1; i < 2; i++){
     // Toggle the clock
@@ -1021,6 +1279,21 @@ void toggle_3wb_enable()  {
 void bootload_3wb()  {
   //Serial.println("Executing 3wb Bootload");
 
+  // Only the image and the trailer (block CRCs, length, CRC) need real data, see main.c on SCM
+  // Without a valid code_length (no insertcrc) every word is sent in full
+  // The first DELTA_BASE_LENGTH bytes are always sent in full: a skipped word holds whatever the
+  // shift register had, and flashed_fingerprint must describe what SCM really holds for deltas to apply
+  unsigned int data_words = (wb_code_length + 4) / 4;
+  unsigned int trailer_word = 0xFEF4 / 4;
+  uint32_t t;
+
+  if (data_words < DELTA_BASE_LENGTH / 4) {
+    data_words = DELTA_BASE_LENGTH / 4;
+  }
+  if (wb_code_length == 0 || data_words > trailer_word) {
+    data_words = trailer_word;
+  }
+
   // Execute hard reset
   pinMode(hReset, OUTPUT);  //Drive low
   delayMicroseconds(500);
@@ -1028,28 +1301,17 @@ void bootload_3wb()  {
   pinMode(hReset, INPUT);   //Back to Hi-Z
   delayMicroseconds(500);
 
-  // Need to send at least 64*1024 bytes to get cortex to reset
-  for (int i = 1; i < 65537; i++) {
-
-    // Loop through one byte at a time
-    for (int j = 0; j < 8; j++) {
-      digitalWrite(dataPin, (ram[i - 1] >> j) & 1);
-      delayMicroseconds(1);
-
-      // Every 32 bits need to strobe the enable high for one cycle
-      if ((i % 4 == 0) && (j == 7)) {
-        digitalWrite(enablePin, 1);
-      }
-      else {
-        digitalWrite(enablePin, 0);
-      }
+  wb_half_cycles = (uint64_t)wb_half_ns * F_CPU / 1000000000;
+  t = ARM_DWT_CYCCNT;
 
-      // Toggle the clock
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 1);
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 0);
-      delayMicroseconds(1);
+  // Need to send all 64*1024 bytes (16384 enable strobes) to get cortex to reset
+  for (unsigned int i = 0; i < 16384; i++) {
+    if (i < data_words || i >= trailer_word) {
+      t = wb_send_bits(get_word(ram, 4 * i), 32, true, t);
+    }
+    else {
+      // Contents do not matter, the strobe still advances the address
+      t = wb_send_bits(0xFFFFFFFF, wb_skip_bits, true, t);
     }
   }
 
@@ -1059,32 +1321,48 @@ void bootload_3wb()  {
   //  digitalWrite(sReset, HIGH);
   //  delay(20);
 
-  for (int i = 1; i < 10000; i++) {
+  // Keep clocking ones while the cortex comes out of reset
+  for (int i = 0; i < 2500; i++) {
+    t = wb_send_bits(0xFFFFFFFF, 32, true, t);
+  }
 
-    // Loop through one byte at a time
-    for (int j = 0; j < 8; j++) {
-      digitalWrite(dataPin, 1);
-      delayMicroseconds(1);
+  flashed_fingerprint = crc32_buf(ram, DELTA_BASE_LENGTH);
+  Serial.println("3WB Bootload Complete");
+}
 
-      // Every 32 bits need to strobe the enable high for one cycle
-      if ((i % 4 == 0) && (j == 7)) {
-        digitalWrite(enablePin, 1);
-      }
-      else {
-        digitalWrite(enablePin, 0);
-      }
+// Reads the 3wb clock half period in ns and the clocks per skipped word as '\n' terminated lines
+void config_3wb() {
+  wb_half_ns = read_serial_int();
+  wb_skip_bits = read_serial_int();
+  if (wb_skip_bits < 1 || wb_skip_bits > 32) {
+    wb_skip_bits = 32;
+  }
+}
 
-      // Toggle the clock
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 1);
-      delayMicroseconds(1);
-      digitalWrite(clkPin, 0);
-      delayMicroseconds(1);
-    }
+// Shifts num_bits of value out LSB first on the 3wb, returns the updated time
+// strobe sets enable during the last bit so the word gets written
+// Each clock half period ends wb_half_cycles after the previous one, measured on the cycle counter,
+// so an interrupt only stretches a period and never shortens one
+uint32_t wb_send_bits(uint32_t value, int num_bits, boolean strobe, uint32_t t) {
+  for (int j = 0; j < num_bits; j++) {
+    digitalWriteFast(dataPin, (value >> j) & 1);
+    digitalWriteFast(enablePin, strobe && j == num_bits - 1);
+
+    t = wb_wait(t);
+    digitalWriteFast(clkPin, HIGH);
+    t = wb_wait(t);
+    digitalWriteFast(clkPin, LOW);
   }
+  return t;
+}
 
+uint32_t wb_wait(uint32_t t) {
+  t += wb_half_cycles;
+  while ((int32_t)(ARM_DWT_CYCCNT - t) < 0);
 
-  Serial.println("3WB Bootload Complete");
+  // Do not try to catch up after an interrupt
+  uint32_t now = ARM_DWT_CYCCNT;
+  return (int32_t)(now - t) > (int32_t)wb_half_cycles ? now : t;
 }
 
 
@@ -1121,23 +1399,27 @@ void transmit_chips()  {
 }
 
 
-//10 KHz clock, 40 percent duty cycle
+// One DSC clock, every step lasts dsc_phase_ns
 void dtick() {
-  delayMicroseconds(1);
-  digitalWrite(dPHI, HIGH);
-  delayMicroseconds(1);
+  uint32_t t = ARM_DWT_CYCCNT;
+
+  scan_wait(t, dsc_phase_cycles);
+  digitalWriteFast(dPHI, HIGH);
+  t = ARM_DWT_CYCCNT;
+  scan_wait(t, dsc_phase_cycles);
 
   //Read
-  digitalWrite(dPHI, LOW);
-  delayMicroseconds(1);
+  digitalWriteFast(dPHI, LOW);
+  t = ARM_DWT_CYCCNT;
+  scan_wait(t, dsc_phase_cycles);
 
   //Shift
-  digitalWrite(dPHIb, HIGH);
-  delayMicroseconds(1);
-  digitalWrite(dPHIb, LOW);
-  delayMicroseconds(1);
-
-
+  digitalWriteFast(dPHIb, HIGH);
+  t = ARM_DWT_CYCCNT;
+  scan_wait(t, dsc_phase_cycles);
+  digitalWriteFast(dPHIb, LOW);
+  t = ARM_DWT_CYCCNT;
+  scan_wait(t, dsc_phase_cycles);
 }
 
 void dsc_debug() {
@@ -1153,12 +1435,22 @@ void dsc_debug() {
 }
 
 
-//Note that Serial.println has a 697 char (699 out) max.
-//2157 = 600 + 600 + 600 + 357
+// Reads the 2157 digital scan chain bits out as '0'/'1' characters
 void dsc_read() {
   //Serial.println("Executing DSC Read");
-  String st = "";
-  int val = 0;
+  dsc_capture();
+  print_packed_bits(DSC_BITS);
+}
+
+// Same, sent packed with a crc32 (scan.py scan_read_packed)
+void dsc_read_packed() {
+  dsc_capture();
+  send_packed("DSC", SCAN_BYTES(DSC_BITS));
+}
+
+// Shifts the digital scan chain out into scan_packed[], first bit out in bit 7 of byte 0
+void dsc_capture() {
+  memset(scan_packed, 0, SCAN_BYTES(DSC_BITS));
 
   // Setup pins for digital scan chain
   pinMode(dPHI, OUTPUT);
@@ -1174,144 +1466,202 @@ void dsc_read() {
   digitalWrite(dSCANi0o1, HIGH);
   dtick();
   digitalWrite(dSCANi0o1, LOW);
-  //First bit should be available
-  val = digitalRead(dSCANOUT);
-  if (val)
-    st = String(st + "1");
-  else
-    st = String(st + "0");
-
-  //2-600
-  for (int i = 1; i < 600 ; i = i + 1) {
-    dtick();
-    val = digitalRead(dSCANOUT);
-    if (val)
-      st = String(st + "1");
-    else
-      st = String(st + "0");
-  }
-  Serial.print(st);
-  st = "";
-
-   //digitalWrite(dSCANIN, HIGH);
-
-  //601-1200
-  for (int i = 0; i < 600 ; i = i + 1) {
-    dtick();
-    val = digitalRead(dSCANOUT);
-    if (val)
-      st = String(st + "1");
-    else
-      st = String(st + "0");
-  }
-  Serial.print(st);
-  st = "";
-
-
-  //1201-1800
-  for (int i = 0; i < 600 ; i = i + 1) {
-    dtick();
-    val = digitalRead(dSCANOUT);
-    if (val)
-      st = String(st + "1");
-    else
-      st = String(st + "0");
-  }
-  Serial.print(st);
-  st = "";
 
-  //digitalWrite(dSCANIN, LOW);
-
-
-  //1801-2157
-  for (int i = 0; i < 357 ; i = i + 1) {
-    dtick();
-    val = digitalRead(dSCANOUT);
-    if (val)
-      st = String(st + "1");
-    else
-      st = String(st + "0");
+  //First bit should be available
+  for (int i = 0; i < DSC_BITS; i++) {
+    if (i > 0)
+      dtick();
+    if (digitalReadFast(dSCANOUT))
+      scan_packed[i >> 3] |= 0x80 >> (i & 7);
   }
-  Serial.print(st);
-  st = "";
-
-  Serial.println(); //Terminator
 
   // Set pins back to hi-Z
   pinMode(dPHI, INPUT);
   pinMode(dPHIb, INPUT);
   pinMode(dSCANi0o1, INPUT);
   pinMode(dSCANIN, INPUT);
-
-  return;
 }
 
-//10 KHz clock, 40 percent duty cycle
+// One ASC clock: PHIb high for scan_phase_ns, then PHI, with scan_gap_ns of both low around each
+// The pins are constants so digitalWriteFast is a single port write
 void atick() {
-  digitalWrite(aPHI, LOW);
-  delayMicroseconds(10);
+  uint32_t t;
+
+  digitalWriteFast(aPHI, LOW);
+  t = ARM_DWT_CYCCNT;
+  scan_wait(t, scan_gap_cycles);
 
   //Shift
-  digitalWrite(aPHIb, HIGH);
-  delayMicroseconds(40);
-  digitalWrite(aPHIb, LOW);
-  delayMicroseconds(10);
+  digitalWriteFast(aPHIb, HIGH);
+  t = ARM_DWT_CYCCNT;
+  scan_wait(t, scan_phase_cycles);
+  digitalWriteFast(aPHIb, LOW);
+  t = ARM_DWT_CYCCNT;
+  scan_wait(t, scan_gap_cycles);
 
   //Read
-  digitalWrite(aPHI, HIGH);
-  delayMicroseconds(40);
+  digitalWriteFast(aPHI, HIGH);
+  t = ARM_DWT_CYCCNT;
+  scan_wait(t, scan_phase_cycles);
+}
+
+// Waits until cycles after t
+// Each tick reads t right after its edge write, so an interrupt anywhere can only lengthen a phase
+// or the non-overlap, never shorten the next one
+void scan_wait(uint32_t t, uint32_t cycles) {
+  while (ARM_DWT_CYCCNT - t < cycles);
+}
+
+void scan_set_clock(int phase_ns, int gap_ns, int dsc_ns) {
+  scan_phase_ns = phase_ns;
+  scan_gap_ns = gap_ns;
+  dsc_phase_ns = dsc_ns;
+  scan_phase_cycles = (uint64_t)phase_ns * F_CPU / 1000000000;
+  scan_gap_cycles = (uint64_t)gap_ns * F_CPU / 1000000000;
+  dsc_phase_cycles = (uint64_t)dsc_ns * F_CPU / 1000000000;
+}
+
+// Reads the ASC phase and non-overlap and the DSC phase in ns as '\n' terminated lines (scan.py config_scan_clock)
+void config_scan() {
+  int phase_ns = read_serial_int();
+  int gap_ns = read_serial_int();
+  int dsc_ns = read_serial_int();
+
+  if (phase_ns > 0 && gap_ns > 0 && dsc_ns > 0) {
+    scan_set_clock(phase_ns, gap_ns, dsc_ns);
+    scan_untested = false;
+  }
 }
 
-//Note that Serial.println has a 697 char (699 out) max.
-//1200 = 600 + 600
+// Finds the fastest ASC clock that loops SCAN_TEST_PASSES patterns through the chain intact, then runs
+// one step slower than that for margin. Keeps the old timing if no rate works (no chip, chain broken).
+// Prints "SCAN <phase> <gap> PASS/FAIL" per rate tried and "SCAN RATE <phase> <gap>" or "SCAN TEST FAILED"
+// when verbose (scan.py scan_selftest). Leaves the pattern in the chain, nothing is loaded.
+void scan_test(boolean verbose) {
+  int old_phase_ns = scan_phase_ns;
+  int old_gap_ns = scan_gap_ns;
+  unsigned int step;
+  boolean pass = false;
+
+  scan_untested = false;
+  for (step = 0; step < SCAN_TEST_STEPS && !pass; step++) {
+    scan_set_clock(scan_test_phase_ns[step], scan_test_phase_ns[step] / 4, dsc_phase_ns);
+    pass = true;
+    for (int n = 0; n < SCAN_TEST_PASSES && pass; n++)
+      pass = scan_test_pass(n);
+
+    if (verbose) {
+      Serial.print("SCAN ");
+      Serial.print(scan_phase_ns);
+      Serial.print(" ");
+      Serial.print(scan_gap_ns);
+      Serial.println(pass ? " PASS" : " FAIL");
+    }
+  }
+
+  if (!pass) {
+    scan_set_clock(old_phase_ns, old_gap_ns, dsc_phase_ns);
+    if (verbose)
+      Serial.println("SCAN TEST FAILED");
+    return;
+  }
+
+  // step is one past the passing rate now
+  if (step >= SCAN_TEST_STEPS)
+    step = SCAN_TEST_STEPS - 1;
+  scan_set_clock(scan_test_phase_ns[step], scan_test_phase_ns[step] / 4, dsc_phase_ns);
+  if (verbose) {
+    Serial.print("SCAN RATE ");
+    Serial.print(scan_phase_ns);
+    Serial.print(" ");
+    Serial.println(scan_gap_ns);
+  }
+}
+
+// Bit k of self test pattern n: alternating ones and zeros first (most edges), then hashes of k
+int scan_test_bit(int k, int n) {
+  if (n == 0)
+    return k & 1;
+  return ((((uint32_t)k + 1) * 2654435761u + (uint32_t)n * 0x9E3779B9u) >> 31) & 1;
+}
+
+// Shifts pattern n into the ASC at the current clock and checks what comes back out
+boolean scan_test_pass(int n) {
+  memset(scan_packed, 0, SCAN_BYTES(ASC_BITS));
+  for (int k = 0; k < ASC_BITS; k++) {
+    if (scan_test_bit(k, n))
+      scan_packed[k >> 3] |= 0x80 >> (k & 7);
+  }
+  asc_shift_packed();
+  asc_capture();
+
+  // The chain returns the last bit shifted in first
+  for (int i = 0; i < ASC_BITS; i++) {
+    if (((scan_packed[i >> 3] >> (7 - (i & 7))) & 1) != scan_test_bit(ASC_BITS - 1 - i, n))
+      return false;
+  }
+  return true;
+}
+
+// Reads the 1200 analog scan chain bits out as '0'/'1' characters
 void asc_read() {
   //Serial.println("Executing ASC Read");
-  String st = "";
-  int val = 0;
+  asc_capture();
+  print_packed_bits(ASC_BITS);
+}
+
+// Same, sent packed with a crc32 (scan.py scan_read_packed)
+void asc_read_packed() {
+  asc_capture();
+  send_packed("ASC", SCAN_BYTES(ASC_BITS));
+}
+
+// Shifts the analog scan chain out into scan_packed[], first bit out in bit 7 of byte 0
+void asc_capture() {
+  memset(scan_packed, 0, SCAN_BYTES(ASC_BITS));
 
   // Set scan chain source as external
   digitalWrite(asc_source_select, HIGH);
 
-  //digitalWrite(aSCANi0o1, HIGH);
-  //atick();
-  //digitalWrite(aSCANi0o1, LOW);
   //First bit should be available
-  val = digitalRead(aSCANOUT);
-  if (val)
-    st = String(st + "1");
-  else
-    st = String(st + "0");
-
-  //2-600
-  for (int i = 1; i < 600 ; i = i + 1) {
-    atick();
-    val = digitalRead(aSCANOUT);
-    if (val)
-      st = String(st + "1");
-    else
-      st = String(st + "0");
+  for (int i = 0; i < ASC_BITS; i++) {
+    if (i > 0)
+      atick();
+    if (digitalReadFast(aSCANOUT))
+      scan_packed[i >> 3] |= 0x80 >> (i & 7);
   }
-  Serial.print(st);
-  st = "";
 
-  //601-1200
-  for (int i = 0; i < 600 ; i = i + 1) {
-    atick();
-    val = digitalRead(aSCANOUT);
-    if (val)
-      st = String(st + "1");
-    else
-      st = String(st + "0");
-  }
-  Serial.print(st);
-  st = "";
+  // Set scan chain source back to internal
+  digitalWrite(asc_source_select, LOW);
+}
+
+// Prints num_bits of scan_packed[] as '0'/'1' characters and a terminator, in chunks
+// Note that Serial.println has a 697 char (699 out) max.
+void print_packed_bits(int num_bits) {
+  char st[601];
+  int n = 0;
 
+  for (int i = 0; i < num_bits; i++) {
+    st[n++] = ((scan_packed[i >> 3] >> (7 - (i & 7))) & 1) ? '1' : '0';
+    if (n == 600 || i == num_bits - 1) {
+      Serial.write(st, n);
+      n = 0;
+    }
+  }
   Serial.println(); //Terminator
+}
 
-  // Set scan chain source back to internal
-  digitalWrite(asc_source_select, LOW);
+// Sends "<tag> <num_bytes>", then num_bytes of scan_packed[] and their crc32 MSB first
+void send_packed(const char *tag, int num_bytes) {
+  unsigned int crc = crc32_buf(scan_packed, num_bytes);
 
-  return;
+  for (int i = 0; i < 4; i++)
+    scan_packed[num_bytes + i] = crc >> (24 - 8 * i);
+
+  Serial.print(tag);
+  Serial.print(" ");
+  Serial.println(num_bytes);
+  Serial.write(scan_packed, num_bytes + 4);
 }
 
 
@@ -1394,163 +1744,38 @@ void cal_3wb() {
 
 // For timing transfer via optical
 // Send optical SFDs at 100ms intervals
+// Every frame takes the same time with the pulse engine, so SFD to SFD is start to start
 void opti_cal() {
 
-    for (int ii = 0; ii < 50; ii++) {
-    
-  #define NOP1 "nop\n\t"
-  
-    int bitmask = 0x01;
-    noInterrupts();
-    int xx;
-  
-    int sfd[4] = {221, 176, 231, 47};
-    int preamble = 85;
-  
-    // Send Preamble of 101010 to allow optical RX to settle
-    for (int i = 0; i < PREAMBLE_LENGTH; i++) {
-      for (int j = 0; j < 8; j++) {
-  
-        //data = 1, long pulse
-        if (preamble & (bitmask << j)) {
-  
-          digitalWriteFast(optical_out, HIGH);
-          for (xx = 0; xx < p1; xx++) {
-            __asm__(NOP1);
-          }
-          digitalWriteFast(optical_out, LOW);
-          for (xx = 0; xx < p2; xx++) {
-            __asm__(NOP1);
-          }
-        }
-        else {    // data = 0, short pulse
-  
-          digitalWriteFast(optical_out, HIGH);
-          for (xx = 0; xx < p3; xx++) {
-            __asm__(NOP1);
-          }
-          digitalWriteFast(optical_out, LOW);
-          for (xx = 0; xx < p4; xx++) {
-            __asm__(NOP1);
-          }
-        }
-      }
-    }
-  
-    // Send start symbol to throw interrupt 
-    for (int i = 0; i < 4; i++) {
-      for (int j = 0; j < 8; j++) {
-  
-        //data = 1, long pulse
-        if (sfd[i] & (bitmask << j)) {
-  
-          digitalWriteFast(optical_out, HIGH);
-          for (xx = 0; xx < p1; xx++) {
-            __asm__(NOP1);
-          }
-          digitalWriteFast(optical_out, LOW);
-          for (xx = 0; xx < p2; xx++) {
-            __asm__(NOP1);
-          }
-        }
-        else {    // data = 0, short pulse
-  
-          digitalWriteFast(optical_out, HIGH);
-          for (xx = 0; xx < p3; xx++) {
-            __asm__(NOP1);
-          }
-          digitalWriteFast(optical_out, LOW);
-          for (xx = 0; xx < p4; xx++) {
-            __asm__(NOP1);
-          }
-        }
-      }
-    }
-
-      // Need to send some extra bits to clock last value through
-  for (int j = 0; j < 50; j++) {
-
-    digitalWriteFast(optical_out, HIGH);
-    for (xx = 0; xx < p1; xx++) {
-      __asm__(NOP1);
-    }
-    digitalWriteFast(optical_out, LOW);
-    for (xx = 0; xx < p2; xx++) {
-      __asm__(NOP1);
-    }
-  }
+  elapsedMicros since_start;
 
-    // Adjusted by measuring interrupt rate on scope
-    //delay(96);
-    //delayMicroseconds(877);
-    delay(96);
-    delayMicroseconds(910);
-    }
-}
-
-// First use transfer_sram() to copy 64kB payload into Teensy SRAM variable ram[]
-// Then call insert_crc() if desired
-// This function will then apply 4B5B encoding and store the new payload in payload4b5b[]
-// This conversion has been validated against the matlab-based conversion and gives the same result
-// BW 11/17/18
-void encode_4b5b() {
+  for (int ii = 0; ii < 50; ii++) {
+    since_start = 0;
 
-  byte converted_nibbles[8];
+    opt_begin(p1, p2, p3, p4);
 
-  // Process input binary data 4 bytes at a time
-  for (int ii = 0; ii < 16384 ; ii = ii + 1) {
+    // Send Preamble of 101010 to allow optical RX to settle
+    opt_add_fill(preamble[0], PREAMBLE_LENGTH);
 
-    // Convert the 4-bit MSB/LSB chunks of the 4 bytes into 8 5-bit encoded values
-    for (int jj = 0; jj < 4 ; jj = jj + 1) {
+    // Send start symbol to throw interrupt
+    opt_add_bytes(sfd, 4);
 
-      //MSBs
-      converted_nibbles[2 * jj + 1] = LUT_4B5B(ram[ii * 4 + jj] >> 4);
+    // Need to send some extra bits to clock last value through
+    opt_add_fill(0xFF, 7);
 
-      //LSBs
-      converted_nibbles[2 * jj] = LUT_4B5B(ram[ii * 4 + jj] & 0xF);
+    opt_run();
 
+    while (since_start < 100000) {
+      yield();
     }
-
-    // The 8 chunks of 5 bits are then turned back into 5 bytes
-    payload4b5b[ii * 5 + 0]  = converted_nibbles[0] | converted_nibbles[1] << 5;
-    payload4b5b[ii * 5 + 1] = converted_nibbles[1] >> 3 | converted_nibbles[2] << 2 | converted_nibbles[3] << 7;
-    payload4b5b[ii * 5 + 2] = converted_nibbles[3] >> 1 | converted_nibbles[4] << 4;
-    payload4b5b[ii * 5 + 3] = converted_nibbles[4] >> 4 | converted_nibbles[5] << 1 | converted_nibbles[6] << 6;
-    payload4b5b[ii * 5 + 4] = converted_nibbles[6] >> 2 | converted_nibbles[7] << 3;
   }
-
-  // For debug printing
-  //  for (byte ii = 0; ii < 15 ; ii = ii + 1) {
-  //    Serial.println(payload4b5b[ii]);
-  //  }
-  // Serial.println("Encoding Done");
-
 }
 
-// Look-up table for doing 4bit to 5bit mapping
-byte LUT_4B5B(byte in) {
-  if (in == 0) return 0x1E;
-  if (in == 1) return 0x09;
-  if (in == 2) return 0x14;
-  if (in == 3) return 0x15;
-
-  if (in == 4) return 0x0A;
-  if (in == 5) return 0x0B;
-  if (in == 6) return 0x0E;
-  if (in == 7) return 0x0F;
-
-  if (in == 8) return 0x12;
-  if (in == 9) return 0x13;
-  if (in == 10) return 0x16;
-  if (in == 11) return 0x17;
-
-  if (in == 12) return 0x1A;
-  if (in == 13) return 0x1B;
-  if (in == 14) return 0x1C;
-  if (in == 15) return 0x1D;
+// 4B5B encoding now happens on the fly while sending (encoder_4b5b.h), so there is nothing to do here
+// Kept so that existing host scripts which send "encode4b5b" still work
+void encode_4b5b() {
 }
 
-
 // Reverses (reflects) bits in a 32-bit word.
 unsigned reverse(unsigned x) {
   x = ((x & 0x55555555) <<  1) | ((x >>  1) & 0x55555555);
@@ -1563,13 +1788,23 @@ unsigned reverse(unsigned x) {
 
 // Same C function used for calculating CRC on SCM
 unsigned int crc32c(unsigned int length) {
-  int i, j;
-  unsigned int byte, crc;
+  return crc32_buf(ram, length);
+}
+
+// CRC over an arbitrary buffer, e.g. one block of ram[]
+unsigned int crc32_buf(byte *data, unsigned int length) {
+  return reverse(~crc32_update(0xFFFFFFFF, data, length));
+}
+
+// Incremental form of crc32_buf(): start from 0xFFFFFFFF, finish with reverse(~crc)
+unsigned int crc32_update(unsigned int crc, byte *data, unsigned int length) {
+  unsigned int i;
+  int j;
+  unsigned int byte;
 
   i = 0;
-  crc = 0xFFFFFFFF;
   while (i < length) {
-    byte = ram[i];            // Get next byte.
+    byte = data[i];            // Get next byte.
     byte = reverse(byte);         // 32-bit reversal.
     for (j = 0; j <= 7; j++) {    // Do eight times.
       if ((int)(crc ^ byte) < 0)
@@ -1579,7 +1814,7 @@ unsigned int crc32c(unsigned int length) {
     }
     i = i + 1;
   }
-  return reverse(~crc);
+  return crc;
 }
 
 // First use transfer_sram() to copy 64kB payload into Teensy SRAM variable ram[]
@@ -1595,6 +1830,7 @@ void insert_crc() {
 
   // Calculate CRC value
   calculated_crc = crc32c(code_length);
+  wb_code_length = code_length;
 
   // Store CRC in binary at location 0xFFFC
   ram[65535] = (calculated_crc & 0xFF000000) >> 24;
@@ -8,8 +8,12 @@ void test_get_asc_bit(void) {
 	/*
 	Functions tested:
 		get_asc_bit()
+		asc_dump()
+	Only failures are printed, followed by a summary line and a dump of
+	ASC[] with every odd position set.
 	*/
 	unsigned int ASC_bit;
+	unsigned int errors = 0;
 
 	unsigned int i;
 	for(i=0; i<1200; i++) {
@@ -17,20 +21,23 @@ void test_get_asc_bit(void) {
 		ASC_bit = get_asc_bit(i);
 		if (ASC_bit != 1) {
 			printf("Incorrect at index %d \n", i);
-		}
-		else {
-			printf("ok %d \n", i);
+			errors++;
 		}
 
 		clear_asc_bit(i);
 		ASC_bit = get_asc_bit(i);
 		if (ASC_bit != 0) {
 			printf("Incorrect at index %d \n", i);
+			errors++;
 		}
-		else {
-			printf("ok %d \n", i);
-		}
 	}
+	printf("get_asc_bit: %u errors\n", errors);
+
+	for(i=0; i<1200; i++) {
+		if(i & 0x1) set_asc_bit(i);
+		else clear_asc_bit(i);
+	}
+	asc_dump();
 }
 
 void test_get_GPIO_enables(void) {
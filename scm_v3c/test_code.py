@@ -7,6 +7,7 @@ SCM. Intended to work in conjunction with test_code.c.
 import serial
 from bootload import *
 from sensor_adc.adc_fsm import *
+from asc_fields import read_asc_dump, diff_asc
 
 def test_get_asc_bit(uart_port, output_file):
 	"""
@@ -17,7 +18,8 @@ def test_get_asc_bit(uart_port, output_file):
 			port output to.
 	Outputs
 		No return value. Assuming test_get_asc_bit() in C is running,
-		reads the output from that via serial port.
+		reads the output from that via serial port and checks the ASC
+		dump that follows it.
 	"""
 	uart_ser = serial.Serial(
 			port=uart_port,
@@ -28,10 +30,17 @@ def test_get_asc_bit(uart_port, output_file):
 			timeout=.5)
 
 	with open(output_file,'wb') as f:
-		for i in range(1200*2):
+		while True:
 			output = uart_ser.readline()
 			print(output)
 			f.write(output)
+			if not output or output.startswith(b'get_asc_bit:'):
+				break
+
+	# Every odd position was left set
+	expected = [ii & 1 for ii in range(1200)]
+	bad = diff_asc(expected, read_asc_dump(uart_ser, send_command=False))
+	print("ASC dump: {} positions differ {}".format(len(bad), bad[:20]))
 
 	uart_ser.close()
 
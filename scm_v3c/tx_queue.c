@@ -0,0 +1,70 @@
+#include "tx_queue.h"
+#include "spsc.h"
+
+// TX frame queue
+// tx_frames[tx_tail] up to tx_head are queued frames, oldest first. The main loop builds a frame
+// directly in tx_frames[tx_head] and then moves tx_head; RF_ISR points the RF controller at
+// tx_frames[tx_tail] and moves tx_tail once it is sent. Each side only stores its own index (spsc.h),
+// so nothing is locked or copied.
+// The ack used to be whatever was in send_packet[]; it now has its own buffer so it cannot be
+// overwritten by a frame being built, and staging it at RX done is a single byte store. The cpy
+// command and radio_loadPacket() copy the first TX_ACK_BYTES of send_packet[] into it, so the ack
+// still carries what was last put there, with the sequence number written over TX_ACK_SEQ_BYTE.
+
+char tx_frames[TX_QUEUE_FRAMES][TX_FRAME_BYTES] __attribute__ ((aligned (4)));
+unsigned char tx_frame_length[TX_QUEUE_FRAMES];
+
+volatile unsigned char tx_head = 0;
+volatile unsigned char tx_tail = 0;
+
+// 802.15.4 ack: frame control 0x0002, sequence number, padded to TX_ACK_BYTES
+char tx_ack_frame[TX_FRAME_BYTES] __attribute__ ((aligned (4))) = {0x02, 0x00};
+unsigned char tx_ack_len = TX_ACK_BYTES;
+
+char* tx_queue_alloc(void) {
+	if(SPSC_FULL(tx_head, tx_tail, TX_QUEUE_FRAMES))
+		return 0;
+	return tx_frames[tx_head];
+}
+
+void tx_queue_commit(unsigned int length) {
+	if(SPSC_FULL(tx_head, tx_tail, TX_QUEUE_FRAMES))
+		return;
+	tx_frame_length[tx_head] = (unsigned char)(length < TX_MAX_PAYLOAD ? length : TX_MAX_PAYLOAD);
+	tx_head = SPSC_NEXT(tx_head, TX_QUEUE_FRAMES);
+}
+
+unsigned int tx_queue_count(void) {
+	return SPSC_COUNT(tx_head, tx_tail, TX_QUEUE_FRAMES);
+}
+
+char* tx_queue_peek(unsigned int* length) {
+	if(SPSC_EMPTY(tx_head, tx_tail))
+		return 0;
+	*length = tx_frame_length[tx_tail];
+	return tx_frames[tx_tail];
+}
+
+void tx_queue_sent(void) {
+	if(!SPSC_EMPTY(tx_head, tx_tail))
+		tx_tail = SPSC_NEXT(tx_tail, TX_QUEUE_FRAMES);
+}
+
+void tx_ack_set(const char* data, unsigned int length) {
+	unsigned int i;
+	
+	if(length > TX_MAX_PAYLOAD)
+		length = TX_MAX_PAYLOAD;
+	for(i=0; i<length; i++)
+		tx_ack_frame[i] = data[i];
+	tx_ack_len = (unsigned char)length;
+}
+
+char* tx_ack_stage(char seq) {
+	tx_ack_frame[TX_ACK_SEQ_BYTE] = seq;
+	return tx_ack_frame;
+}
+
+unsigned int tx_ack_length(void) {
+	return tx_ack_len;
+}
@@ -0,0 +1,45 @@
+#ifndef tx_queue   /* Include guard */
+#define tx_queue
+
+// Queue of TX frames for the RF controller, and the ack template
+// Frames are built in place in a queue slot from the main loop and sent from RF_ISR, one after the
+// other for a burst (radio_txBurst() in scum_radio_bsp.c). The ack RF_ISR sends after a good packet is
+// kept ready in its own buffer, so only the sequence number is written at RX done. See tx_queue.c.
+
+// Number of frames, a power of two; at most TX_QUEUE_FRAMES - 1 are queued (spsc.h)
+#define TX_QUEUE_FRAMES		4
+#if (TX_QUEUE_FRAMES & (TX_QUEUE_FRAMES - 1)) != 0
+#error TX_QUEUE_FRAMES must be a power of two
+#endif
+// Largest payload, the radio appends the 2 CRC bytes
+#define TX_MAX_PAYLOAD		125
+// Frame buffer size, rounded up to whole words
+#define TX_FRAME_BYTES		128
+
+// Ack payload length, as RF_ISR has always sent
+#define TX_ACK_BYTES		30
+// Ack byte set to the sequence number of the packet being acked: 802.15.4 frame control, then sequence number
+#define TX_ACK_SEQ_BYTE		2
+// Byte of a received packet (rx_packet data, after the length byte) holding its sequence number
+#define RX_SEQ_BYTE			3
+
+// From the main loop: buffer for the next frame, or 0 if the queue is full
+char* tx_queue_alloc(void);
+// Queues the frame written to the tx_queue_alloc() buffer, length bytes of payload
+void tx_queue_commit(unsigned int length);
+// Number of queued frames
+unsigned int tx_queue_count(void);
+
+// From RF_ISR: oldest queued frame and its length, or 0 if none
+char* tx_queue_peek(unsigned int* length);
+// Frees the frame returned by tx_queue_peek() once it has been sent
+void tx_queue_sent(void);
+
+// Replaces the ack template, up to TX_MAX_PAYLOAD bytes; it is an 802.15.4 ack frame control until the
+// cpy command or radio_loadPacket() copies in the start of send_packet[]
+void tx_ack_set(const char* data, unsigned int length);
+// Writes the sequence number into the template and returns it, ready to load
+char* tx_ack_stage(char seq);
+unsigned int tx_ack_length(void);
+
+#endif
@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "uart_cmd.h"
+#include "crc32.h"
+#include "spsc.h"
+
+// UART command dispatcher
+// UART_ISR used to match a 4-character window against every command and run the command in the
+// interrupt, so a command that printed or wrote the scan chain held off the radio interrupts and
+// bytes arriving meanwhile were lost. Now the ISR only stores the byte in a ring: UART_ISR is the
+// only producer and the main loop the only consumer (spsc.h). uart_cmd_poll() feeds the bytes through a small state machine that collects a
+// text line or a binary frame, then looks the command up and runs it.
+
+unsigned char uart_rx_buffer[UART_RX_BYTES];
+volatile unsigned int uart_rx_head = 0;
+volatile unsigned int uart_rx_tail = 0;
+volatile unsigned int uart_rx_drops = 0;
+
+// What the next byte is
+#define CMD_TEXT		0	// Text line, or UART_CMD_SYNC at the start of a line
+#define CMD_SKIP		1	// Rest of a text line that was too long
+#define CMD_OPCODE		2
+#define CMD_LENGTH		3
+#define CMD_PAYLOAD		4
+#define CMD_CRC			5
+
+static unsigned int cmd_state = CMD_TEXT;
+static char cmd_line[UART_CMD_LINE_BYTES + 1];
+static unsigned int cmd_len = 0;
+static unsigned int cmd_opcode;
+static unsigned int cmd_payload_len;
+static unsigned int cmd_crc;
+static unsigned int cmd_rx_crc;
+static unsigned int cmd_crc_bytes;
+static unsigned int cmd_running = 0;
+
+void uart_rx_put(unsigned char ch) {
+
+	unsigned int head = uart_rx_head;
+	unsigned int next = SPSC_NEXT(head, UART_RX_BYTES);
+
+	if(next == uart_rx_tail) {
+		uart_rx_drops++;
+		return;
+	}
+	uart_rx_buffer[head] = ch;
+	uart_rx_head = next;
+}
+
+// "sft" on a line of its own, matched as the bytes arrive; starts as if after a newline
+static const char sft_line[] = "\nsft\n";
+static unsigned int sft_matched = 1;
+
+// Binary frames are passed over the way cmd_byte() reads them, their payload and CRC can hold any byte
+#define SFT_TEXT		0
+#define SFT_OPCODE		1
+#define SFT_LENGTH		2
+#define SFT_FRAME		3	// Payload and CRC
+static unsigned int sft_state = SFT_TEXT;
+static unsigned int sft_frame_left;
+
+unsigned int uart_rx_soft_reset(unsigned char ch) {
+
+	switch(sft_state) {
+	case SFT_OPCODE:
+		sft_state = SFT_LENGTH;
+		return 0;
+	case SFT_LENGTH:
+		sft_frame_left = ch + 4;
+		sft_state = SFT_FRAME;
+		return 0;
+	case SFT_FRAME:
+		// The frame ends at the start of a line, as cmd_byte() sees it
+		if(--sft_frame_left == 0)
+			sft_state = SFT_TEXT;
+		return 0;
+	}
+
+	if(ch == UART_CMD_SYNC && sft_matched == 1) {
+		sft_state = SFT_OPCODE;
+		return 0;
+	}
+	if(ch == '\r' && sft_matched == 4)
+		return 0;
+	if(ch == sft_line[sft_matched])
+		sft_matched++;
+	else
+		sft_matched = ch == '\n';
+	if(sft_matched < sizeof(sft_line) - 1)
+		return 0;
+	sft_matched = 1;
+	return 1;
+}
+
+unsigned int uart_cmd_arg(const uart_cmd_args* args, unsigned int i, unsigned int fallback) {
+	return i < args->argc ? args->argv[i] : fallback;
+}
+
+static const uart_cmd_entry* find_name(const char* name) {
+
+	unsigned int lo = 0;
+	unsigned int hi = uart_num_cmds;
+	unsigned int mid;
+	int order;
+
+	while(lo < hi) {
+		mid = (lo + hi) >> 1;
+		order = strcmp(name, uart_cmds[mid].name);
+		if(order == 0)
+			return &uart_cmds[mid];
+		if(order < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return 0;
+}
+
+static const uart_cmd_entry* find_opcode(unsigned int opcode) {
+
+	unsigned int i;
+
+	for(i=0; i<uart_num_cmds; i++)
+		if(uart_cmds[i].opcode == opcode)
+			return &uart_cmds[i];
+	return 0;
+}
+
+// Space separated numbers, returns 0 if one is malformed or there are too many
+static unsigned int parse_args(char* p, uart_cmd_args* args, unsigned int max_args) {
+
+	char* end;
+
+	args->argc = 0;
+	while(1) {
+		while(*p == ' ')
+			p++;
+		if(*p == 0)
+			return 1;
+		if(args->argc == max_args)
+			return 0;
+		args->argv[args->argc++] = strtoul(p, &end, 0);
+		if(end == p || (*end != ' ' && *end != 0))
+			return 0;
+		p = end;
+	}
+}
+
+static void run_line(void) {
+
+	const uart_cmd_entry* cmd;
+	uart_cmd_args args;
+	char* rest;
+
+	if(cmd_len > 0 && cmd_line[cmd_len - 1] == '\r')
+		cmd_len--;
+	if(cmd_len == 0)
+		return;
+	cmd_line[cmd_len] = 0;
+
+	rest = strchr(cmd_line, ' ');
+	if(rest)
+		*rest++ = 0;
+	else
+		rest = &cmd_line[cmd_len];
+
+	cmd = find_name(cmd_line);
+	if(cmd == 0) {
+		printf("unknown command\n");
+		return;
+	}
+
+	args.text = rest;
+	args.text_len = &cmd_line[cmd_len] - rest;
+	if(cmd->max_args == UART_CMD_TEXT)
+		args.argc = 0;
+	else if(!parse_args(rest, &args, cmd->max_args)) {
+		printf("bad arguments for %s\n", cmd->name);
+		return;
+	}
+	cmd->run(&args);
+}
+
+static void run_frame(void) {
+
+	const uart_cmd_entry* cmd = find_opcode(cmd_opcode);
+	uart_cmd_args args;
+	unsigned int i;
+	unsigned char* word;
+
+	if(cmd_rx_crc != crc_final(cmd_crc) || cmd == 0 || cmd_payload_len > UART_CMD_LINE_BYTES) {
+		printf("NAK %u\n", cmd_opcode);
+		return;
+	}
+
+	args.text = cmd_line;
+	args.text_len = cmd_payload_len;
+	args.argc = 0;
+	if(cmd->max_args != UART_CMD_TEXT) {
+		if((cmd_payload_len & 3) || (cmd_payload_len >> 2) > cmd->max_args) {
+			printf("NAK %u\n", cmd_opcode);
+			return;
+		}
+		args.argc = cmd_payload_len >> 2;
+		for(i=0; i<args.argc; i++) {
+			word = (unsigned char*)&cmd_line[i << 2];
+			args.argv[i] = (word[0] << 24) | (word[1] << 16) | (word[2] << 8) | word[3];
+		}
+	}
+	cmd->run(&args);
+	printf("ACK %u\n", cmd_opcode);
+}
+
+static void cmd_byte(unsigned char ch) {
+
+	switch(cmd_state) {
+	case CMD_TEXT:
+		if(ch == UART_CMD_SYNC && cmd_len == 0) {
+			cmd_crc = crc_init();
+			cmd_state = CMD_OPCODE;
+		} else if(ch == '\n') {
+			run_line();
+			cmd_len = 0;
+		} else if(cmd_len == UART_CMD_LINE_BYTES) {
+			printf("Input exceeds maximum line length\n");
+			cmd_state = CMD_SKIP;
+		} else
+			cmd_line[cmd_len++] = ch;
+		break;
+	case CMD_SKIP:
+		if(ch == '\n') {
+			cmd_len = 0;
+			cmd_state = CMD_TEXT;
+		}
+		break;
+	case CMD_OPCODE:
+		cmd_opcode = ch;
+		cmd_crc = crc_update(cmd_crc, &ch, 1);
+		cmd_state = CMD_LENGTH;
+		break;
+	case CMD_LENGTH:
+		cmd_payload_len = ch;
+		cmd_crc = crc_update(cmd_crc, &ch, 1);
+		cmd_len = 0;
+		cmd_rx_crc = 0;
+		cmd_crc_bytes = 0;
+		cmd_state = ch ? CMD_PAYLOAD : CMD_CRC;
+		break;
+	case CMD_PAYLOAD:
+		// A payload too long for the buffer is still read to its end, then refused
+		if(cmd_len < UART_CMD_LINE_BYTES)
+			cmd_line[cmd_len] = ch;
+		cmd_len++;
+		cmd_crc = crc_update(cmd_crc, &ch, 1);
+		if(cmd_len == cmd_payload_len)
+			cmd_state = CMD_CRC;
+		break;
+	case CMD_CRC:
+		cmd_rx_crc = (cmd_rx_crc << 8) | ch;
+		if(++cmd_crc_bytes == 4) {
+			run_frame();
+			cmd_len = 0;
+			cmd_state = CMD_TEXT;
+		}
+		break;
+	}
+}
+
+void uart_cmd_poll(void) {
+
+	unsigned int tail;
+	unsigned char ch;
+
+	// A command that waits and polls again must not have its line overwritten
+	if(cmd_running)
+		return;
+	cmd_running = 1;
+
+	tail = uart_rx_tail;
+	while(!SPSC_EMPTY(uart_rx_head, tail)) {
+		ch = uart_rx_buffer[tail];
+		tail = SPSC_NEXT(tail, UART_RX_BYTES);
+		// Free the byte before running a command, which may take a while
+		uart_rx_tail = tail;
+		cmd_byte(ch);
+	}
+
+	cmd_running = 0;
+}
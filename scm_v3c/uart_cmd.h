@@ -0,0 +1,61 @@
+#ifndef uart_cmd   /* Include guard */
+#define uart_cmd
+
+// UART command dispatcher
+// UART_ISR only queues each received byte (uart_rx_put()); the main loop runs the commands (uart_cmd_poll())
+// from the command table, uart_cmds[] in Int_Handlers.h. Two ways to send a command, mixed freely:
+//   text:   a line with the name and optional arguments separated by spaces, e.g. "atx 250000\n".
+//           Numbers are decimal or 0x hex; a UART_CMD_TEXT command gets the rest of the line as is.
+//   binary: UART_CMD_SYNC, opcode, payload length (0-255), payload, CRC-32 of the opcode, length and
+//           payload MSB first. The payload is the arguments as 4-byte words MSB first, or the text of a
+//           UART_CMD_TEXT command. The chip answers "ACK <opcode>\n" once the command has run, or
+//           "NAK <opcode>\n" if the frame was corrupted or not accepted, and the command is not run.
+// uart_cmd.py on the host reads the table and sends either form. See uart_cmd.c.
+
+// RX ring size in bytes, a power of two
+#define UART_RX_BYTES			256
+#if (UART_RX_BYTES & (UART_RX_BYTES - 1)) != 0
+#error UART_RX_BYTES must be a power of two
+#endif
+// Longest text line or binary payload: "cpy " and a 127-byte packet fit
+#define UART_CMD_LINE_BYTES		136
+// Most numeric arguments a command can take
+#define UART_CMD_MAX_ARGS		8
+// First byte of a binary frame, never the start of a text command
+#define UART_CMD_SYNC			0xA5
+// max_args of a command that takes its arguments as text
+#define UART_CMD_TEXT			0xFF
+
+typedef struct {
+	unsigned int argc;
+	unsigned int argv[UART_CMD_MAX_ARGS];
+	// Text after the name and its space, or the binary payload; not NUL terminated
+	const char* text;
+	unsigned int text_len;
+} uart_cmd_args;
+
+typedef struct {
+	char name[4];
+	unsigned char opcode;
+	unsigned char max_args;
+	void (*run)(const uart_cmd_args* args);
+} uart_cmd_entry;
+
+// The command table, sorted by name for the lookup; opcodes must not change once a host script uses them
+extern const uart_cmd_entry uart_cmds[];
+extern const unsigned int uart_num_cmds;
+
+// Bytes lost because the RX ring was full
+extern volatile unsigned int uart_rx_drops;
+
+// From UART_ISR: queues a received byte
+void uart_rx_put(unsigned char ch);
+// From UART_ISR: returns 1 once the bytes given so far end with the text line "sft", so the soft reset
+// does not depend on the main loop still polling. Bytes inside binary frames are not matched
+unsigned int uart_rx_soft_reset(unsigned char ch);
+// From the main loop and wait loops: runs every complete command received so far
+void uart_cmd_poll(void);
+// Argument i of a command, or fallback if it was not given
+unsigned int uart_cmd_arg(const uart_cmd_args* args, unsigned int i, unsigned int fallback);
+
+#endif
@@ -0,0 +1,154 @@
+"""
+Host side of the firmware's UART command dispatcher (uart_cmd.c).
+
+Commands can be sent as text lines, e.g. b'atx 250000\\n', or as binary
+frames:
+	0xA5, opcode, payload length, payload, CRC-32 of opcode, length and payload MSB first
+with the arguments as 4-byte words MSB first (or the raw text for a command
+like cpy). The chip queues received bytes, so frames can be sent back to
+back as long as they fit in its RX ring (UART_RX_BYTES in uart_cmd.h); it
+answers each one with "ACK <opcode>" after the command's own output, or
+"NAK <opcode>" if the frame was corrupted and the command was not run. The names and opcodes come from the uart_cmds[] table in
+Int_Handlers.h.
+
+Run commands from the command line:
+	python uart_cmd.py COM18 "atx 250000" rrt
+"""
+
+import os
+import re
+import struct
+import sys
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TABLE = os.path.join(HERE, 'Int_Handlers.h')
+
+SYNC = 0xA5
+TEXT_ARGS = 'UART_CMD_TEXT'
+MAX_PAYLOAD = 136
+# UART_RX_BYTES in uart_cmd.h; the ring holds one byte less
+RX_WINDOW = 256 - 1
+
+ENTRY_RE = re.compile(r'\{\s*"(\w+)",\s*(0x[0-9A-Fa-f]+|\d+),\s*(\w+),\s*\w+\s*\}')
+
+def load_commands(path=TABLE):
+	"""
+	Inputs:
+		path: String. File holding the uart_cmds[] table.
+	Outputs:
+		Returns a list of (name, opcode, most numeric arguments) in table
+		order; the argument count is None for commands that take text.
+	"""
+	with open(path) as f:
+		text = f.read()
+	table = text[text.index('uart_cmds[] = {'):]
+	table = table[:table.index('};')]
+	return [(name, int(opcode, 0), None if max_args == TEXT_ARGS else int(max_args))
+		for name, opcode, max_args in ENTRY_RE.findall(table)]
+
+def encode_frame(opcode, args=(), text=None):
+	"""
+	Inputs:
+		opcode: Integer. Opcode of the command.
+		args: Sequence of integers. Numeric arguments.
+		text: Bytes or None. Payload of a command that takes text, used instead of args.
+	Outputs:
+		Returns the binary frame as bytes.
+	Raises:
+		ValueError if the payload is too long for the chip.
+	"""
+	payload = text if text is not None else b''.join(struct.pack('>I', a & 0xFFFFFFFF) for a in args)
+	if len(payload) > MAX_PAYLOAD:
+		raise ValueError("Payload of {} bytes is longer than {}".format(len(payload), MAX_PAYLOAD))
+	body = bytes([opcode, len(payload)]) + payload
+	return bytes([SYNC]) + body + struct.pack('>I', zlib.crc32(body))
+
+def run_commands(uart_ser, commands, table=None, window=RX_WINDOW):
+	"""
+	Inputs:
+		uart_ser: The serial connection (type Serial) to the SCM UART.
+		commands: List of (name, args) with args a sequence of integers, or
+			bytes for a command that takes text.
+		table: List from load_commands(), read from Int_Handlers.h if None.
+		window: Integer. Most bytes sent but not yet answered, so the chip's
+			RX ring never overflows.
+	Outputs:
+		Sends the commands as binary frames, back to back while their bytes
+		fit in window and each time an answer frees room, then returns a
+		list with the lines each command printed, in order.
+		A last sft is sent as the text line "sft", which the chip acts on in
+		its UART interrupt, and is not waited for: the chip resets instead
+		of answering. Its output is an empty list.
+	Raises:
+		KeyError for an unknown command name.
+		ValueError if the chip refuses a frame or the replies are out of step;
+		the commands after it are not waited for. Also if sft is not last.
+	"""
+	opcodes = {name: opcode for name, opcode, _ in (table or load_commands())}
+	reset = bool(commands) and commands[-1][0] == 'sft'
+	if reset:
+		commands = commands[:-1]
+	if any(name == 'sft' for name, _ in commands):
+		raise ValueError("sft resets the chip, it must be the last command")
+	frames = []
+	expected = []
+	for name, args in commands:
+		opcode = opcodes[name]
+		if isinstance(args, bytes):
+			frames.append(encode_frame(opcode, text=args))
+		else:
+			frames.append(encode_frame(opcode, args))
+		expected.append((name, opcode))
+
+	outputs = []
+	lines = []
+	sent = 0
+	in_flight = 0
+	while len(outputs) < len(expected):
+		# A command's frame has left the ring by the time it is answered
+		burst = []
+		while sent < len(frames) and (in_flight == 0 or in_flight + len(frames[sent]) <= window):
+			burst.append(frames[sent])
+			in_flight += len(frames[sent])
+			sent += 1
+		if burst:
+			uart_ser.write(b''.join(burst))
+
+		line = uart_ser.readline()
+		if not line:
+			raise ValueError("No reply to {}".format(expected[len(outputs)][0]))
+		fields = line.split()
+		if len(fields) == 2 and fields[0] in (b'ACK', b'NAK') and fields[1].isdigit():
+			name, opcode = expected[len(outputs)]
+			if fields[0] == b'NAK' or int(fields[1]) != opcode:
+				raise ValueError("{} for {}: {}".format(fields[0].decode(), name, line.strip().decode()))
+			in_flight -= len(frames[len(outputs)])
+			outputs.append(lines)
+			lines = []
+		else:
+			lines.append(line.decode('latin-1'))
+	if reset:
+		uart_ser.write(b'sft\n')
+		outputs.append([])
+	return outputs
+
+def parse_command(text):
+	"""Splits "atx 250000" into ('atx', [250000]); cpy keeps its text as bytes."""
+	name, _, rest = text.partition(' ')
+	if name == 'cpy':
+		return name, rest.encode('latin-1')
+	return name, [int(arg, 0) for arg in rest.split()]
+
+if __name__ == "__main__":
+	import serial
+
+	if len(sys.argv) < 3:
+		print(__doc__)
+		sys.exit(1)
+	uart = serial.Serial(port=sys.argv[1], baudrate=19200, timeout=2)
+	try:
+		for text, lines in zip(sys.argv[2:], run_commands(uart, [parse_command(c) for c in sys.argv[2:]])):
+			print("{}: {}".format(text, ''.join(lines).rstrip()))
+	finally:
+		uart.close()
@@ -0,0 +1,183 @@
+#include "uart_tx.h"
+#include "spsc.h"
+
+// Buffered UART transmit
+// A write to the UART data register holds the bus until the UART can take the character, so sending
+// straight from printf() runs the caller at 19200 baud, about 0.5 ms per character. The SCM3C UART has
+// no TX-empty flag or TX interrupt (its interrupt is RX only), so the FIFO is drained from the RF timer
+// instead: COMPARE7 is armed one character time ahead and each match sends one character, by which time
+// the UART has finished the previous one and the write does not stall.
+// Producers are the main loop and the ISRs (uart_out() from printf()), the only consumer besides
+// uart_tx_flush() is RFTIMER_ISR. The ISRs all run at the default NVIC priority, so only the main loop
+// side needs interrupts off while it touches the FIFO, and a character is always popped and written
+// in one critical section so the order on the line is the order of the FIFO.
+// initialize_mote() starts the RF timer and unmasks its interrupt, so output is buffered from then on.
+// Before that (the "Initializing..." print in main()), and after cmd_xx1 masks the RF timer, nothing
+// drains the FIFO and uart_tx_put() falls back to sending directly. If COMPARE7 was left where it will
+// not match (see uart_tx_stale()), the next uart_tx_put() re-arms it. Code that masks the RF timer in
+// the NVIC flushes first.
+
+#ifndef UART_TX_HOST
+#include "Memory_Map.h"
+
+// RF timer counts per character: 10 bits at 19200 baud is 260 counts at 500 kHz, plus some margin
+#define UART_TX_TICKS		270
+
+static void uart_tx_write(int ch) {
+	UART_REG__TX_DATA = ch;
+}
+
+static unsigned int uart_tx_tick_ok(void) {
+	return (RFTIMER_REG__CONTROL & (RFTIMER_REG__CONTROL_ENABLE | RFTIMER_REG__CONTROL_INTERRUPT_ENABLE))
+		== (RFTIMER_REG__CONTROL_ENABLE | RFTIMER_REG__CONTROL_INTERRUPT_ENABLE) && (ISER & 0x80);
+}
+
+static void uart_tx_arm(void) {
+	unsigned int now = RFTIMER_REG__COUNTER;
+	unsigned int max = RFTIMER_REG__MAX_COUNT;
+	unsigned int left = now < max ? max - now : 0;
+	unsigned int target;
+
+	// The counter rolls over to 0 after MAX_COUNT
+	if(left < UART_TX_TICKS)
+		target = UART_TX_TICKS - left - 1;
+	else
+		target = now + UART_TX_TICKS;
+	// A period shorter than a character still matches once per period
+	if(target > max)
+		target = max;
+	RFTIMER_REG__COMPARE7 = target;
+	RFTIMER_REG__COMPARE7_CONTROL = 0x3;
+}
+
+// COMPARE7 is armed but will not match in time: MAX_COUNT was lowered below it (housekeeping sets it
+// every packet), or the counter was moved (RF_ISR syncs it to expected_RX_arrival) so it is neither
+// just before the compare nor just past it with the match still to be serviced
+static unsigned int uart_tx_stale(void) {
+	unsigned int now = RFTIMER_REG__COUNTER;
+	unsigned int max = RFTIMER_REG__MAX_COUNT;
+	unsigned int target = RFTIMER_REG__COMPARE7;
+	unsigned int ahead, behind;
+
+	if(target > max || now > max)
+		return 1;
+	ahead = target >= now ? target - now : target + (max + 1 - now);
+	behind = now >= target ? now - target : now + (max + 1 - target);
+	return ahead > UART_TX_TICKS && behind > UART_TX_TICKS;
+}
+
+static void uart_tx_disarm(void) {
+	RFTIMER_REG__COMPARE7_CONTROL = 0x0;
+}
+
+// Returns the PRIMASK to restore, so the FIFO can also be used with interrupts already off
+static unsigned int uart_tx_lock(void) {
+	register unsigned int primask __asm("primask");
+	unsigned int saved = primask;
+
+	__disable_irq();
+	return saved;
+}
+
+static void uart_tx_unlock(unsigned int saved) {
+	if(!saved)
+		__enable_irq();
+}
+#else
+// Host build (tests/uart_tx_host.c) supplies the hardware side
+void uart_tx_write(int ch);
+unsigned int uart_tx_tick_ok(void);
+void uart_tx_arm(void);
+unsigned int uart_tx_stale(void);
+void uart_tx_disarm(void);
+unsigned int uart_tx_lock(void);
+void uart_tx_unlock(unsigned int saved);
+#endif
+
+unsigned char uart_tx_fifo[UART_TX_FIFO_BYTES];
+volatile unsigned int uart_tx_head = 0;
+volatile unsigned int uart_tx_tail = 0;
+// COMPARE7 is armed and will send the next character
+volatile unsigned int uart_tx_busy = 0;
+
+volatile unsigned int uart_tx_policy = UART_TX_BLOCK;
+volatile unsigned int uart_tx_drops = 0;
+
+// Call with the FIFO locked and not empty
+static void uart_tx_send_oldest(void) {
+	unsigned int tail = uart_tx_tail;
+
+	uart_tx_write(uart_tx_fifo[tail]);
+	uart_tx_tail = SPSC_NEXT(tail, UART_TX_FIFO_BYTES);
+}
+
+int uart_tx_put(int ch) {
+
+	unsigned int saved;
+
+	if(!uart_tx_tick_ok()) {
+		// Nothing drains the FIFO: send what is queued, then ch, at line speed
+		uart_tx_flush();
+		saved = uart_tx_lock();
+		uart_tx_busy = 0;
+		uart_tx_disarm();
+		uart_tx_write(ch);
+		uart_tx_unlock(saved);
+		return ch;
+	}
+
+	saved = uart_tx_lock();
+	if(uart_tx_busy && uart_tx_stale()) {
+		// Nothing would drain the FIFO: restart it with the oldest character, or go idle if empty
+		if(!SPSC_EMPTY(uart_tx_head, uart_tx_tail)) {
+			uart_tx_send_oldest();
+			uart_tx_arm();
+		} else
+			uart_tx_busy = 0;
+	}
+	if(!uart_tx_busy) {
+		// The line is idle: send ch now and leave the next ones to COMPARE7
+		uart_tx_write(ch);
+		uart_tx_busy = 1;
+		uart_tx_arm();
+	} else {
+		if(SPSC_FULL(uart_tx_head, uart_tx_tail, UART_TX_FIFO_BYTES)) {
+			if(uart_tx_policy == UART_TX_DROP) {
+				uart_tx_drops++;
+				uart_tx_unlock(saved);
+				return ch;
+			}
+			uart_tx_send_oldest();
+		}
+		uart_tx_fifo[uart_tx_head] = ch;
+		uart_tx_head = SPSC_NEXT(uart_tx_head, UART_TX_FIFO_BYTES);
+	}
+	uart_tx_unlock(saved);
+	return ch;
+}
+
+void uart_tx_tick(void) {
+	if(!SPSC_EMPTY(uart_tx_head, uart_tx_tail)) {
+		uart_tx_send_oldest();
+		uart_tx_arm();
+	} else {
+		uart_tx_busy = 0;
+		uart_tx_disarm();
+	}
+}
+
+void uart_tx_flush(void) {
+
+	unsigned int saved;
+
+	// Interrupts are only held off for one character at a time
+	while(1) {
+		saved = uart_tx_lock();
+		if(SPSC_EMPTY(uart_tx_head, uart_tx_tail)) {
+			uart_tx_unlock(saved);
+			return;
+		}
+		uart_tx_send_oldest();
+		uart_tx_unlock(saved);
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef uart_tx   /* Include guard */
+#define uart_tx
+
+// Buffered UART transmit
+// uart_out() (retarget.c, so printf() too) queues characters in a FIFO that is sent one character per
+// RF timer COMPARE7 interrupt, so the caller runs on at CPU speed. See uart_tx.c.
+
+// FIFO size in bytes, a power of two
+#define UART_TX_FIFO_BYTES	512
+#if (UART_TX_FIFO_BYTES & (UART_TX_FIFO_BYTES - 1)) != 0
+#error UART_TX_FIFO_BYTES must be a power of two
+#endif
+
+// What uart_tx_put() does when the FIFO is full
+#define UART_TX_BLOCK		0	// Send the oldest queued character first, at line speed; nothing is lost
+#define UART_TX_DROP		1	// Drop the new character and count it in uart_tx_drops
+// A dropped byte in a binary frame (asc_dump(), log_drain()) fails its CRC on the host
+
+extern volatile unsigned int uart_tx_policy;
+extern volatile unsigned int uart_tx_drops;
+
+// Queues ch, returns ch
+int uart_tx_put(int ch);
+// From RFTIMER_ISR on COMPARE7: sends the next queued character
+void uart_tx_tick(void);
+// Sends everything queued before returning; the UART may still be shifting out the last character
+void uart_tx_flush(void);
+
+#endif
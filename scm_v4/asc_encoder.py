@@ -0,0 +1,147 @@
+# Generated by scan_layout.py from asc_layout.txt, do not edit
+"""
+Encoder for the 72 bit scan chain described in asc_layout.txt.
+encode() takes the arguments of scan_28.construct_ASC() and returns the same bits.
+"""
+
+CHAIN_BITS = 72
+CHAIN_BYTES = 9
+
+# name: (list argument, width, default, positions, argument element at each position,
+#	inverted positions, (op, value, chain bits) rules that override the mapping)
+FIELDS = {
+	'radio_en_tx': (True, 1, [0], (71,), (0,), (1,), ()),
+	'radio_lo_ftune': (True, 6, [0, 0, 0, 0, 0, 0], (68, 69, 70, 65, 66, 67), (0, 1, 2, 3, 4, 5), (1, 1, 1, 1, 1, 1), ()),
+	'radio_lo_itune': (True, 3, [0, 0, 0], (62, 64, 63), (0, 1, 2), (1, 1, 1), ()),
+	'radio_en_lo': (True, 1, [0], (61,), (0,), (1,), ()),
+	'radio_lo_fine': (True, 2, [0, 0], (59, 60), (0, 1), (1, 1), ()),
+	'radio_en_debug_degen': (True, 1, [0], (58,), (0,), (1,), ()),
+	'radio_en_debug_driver': (True, 1, [0], (57,), (0,), (1,), ()),
+	'radio_en_output_degen': (True, 1, [0], (56,), (0,), (1,), ()),
+	'radio_en_output_drive': (True, 1, [0], (55,), (0,), (1,), ()),
+	'cam_row': (True, 4, [0, 0, 0, 0], (33, 32, 31, 30), (0, 1, 2, 3), (1, 1, 1, 1), ()),
+	'cam_col': (True, 5, [0, 0, 0, 0, 0], (4, 3, 2, 1, 0), (0, 1, 2, 3, 4), (1, 1, 1, 1, 1), ()),
+	'cam_read': (True, 10, [0, 0, 0, 0, 0, 0, 0, 0, 0, 0], (29, 28, 27, 26, 25, 24, 23, 22, 21, 20), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9), (1, 1, 1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'cam_exposure': (True, 14, [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0], (10, 9, 8, 7, 19, 18, 17, 16, 15, 14, 13, 12, 11, 6), (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13), (1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1), ()),
+	'cam_en_dig': (True, 1, [0], (5,), (0,), (1,), ()),
+	'cam_gain': (True, 2, [0, 0], (36, 37), (0, 1), (1, 1), ()),
+	'cam_en_pga': (True, 1, [0], (35,), (0,), (1,), ()),
+	'cam_en_pixel_out': (True, 1, [0], (34,), (0,), (1,), ()),
+}
+
+# Chain bits with every field at its default
+DEFAULT = [1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1]
+
+def _field(name):
+	try:
+		return FIELDS[name]
+	except KeyError:
+		raise TypeError("No scan chain field {!r}".format(name))
+
+def value_bits(name, value):
+	"""Element bits of a field value, given as construct_scan() takes it or as an integer (MSB first)."""
+	is_list, width = _field(name)[:2]
+	if not is_list:
+		return [value]
+	if isinstance(value, int):
+		return [(value >> (width - 1 - ii)) & 1 for ii in range(width)]
+	if len(value) != width:
+		raise ValueError("{} takes {} bits, got {}".format(name, width, len(value)))
+	return list(value)
+
+def _number(name, value):
+	if _field(name)[0] and not isinstance(value, int):
+		return int(''.join(map(str, value)), 2)
+	return int(value)
+
+def _chain_bits(name, value):
+	_, _, _, _, elements, inverts, rules = _field(name)
+	number = _number(name, value)
+	for op, v, bits in rules:
+		if op == '*' or (op == '=' and number == v) or (op == '>=' and number >= v):
+			return bits
+	vbits = value_bits(name, value)
+	return [vbits[e] ^ i for e, i in zip(elements, inverts)]
+
+def encode(**fields):
+	"""
+	Inputs:
+		Any arguments of the reference function, as lists of bits or
+		integers (MSB first).
+	Outputs:
+		Returns the same list of chain bits in shift order: the default
+		image with the given fields written.
+	"""
+	bits = list(DEFAULT)
+	for name, value in fields.items():
+		for p, b in zip(_field(name)[3], _chain_bits(name, value)):
+			bits[p] = b
+	return bits
+
+# The chain as one integer, position 0 in the MSB of the first byte, and per field the mask of its
+# positions and the bit of each, so encode_bytes() touches only the given fields
+_PAD = 8 * CHAIN_BYTES - CHAIN_BITS
+_DEFAULT_INT = int(''.join(map(str, DEFAULT)), 2) << _PAD
+_BITS = {}
+for _name, _field_info in FIELDS.items():
+	_shifts = [8 * CHAIN_BYTES - 1 - p for p in _field_info[3]]
+	_BITS[_name] = (sum(1 << s for s in _shifts), _shifts)
+del _name, _field_info, _shifts
+
+def encode_bytes(**fields):
+	"""Same as encode(), packed 8 bits per byte MSB first as sent to the Teensy (scan.pack_bits)."""
+	image = _DEFAULT_INT
+	for name, value in fields.items():
+		chain = _chain_bits(name, value)
+		mask, shifts = _BITS[name]
+		image &= ~mask
+		for s, b in zip(shifts, chain):
+			if b:
+				image |= 1 << s
+	return image.to_bytes(CHAIN_BYTES, 'big')
+
+def encode_batch(count, **fields):
+	"""
+	Inputs:
+		count: Integer. Number of variants.
+		fields: Arguments of the reference function. A list or integer is
+			used for every variant. A numpy array gives one value per
+			variant, either count integers (MSB first) or a (count, width)
+			array of bits.
+	Outputs:
+		Returns a (count, CHAIN_BYTES) uint8 numpy array, row k packed
+		like encode_bytes() for variant k.
+	"""
+	import numpy as np
+
+	bits = np.tile(np.array(DEFAULT, dtype=np.uint8), (count, 1))
+	for name, value in fields.items():
+		is_list, width, _, positions, elements, inverts, rules = _field(name)
+		if isinstance(value, np.ndarray) and value.ndim == 2:
+			vbits = value.astype(np.uint8)
+			numbers = vbits.astype(np.int64).dot(1 << np.arange(width - 1, -1, -1, dtype=np.int64))
+		elif isinstance(value, np.ndarray):
+			numbers = value.astype(np.int64)
+			vbits = ((numbers[:, None] >> np.arange(width - 1, -1, -1)) & 1).astype(np.uint8)
+		else:
+			vbits = np.tile(np.array(value_bits(name, value), dtype=np.uint8), (count, 1))
+			numbers = np.full(count, _number(name, value), dtype=np.int64)
+
+		if elements is not None:
+			chain = vbits[:, list(elements)] ^ np.array(inverts, dtype=np.uint8)
+		else:
+			chain = np.zeros((count, len(positions)), dtype=np.uint8)
+		# Applied last to first so the first matching rule wins
+		for op, v, rule in reversed(rules):
+			if op == '*':
+				match = np.ones(count, dtype=bool)
+			elif op == '=':
+				match = numbers == v
+			else:
+				match = numbers >= v
+			chain = np.where(match[:, None], np.array(rule, dtype=np.uint8), chain)
+		bits[:, list(positions)] = chain
+
+	return np.packbits(bits, axis=1)
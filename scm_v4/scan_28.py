@@ -6,8 +6,11 @@ import os
 import sys
 import time
 import struct
+import zlib
 import difflib
 import visa
+
+import asc_encoder
 from subprocess import Popen, PIPE
 
 ####################################################
@@ -16,14 +19,90 @@ from subprocess import Popen, PIPE
 ####################################################
 ####################################################
 
+def pack_bits(bits):
+	"""
+	Inputs:
+		bits: List of 0/1 integers in shift order.
+	Outputs:
+		Returns the bits packed 8 per byte, bit k in bit 7-(k%8) of byte
+		k//8, zero padded, as taken by the Teensy's packed scan commands.
+	"""
+	data = bytearray((len(bits) + 7) // 8)
+	for ii, bit in enumerate(bits):
+		if bit:
+			data[ii >> 3] |= 0x80 >> (ii & 7)
+	return bytes(data)
+
+def read_packed(ser, tag):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy.
+		tag: Bytes. Start of the header line, e.g. b'ASC'.
+	Outputs:
+		Returns the bits of a "<tag> <num_bytes>" frame followed by
+		num_bytes bytes and their CRC-32, MSB first.
+	Raises:
+		ValueError if the frame is missing, short or fails its CRC.
+	"""
+	line = ser.readline()
+	if not line.startswith(tag + b' '):
+		raise ValueError("No {} frame received".format(tag.decode()))
+	num_bytes = int(line.split()[1])
+	data = ser.read(num_bytes + 4)
+	if len(data) != num_bytes + 4 or \
+			zlib.crc32(data[:num_bytes]) != int.from_bytes(data[num_bytes:], 'big'):
+		raise ValueError("Bad {} frame".format(tag.decode()))
+	return [(byte >> (7 - ii)) & 1 for byte in bytearray(data[:num_bytes]) for ii in range(8)]
+
+def scan_write(ser, ASC):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy.
+		ASC: List of integers. Analog scan chain bits.
+	Outputs:
+		Shifts ASC into the chain as packed bits with a CRC, last position
+		first, without loading it. Returns the Teensy's reply lines.
+	Raises:
+		ValueError if the Teensy rejects the write.
+	"""
+	data = pack_bits(ASC[::-1])
+	ser.write(b'ascwriteb\n')
+	lines = [ser.readline()]
+	ser.write(data + zlib.crc32(data).to_bytes(4, 'big'))
+	lines.append(ser.readline())
+	if not lines[-1].startswith(b'ASC Write Complete'):
+		raise ValueError('Scan chain write failed')
+	return lines
+
+def scan_load(ser):
+	"""Latches the shifted-in chain to its outputs, returns the Teensy's reply."""
+	ser.write(b'ascload\n')
+	return ser.readline()
+
+def scan_readback(ser, ASC):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy.
+		ASC: List of integers. The chain that was last written and loaded.
+	Outputs:
+		Returns the positions of ASC that read back differently. Reading
+		shifts the chain, so this only checks a chain after scan_load().
+	"""
+	# They come out in the order they went in
+	ser.write(b'ascreadb\n')
+	scan_out = read_packed(ser, b'ASC')[:len(ASC)][::-1]
+	return [ii for ii in range(len(ASC)) if ASC[ii] != scan_out[ii]]
+
 def program_scan(com_port, ASC):
 	"""
 	Inputs:
 		com_port: String. Name of the COM port to connect to.
 		ASC: List of integers. Analog scan chain bits.
 	Outputs:
-		None. Programs the scan chain and prints if scan in matches
-		scan out.
+		None. Programs the scan chain with the packed binary commands and
+		checks the readback.
+	Raises:
+		ValueError if the Teensy rejects the write or the readback differs.
 	"""
 	# Open COM port to teensy to bit-bang scan chain
 	ser = serial.Serial(
@@ -31,39 +110,29 @@ def program_scan(com_port, ASC):
 	    baudrate=19200,
 	    parity=serial.PARITY_NONE,
 	    stopbits=serial.STOPBITS_ONE,
-	    bytesize=serial.EIGHTBITS
+	    bytesize=serial.EIGHTBITS,
+	    timeout=2
 	)
 
 	# ASC configuration
 	time.sleep(0.1)
 
-	# Convert array to string for uart
-	ASC_string = ''.join(map(str,ASC));
+	try:
+		# Send packed bits with a CRC to uC and program into IC
+		for line in scan_write(ser, ASC):
+			print(line)
 
-	# Send string to uC and program into IC
-	ser.write(b'ascwrite\n');
-	print(ser.readline());
-	ser.write((ASC_string[::-1]).encode());
-	print(ser.readline());
+		# Execute the load command to latch values inside chip
+		print(scan_load(ser))
 
-	# Execute the load command to latch values inside chip
-	ser.write(b'ascload\n');
-	print(ser.readline());
+		# Compare what was written to what was read back
+		mismatches = scan_readback(ser, ASC)
+	finally:
+		ser.close()
 
-	# Read back the scan chain contents
-	ser.write(b'ascread\n');
-	x = ser.readline();
-	scan_out = x[::-1];
-	print(ASC_string)
-	print(scan_out.decode())
-
-	# Compare what was written to what was read back
-	if int(ASC_string) == int(scan_out.decode()):
-		ser.close();
-		print('Read matches Write')
-	else:
-		ser.close();
-		raise ValueError('Read/Write Comparison Incorrect')
+	if mismatches:
+		raise ValueError('Read/Write Comparison Incorrect at positions {}'.format(mismatches))
+	print('Read matches Write')
 
 def construct_ASC(radio_en_tx=[0], radio_lo_ftune = [0,0,0,0,0,0],
 					radio_lo_itune = [0,0,0], radio_en_lo = [0],
@@ -132,6 +201,152 @@ def construct_ASC(radio_en_tx=[0], radio_lo_ftune = [0,0,0,0,0,0],
 
 	return ASC
 
+###################################################
+###################################################
+################## Sweep Functions ################
+###################################################
+###################################################
+
+def gray_rank(value):
+	"""Position of value in the binary reflected Gray code sequence."""
+	rank = 0
+	while value:
+		rank ^= value
+		value >>= 1
+	return rank
+
+def gray_order(sizes):
+	"""
+	Inputs:
+		sizes: List of integers. Number of values of each grid axis.
+	Outputs:
+		Returns every index tuple of the grid, the last axis changing
+		fastest and reversing direction each time an outer axis steps, so
+		consecutive tuples differ in one axis by one step.
+	"""
+	if not sizes:
+		return [()]
+	inner = gray_order(sizes[1:])
+	order = []
+	for ii in range(sizes[0]):
+		order += [(ii,) + rest for rest in (inner if ii % 2 == 0 else inner[::-1])]
+	return order
+
+def sweep_points(grid):
+	"""
+	Inputs:
+		grid: Dictionary (or list of pairs) of axis name to list of values,
+			outermost (least often changed) axis first. Axes named after
+			construct_ASC() arguments are scan chain fields and take integers
+			(MSB first) or bit lists; other axes (e.g. an input voltage) are
+			passed to the measurement as they are.
+	Outputs:
+		Returns the grid points as dictionaries in sweep order. Scan field
+		values are visited in Gray code order, so each step flips as few
+		chain bits as possible; other axes keep their given order and
+		reverse direction instead of jumping back.
+	"""
+	axes = []
+	for name, values in (grid.items() if hasattr(grid, 'items') else grid):
+		values = list(values)
+		if name in asc_encoder.FIELDS:
+			values.sort(key=lambda v: gray_rank(v if isinstance(v, int) else int(''.join(map(str, v)), 2)))
+		axes.append((name, values))
+	return [{name: values[ii] for (name, values), ii in zip(axes, index)}
+		for index in gray_order([len(values) for _, values in axes])]
+
+def count_flips(a, b):
+	"""Number of scan chain bits that differ between two chains."""
+	return sum(x != y for x, y in zip(a, b))
+
+def run_sweep(ser, grid, measure, out_path, base=None, pipeline=True, verify=True, invert=False):
+	"""
+	Inputs:
+		ser: Open serial port to the Teensy programming the scan chain.
+		grid: Axes to sweep, see sweep_points().
+		measure: Function called with each point (dictionary of axis
+			values) once its scan chain is loaded. Returns a dictionary of
+			results (or a single value, stored as 'value'). Must not use
+			ser while pipeline is on.
+		out_path: String. CSV file the results are streamed to, one row per
+			point: index, axis values (scan fields as integers), number of
+			chain bits flipped to get there, then the measurement columns.
+		base: Dictionary of construct_ASC() arguments for everything the
+			grid does not sweep.
+		pipeline: Boolean. Shift the next point's chain in while the
+			current one is being measured. The chain outputs only change at
+			the load, but the scan clock does run during the measurement.
+		verify: Boolean. Read back every loaded chain (the readback is part
+			of the pipelined work).
+		invert: Boolean. Invert every chain bit before writing, as
+			program_scan_pga() does.
+	Outputs:
+		Returns the number of points measured. Points whose chain is the
+		same as the previous one are not rewritten.
+	Raises:
+		ValueError if a write is rejected or a chain reads back wrong.
+	"""
+	import csv
+	from concurrent.futures import ThreadPoolExecutor
+
+	base = dict(base or {})
+	points = sweep_points(grid)
+	chains = [asc_encoder.encode(**dict(base, **{k: v for k, v in point.items() if k in asc_encoder.FIELDS}))
+		for point in points]
+	if invert:
+		chains = [[1 - x for x in chain] for chain in chains]
+
+	# What is in the shift register and what is loaded, as indexes into chains
+	state = {'shifted': None, 'loaded': None, 'verified': None}
+
+	def prepare(k):
+		# Check the loaded chain before shifting anything else in, then shift in chain k
+		loaded = state['loaded']
+		if verify and loaded is not None and state['verified'] != loaded and state['shifted'] == loaded:
+			mismatches = scan_readback(ser, chains[loaded])
+			if mismatches:
+				raise ValueError('Point {}: readback incorrect at positions {}'.format(loaded, mismatches))
+			state['verified'] = loaded
+			state['shifted'] = None
+		if k < len(chains) and (loaded is None or chains[k] != chains[loaded]):
+			scan_write(ser, chains[k])
+			state['shifted'] = k
+
+	def value_column(v):
+		return v if isinstance(v, (int, float, str)) else int(''.join(map(str, v)), 2)
+
+	with open(out_path, 'w', newline='') as f, ThreadPoolExecutor(max_workers=1) as pool:
+		writer = None
+		pending = pool.submit(prepare, 0)
+		for k, point in enumerate(points):
+			if pending is not None:
+				pending.result()
+			if state['shifted'] == k:
+				scan_load(ser)
+				state['loaded'] = k
+			pending = pool.submit(prepare, k + 1) if pipeline else None
+
+			flips = count_flips(chains[k - 1], chains[k]) if k else 0
+			result = measure(point)
+			if not isinstance(result, dict):
+				result = {'value': result}
+
+			row = dict(point=k, scan_bits_flipped=flips)
+			row.update({name: value_column(v) for name, v in point.items()})
+			row.update(result)
+			if writer is None:
+				writer = csv.DictWriter(f, ['point'] + list(point) + ['scan_bits_flipped'] + list(result))
+				writer.writeheader()
+			writer.writerow(row)
+			f.flush()
+
+			if not pipeline:
+				prepare(k + 1)
+		if pending is not None:
+			pending.result()
+
+	return len(points)
+
 #################################################
 #################################################
 ################## PGA Testing ################## 
@@ -225,27 +440,34 @@ def test_pga_variance(gain_bits, iterations=500, vin=0.5,
 
 	return vout
 
-def test_pga_gain(gain_bits, com_port="COM10", 
+def test_pga_gain(gains=[[0,0],[0,1],[1,0],[1,1]], com_port="COM10",
 					psu_name='USB0::0x0957::0x2C07::MY57801384::0::INSTR',
-					iterations=10):
+					iterations=10, scan_port=None, out_path="pga_gain.csv",
+					vin_step=5e-3):
 	"""
 	Inputs:
-		gain_bits: The gain setting <1:0>. The mapping is
+		gains: List of gain settings <1:0> to sweep. The mapping is
 			00 = 1
 			01 = 4/3
 			10 = 2
 			11 = 4
-		com_port: String. Name of the COM port to connect to.
+		com_port: String. Name of the COM port of the Teensy reading the
+			test PGA.
 		psu_name: String. Name used by Visa to find the PSU.
-		iterations: Integer. Number of readings to take before stepping
-			the function generator voltage.
+		iterations: Integer. Number of readings to take at each input voltage.
+		scan_port: String. Name of the COM port of the Teensy programming
+			the scan chain, if not the one on com_port. On a shared port the
+			readings are stopped after each point so the chain can be
+			programmed in between, without pipelining.
+		out_path: String. CSV file for the results.
+		vin_step: Float. Input voltage step over 0 to 1 V.
 	Outputs:
-		 Returns the xdata (input voltage) and ydata (PGA output voltage). 
-		 Uses the function generator to sweep the input voltage
-		 of the test PGA. 
+		Returns the number of points measured. Uses the function generator
+		to sweep the input voltage of the test PGA at each gain and streams
+		the input voltage, gain and mean/min/max PGA output readings to
+		out_path (see run_sweep()).
 	"""
-	# Program the scan chain appropriately
-	program_scan_pga(com_port, gain_bits)
+	shared = scan_port is None or scan_port == com_port
 
 	# Open the serial with Teensy and start the PGA and digital clocks
 	ser = serial.Serial(
@@ -253,11 +475,12 @@ def test_pga_gain(gain_bits, com_port="COM10",
 	    baudrate=19200,
 	    parity=serial.PARITY_NONE,
 	    stopbits=serial.STOPBITS_ONE,
-	    bytesize=serial.EIGHTBITS
+	    bytesize=serial.EIGHTBITS,
+	    timeout=2
 	)
 	time.sleep(0.1)
-	ser.write(b'test_pga\n')
-	# print(ser.readline());
+	if not shared:
+		ser.write(b'test_pga\n')
 
 	# Connect to the function generator and set the conditions
 	# for the connection appropriately.
@@ -268,21 +491,40 @@ def test_pga_gain(gain_bits, com_port="COM10",
 	psu.write('SOURCE2:FUNCTION DC')
 	psu.write('OUTPUT2 ON')
 
-	# Step the function generator and read from the Teensy analog read.
-	vin_vec = np.arange(0, 1, 5e-3)
-	vout = dict()
-	for vin in vin_vec:
-		psu.write('SOURCE2:VOLTAGE:OFFSET {}'.format(vin))
-		for i in range(iterations):
-			# TODO: Convert from the analogRead output
-			# to actual analog values. Match analog resolution!
-			vout[vin][i] = ser.readline()
-
-	# Due diligence for closing things out
-	ser.close()
-	psu.close()
-
-	return vin, vout
+	def measure(point):
+		# Step the function generator and read from the Teensy analog read,
+		# dropping readings taken before the new setting
+		psu.write('SOURCE2:VOLTAGE:OFFSET {}'.format(point['vin']))
+		if shared:
+			ser.write(b'test_pga\n')
+		ser.reset_input_buffer()
+		ser.readline()
+		# TODO: Convert from the analogRead output
+		# to actual analog values. Match analog resolution!
+		vout = [float(ser.readline()) for i in range(iterations)]
+		if shared:
+			# Readings still on their way would be taken for scan chain replies
+			ser.write(b'test_pga_stop\n')
+			time.sleep(0.01)
+			ser.reset_input_buffer()
+		return dict(vout_mean=sum(vout) / len(vout), vout_min=min(vout), vout_max=max(vout))
+
+	if shared:
+		scan_ser = ser
+	else:
+		scan_ser = serial.Serial(port=scan_port, baudrate=19200, timeout=2)
+		time.sleep(0.1)
+	try:
+		# Gain is the outer axis, so the chain only changes once per gain
+		grid = [('cam_gain', gains), ('vin', [ii * vin_step for ii in range(int(round(1 / vin_step)))])]
+		return run_sweep(scan_ser, grid, measure, out_path, base=dict(cam_en_pga=[1]), invert=True,
+			pipeline=not shared)
+	finally:
+		# Due diligence for closing things out
+		if not shared:
+			scan_ser.close()
+		ser.close()
+		psu.close()
 
 #################################################
 #################################################
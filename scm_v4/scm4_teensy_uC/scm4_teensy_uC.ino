@@ -33,6 +33,22 @@ const int pin_PA_amp_tune_1 = 2;
 String inputString = "";   
 boolean stringComplete = false; 
 
+// Scan chain length and the buffer for packed transfers (bit k is bit 7-(k%8) of byte k/8, then a crc32)
+#define ASC_BITS          72
+#define ASC_BYTES         ((ASC_BITS + 7) / 8)
+byte scan_packed[ASC_BYTES + 4];
+
+// Scan clock low and high time in ns, set with configscan or found by scantest
+int scan_half_ns = 1000;
+uint32_t scan_half_cycles;
+// Cleared once scantest has run or the timing was configured
+boolean scan_untested = true;
+
+// Half periods tried by scantest, fastest first
+const int scan_test_half_ns[] = {50, 100, 200, 500, 1000, 2000, 5000, 10000};
+#define SCAN_TEST_STEPS   (sizeof(scan_test_half_ns) / sizeof(scan_test_half_ns[0]))
+#define SCAN_TEST_PASSES  3
+
 // Runs once at power-on
 void setup() {
   // Open USB serial port; baud doesn't matter; 12Mbps regardless of setting
@@ -41,6 +57,11 @@ void setup() {
   // Reserve 200 bytes for the inputString:
   inputString.reserve(200);
 
+  // Cycle counter used to time the scan clock
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+  scan_set_clock(scan_half_ns);
+
   // Setup pins for analog scan chain
   pinMode(pin_scan_in, OUTPUT);
   digitalWrite(pin_scan_in, HIGH);
@@ -97,10 +118,30 @@ void loop() {
       asc_read();
     }
 
+    else if (inputString == "ascwriteb\n") {
+      asc_write_packed();
+    }
+
+    else if (inputString == "ascreadb\n") {
+      asc_read_packed();
+    }
+
+    else if (inputString == "configscan\n") {
+      config_scan();
+    }
+
+    else if (inputString == "scantest\n") {
+      scan_test(true);
+    }
+
     else if (inputString == "test_pga\n") {
       test_pga();
     }
 
+    else if (inputString == "test_pga_stop\n") {
+      test_pga_stop();
+    }
+
     // Reset to listen for a new '\n' terminated string over serial
     inputString = "";
     stringComplete = false;
@@ -108,6 +149,9 @@ void loop() {
 }
 
 void asc_write() {
+  if (scan_untested)
+    scan_test(false);
+
   Serial.println("Executing ASC Write");
   int count = 0;
   char scanbits[72];
@@ -173,6 +217,77 @@ void asc_read() {
   return;
 }
 
+// Receives the scan chain packed 8 bits per byte with a crc32 (scan_28.py scan_write_packed)
+// Then bitbangs them out to ASC, bit 0 first
+void asc_write_packed() {
+  unsigned int crc;
+
+  // The chain is about to be overwritten, so this is the time to find its clock rate
+  if (scan_untested)
+    scan_test(false);
+
+  Serial.println("Executing ASC Write");
+  if (Serial.readBytes((char *)scan_packed, ASC_BYTES + 4) != ASC_BYTES + 4) {
+    Serial.println("Error in the ASC Write: timeout");
+    return;
+  }
+  crc = ((unsigned int)scan_packed[ASC_BYTES] << 24) | (scan_packed[ASC_BYTES + 1] << 16) |
+        (scan_packed[ASC_BYTES + 2] << 8) | scan_packed[ASC_BYTES + 3];
+  if (crc32_buf(scan_packed, ASC_BYTES) != crc) {
+    Serial.println("Error in the ASC Write: CRC");
+    return;
+  }
+
+  asc_shift_packed();
+  Serial.println("ASC Write Complete");
+}
+
+// Shifts ASC_BITS bits from scan_packed[] into the chain, bit 0 first
+void asc_shift_packed() {
+  for (int x=0; x<ASC_BITS; x++) {
+    digitalWriteFast(pin_scan_in, (scan_packed[x >> 3] >> (7 - (x & 7))) & 1);
+    // Pulse the clock
+    atick();
+  }
+}
+
+// Reads the scan chain out packed, as "ASC <bytes>", the bytes and their crc32 MSB first
+void asc_read_packed() {
+  unsigned int crc;
+
+  asc_capture();
+  crc = crc32_buf(scan_packed, ASC_BYTES);
+  for (int i=0; i<4; i++)
+    scan_packed[ASC_BYTES + i] = crc >> (24 - 8 * i);
+
+  Serial.print("ASC ");
+  Serial.println(ASC_BYTES);
+  Serial.write(scan_packed, ASC_BYTES + 4);
+}
+
+// Shifts the chain out into scan_packed[], first bit out in bit 7 of byte 0
+void asc_capture() {
+  memset(scan_packed, 0, ASC_BYTES);
+  for (int i=0; i<ASC_BITS; i++) {
+    if (i > 0)
+      atick();
+    if (digitalReadFast(pin_scan_out))
+      scan_packed[i >> 3] |= 0x80 >> (i & 7);
+  }
+}
+
+// Standard CRC-32 (same as zlib.crc32 on the host)
+unsigned int crc32_buf(byte *data, unsigned int length) {
+  unsigned int crc = 0xFFFFFFFF;
+
+  for (unsigned int i=0; i<length; i++) {
+    crc ^= data[i];
+    for (int j=0; j<8; j++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
 void test_pga() {
   /*
   Starts the PGA clock at 50% duty cycle and
@@ -194,6 +309,11 @@ void test_pga() {
   return;
 }
 
+// Stops the readings test_pga() started, so the serial port can take scan chain commands again
+void test_pga_stop() {
+  detachInterrupt(digitalPinToInterrupt(pin_pga_clk));
+}
+
 void _ISR_test_pga_() {
   /*
   Analog reads the test PGA's analog output pin and sends it 
@@ -204,10 +324,96 @@ void _ISR_test_pga_() {
   Serial.println(voltage, DEC);
 }
 
+// One scan clock, low then high for scan_half_ns each
+// Each half is timed from the cycle count read right after its edge, so an interrupt can only lengthen it
 void atick() {
-  digitalWrite(pin_scan_clk, LOW);
-  delayMicroseconds(10);
-  digitalWrite(pin_scan_clk, HIGH);
+  uint32_t t;
+
+  digitalWriteFast(pin_scan_clk, LOW);
+  t = ARM_DWT_CYCCNT;
+  while (ARM_DWT_CYCCNT - t < scan_half_cycles);
+  digitalWriteFast(pin_scan_clk, HIGH);
+  t = ARM_DWT_CYCCNT;
+  while (ARM_DWT_CYCCNT - t < scan_half_cycles);
+}
+
+void scan_set_clock(int half_ns) {
+  scan_half_ns = half_ns;
+  scan_half_cycles = (uint64_t)half_ns * F_CPU / 1000000000;
+}
+
+// Reads the scan clock half period in ns as a '\n' terminated line
+void config_scan() {
+  int half_ns = Serial.readStringUntil('\n').toInt();
+
+  if (half_ns > 0) {
+    scan_set_clock(half_ns);
+    scan_untested = false;
+  }
+}
+
+// Finds the fastest scan clock that loops SCAN_TEST_PASSES patterns through the chain intact, then runs
+// one step slower than that for margin. Keeps the old timing if no rate works.
+// Prints "SCAN <half_ns> PASS/FAIL" per rate tried and "SCAN RATE <half_ns>" or "SCAN TEST FAILED" when
+// verbose. Leaves the pattern in the chain, nothing is loaded.
+void scan_test(boolean verbose) {
+  int old_half_ns = scan_half_ns;
+  unsigned int step;
+  boolean pass = false;
+
+  scan_untested = false;
+  for (step=0; step<SCAN_TEST_STEPS && !pass; step++) {
+    scan_set_clock(scan_test_half_ns[step]);
+    pass = true;
+    for (int n=0; n<SCAN_TEST_PASSES && pass; n++)
+      pass = scan_test_pass(n);
+
+    if (verbose) {
+      Serial.print("SCAN ");
+      Serial.print(scan_half_ns);
+      Serial.println(pass ? " PASS" : " FAIL");
+    }
+  }
+
+  if (!pass) {
+    scan_set_clock(old_half_ns);
+    if (verbose)
+      Serial.println("SCAN TEST FAILED");
+    return;
+  }
+
+  // step is one past the passing rate now
+  if (step >= SCAN_TEST_STEPS)
+    step = SCAN_TEST_STEPS - 1;
+  scan_set_clock(scan_test_half_ns[step]);
+  if (verbose) {
+    Serial.print("SCAN RATE ");
+    Serial.println(scan_half_ns);
+  }
+}
+
+// Bit k of self test pattern n: alternating ones and zeros first (most edges), then hashes of k
+int scan_test_bit(int k, int n) {
+  if (n == 0)
+    return k & 1;
+  return ((((uint32_t)k + 1) * 2654435761u + (uint32_t)n * 0x9E3779B9u) >> 31) & 1;
+}
+
+// Shifts pattern n in at the current clock and checks that it comes back out in the same order
+boolean scan_test_pass(int n) {
+  memset(scan_packed, 0, ASC_BYTES);
+  for (int k=0; k<ASC_BITS; k++) {
+    if (scan_test_bit(k, n))
+      scan_packed[k >> 3] |= 0x80 >> (k & 7);
+  }
+  asc_shift_packed();
+  asc_capture();
+
+  for (int i=0; i<ASC_BITS; i++) {
+    if (((scan_packed[i >> 3] >> (7 - (i & 7))) & 1) != scan_test_bit(i, n))
+      return false;
+  }
+  return true;
 }
 
 void serialEvent() {
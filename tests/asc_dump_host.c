@@ -0,0 +1,59 @@
+// Host build of the ASC bit helpers and asc_dump() in scm_v3c/scm3_hardware_interface.c
+// Build with e.g. cc -O2 -I../scm_v3c asc_dump_host.c ../scm_v3c/scm3_hardware_interface.c ../scm_v3c/crc32.c
+//   asc_dump_host   fills ASC[] from a fixed seed and checks get_asc_bit() against the original reverse() based
+//                   version at every position, then prints "WORDS" and the 38 words followed by the asc_dump() output
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "scm3_hardware_interface.h"
+
+extern unsigned int ASC[38];
+
+// Symbols the rest of scm3_hardware_interface.c needs to link
+char send_packet[127];
+void asc_shift_words(unsigned int* words, unsigned int count) {}
+void radio_loadPacket(unsigned int len) {}
+
+int uart_out(int ch) {
+	putchar(ch);
+	return ch;
+}
+
+// Reference: the original get_asc_bit()
+static unsigned int ref_get_asc_bit(unsigned int position) {
+	unsigned int word_index = position >> 5;
+	unsigned int ASC_word_rev = reverse(ASC[word_index]);
+	return (ASC_word_rev >> (position - (word_index<<5))) & 0x1;
+}
+
+int main(void) {
+	unsigned int i;
+	int errors = 0;
+
+	srand(3);
+	for(i=0; i<38; i++)
+		ASC[i] = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+
+	for(i=0; i<38*32; i++) {
+		if(get_asc_bit(i) != ref_get_asc_bit(i)) {
+			fprintf(stderr, "get_asc_bit(%u) differs\n", i);
+			errors++;
+		}
+		// set/clear and get agree on the layout
+		set_asc_bit(i);
+		if(get_asc_bit(i) != 1) errors++;
+		clear_asc_bit(i);
+		if(get_asc_bit(i) != 0) errors++;
+		if(ref_get_asc_bit(i) != 0) errors++;
+	}
+
+	for(i=0; i<38; i++)
+		ASC[i] = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+	printf("WORDS");
+	for(i=0; i<38; i++)
+		printf(" %08X", ASC[i]);
+	printf("\n");
+	asc_dump();
+
+	return errors != 0;
+}
@@ -0,0 +1,135 @@
+// Host build of scm_v3c/asc_fields.c
+// Build with e.g. cc -O2 -I../scm_v3c asc_fields_host.c ../scm_v3c/asc_fields.c
+//   asc_fields_host        compare every field setter against the per-bit loops it replaced
+//   asc_fields_host dump   print the ASC words after writing each field to 0x5A5A over an all ones/zeros chain
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asc_fields.h"
+
+unsigned int ASC[38];
+
+// From scm3_hardware_interface.c
+unsigned reverse(unsigned x) {
+	x = ((x & 0x55555555) <<  1) | ((x >>  1) & 0x55555555);
+	x = ((x & 0x33333333) <<  2) | ((x >>  2) & 0x33333333);
+	x = ((x & 0x0F0F0F0F) <<  4) | ((x >>  4) & 0x0F0F0F0F);
+	x = (x << 24) | ((x & 0xFF00) << 8) |
+		((x >> 8) & 0xFF00) | (x >> 24);
+	return x;
+}
+
+static void set_asc_bit(unsigned int position) {
+	ASC[position >> 5] |= 0x80000000 >> (position & 31);
+}
+
+static void clear_asc_bit(unsigned int position) {
+	ASC[position >> 5] &= ~(0x80000000 >> (position & 31));
+}
+
+static void put_bit(unsigned int position, unsigned int bit) {
+	if(bit & 0x1) set_asc_bit(position);
+	else clear_asc_bit(position);
+}
+
+// Reference: the per-bit loops of the original scm3C_hardware_interface.c setters, written as
+// (first position, step, first value bit, number of bits, inverted)
+static void ref_bits(unsigned int value, unsigned int first, int step, unsigned int lsb, unsigned int n, unsigned int inv) {
+	unsigned int j;
+	for(j=0; j<n; j++)
+		put_bit(first + step*(int)j, ((value >> (lsb+j)) & 0x1) ^ inv);
+}
+
+static void ref_write(unsigned int field, unsigned int v) {
+	switch(field) {
+		case ASC_FIELD_GPO_ROW1: ref_bits(v, 245, 1, 0, 4, 0); break;
+		case ASC_FIELD_GPO_ROW2: ref_bits(v, 249, 1, 0, 4, 0); break;
+		case ASC_FIELD_GPO_ROW3: ref_bits(v, 253, 1, 0, 4, 0); break;
+		case ASC_FIELD_GPO_ROW4: ref_bits(v, 257, 1, 0, 4, 0); break;
+		case ASC_FIELD_GPI_ROW1: ref_bits(v, 261, 1, 0, 2, 0); break;
+		case ASC_FIELD_GPI_ROW2: ref_bits(v, 263, 1, 0, 2, 0); break;
+		case ASC_FIELD_GPI_ROW3: ref_bits(v, 265, 1, 0, 2, 0); break;
+		case ASC_FIELD_GPI_ROW4: ref_bits(v, 267, 1, 0, 2, 0); break;
+		case ASC_FIELD_ZCC_DEMOD_THRESH: ref_bits(v, 107, 1, 0, 16, 0); break;
+		case ASC_FIELD_ZCC_CLKDIV: ref_bits(v, 124, 1, 0, 8, 0); break;
+		case ASC_FIELD_ZCC_EARLY: ref_bits(v, 209, 1, 0, 16, 0); break;
+		case ASC_FIELD_IF_GAIN_I: ref_bits(v, 485, 1, 0, 6, 0); break;
+		case ASC_FIELD_IF_GAIN_Q: ref_bits(v, 277, -1, 0, 6, 0); break;
+		case ASC_FIELD_IF_COMP_TRIM_I_N: ref_bits(v, 452, 1, 0, 5, 0); break;
+		case ASC_FIELD_IF_COMP_TRIM_I_P: ref_bits(v, 457, 1, 0, 5, 0); break;
+		case ASC_FIELD_IF_COMP_TRIM_Q_N: ref_bits(v, 344, -1, 0, 5, 0); break;
+		case ASC_FIELD_IF_COMP_TRIM_Q_P: ref_bits(v, 339, -1, 0, 5, 0); break;
+		case ASC_FIELD_IF_RC_COARSE: ref_bits(v, 431, -1, 0, 5, 0); break;
+		case ASC_FIELD_IF_RC_FINE: ref_bits(v, 437, -1, 0, 5, 0); break;
+		case ASC_FIELD_IF_RC_HIGH_RANGE: ref_bits(v, 726, 1, 0, 1, 0); break;
+		case ASC_FIELD_IF_LDO: ref_bits(v, 492, 1, 0, 7, 0); break;
+		case ASC_FIELD_VDDD_LDO: ref_bits(v, 797, -1, 0, 5, 0); ref_bits(v, 792, -1, 5, 2, 1); break;
+		case ASC_FIELD_AUX_LDO: ref_bits(v, 917, 1, 0, 5, 0); ref_bits(v, 922, 1, 5, 2, 1); break;
+		case ASC_FIELD_ALWAYSON_LDO: ref_bits(v, 929, -1, 0, 5, 0); ref_bits(v, 924, 1, 5, 1, 1); break;
+		case ASC_FIELD_ALWAYSON_LDO_PANIC: ref_bits(v, 557, 1, 0, 1, 1); break;
+		case ASC_FIELD_SYS_CLK2_COARSE_LO: ref_bits(v, 860, 1, 0, 2, 0); break;
+		case ASC_FIELD_SYS_CLK2_COARSE_HI: ref_bits(v, 875, 1, 0, 3, 1); break;
+		case ASC_FIELD_SYS_CLK2_FINE: ref_bits(v, 870, 1, 0, 4, 0); ref_bits(v, 874, 1, 4, 1, 1); break;
+	}
+}
+
+static void fill(unsigned int* asc) {
+	int i;
+	for(i=0; i<38; i++)
+		asc[i] = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+}
+
+static int check(void) {
+	unsigned int start[38], expected[38];
+	unsigned int field, trial, value;
+	int errors = 0;
+
+	srand(1);
+	for(field=0; field<ASC_NUM_FIELDS; field++) {
+		for(trial=0; trial<2000; trial++) {
+			fill(start);
+			value = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+
+			memcpy(ASC, start, sizeof(ASC));
+			ref_write(field, value);
+			memcpy(expected, ASC, sizeof(ASC));
+
+			memcpy(ASC, start, sizeof(ASC));
+			asc_field_write(field, value);
+			if(memcmp(ASC, expected, sizeof(ASC)) != 0) {
+				printf("field %u: write of 0x%08X differs\n", field, value);
+				errors++;
+				break;
+			}
+			if(asc_field_read(field) != (value & ((1u << asc_fields[field].width) - 1))) {
+				printf("field %u: read back of 0x%08X differs\n", field, value);
+				errors++;
+				break;
+			}
+		}
+	}
+	printf("%d errors\n", errors);
+	return errors != 0;
+}
+
+static void dump(void) {
+	unsigned int field, fill_word, i;
+
+	for(field=0; field<ASC_NUM_FIELDS; field++) {
+		for(fill_word=0; fill_word<2; fill_word++) {
+			memset(ASC, fill_word ? 0xFF : 0x00, sizeof(ASC));
+			asc_field_write(field, 0x5A5A);
+			for(i=0; i<38; i++)
+				printf("%08X%c", ASC[i], i == 37 ? '\n' : ' ');
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	if(argc > 1 && strcmp(argv[1], "dump") == 0) {
+		dump();
+		return 0;
+	}
+	return check();
+}
@@ -0,0 +1,67 @@
+// Host build of analog_scan_chain_write() and analog_scan_chain_invalidate() in scm_v3c/scm3_hardware_interface.c
+// Build with e.g. cc -O2 -I../scm_v3c asc_shadow_host.c ../scm_v3c/scm3_hardware_interface.c ../scm_v3c/crc32.c
+//   asc_shadow_host   shifts into a model of the chip shift register that the Teensy also shifts, and checks
+//                     a skipped write never leaves other bits to be loaded once the chain is invalidated
+
+#include <stdio.h>
+#include <string.h>
+#include "scm3_hardware_interface.h"
+
+extern unsigned int asc_writes_skipped;
+
+static unsigned int chain[38];
+static unsigned int shifts = 0;
+static int errors = 0;
+
+#define CHECK(cond) do { if(!(cond)) { printf("line %d: %s\n", __LINE__, #cond); errors++; } } while(0)
+
+// The asm shift (cm0dsasm.s), as a copy into the model
+void asc_shift_words(unsigned int* words, unsigned int count) {
+	memcpy(chain, words, count * 4);
+	shifts++;
+}
+
+// Symbols the rest of scm3_hardware_interface.c needs to link
+char send_packet[127];
+void radio_loadPacket(unsigned int len) {}
+
+int uart_out(int ch) {
+	putchar(ch);
+	return ch;
+}
+
+int main(void) {
+	unsigned int asc[38];
+	unsigned int i;
+
+	for(i=0; i<38; i++)
+		asc[i] = 0x01010101 * i;
+
+	// The first write after reset always shifts, the same contents again do not
+	analog_scan_chain_write(asc);
+	CHECK(shifts == 1 && memcmp(chain, asc, sizeof(asc)) == 0);
+	analog_scan_chain_write(asc);
+	CHECK(shifts == 1 && asc_writes_skipped == 1);
+
+	// Any changed word shifts, including the last one
+	asc[37] ^= 0x80000000;
+	analog_scan_chain_write(asc);
+	CHECK(shifts == 2 && memcmp(chain, asc, sizeof(asc)) == 0);
+
+	// The Teensy shifts its own pattern (ascwrite, or a destructive ascread or scantest): without
+	// invalidating, the firmware's identical write is skipped and the Teensy's bits would be loaded
+	memset(chain, 0xA5, sizeof(chain));
+	analog_scan_chain_write(asc);
+	CHECK(shifts == 2 && memcmp(chain, asc, sizeof(asc)) != 0);
+
+	// The "inv" command after the external scan makes the same write shift again
+	analog_scan_chain_invalidate();
+	analog_scan_chain_write(asc);
+	CHECK(shifts == 3 && memcmp(chain, asc, sizeof(asc)) == 0);
+	analog_scan_chain_write(asc);
+	CHECK(shifts == 3 && asc_writes_skipped == 3);
+
+	if(errors == 0)
+		printf("OK\n");
+	return errors != 0;
+}
@@ -0,0 +1,48 @@
+"""
+Fixtures for the host C checks. Each builds tests/<name>_host.c with the
+scm_v3c sources it exercises using the host C compiler ($CC, cc or gcc),
+runs it and checks its output. They are skipped if no C compiler is found.
+"""
+
+import os
+import shutil
+import subprocess
+
+import pytest
+
+REPO_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+SCM_DIR = os.path.join(REPO_DIR, 'scm_v3c')
+CC = os.environ.get('CC') or shutil.which('cc') or shutil.which('gcc')
+
+@pytest.fixture
+def host_build(tmp_path):
+	"""
+	Returns build(sources, defines=(), flags=(), includes=()), which compiles
+	sources with -O2, -D for each of defines and then flags, and returns the
+	program's path. scm_v3c and includes are on the include path. Paths in
+	sources and includes are from the top of the repo.
+	"""
+	if CC is None:
+		pytest.skip("no host C compiler")
+
+	def build(sources, defines=(), flags=(), includes=()):
+		exe = str(tmp_path / os.path.splitext(os.path.basename(sources[0]))[0])
+		subprocess.check_call([CC, '-O2', '-I', SCM_DIR] + ['-I' + os.path.join(REPO_DIR, d) for d in includes] +
+			['-D' + d for d in defines] +
+			[os.path.join(REPO_DIR, s) for s in sources] + ['-o', exe] + list(flags))
+		return exe
+	return build
+
+@pytest.fixture
+def build_and_run(host_build):
+	"""
+	Returns run(sources, defines=(), flags=(), includes=(), args=()), which builds as
+	host_build does, runs the program with args and requires it to exit
+	with 0. Returns the subprocess.CompletedProcess, stdout and stderr as bytes.
+	"""
+	def run(sources, defines=(), flags=(), includes=(), args=()):
+		exe = host_build(sources, defines, flags, includes)
+		result = subprocess.run([exe] + [str(a) for a in args], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+		assert result.returncode == 0, (result.stdout + result.stderr).decode('latin-1')
+		return result
+	return run
@@ -0,0 +1,120 @@
+// Host build of scm_v3c/crc32.c for equivalence testing and benchmarking
+// Build with e.g. cc -O2 -DCRC32_TABLE_SIZE=16 -I../scm_v3c crc32_host.c ../scm_v3c/crc32.c
+//   crc32_host [stride]  compare against the original bitwise crc32c over random images,
+//                        every code_length (or every stride-th one), and chunked crc_update() calls
+//   crc32_host bench     time a full 64 kB image against the original
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "crc32.h"
+
+#define IMAGE_SIZE 65536
+
+// Reference: the original SCM implementation
+static unsigned reverse(unsigned x) {
+	x = ((x & 0x55555555) <<  1) | ((x >>  1) & 0x55555555);
+	x = ((x & 0x33333333) <<  2) | ((x >>  2) & 0x33333333);
+	x = ((x & 0x0F0F0F0F) <<  4) | ((x >>  4) & 0x0F0F0F0F);
+	x = (x << 24) | ((x & 0xFF00) << 8) |
+		((x >> 8) & 0xFF00) | (x >> 24);
+	return x;
+}
+
+// One step of the original loop, so every prefix length can be checked in a single pass
+static unsigned int ref_update(unsigned int crc, unsigned char b) {
+	unsigned int byte = reverse(b);
+	int j;
+	for (j = 0; j <= 7; j++) {
+		if ((int)(crc ^ byte) < 0)
+			crc = (crc << 1) ^ 0x04C11DB7;
+		else crc = crc << 1;
+		byte = byte << 1;
+	}
+	return crc;
+}
+
+static unsigned char image[IMAGE_SIZE];
+
+static int check(unsigned int seed, unsigned int stride) {
+	unsigned int crc_ref = 0xFFFFFFFF;
+	unsigned int length;
+	unsigned int i;
+	int errors = 0;
+
+	srand(seed);
+	for (i = 0; i < IMAGE_SIZE; i++) image[i] = (unsigned char)rand();
+
+	// code_length is inserted at 0xFFF8, so the CRC covers at most 0xFFF8 bytes
+	for (length = 0; length <= 0xFFF8; length++) {
+		if ((length % stride == 0 || length == 0xFFF8) && crc32c(image, length) != reverse(~crc_ref)) {
+			printf("seed %u: mismatch at length %u\n", seed, length);
+			if (++errors > 10) return errors;
+		}
+		crc_ref = ref_update(crc_ref, image[length]);
+	}
+
+	// Chunked crc_update() calls must give the same result as one pass
+	for (i = 0; i < 100; i++) {
+		unsigned int crc = crc_init();
+		unsigned int offset = 0;
+		length = (unsigned int)rand() % 0xFFF9;
+		while (offset < length) {
+			unsigned int chunk = 1 + (unsigned int)rand() % 2048;
+			if (chunk > length - offset) chunk = length - offset;
+			crc = crc_update(crc, image + offset, chunk);
+			offset += chunk;
+		}
+		if (crc_final(crc) != crc32c(image, length)) {
+			printf("seed %u: chunked mismatch at length %u\n", seed, length);
+			errors++;
+		}
+	}
+	return errors;
+}
+
+static void bench(void) {
+	unsigned int crc = 0, crc_ref = 0;
+	int runs = 200;
+	int r, i;
+	clock_t start;
+	double secs, secs_ref;
+
+	for (i = 0; i < IMAGE_SIZE; i++) image[i] = (unsigned char)rand();
+
+	start = clock();
+	for (r = 0; r < runs; r++) {
+		unsigned int c = 0xFFFFFFFF;
+		for (i = 0; i < IMAGE_SIZE - 8; i++) c = ref_update(c, image[i]);
+		crc_ref += reverse(~c);
+	}
+	secs_ref = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	for (r = 0; r < runs; r++) crc += crc32c(image, IMAGE_SIZE - 8);
+	secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	printf("original:              %8.1f us per 64 kB image\n", 1e6 * secs_ref / runs);
+	printf("CRC32_TABLE_SIZE=%-3d:  %8.1f us per 64 kB image (%.1fx)%s\n",
+		CRC32_TABLE_SIZE, 1e6 * secs / runs, secs_ref / secs, crc == crc_ref ? "" : " MISMATCH");
+}
+
+int main(int argc, char **argv) {
+	int errors = 0;
+	unsigned int seed;
+	unsigned int stride = 1;
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench();
+		return 0;
+	}
+	if (argc > 1) stride = (unsigned int)atoi(argv[1]);
+	if (stride == 0) stride = 1;
+
+	// First image at every length, the rest sampled to keep the run short
+	errors += check(1, stride);
+	for (seed = 2; seed <= 4; seed++) errors += check(seed, stride * 251);
+	printf("%s\n", errors ? "FAIL" : "OK");
+	return errors != 0;
+}
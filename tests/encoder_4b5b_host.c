@@ -0,0 +1,104 @@
+// Host harness for scm_v3c/teensy_uC_programmer/encoder_4b5b.h
+// Compares the streaming table encoder with the original encode_4b5b() / LUT_4B5B() from the Teensy sketch
+// Usage: encoder_4b5b_host [bench]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "encoder_4b5b.h"
+
+typedef unsigned char byte;
+
+#define IMAGE_BYTES 65536
+
+static byte ram[IMAGE_BYTES];
+static byte reference[IMAGE_BYTES / 4 * 5];
+
+// Original Teensy implementation
+static byte LUT_4B5B(byte in) {
+	if (in == 0) return 0x1E;
+	if (in == 1) return 0x09;
+	if (in == 2) return 0x14;
+	if (in == 3) return 0x15;
+
+	if (in == 4) return 0x0A;
+	if (in == 5) return 0x0B;
+	if (in == 6) return 0x0E;
+	if (in == 7) return 0x0F;
+
+	if (in == 8) return 0x12;
+	if (in == 9) return 0x13;
+	if (in == 10) return 0x16;
+	if (in == 11) return 0x17;
+
+	if (in == 12) return 0x1A;
+	if (in == 13) return 0x1B;
+	if (in == 14) return 0x1C;
+	return 0x1D;
+}
+
+static void ref_encode_4b5b(byte *payload4b5b) {
+	byte converted_nibbles[8];
+	int ii, jj;
+
+	for (ii = 0; ii < IMAGE_BYTES / 4; ii++) {
+		for (jj = 0; jj < 4; jj++) {
+			converted_nibbles[2 * jj + 1] = LUT_4B5B(ram[ii * 4 + jj] >> 4);
+			converted_nibbles[2 * jj] = LUT_4B5B(ram[ii * 4 + jj] & 0xF);
+		}
+		payload4b5b[ii * 5 + 0] = converted_nibbles[0] | converted_nibbles[1] << 5;
+		payload4b5b[ii * 5 + 1] = converted_nibbles[1] >> 3 | converted_nibbles[2] << 2 | converted_nibbles[3] << 7;
+		payload4b5b[ii * 5 + 2] = converted_nibbles[3] >> 1 | converted_nibbles[4] << 4;
+		payload4b5b[ii * 5 + 3] = converted_nibbles[4] >> 4 | converted_nibbles[5] << 1 | converted_nibbles[6] << 6;
+		payload4b5b[ii * 5 + 4] = converted_nibbles[6] >> 2 | converted_nibbles[7] << 3;
+	}
+}
+
+static int check(void) {
+	struct encoder_4b5b enc;
+	int ii;
+
+	ref_encode_4b5b(reference);
+	encoder_4b5b_start(&enc, ram);
+	for (ii = 0; ii < IMAGE_BYTES / 4 * 5; ii++) {
+		byte out = encoder_4b5b_next(&enc);
+		if (out != reference[ii]) {
+			printf("mismatch at %d: %02X != %02X\n", ii, out, reference[ii]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	int ii, round;
+
+	// Every byte value in every position of a group
+	for (ii = 0; ii < IMAGE_BYTES; ii++) ram[ii] = (ii >> 2) + ii;
+	if (check()) return 1;
+
+	srand(1);
+	for (round = 0; round < 20; round++) {
+		for (ii = 0; ii < IMAGE_BYTES; ii++) ram[ii] = rand();
+		if (check()) return 1;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		struct encoder_4b5b enc;
+		unsigned int sum = 0;
+		clock_t t0 = clock();
+		for (round = 0; round < 100; round++) ref_encode_4b5b(reference);
+		clock_t t1 = clock();
+		for (round = 0; round < 100; round++) {
+			encoder_4b5b_start(&enc, ram);
+			for (ii = 0; ii < IMAGE_BYTES / 4 * 5; ii++) sum += encoder_4b5b_next(&enc);
+		}
+		clock_t t2 = clock();
+		printf("original: %.0f us, table: %.0f us per 64kB (%u)\n",
+			(t1 - t0) * 1e6 / CLOCKS_PER_SEC / 100, (t2 - t1) * 1e6 / CLOCKS_PER_SEC / 100, sum + reference[0]);
+	}
+
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,100 @@
+// Host build of scm_v3c/lc_map.c
+// Build with e.g. cc -O2 -I../scm_v3c lc_map_host.c ../scm_v3c/lc_map.c
+//   lc_map_host   compares LC_code_cfg() and LC_dac_cfg() against the register words the original
+//                 LC_monotonic()/LC_FREQCHANGE() wrote, for every LC code and DAC code combination
+
+#include <stdio.h>
+#include <limits.h>
+#include "lc_map.h"
+
+static unsigned int ref_reg7, ref_reg8;
+
+// Reference: the original LC_FREQCHANGE(), storing to ref_reg7/8 instead of ANALOG_CFG_REG__7/8
+static unsigned char flipChar(unsigned char b) {
+	b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+	b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+	b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+	return b;
+}
+
+static void ref_LC_FREQCHANGE(int coarse, int mid, int fine) {
+	char coarse_m = (char)(coarse & 0x1F);
+	char mid_m = (char)(mid & 0x1F);
+	char fine_m = (char)(fine & 0x1F);
+	unsigned int coarse_f = (unsigned int)(flipChar(coarse_m));
+	unsigned int mid_f = (unsigned int)(flipChar(mid_m));
+	unsigned int fine_f = (unsigned int)(flipChar(fine_m));
+	unsigned int fcode = 0x00000000;
+	unsigned int fcode2 = 0x00000000;
+
+	fine_f &= 0x000000FF;
+	mid_f &= 0x000000FF;
+	coarse_f &= 0x000000FF;
+
+	fcode |= (unsigned int)((fine_f & 0x78) << 9);
+	fcode |= (unsigned int)(mid_f << 3);
+	fcode |= (unsigned int)(coarse_f >> 3);
+	fcode2 |= (unsigned int)((fine_f&0x80) >> 7);
+
+	ref_reg7 = fcode;
+	ref_reg8 = fcode2;
+}
+
+// Reference: the original LC_monotonic()
+static void ref_LC_monotonic(int LC_code) {
+	int fine_fix = 0;
+	int mid_fix = 0;
+	int mid_divs = 25;
+	int coarse_divs = 155;
+	int mid;
+	int fine;
+	int coarse = (((LC_code/coarse_divs + 19) & 0x000000FF));
+
+	LC_code = LC_code % coarse_divs;
+	mid = ((((LC_code/mid_divs)*3 + mid_fix) & 0x000000FF));
+	if (LC_code/mid_divs >= 2) {fine_fix = 0;};
+	fine = (((LC_code % mid_divs + fine_fix) & 0x000000FF));
+	if (fine > 15){fine++;};
+
+	ref_LC_FREQCHANGE(coarse,mid,fine);
+}
+
+static int check_code(int code) {
+	unsigned int cfg = LC_code_cfg(code);
+	ref_LC_monotonic(code);
+	if(LC_CFG_REG7(cfg) != ref_reg7 || LC_CFG_REG8(cfg) != ref_reg8) {
+		printf("LC code %d: %04X %X, expected %04X %X\n", code, LC_CFG_REG7(cfg), LC_CFG_REG8(cfg), ref_reg7, ref_reg8);
+		return 1;
+	}
+	return 0;
+}
+
+int main(void) {
+	int code, coarse, mid, fine;
+	unsigned int cfg;
+	int errors = 0;
+
+	// Every code on the reciprocal path, past its end and negative
+	for(code=-100000; code<=100000 && errors<10; code++)
+		errors += check_code(code);
+	errors += check_code(INT_MAX);
+	errors += check_code(INT_MIN);
+
+	// Every DAC code, plus bits above the 5 that are used
+	for(coarse=-32; coarse<64 && errors<10; coarse++) {
+		for(mid=-32; mid<64; mid++) {
+			for(fine=-32; fine<64; fine++) {
+				cfg = LC_dac_cfg(coarse, mid, fine);
+				ref_LC_FREQCHANGE(coarse, mid, fine);
+				if(LC_CFG_REG7(cfg) != ref_reg7 || LC_CFG_REG8(cfg) != ref_reg8) {
+					printf("DACs %d %d %d: %04X %X, expected %04X %X\n", coarse, mid, fine,
+						LC_CFG_REG7(cfg), LC_CFG_REG8(cfg), ref_reg7, ref_reg8);
+					errors++;
+				}
+			}
+		}
+	}
+
+	printf("%d errors\n", errors);
+	return errors != 0;
+}
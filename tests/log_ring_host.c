@@ -0,0 +1,54 @@
+// Host build of scm_v3c/log_ring.c
+// Build with e.g. cc -O2 -I../scm_v3c '-DLOG_TIMESTAMP()=host_time()' log_ring_host.c ../scm_v3c/log_ring.c ../scm_v3c/crc32.c
+//   log_ring_host   logs records of every format, some past a full ring, draining now and then. The UART
+//                   output (LOG frames) goes to stdout and the text printf() would have printed for each
+//                   record that was kept goes to stderr, for log_decode.py to be checked against.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "log_ring.h"
+
+#define LOG_FORMAT(id, format, nargs) format,
+static const char* formats[LOG_NUM_FORMATS] = { LOG_FORMATS };
+#undef LOG_FORMAT
+
+static unsigned int now = 1000;
+
+unsigned int host_time(void) {
+	return now;
+}
+
+// retarget.c
+int uart_out(int ch) {
+	putchar(ch);
+	return ch;
+}
+
+static void event(unsigned int id, int* a) {
+	unsigned int drops = log_drops;
+	
+	now += 37;
+	log_event(id, a[0], a[1], a[2], a[3], a[4], a[5]);
+	if(log_drops == drops)
+		fprintf(stderr, formats[id], a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+int main(void) {
+	int a[LOG_MAX_ARGS];
+	unsigned int n, i, id;
+	
+	srand(7);
+	for(n=0; n<3000; n++) {
+		id = n % LOG_NUM_FORMATS;
+		for(i=0; i<LOG_MAX_ARGS; i++)
+			a[i] = (n & 1) ? rand() - RAND_MAX / 2 : rand() % 100;
+		event(id, a);
+		// Drain often at first, then rarely so the ring fills up
+		if((n < 1000 && n % 7 == 0) || n % 400 == 0)
+			log_drain();
+	}
+	log_drain();
+	fflush(stderr);
+	fprintf(stderr, "DROPS %u\n", log_drops);
+	return 0;
+}
@@ -0,0 +1,186 @@
+"""
+Small Cortex-M0 model for checking and timing the hand-written routines in
+scm_v3c/cm0dsasm.s on the host.
+
+Runs one PROC from the armasm source, covering only the Thumb-1
+instructions those routines use. Cycle counts come from the Cortex-M0 TRM
+instruction timing table. Stores and loads at or above 0x40000000 cost
+extra bus wait states. Every store is logged with the cycle it is issued
+on, so the register sequence a routine produces can be compared with the C
+code it replaces and the time between writes measured.
+
+Usage:
+	cpu = M0Model(asm_source, 'asc_shift_words')
+	cpu.mem.update(...)
+	cycles = cpu.call(r0, r1)
+	cpu.stores  # list of (address, value)
+	cpu.store_cycles  # cycle each of those stores was issued on
+"""
+
+import re
+
+PERIPHERAL_BASE = 0x40000000
+RETURN_ADDRESS = 0xFFFFFFF0
+
+def parse_proc(source, name):
+	"""Returns (instructions, labels, literals) of PROC name."""
+	lines = source.splitlines()
+	start = None
+	for ii, line in enumerate(lines):
+		if re.match(r'^{}\s+PROC\b'.format(re.escape(name)), line):
+			start = ii
+			break
+	if start is None:
+		raise ValueError("PROC {} not found".format(name))
+
+	instructions = []
+	labels = {}
+	for line in lines[start + 1:]:
+		code = line.split(';')[0].rstrip()
+		if not code.strip():
+			continue
+		if not code[0].isspace():
+			labels[code.strip()] = len(instructions)
+			continue
+		parts = code.split(None, 1)
+		op = parts[0].upper()
+		if op == 'ENDP':
+			break
+		if op in ('EXPORT', 'IMPORT', 'LTORG', 'ALIGN'):
+			continue
+		args = [a.strip() for a in re.split(r',(?![^{\[]*[}\]])', parts[1])] if len(parts) > 1 else []
+		instructions.append((op, args))
+	return instructions, labels
+
+def imm(arg):
+	return int(arg.lstrip('#=').strip(), 0)
+
+def reg_list(arg):
+	regs = []
+	for part in arg.strip('{}').split(','):
+		part = part.strip()
+		if '-' in part:
+			lo, hi = part.split('-')
+			regs += ['R{}'.format(r) for r in range(int(lo[1:]), int(hi[1:]) + 1)]
+		else:
+			regs.append(part)
+	return regs
+
+class M0Model:
+	def __init__(self, source, name, wait_states=0):
+		self.instructions, self.labels = parse_proc(source, name)
+		self.wait_states = wait_states
+		self.mem = {}
+		self.stores = []
+		self.store_cycles = []
+
+	def _access_cost(self, address):
+		return 2 + (self.wait_states if address >= PERIPHERAL_BASE else 0)
+
+	def _flags(self, result):
+		result &= 0xFFFFFFFF
+		self.n = result >> 31
+		self.z = int(result == 0)
+		return result
+
+	def call(self, *args, max_cycles=10000000):
+		"""Runs the PROC with args in R0-R3, returns the cycles taken (excluding the call)."""
+		r = {'R{}'.format(ii): 0 for ii in range(13)}
+		for ii, a in enumerate(args):
+			r['R{}'.format(ii)] = a & 0xFFFFFFFF
+		r['SP'] = 0x20010000
+		r['LR'] = RETURN_ADDRESS
+		self.n = self.z = self.c = 0
+		self.stores = []
+		self.store_cycles = []
+		self.regs = r
+
+		pc = 0
+		cycles = 0
+		while cycles < max_cycles:
+			op, a = self.instructions[pc]
+			pc += 1
+
+			if op == 'PUSH':
+				regs = reg_list(a[0])
+				for name in reversed(regs):
+					r['SP'] -= 4
+					self.mem[r['SP']] = r[name]
+				cycles += 1 + len(regs)
+			elif op == 'POP':
+				regs = reg_list(a[0])
+				for name in regs:
+					value = self.mem[r['SP']]
+					r['SP'] += 4
+					if name == 'PC':
+						if value != RETURN_ADDRESS:
+							raise ValueError("POP to unknown return address")
+						return cycles + 4 + len(regs) - 1
+					r[name] = value
+				cycles += 1 + len(regs)
+			elif op == 'BX':
+				return cycles + 3
+			elif op in ('B', 'BNE', 'BEQ', 'BCS', 'BCC'):
+				taken = {'B': True, 'BNE': not self.z, 'BEQ': bool(self.z),
+					'BCS': bool(self.c), 'BCC': not self.c}[op]
+				if taken:
+					pc = self.labels[a[0]]
+					cycles += 3
+				else:
+					cycles += 1
+			elif op in ('LDR', 'STR'):
+				if a[1].startswith('='):
+					r[a[0]] = imm(a[1]) & 0xFFFFFFFF
+					cycles += 2
+					continue
+				m = re.match(r'\[(\w+)(?:\s*,\s*#?(\w+))?\]', a[1])
+				address = (r[m.group(1)] + (int(m.group(2), 0) if m.group(2) else 0)) & 0xFFFFFFFF
+				if op == 'LDR':
+					r[a[0]] = self.mem.get(address, 0)
+				else:
+					self.mem[address] = r[a[0]]
+					self.stores.append((address, r[a[0]]))
+					self.store_cycles.append(cycles)
+				cycles += self._access_cost(address)
+			elif op == 'MOVS':
+				r[a[0]] = self._flags(imm(a[1]) if a[1].startswith('#') else r[a[1]])
+				cycles += 1
+			elif op in ('ADDS', 'SUBS', 'CMP'):
+				if op == 'CMP':
+					dst, x, y = None, r[a[0]], a[1]
+				elif len(a) == 3:
+					dst, x, y = a[0], r[a[1]], a[2]
+				else:
+					dst, x, y = a[0], r[a[0]], a[1]
+				y = imm(y) if y.startswith('#') else r[y]
+				if op == 'ADDS':
+					result = x + y
+					self.c = int(result > 0xFFFFFFFF)
+				else:
+					result = x - y
+					self.c = int(x >= y)
+				result = self._flags(result)
+				if dst:
+					r[dst] = result
+				cycles += 1
+			elif op in ('ANDS', 'EORS', 'ORRS', 'BICS'):
+				x, y = r[a[0]], r[a[1]]
+				r[a[0]] = self._flags({'ANDS': x & y, 'EORS': x ^ y, 'ORRS': x | y, 'BICS': x & ~y}[op])
+				cycles += 1
+			elif op in ('LSLS', 'LSRS'):
+				x = r[a[1]]
+				shift = imm(a[2]) if len(a) == 3 else 0
+				if op == 'LSLS':
+					if shift:
+						self.c = (x >> (32 - shift)) & 1
+					result = x << shift
+				else:
+					if shift:
+						self.c = (x >> (shift - 1)) & 1
+					result = x >> shift
+				r[a[0]] = self._flags(result)
+				cycles += 1
+			else:
+				raise ValueError("Instruction {} not modelled".format(op))
+
+		raise RuntimeError("No return after {} cycles".format(max_cycles))
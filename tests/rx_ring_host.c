@@ -0,0 +1,93 @@
+// Host build of scm_v3c/rx_ring.c
+// Build with e.g. cc -O2 -I../scm_v3c rx_ring_host.c ../scm_v3c/rx_ring.c
+//   rx_ring_host   plays the radio DMA and RF_ISR against a main loop that drains the ring at
+//                  different rates, and checks every packet arrives in order, in place, or is counted as dropped
+
+#include <stdio.h>
+#include <string.h>
+#include "rx_ring.h"
+
+static char* dma_addr;
+static int errors = 0;
+
+#define CHECK(cond) do { if(!(cond)) { printf("line %d: %s\n", __LINE__, #cond); errors++; } } while(0)
+
+// The DMA writes packet n, RF_ISR queues it and moves the DMA on
+static rx_packet* receive(unsigned int n) {
+	rx_packet* rx;
+	unsigned int i;
+	
+	dma_addr[0] = (char)(2 + n % 100);
+	for(i=1; i<=(unsigned int)dma_addr[0]; i++)
+		dma_addr[i] = (char)(n + i);
+	
+	rx = rx_ring_rx_done();
+	CHECK(rx->data == dma_addr);
+	CHECK(rx == rx_ring_last());
+	rx->sfd_timestamp = (signed int)n;
+	dma_addr = rx_ring_dma_addr();
+	return rx;
+}
+
+// Main loop side: checks and releases the oldest packet, returns its number or -1
+static int consume(void) {
+	rx_packet* rx = rx_ring_peek();
+	unsigned int n, i;
+	
+	if(rx == 0)
+		return -1;
+	n = (unsigned int)rx->sfd_timestamp;
+	CHECK(rx->length == 2 + n % 100);
+	for(i=1; i<=rx->length; i++)
+		CHECK(rx->data[i] == (char)(n + i));
+	rx_ring_release();
+	return (int)n;
+}
+
+int main(void) {
+	unsigned int n, i, received, burst;
+	int got, expected;
+	
+	dma_addr = rx_ring_init();
+	CHECK(rx_ring_peek() == 0);
+	
+	// Back to back packets up to the ring size are all kept, each in its own slot
+	for(n=0; n<RX_RING_SLOTS-1; n++)
+		receive(n);
+	for(n=0; n<RX_RING_SLOTS-1; n++)
+		CHECK(consume() == (int)n);
+	CHECK(consume() == -1);
+	
+	// One more than that is dropped and its slot reused, queued packets are untouched
+	for(n=0; n<RX_RING_SLOTS; n++)
+		receive(100 + n);
+	CHECK(rx_ring_drops == 1);
+	for(n=0; n<RX_RING_SLOTS-1; n++)
+		CHECK(consume() == (int)(100 + n));
+	CHECK(consume() == -1);
+	
+	// Bursts against a slower consumer: every packet is either consumed in order or counted as dropped
+	rx_ring_drops = 0;
+	expected = 1000;
+	received = 0;
+	for(burst=0; burst<200; burst++) {
+		for(i=0; i<burst % 5; i++)
+			receive(1000 + received++);
+		for(i=0; i<burst % 3; i++) {
+			got = consume();
+			if(got < 0)
+				break;
+			CHECK(got >= expected);
+			expected = got + 1;
+		}
+	}
+	while((got = consume()) >= 0) {
+		CHECK(got >= expected);
+		expected = got + 1;
+	}
+	printf("%u packets, %u dropped\n", received, rx_ring_drops);
+	CHECK(rx_ring_drops > 0);
+	
+	printf("%d errors\n", errors);
+	return errors != 0;
+}
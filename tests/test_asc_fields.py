@@ -0,0 +1,101 @@
+"""
+Checks the analog scan chain field table in scm_v3c/asc_fields.py against
+construct_scan() in scm_v3c/scan.py and the generated asc_fields.h, and
+runs tests/asc_fields_host.c to compare asc_field_write()/asc_field_read()
+with the per-bit setter loops they replaced. tests/asc_dump_host.c checks
+get_asc_bit() and the asc_dump() format read by asc_fields.read_asc_dump().
+The C checks are skipped if no C compiler is found.
+"""
+
+import inspect
+import io
+import os
+import subprocess
+import sys
+import types
+
+import pytest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM_DIR = os.path.join(HERE, '..', 'scm_v3c')
+sys.path.insert(0, SCM_DIR)
+
+# scan.py only needs pyserial to talk to hardware
+try:
+	import serial
+except ImportError:
+	sys.modules['serial'] = types.ModuleType('serial')
+
+import asc_fields
+import scan
+
+def to_words(bits):
+	"""ASC[] words of a construct_scan() style bit list (position 0 is the MSB of word 0)."""
+	bits = bits + [0] * (38 * 32 - len(bits))
+	return [int(''.join(map(str, bits[32 * ii:32 * ii + 32])), 2) for ii in range(38)]
+
+def test_header_is_generated():
+	with open(asc_fields.HEADER) as f:
+		assert f.read() == asc_fields.generate_header(), "run python scm_v3c/asc_fields.py"
+
+def test_fields_cover_construct_scan_bits():
+	params = inspect.signature(scan.construct_scan).parameters
+	for name, positions, _, arg in asc_fields.ASC_FIELDS:
+		if arg is None:
+			continue
+		width = len(params[arg].default)
+		zeros = scan.construct_scan(**{arg: [0] * width})
+		ones = scan.construct_scan(**{arg: [1] * width})
+		changed = [ii for ii in range(len(zeros)) if zeros[ii] != ones[ii]]
+		assert changed == sorted(positions), name
+
+def test_encode_decode():
+	for name, positions, _, _ in asc_fields.ASC_FIELDS:
+		asc = [0] * 1200
+		value = 0x5A5A & ((1 << len(positions)) - 1)
+		asc_fields.encode_field(asc, name, value)
+		assert asc_fields.decode_field(asc, name) == value
+
+def test_field_writes_match_bit_loops(host_build):
+	exe = host_build(['tests/asc_fields_host.c', 'scm_v3c/asc_fields.c'])
+	result = subprocess.run([exe], stdout=subprocess.PIPE, universal_newlines=True)
+	assert result.returncode == 0, result.stdout
+
+	# The C descriptors place each field where the Python table says
+	dump = subprocess.run([exe, 'dump'], stdout=subprocess.PIPE, universal_newlines=True,
+		check=True).stdout.split('\n')
+	for ii, (name, _, _, _) in enumerate(asc_fields.ASC_FIELDS):
+		for fill in (0, 1):
+			asc = asc_fields.encode_field([fill] * (38 * 32), name, 0x5A5A & 0xFFFF)
+			assert [int(w, 16) for w in dump[2 * ii + fill].split()] == to_words(asc), name
+
+class FakeUart:
+	"""Byte stream standing in for the SCM UART."""
+	def __init__(self, data):
+		self.stream = io.BytesIO(data)
+		self.written = b''
+	def write(self, data):
+		self.written += data
+	def readline(self):
+		return self.stream.readline()
+	def read(self, size):
+		return self.stream.read(size)
+
+def test_get_asc_bit_and_dump(build_and_run):
+	result = build_and_run(['tests/asc_dump_host.c', 'scm_v3c/scm3_hardware_interface.c', 'scm_v3c/crc32.c'],
+		flags=['-w'])
+
+	words_line, dump = result.stdout.split(b'\n', 1)
+	words = [int(w, 16) for w in words_line.split()[1:]]
+	uart = FakeUart(dump)
+	bits = asc_fields.read_asc_dump(uart)
+	assert uart.written == b'asc\n'
+	assert bits == asc_fields.asc_bytes_to_bits(b''.join(w.to_bytes(4, 'big') for w in words))
+	assert to_words(bits) == words
+	assert asc_fields.diff_asc(bits, bits[:7] + [1 - bits[7]] + bits[8:]) == [7]
+
+	# A corrupted byte is caught
+	bad = bytearray(dump)
+	bad[20] ^= 0x10
+	with pytest.raises(ValueError):
+		asc_fields.read_asc_dump(FakeUart(bytes(bad)))
@@ -0,0 +1,21 @@
+"""
+Runs tests/asc_shadow_host.c, which checks that analog_scan_chain_write()
+skips only writes the scan chain already holds, and that
+analog_scan_chain_invalidate() (the "inv" UART command) makes the next one
+shift after the Teensy has shifted the chain. Skipped if no C compiler is
+found.
+"""
+
+import os
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, '..', 'scm_v3c'))
+
+import uart_cmd
+
+def test_inv_command():
+	assert ('inv', 0x1A, 0) in uart_cmd.load_commands()
+
+def test_asc_shadow(build_and_run):
+	build_and_run(['tests/asc_shadow_host.c', 'scm_v3c/scm3_hardware_interface.c', 'scm_v3c/crc32.c'], flags=['-w'])
@@ -0,0 +1,97 @@
+"""
+Runs asc_shift_words from scm_v3c/cm0dsasm.s on the Cortex-M0 model in
+tests/m0_model.py. Its ANALOG_CFG_REG__22 writes must match the original C
+loop of analog_scan_chain_write() bit for bit.
+
+The asm is much faster than the -O0 C loop was, so the clock phases it
+drives are short. test_phase_widths pins them to what cm0dsasm.s documents;
+analog_scan_chain_write() has asc_shift_hold for stretching them.
+
+Run directly to print the cycle counts and phase widths:
+	python tests/test_asc_shift.py
+"""
+
+import os
+import random
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, HERE)
+
+from m0_model import M0Model
+
+ASM = os.path.join(HERE, '..', 'scm_v3c', 'cm0dsasm.s')
+ANALOG_CFG_REG__22 = 0x52580000
+ASC_ADDR = 0x20001000
+
+def reference_writes(asc):
+	"""Register values written by the original C analog_scan_chain_write()."""
+	writes = []
+	for i in range(37, -1, -1):
+		for j in range(32):
+			asc_reg = 0x21 if (asc[i] >> j) & 1 == 0 else 0x20
+			writes.append(asc_reg)
+			asc_reg &= ~0x2
+			writes.append(asc_reg)
+			asc_reg |= 0x4
+			writes.append(asc_reg)
+			asc_reg &= ~0x4
+			writes.append(asc_reg)
+			asc_reg |= 0x2
+			writes.append(asc_reg)
+	return writes
+
+def run(asc, wait_states=0):
+	with open(ASM) as f:
+		cpu = M0Model(f.read(), 'asc_shift_words', wait_states)
+	for ii, word in enumerate(asc):
+		cpu.mem[ASC_ADDR + 4 * ii] = word
+	cycles = cpu.call(ASC_ADDR, len(asc))
+	return cpu, cycles
+
+def test_same_register_writes_as_c_loop():
+	rng = random.Random(0)
+	for asc in ([0] * 38, [0xFFFFFFFF] * 38, [rng.getrandbits(32) for _ in range(38)]):
+		cpu, _ = run(asc)
+		assert all(addr == ANALOG_CFG_REG__22 for addr, _ in cpu.stores)
+		assert [value for _, value in cpu.stores] == reference_writes(asc)
+		# Callee-saved registers are restored
+		assert all(cpu.regs['R{}'.format(ii)] == 0 for ii in range(4, 8))
+
+def test_cycles_per_bit():
+	_, cycles = run([0x12345678] * 38)
+	assert cycles / (38 * 32) < 17.5
+
+def phase_widths(cpu):
+	"""Shortest time in cycles between the writes that start and end each phase."""
+	t = cpu.store_cycles
+	# Per bit: phi1 low, phi1 low, phi2 high, phi2 low, phi1 high
+	return {
+		'phi1 low to phi2 high': min(t[ii + 2] - t[ii] for ii in range(0, len(t), 5)),
+		'phi2 high': min(t[ii + 3] - t[ii + 2] for ii in range(0, len(t), 5)),
+		'phi2 low to phi1 high': min(t[ii + 4] - t[ii + 3] for ii in range(0, len(t), 5)),
+		'phi1 high': min(t[ii + 5] - t[ii + 4] for ii in range(0, len(t) - 5, 5)),
+	}
+
+def test_phase_widths():
+	for wait_states in (0, 2):
+		cpu, _ = run([0x12345678] * 38, wait_states)
+		assert phase_widths(cpu) == {
+			'phi1 low to phi2 high': 5 + 2 * wait_states,
+			'phi2 high': 2 + wait_states,
+			'phi2 low to phi1 high': 3 + wait_states,
+			'phi1 high': 6 + wait_states,
+		}
+
+def test_zero_words():
+	cpu, _ = run([])
+	assert cpu.stores == []
+
+if __name__ == "__main__":
+	asc = [random.getrandbits(32) for _ in range(38)]
+	for wait_states in (0, 1, 2):
+		cpu, cycles = run(asc, wait_states)
+		print("{} bus wait states: {} cycles per write, {:.1f} per bit, {:.2f} ms at 5 MHz HCLK".format(
+			wait_states, cycles, cycles / (38 * 32), cycles / 5e3))
+		for phase, width in phase_widths(cpu).items():
+			print("\t{}: {} cycles, {} ns at 5 MHz HCLK".format(phase, width, width * 200))
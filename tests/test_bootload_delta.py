@@ -0,0 +1,79 @@
+"""
+Host-side checks for delta reprogramming in scm_v3c/bootload.py.
+apply_delta_stream() mirrors what optical_loader.c does with the stream.
+"""
+
+import os
+import random
+import sys
+import types
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM_DIR = os.path.join(HERE, '..', 'scm_v3c')
+sys.path.insert(0, SCM_DIR)
+
+# bootload.py only needs pyserial to talk to hardware
+try:
+	import serial
+except ImportError:
+	sys.modules['serial'] = types.ModuleType('serial')
+
+import bootload
+
+def padded(code):
+	return bytes(code) + bytes(-len(code) % 4)
+
+def check(base, code):
+	stream = bootload.build_delta_stream(base, code)
+	mem = bootload.apply_delta_stream(base, stream)
+	image = padded(code)
+	assert mem[:len(image)] == image
+	assert int.from_bytes(stream[8:12], 'little') == zlib.crc32(image)
+	return stream
+
+def test_delta_tracks_change_size():
+	rng = random.Random(0)
+	code = bytearray(rng.randrange(256) for _ in range(12000))
+	base = bytes(code) + bytes(65536 - len(code))
+
+	# Unchanged image is just the header
+	assert len(check(base, code)) == 16
+
+	# A few scattered edits cost a few runs
+	for i in (10, 11, 4000, 11999):
+		code[i] ^= 0xFF
+	stream = check(base, code)
+	assert len(stream) < 16 + 3 * (8 + 8)
+
+def test_delta_grow_and_shrink():
+	with open(os.path.join(SCM_DIR, 'code_base.bin'), 'rb') as f:
+		old = f.read()
+	with open(os.path.join(SCM_DIR, 'code.bin'), 'rb') as f:
+		new = f.read()
+	base = old + bytes(65536 - len(old))
+	check(base, new)
+	check(base, new[:1001])
+	check(base, old + b'\x12\x34\x56')
+
+def test_fingerprint_ignores_trailer():
+	base = bytearray(65536)
+	fingerprint = bootload.image_fingerprint(base)
+	base[0xFFF8:0xFFFC] = (1234).to_bytes(4, 'little')
+	assert bootload.image_fingerprint(base) == fingerprint
+
+def test_delta_run_limit():
+	# Edits every 64 bytes must be merged down to what the Teensy can hold
+	code = bytearray(20000)
+	base = bytes(65536)
+	for i in range(0, len(code), 64):
+		code[i] = 1
+	stream = check(base, code)
+	assert int.from_bytes(stream[12:16], 'little') <= bootload.DELTA_MAX_RUNS
+
+def test_loader_result():
+	assert bootload.parse_loader_result(b'New image OK (1234 bytes from 567), booting\n') is True
+	assert bootload.parse_loader_result(b'New image CRC failed: 0x1 != 0x2\n') is False
+	assert bootload.parse_loader_result('New image decode failed (1 of 2 bytes)\n') is False
+	assert bootload.parse_loader_result(b'New image not booted: loader copy routine too large\n') is False
+	assert bootload.parse_loader_result(b'Waiting for delta\n') is None
@@ -0,0 +1,56 @@
+"""
+Host-side checks for the stage-2 image compressor in scm_v3c/bootload.py.
+decompress_lzss() mirrors the decoder in scm_v3c/optical_loader.c.
+"""
+
+import os
+import random
+import sys
+import types
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM_DIR = os.path.join(HERE, '..', 'scm_v3c')
+sys.path.insert(0, SCM_DIR)
+
+# bootload.py only needs pyserial to talk to hardware
+try:
+	import serial
+except ImportError:
+	sys.modules['serial'] = types.ModuleType('serial')
+
+import bootload
+
+def roundtrip(data):
+	comp = bootload.compress_lzss(data)
+	assert bootload.decompress_lzss(comp, len(data)) == data
+	return comp
+
+def test_lzss_roundtrip_patterns():
+	rng = random.Random(0)
+	roundtrip(b'')
+	roundtrip(b'\x00')
+	roundtrip(bytes(5000))
+	roundtrip(bytes(rng.randrange(256) for _ in range(3000)))
+	roundtrip(bytes(rng.randrange(3) for _ in range(10000)))
+	# Repeats just inside and just outside the match window
+	chunk = bytes(rng.randrange(256) for _ in range(64))
+	roundtrip(chunk + bytes(bootload.LZ_MAX_OFFSET - 64) + chunk)
+	roundtrip(chunk + bytes(bootload.LZ_MAX_OFFSET) + chunk)
+
+def test_lzss_compresses_firmware():
+	with open(os.path.join(SCM_DIR, 'code.bin'), 'rb') as f:
+		code = f.read()
+	comp = roundtrip(code)
+	assert len(comp) < len(code)
+
+def test_stage2_stream_header():
+	code = bytes(range(10)) * 7
+	stream = bootload.build_stage2_stream(code)
+	words = [int.from_bytes(stream[i:i + 4], 'little') for i in range(0, 16, 4)]
+	image = code + bytes(-len(code) % 4)
+	assert words[0] == bootload.OPTICAL_LOADER_MAGIC
+	assert words[1] == len(image)
+	assert words[3] == zlib.crc32(image)
+	assert len(stream) % 4 == 0
+	assert bootload.decompress_lzss(stream[16:16 + words[2]], words[1]) == image
@@ -0,0 +1,19 @@
+"""
+Host-side checks for the table-driven CRC engine in scm_v3c/crc32.c.
+Compiles tests/crc32_host.c once per table size and requires bit-identical
+results with the original bitwise crc32c(). Skipped if no C compiler is found.
+"""
+
+import zlib
+
+import pytest
+
+@pytest.mark.parametrize('table_size', [256, 16, 0])
+def test_crc32_matches_bitwise(table_size, build_and_run):
+	# The bitwise build is slow, so only sample its lengths
+	build_and_run(['tests/crc32_host.c', 'scm_v3c/crc32.c'], defines=['CRC32_TABLE_SIZE={}'.format(table_size)],
+		args=[1 if table_size else 13])
+
+def test_crc32_is_standard_crc32():
+	# The bootloader tools rely on the SCM CRC being plain CRC-32 (zlib)
+	assert zlib.crc32(b'123456789') == 0xCBF43926
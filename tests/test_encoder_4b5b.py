@@ -0,0 +1,8 @@
+"""
+Host-side check that the streaming 4B5B encoder used by the Teensy programmer
+(scm_v3c/teensy_uC_programmer/encoder_4b5b.h) is byte-identical to the original
+encode_4b5b(). Skipped if no C compiler is found.
+"""
+
+def test_encoder_4b5b_matches_original(build_and_run):
+	build_and_run(['tests/encoder_4b5b_host.c'], includes=['scm_v3c/teensy_uC_programmer'])
@@ -0,0 +1,8 @@
+"""
+Runs tests/lc_map_host.c, which checks that the division-free LO code mapping
+in scm_v3c/lc_map.c writes the same ANALOG_CFG_REG__7/8 words as the original
+LC_monotonic()/LC_FREQCHANGE() for every code. Skipped if no C compiler is found.
+"""
+
+def test_lc_map_matches_lc_monotonic(build_and_run):
+	build_and_run(['tests/lc_map_host.c', 'scm_v3c/lc_map.c'])
@@ -0,0 +1,78 @@
+"""
+Runs tests/log_ring_host.c, which logs through scm_v3c/log_ring.c on the
+host, and checks that scm_v3c/log_decode.py turns the LOG frames back into
+the text the C library prints for the same formats. Skipped if no C compiler
+is found. Also checks that sensor_adc/adc_fsm.py reads ADC values from LOG
+frames.
+"""
+
+import contextlib
+import io
+import os
+import sys
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, '..', 'scm_v3c'))
+
+import log_decode
+from sensor_adc import adc_fsm
+
+def test_formats_match_header():
+	formats = log_decode.load_formats()
+	assert formats[0] == ('LOG_RF_TX_DONE', "IF=%d, LQI=%d, CDR=%d, len=%d, SFD=%d, LC=%d\n", 6)
+	assert [nargs for _, fmt, nargs in formats] == \
+		[len(log_decode.CONVERSION_RE.findall(fmt)) for _, fmt, _ in formats]
+
+def test_bad_frame_skipped():
+	data = bytes([1]) + (1234).to_bytes(4, 'big')
+	stream = io.BytesIO(b'hello\n' + b'LOG 5 0\n' + data + b'\x00\x00\x00\x00' + b'after\n')
+	assert list(log_decode.decode_stream(stream)) == ['hello\n', 'log: bad frame of 5 bytes\n', 'after\n']
+
+def log_frame(records):
+	data = b''.join(records)
+	return 'LOG {} 0\n'.format(len(data)).encode() + data + zlib.crc32(data).to_bytes(4, 'big')
+
+def test_adc_read_uart():
+	formats = [name for name, _, _ in log_decode.load_formats()]
+	adc = bytes([formats.index('LOG_ADC_DATA')]) + (77).to_bytes(4, 'big') + (1234).to_bytes(4, 'big')
+	bad_crc = bytes([formats.index('LOG_RF_BAD_CRC')]) + (78).to_bytes(4, 'big')
+	stream = io.BytesIO(b'Starting on-chip FSM ADC conversion\n' + log_frame([bad_crc, adc]))
+	assert adc_fsm.read_uart(stream) == 1234
+	assert adc_fsm.read_uart(io.BytesIO(b'')) == 2048
+	frame = bytearray(log_frame([adc]))
+	frame[-1] ^= 1
+	assert adc_fsm.read_uart(io.BytesIO(bytes(frame))) == 4096
+
+def test_adc_read_uart_keeps_stream():
+	# One frame holding two conversions, then a frame reporting drops: each call
+	# returns the next value, and the drops are reported once
+	formats = [name for name, _, _ in log_decode.load_formats()]
+	adc = [bytes([formats.index('LOG_ADC_DATA')]) + (77).to_bytes(4, 'big') + value.to_bytes(4, 'big')
+		for value in (1234, 1235, 1236, 1237)]
+	dropped = log_frame([adc[2]]).replace(b'LOG 9 0\n', b'LOG 9 3\n')
+	stream = io.BytesIO(log_frame(adc[:2]) + dropped)
+	printed = io.StringIO()
+	with contextlib.redirect_stdout(printed):
+		assert [adc_fsm.read_uart(stream) for _ in range(4)] == [1234, 1235, 1236, 2048]
+		# Input arriving after a timeout is read by the same generator
+		end = stream.tell()
+		stream.write(log_frame([adc[3]]).replace(b'LOG 9 0\n', b'LOG 9 3\n'))
+		stream.seek(end)
+		assert adc_fsm.read_uart(stream) == 1237
+	assert printed.getvalue() == 'log: 3 records dropped\n'
+
+def test_decoded_log_matches_printf(build_and_run):
+	result = build_and_run(['tests/log_ring_host.c', 'scm_v3c/log_ring.c', 'scm_v3c/crc32.c'],
+		defines=['LOG_TIMESTAMP()=host_time()'], flags=['-w'])
+
+	expected, drops_line = result.stderr.decode().rsplit('DROPS ', 1)
+	lines = list(log_decode.decode_stream(io.BytesIO(result.stdout)))
+	dropped = [line for line in lines if line.startswith('log: ')]
+	assert ''.join(line for line in lines if not line.startswith('log: ')) == expected
+	assert int(drops_line) > 0
+	assert sum(int(line.split()[1]) for line in dropped) == int(drops_line)
+
+	# Timestamps are the RF timer count at each record
+	first = next(log_decode.decode_stream(io.BytesIO(result.stdout), timestamps=True))
+	assert first.startswith('[      1037] IF=')
@@ -0,0 +1,43 @@
+"""
+Host-side checks for the optical link model and p1..p4 tuner in
+scm_v3c/optical_sim. Skipped if no C compiler is found.
+"""
+
+import os
+import subprocess
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+CODE_BIN = os.path.join(HERE, '..', 'scm_v3c', 'code.bin')
+
+def build(host_build):
+	return host_build(['scm_v3c/optical_sim/optical_tune.c', 'scm_v3c/optical_sim/optical_sim.c'], flags=['-lm'])
+
+def run(exe, *args):
+	result = subprocess.run([exe] + [str(a) for a in args] + [CODE_BIN],
+		stdout=subprocess.PIPE, universal_newlines=True)
+	return result.returncode, result.stdout.strip().splitlines()[-1]
+
+def test_default_timing_decodes(host_build):
+	optical_tune = build(host_build)
+	code, line = run(optical_tune, '-c', 80, 80, 2, 80)
+	assert code == 0, line
+
+def test_short_pulses_get_eaten(host_build):
+	optical_tune = build(host_build)
+	# Front end that needs more than the 333 ns minimum pulse of the Teensy engine
+	code, line = run(optical_tune, '-h', 500, '-c', 80, 80, 2, 80)
+	assert code == 1
+	code, line = run(optical_tune, '-h', 500, '-c', 80, 80, 30, 80)
+	assert code == 0, line
+
+def test_tuner_is_faster_and_safe(host_build):
+	optical_tune = build(host_build)
+	code, line = run(optical_tune, '-j', 30)
+	assert code == 0, line
+	p1, p2, p3, p4, ms = line.split()
+	_, default = run(optical_tune, '-j', 30, '-c', 80, 80, 2, 80)
+	assert float(ms) < float(default.split()[4])
+
+	# The 50 ns margin it was tuned with covers extra jitter on every edge
+	code, line = run(optical_tune, '-j', 50, '-m', 0, '-n', 16, '-c', p1, p2, p3, p4)
+	assert code == 0, line
@@ -0,0 +1,82 @@
+"""
+Checks the multi-board orchestrator in scm_v3c/program_rack.py against
+pty-backed fake Teensy/SCM pairs from scm_v3c/fake_teensy.py. Linux only.
+"""
+
+import os
+import sys
+import time
+import types
+
+import pytest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM_DIR = os.path.join(HERE, '..', 'scm_v3c')
+sys.path.insert(0, SCM_DIR)
+
+# bootload.py only needs pyserial to talk to hardware
+try:
+	import serial
+except ImportError:
+	sys.modules['serial'] = types.ModuleType('serial')
+
+pytestmark = pytest.mark.skipif(not hasattr(os, 'openpty'), reason="needs a pty")
+
+CODE_BIN = os.path.join(SCM_DIR, 'code.bin')
+BOOT_TIME = 0.5
+
+def open_port(port):
+	import fake_teensy
+	return fake_teensy.open_port(port, timeout=0.2)
+
+def make_boards(corrupt=()):
+	import fake_teensy
+	boards = []
+	for ii in range(4):
+		scum = fake_teensy.FakeScum(corrupt_bytes=[0x1234] if ii in corrupt else [])
+		boards.append((fake_teensy.FakeTeensy(scum=scum, boot_time=BOOT_TIME), scum))
+	return boards
+
+def close_boards(boards):
+	for teensy, scum in boards:
+		teensy.close()
+		scum.close()
+
+def test_boards_programmed_in_parallel():
+	import program_rack
+	boards = make_boards(corrupt=(2,))
+	try:
+		start = time.time()
+		results = program_rack.program_boards([(t.port, s.port) for t, s in boards],
+			file_binary=CODE_BIN, block_size=1024, open_port=open_port)
+		elapsed = time.time() - start
+
+		with open(CODE_BIN, 'rb') as f:
+			code = f.read()
+		for ii, (r, (teensy, scum)) in enumerate(zip(results, boards)):
+			assert r['error'] is None
+			assert scum.boots == 1
+			assert (scum.image[:len(code)] == code) == (ii != 2)
+			assert teensy.optical_timing == [80, 80, 2, 80]
+		assert [r['crc_ok'] for r in results] == [True, True, False, True]
+		assert results[2]['bad_blocks'] == [0x1234 // 1024]
+
+		# Boots overlap instead of adding up
+		assert elapsed < len(boards) * BOOT_TIME
+	finally:
+		close_boards(boards)
+
+def test_failed_board_does_not_stop_others():
+	import program_rack
+	boards = make_boards()
+	try:
+		ports = [(t.port, s.port) for t, s in boards]
+		ports[1] = ('/dev/does-not-exist', None)
+		results = program_rack.program_boards(ports, file_binary=CODE_BIN,
+			boot_mode='3wb', open_port=open_port)
+
+		assert results[1]['error'] is not None
+		assert [r['crc_ok'] for r in results] == [True, None, True, True]
+		assert boards[1][1].boots == 0
+	finally:
+		close_boards(boards)
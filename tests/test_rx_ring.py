@@ -0,0 +1,8 @@
+"""
+Runs tests/rx_ring_host.c, which checks the RX packet ring in
+scm_v3c/rx_ring.c with simulated back-to-back packets and a slow consumer.
+Skipped if no C compiler is found.
+"""
+
+def test_rx_ring(build_and_run):
+	build_and_run(['tests/rx_ring_host.c', 'scm_v3c/rx_ring.c'])
@@ -0,0 +1,114 @@
+"""
+Checks the encoders generated by scm_v3c/scan_layout.py from the SCM3C and
+SCM v4 layout files against construct_scan() in scm_v3c/scan.py and
+construct_ASC() in scm_v4/scan_28.py. The numpy batch encoder is checked
+only if numpy is installed.
+"""
+
+import importlib.util
+import inspect
+import os
+import random
+import sys
+import tempfile
+import types
+
+import pytest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM_DIR = os.path.join(HERE, '..', 'scm_v3c')
+SCM4_DIR = os.path.join(HERE, '..', 'scm_v4')
+sys.path.insert(0, SCM_DIR)
+
+# The scan scripts only need pyserial and pyvisa to talk to hardware
+for module in ('serial', 'visa'):
+	try:
+		__import__(module)
+	except ImportError:
+		sys.modules[module] = types.ModuleType(module)
+
+import scan
+import scan_layout
+
+def load(path, name):
+	spec = importlib.util.spec_from_file_location(name, path)
+	module = importlib.util.module_from_spec(spec)
+	spec.loader.exec_module(module)
+	return module
+
+def random_arguments(function, rng):
+	kwargs = {}
+	for name, param in inspect.signature(function).parameters.items():
+		if name == 'pre_dyn_sel':
+			kwargs[name] = rng.randrange(6)
+		elif isinstance(param.default, list):
+			kwargs[name] = [rng.getrandbits(1) for _ in param.default]
+		else:
+			kwargs[name] = rng.getrandbits(1)
+	return kwargs
+
+def test_generated_files_are_current():
+	for path in scan_layout.LAYOUTS:
+		for out_path, text in scan_layout.outputs(scan_layout.Layout(path)):
+			with open(out_path) as f:
+				assert f.read() == text, "run python scm_v3c/scan_layout.py"
+
+def test_scm3c_encoder_matches_construct_scan():
+	asc_encoder = load(os.path.join(SCM_DIR, 'asc_encoder.py'), 'asc_encoder')
+	assert asc_encoder.encode() == scan.construct_scan()
+
+	rng = random.Random(1)
+	for _ in range(200):
+		kwargs = random_arguments(scan.construct_scan, rng)
+		expected = scan.construct_scan(**kwargs)
+		assert asc_encoder.encode(**kwargs) == expected
+		assert asc_encoder.encode_bytes(**kwargs) == scan.pack_bits(expected)
+
+	# Integers are MSB first, like the lists
+	assert asc_encoder.encode(lo_fine_tune=0b100101) == scan.construct_scan(lo_fine_tune=[1, 0, 0, 1, 0, 1])
+	# Dividers of 4 and up clear the CortexM0 divider bits
+	assert asc_encoder.encode(div_CortexM0_Nin=4) == scan.construct_scan(div_CortexM0_Nin=[0, 0, 0, 0, 0, 1, 0, 0])
+	with pytest.raises(TypeError):
+		asc_encoder.encode(not_a_field=1)
+
+def test_scm4_encoder_matches_construct_ASC():
+	sys.path.insert(0, SCM4_DIR)
+	try:
+		scan_28 = load(os.path.join(SCM4_DIR, 'scan_28.py'), 'scan_28')
+		asc_encoder = load(os.path.join(SCM4_DIR, 'asc_encoder.py'), 'scm4_asc_encoder')
+	finally:
+		sys.path.remove(SCM4_DIR)
+
+	rng = random.Random(2)
+	for _ in range(200):
+		kwargs = random_arguments(scan_28.construct_ASC, rng)
+		assert asc_encoder.encode(**kwargs) == scan_28.construct_ASC(**kwargs)
+
+def test_layout_errors():
+	text = "chain 16\nreference x\nencoder x.py\na [00] 0..1\nb 0 1\n"
+	with tempfile.NamedTemporaryFile('w', suffix='.txt', delete=False) as f:
+		f.write(text)
+	try:
+		with pytest.raises(ValueError, match="also driven by a"):
+			scan_layout.Layout(f.name)
+	finally:
+		os.remove(f.name)
+
+def test_batch_matches_encode_bytes():
+	np = pytest.importorskip('numpy')
+	asc_encoder = load(os.path.join(SCM_DIR, 'asc_encoder.py'), 'asc_encoder')
+
+	count = 64
+	rng = np.random.RandomState(3)
+	fine = rng.randint(0, 64, count)
+	mid_bits = rng.randint(0, 2, (count, 6))
+	cortex = rng.randint(0, 8, count)
+	pre_dyn_sel = rng.randint(0, 6, count)
+	batch = asc_encoder.encode_batch(count, lo_fine_tune=fine, lo_mid_tune=mid_bits,
+		div_CortexM0_Nin=cortex, pre_dyn_sel=pre_dyn_sel, polyphase_enable=0, IQ_select=[1, 0])
+	assert batch.shape == (count, asc_encoder.CHAIN_BYTES)
+
+	for ii in range(count):
+		expected = asc_encoder.encode_bytes(lo_fine_tune=int(fine[ii]), lo_mid_tune=[int(b) for b in mid_bits[ii]],
+			div_CortexM0_Nin=int(cortex[ii]), pre_dyn_sel=int(pre_dyn_sel[ii]), polyphase_enable=0, IQ_select=[1, 0])
+		assert batch[ii].tobytes() == expected
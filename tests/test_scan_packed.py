@@ -0,0 +1,134 @@
+"""
+Checks the packed binary scan chain protocol and the scan clock commands in
+scm_v3c/scan.py against the pty-backed fake Teensy in scm_v3c/fake_teensy.py.
+Linux only.
+"""
+
+import os
+import random
+import sys
+import types
+
+import pytest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM_DIR = os.path.join(HERE, '..', 'scm_v3c')
+sys.path.insert(0, SCM_DIR)
+
+# scan.py only needs pyserial to talk to hardware
+try:
+	import serial
+except ImportError:
+	sys.modules['serial'] = types.ModuleType('serial')
+
+pytestmark = pytest.mark.skipif(not hasattr(os, 'openpty'), reason="needs a pty")
+
+def connect(**kwargs):
+	import fake_teensy
+	teensy = fake_teensy.FakeTeensy(**kwargs)
+	return teensy, fake_teensy.open_port(teensy.port)
+
+def test_pack_unpack():
+	import scan
+	bits = [random.getrandbits(1) for _ in range(scan.DSC_BITS)]
+	data = scan.pack_bits(bits)
+	assert len(data) == 270
+	assert scan.unpack_bits(data, len(bits)) == bits
+	assert scan.pack_bits([1, 0, 0, 0, 0, 0, 0, 1, 1]) == b'\x81\x80'
+
+def test_program_asc():
+	import scan
+	teensy, ser = connect()
+	try:
+		asc = scan.construct_scan()
+		assert len(asc) == scan.ASC_BITS
+		assert scan.program_asc(ser, asc) == []
+		assert teensy.asc_latched == asc
+		# 150 bytes and a CRC instead of 1200 characters
+		assert teensy.scan_bytes_received == 154
+
+		# Same chain contents through the ASCII commands
+		ser.write(b'ascread\n')
+		assert ser.readline().strip() == ''.join(map(str, asc[::-1])).encode()
+	finally:
+		ser.close()
+		teensy.close()
+
+def test_program_asc_invalidates_firmware_copy():
+	import io
+	import scan
+
+	class FakeUart(io.BytesIO):
+		written = b''
+		def write(self, data):
+			self.written += data
+
+	teensy, ser = connect()
+	uart = FakeUart(b'ASC shadow invalidated\n')
+	try:
+		assert scan.program_asc(ser, scan.construct_scan(), uart_ser=uart) == []
+		assert uart.written == b'inv\n'
+	finally:
+		ser.close()
+		teensy.close()
+
+def test_readback_mismatch_reported():
+	import scan
+	teensy, ser = connect(asc_stuck={100: 1, 971: 0})
+	try:
+		asc = [0] * scan.ASC_BITS
+		asc[971] = 1
+		assert scan.program_asc(ser, asc) == [100, 971]
+	finally:
+		ser.close()
+		teensy.close()
+
+def test_corrupted_write_rejected():
+	import scan
+	teensy, ser = connect(corrupt_scan_writes=1)
+	try:
+		asc = scan.construct_scan()
+		with pytest.raises(ValueError):
+			scan.scan_write_packed(ser, asc)
+		assert teensy.asc == [0] * scan.ASC_BITS
+
+		# The retry goes through
+		scan.scan_write_packed(ser, asc)
+		assert teensy.asc == asc
+	finally:
+		ser.close()
+		teensy.close()
+
+def test_dsc_read():
+	import scan
+	teensy, ser = connect()
+	try:
+		assert scan.scan_read_packed(ser, scan.DSC_BITS, b'dscreadb\n', b'DSC') == teensy.dsc
+	finally:
+		ser.close()
+		teensy.close()
+
+def test_scan_clock():
+	import scan
+	teensy, ser = connect(scan_min_phase_ns=150)
+	try:
+		# Fastest passing rate is 200 ns, one step slower is kept
+		assert scan.scan_selftest(ser) == (500, 125)
+		assert teensy.scan_clock == (500, 125, 1000)
+
+		scan.config_scan_clock(ser, 2000, 400, 500)
+		ser.write(b'dscreadb\n')
+		scan.read_packed(ser, b'DSC')
+		assert teensy.scan_clock == (2000, 400, 500)
+	finally:
+		ser.close()
+		teensy.close()
+
+	teensy, ser = connect(asc_stuck={5: 1})
+	try:
+		with pytest.raises(ValueError):
+			scan.scan_selftest(ser)
+		assert teensy.scan_clock == (1000, 250, 1000)
+	finally:
+		ser.close()
+		teensy.close()
@@ -0,0 +1,160 @@
+"""
+Checks the sweep runner in scm_v4/scan_28.py: Gray code point ordering and
+run_sweep() against an in-process stand-in for the SCM4 Teensy's packed scan
+commands (shift register, load latch, destructive readback).
+"""
+
+import csv
+import importlib.util
+import os
+import sys
+import tempfile
+import types
+import zlib
+
+import pytest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM4_DIR = os.path.join(HERE, '..', 'scm_v4')
+
+# scan_28.py only needs pyserial and pyvisa to talk to hardware
+for module in ('serial', 'visa'):
+	try:
+		__import__(module)
+	except ImportError:
+		sys.modules[module] = types.ModuleType(module)
+
+def load_scan_28():
+	sys.path.insert(0, SCM4_DIR)
+	try:
+		sys.modules.pop('asc_encoder', None)
+		spec = importlib.util.spec_from_file_location('scan_28', os.path.join(SCM4_DIR, 'scan_28.py'))
+		module = importlib.util.module_from_spec(spec)
+		spec.loader.exec_module(module)
+		return module
+	finally:
+		sys.path.remove(SCM4_DIR)
+		sys.modules.pop('asc_encoder', None)
+
+scan_28 = load_scan_28()
+ASC_BITS = len(scan_28.construct_ASC())
+ASC_BYTES = (ASC_BITS + 7) // 8
+
+class FakeScm4Port:
+	"""Serial port answering the SCM4 sketch's ascwriteb/ascload/ascreadb commands."""
+	def __init__(self, stuck=None):
+		self.stuck = stuck or {}
+		self.shift = [0] * ASC_BITS		# shift order, as the Teensy clocks it in
+		self.latched = None
+		self.log = []
+		self.replies = b''
+		self.expect_data = False
+
+	def write(self, data):
+		if self.expect_data:
+			self.expect_data = False
+			payload, crc = data[:ASC_BYTES], int.from_bytes(data[ASC_BYTES:], 'big')
+			if zlib.crc32(payload) != crc:
+				self.replies += b'Error in the ASC Write: CRC\r\n'
+				return
+			self.shift = [(payload[ii >> 3] >> (7 - (ii & 7))) & 1 for ii in range(ASC_BITS)]
+			self.replies += b'ASC Write Complete\r\n'
+		elif data == b'ascwriteb\n':
+			self.log.append('write')
+			self.expect_data = True
+			self.replies += b'Executing ASC Write\r\n'
+		elif data == b'ascload\n':
+			self.log.append('load')
+			self.latched = self.shift[::-1]
+			self.replies += b'Executing ASC Load\r\n'
+		elif data == b'ascreadb\n':
+			self.log.append('read')
+			out = list(self.shift)
+			for position, bit in self.stuck.items():
+				out[ASC_BITS - 1 - position] = bit
+			# Shifting out leaves scan_in's level behind
+			self.shift = [0] * ASC_BITS
+			payload = scan_28.pack_bits(out)
+			self.replies += 'ASC {}\r\n'.format(ASC_BYTES).encode() + payload + \
+				zlib.crc32(payload).to_bytes(4, 'big')
+
+	def readline(self):
+		line, sep, self.replies = self.replies.partition(b'\n')
+		return line + sep
+
+	def read(self, size):
+		data, self.replies = self.replies[:size], self.replies[size:]
+		return data
+
+def read_csv(path):
+	with open(path, newline='') as f:
+		return list(csv.DictReader(f))
+
+def test_gray_order():
+	order = scan_28.gray_order([3, 2, 4])
+	assert len(set(order)) == 24
+	for a, b in zip(order, order[1:]):
+		assert sum(abs(x - y) for x, y in zip(a, b)) == 1
+
+	assert [scan_28.gray_rank(v) for v in range(4)] == [0, 1, 3, 2]
+	points = scan_28.sweep_points([('cam_gain', [0, 1, 2, 3]), ('vin', [0.1, 0.2])])
+	assert [p['cam_gain'] for p in points] == [0, 0, 1, 1, 3, 3, 2, 2]
+	assert [p['vin'] for p in points] == [0.1, 0.2, 0.2, 0.1, 0.1, 0.2, 0.2, 0.1]
+
+@pytest.mark.parametrize('pipeline', [True, False])
+def test_run_sweep(pipeline):
+	port = FakeScm4Port()
+	seen = []
+	def measure(point):
+		# The chain for this point is what the outputs see
+		seen.append(port.latched)
+		return dict(vout=point['vin'] * 2)
+
+	grid = [('cam_gain', [[0, 0], [0, 1], [1, 0], [1, 1]]), ('vin', [0.0, 0.5, 1.0])]
+	base = dict(cam_en_pga=[1])
+	out_dir = tempfile.mkdtemp()
+	try:
+		out_path = os.path.join(out_dir, 'sweep.csv')
+		assert scan_28.run_sweep(port, grid, measure, out_path, base=base, pipeline=pipeline) == 12
+		rows = read_csv(out_path)
+	finally:
+		os.remove(out_path)
+		os.rmdir(out_dir)
+
+	points = scan_28.sweep_points(grid)
+	for point, latched in zip(points, seen):
+		assert latched == scan_28.construct_ASC(**dict(base, cam_gain=point['cam_gain']))
+
+	# One write and load per gain, each load read back before the next write
+	assert port.log == ['write', 'load', 'read'] * 4
+
+	assert list(rows[0]) == ['point', 'cam_gain', 'vin', 'scan_bits_flipped', 'vout']
+	assert [int(r['cam_gain']) for r in rows] == [0, 0, 0, 1, 1, 1, 3, 3, 3, 2, 2, 2]
+	assert [int(r['scan_bits_flipped']) for r in rows] == [0, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0]
+	assert [float(r['vout']) for r in rows] == [2 * p['vin'] for p in points]
+
+def test_run_sweep_inverted():
+	port = FakeScm4Port()
+	seen = []
+	grid = dict(cam_gain=[0, 3])
+	out_dir = tempfile.mkdtemp()
+	try:
+		out_path = os.path.join(out_dir, 'sweep.csv')
+		scan_28.run_sweep(port, grid, lambda point: seen.append(port.latched) or 0, out_path, invert=True)
+	finally:
+		os.remove(out_path)
+		os.rmdir(out_dir)
+	assert seen[1] == [1 - x for x in scan_28.construct_ASC(cam_gain=[1, 1])]
+
+def test_run_sweep_readback_error():
+	port = FakeScm4Port(stuck={20: 0})
+	out_dir = tempfile.mkdtemp()
+	try:
+		out_path = os.path.join(out_dir, 'sweep.csv')
+		with pytest.raises(ValueError, match='20'):
+			scan_28.run_sweep(port, dict(cam_gain=[0, 1]), lambda point: 0, out_path)
+		# The first point was measured before its readback failed
+		assert len(read_csv(out_path)) == 1
+	finally:
+		os.remove(out_path)
+		os.rmdir(out_dir)
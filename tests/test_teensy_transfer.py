@@ -0,0 +1,53 @@
+"""
+Checks the framed host to Teensy transfer (bootload.teensy_transfer) against
+the pty-based Teensy stand-in in scm_v3c/fake_teensy.py. Linux only.
+"""
+
+import os
+import random
+import sys
+import time
+import types
+
+import pytest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM_DIR = os.path.join(HERE, '..', 'scm_v3c')
+sys.path.insert(0, SCM_DIR)
+
+# bootload.py only needs pyserial to talk to hardware
+try:
+	import serial
+except ImportError:
+	sys.modules['serial'] = types.ModuleType('serial')
+
+import bootload
+
+pytestmark = pytest.mark.skipif(not hasattr(os, 'openpty'), reason="needs a pty")
+
+def run_transfer(data, corrupt_frames=()):
+	import fake_teensy
+	teensy = fake_teensy.FakeTeensy(corrupt_frames=corrupt_frames)
+	ser = fake_teensy.open_port(teensy.port, timeout=0.2)
+	try:
+		start = time.time()
+		resent = bootload.teensy_transfer(ser, data)
+		elapsed = time.time() - start
+		return teensy, resent, elapsed
+	finally:
+		ser.close()
+		teensy.close()
+
+def test_transfer_64k():
+	data = bytes(random.Random(0).randrange(256) for _ in range(65536))
+	teensy, resent, elapsed = run_transfer(data)
+	assert teensy.ram[:65536] == data
+	assert resent == 0
+	# Milliseconds on real USB; leave plenty of room for a loaded test machine
+	assert elapsed < 2
+
+def test_transfer_recovers_from_bad_frames():
+	data = bytes(random.Random(1).randrange(256) for _ in range(20000))
+	teensy, resent, _ = run_transfer(data, corrupt_frames=(0, 5, 6, 19))
+	assert teensy.ram[:len(data)] == data
+	assert resent > 0
@@ -0,0 +1,7 @@
+"""
+Runs tests/tx_queue_host.c, which checks the TX frame queue and ack template
+in scm_v3c/tx_queue.c. Skipped if no C compiler is found.
+"""
+
+def test_tx_queue(build_and_run):
+	build_and_run(['tests/tx_queue_host.c', 'scm_v3c/tx_queue.c'])
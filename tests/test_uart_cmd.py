@@ -0,0 +1,107 @@
+"""
+Checks the UART command table in scm_v3c/Int_Handlers.h and runs
+tests/uart_cmd_host.c, which feeds text commands and binary frames from
+scm_v3c/uart_cmd.py through the dispatcher in scm_v3c/uart_cmd.c. The C
+checks are skipped if no C compiler is found.
+"""
+
+import io
+import os
+import re
+import subprocess
+import sys
+
+import pytest
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCM_DIR = os.path.join(HERE, '..', 'scm_v3c')
+sys.path.insert(0, SCM_DIR)
+
+import uart_cmd
+
+# Table of tests/uart_cmd_host.c
+HOST_TABLE = [('add', 1, 2), ('arg', 2, 8), ('cpy', 3, None), ('nop', 4, 0)]
+
+class FakeUart:
+	"""Byte stream standing in for the SCM UART."""
+	def __init__(self, data):
+		self.stream = io.BytesIO(data)
+		self.written = b''
+	def write(self, data):
+		self.written += data
+	def readline(self):
+		return self.stream.readline()
+
+def test_table():
+	table = uart_cmd.load_commands()
+	names = [name for name, _, _ in table]
+	assert names == sorted(names)
+	assert len(set(opcode for _, opcode, _ in table)) == len(table)
+	assert ('zzz', 0x01, 0) in table and ('cpy', 0x02, None) in table and ('atx', 0x11, 2) in table
+	# Every command the old UART_ISR chain knew is still there
+	for name in ['zzz', 'cpy', 'lod', 'snd', 'rcv', 'end', 'rst', 'sta', 'sft', 'ad0', 'ad1', 'ad2',
+			'ad3', 'ad4', 'ad5', 'ad6', 'atx', 'arx', 'rrt', 'xx1', 'xx2', 'blk', 'asc', 'ldr', 'dlt']:
+		assert name in names
+
+def test_run_commands_nak():
+	uart = FakeUart(b'sum 103\nACK 1\nNAK 4\n')
+	with pytest.raises(ValueError, match='nop'):
+		uart_cmd.run_commands(uart, [('add', [1, 2]), ('nop', [])], table=HOST_TABLE)
+	assert uart.written == uart_cmd.encode_frame(1, [1, 2]) + uart_cmd.encode_frame(4)
+
+def test_run_commands_window():
+	# 40 frames of 15 bytes do not fit in the chip's RX ring at once
+	frame = uart_cmd.encode_frame(1, [1, 2])
+	uart = FakeUart(b'sum 103\nACK 1\n' * 40)
+	in_flight = []
+	readline = uart.readline
+	def answered():
+		in_flight.append(len(uart.written) - len(frame) * uart.stream.getvalue()[:uart.stream.tell()].count(b'ACK'))
+		return readline()
+	uart.readline = answered
+	assert uart_cmd.run_commands(uart, [('add', [1, 2])] * 40, table=HOST_TABLE) == [['sum 103\n']] * 40
+	assert uart.written == frame * 40
+	assert max(in_flight) <= uart_cmd.RX_WINDOW
+	with open(os.path.join(SCM_DIR, 'uart_cmd.h')) as f:
+		assert re.search(r'#define UART_RX_BYTES\s+{}\b'.format(uart_cmd.RX_WINDOW + 1), f.read())
+
+def test_run_commands_sft():
+	uart = FakeUart(b'sum 103\nACK 1\n')
+	assert uart_cmd.run_commands(uart, [('add', [1, 2]), ('sft', [])], table=HOST_TABLE) == [['sum 103\n'], []]
+	assert uart.written == uart_cmd.encode_frame(1, [1, 2]) + b'sft\n'
+	with pytest.raises(ValueError, match='last'):
+		uart_cmd.run_commands(FakeUart(b''), [('sft', []), ('add', [1])], table=HOST_TABLE)
+
+def run_host(exe, data):
+	return subprocess.run([exe], input=data, stdout=subprocess.PIPE, check=True).stdout
+
+def test_dispatcher(host_build):
+	exe = host_build(['tests/uart_cmd_host.c', 'scm_v3c/uart_cmd.c', 'scm_v3c/crc32.c'])
+	result = subprocess.run([exe, 'ring'], stdout=subprocess.PIPE, universal_newlines=True)
+	assert result.returncode == 0, result.stdout
+
+	# Text commands, back to back
+	out = run_host(exe, b'add 5\nadd 0x10 7\r\ncpy hello  world\nnop\nfoo\n\nadd x\nnop 1\n'
+		b'arg 1 2 3 4 5 6 7 8 9\n' + b'cpy ' + b'a' * 140 + b'\nnop\n')
+	assert out.decode().split('\n') == ['sum 105', 'sum 23', 'cpy 12 [hello  world]', 'nop',
+		'unknown command', 'bad arguments for add', 'bad arguments for nop', 'bad arguments for arg',
+		'Input exceeds maximum line length', 'nop', '']
+
+	# Binary frames between text lines; a corrupted frame is refused and the next one still runs
+	bad = bytearray(uart_cmd.encode_frame(1, [1, 1]))
+	bad[4] ^= 0x01
+	frames = [uart_cmd.encode_frame(1, [1, 2]), uart_cmd.encode_frame(3, text=b'x\ny\xA5'),
+		bytes(bad), uart_cmd.encode_frame(2, [0xFFFFFFFF] * 8), uart_cmd.encode_frame(4, [1]),
+		uart_cmd.encode_frame(9), uart_cmd.encode_frame(4)]
+	out = run_host(exe, b'nop\n' + b''.join(frames) + b'add 1 1\n')
+	assert out.split(b'\n') == [b'nop', b'sum 3', b'ACK 1', b'cpy 4 [x', b'y\xA5]', b'ACK 3',
+		b'NAK 1', b'arg' + b' 4294967295' * 8, b'ACK 2', b'NAK 4', b'NAK 9', b'nop', b'ACK 4', b'sum 2', b'']
+
+	# run_commands() pairs each command with its output
+	commands = [('add', [3]), ('cpy', b'pkt'), ('arg', [7, 8])]
+	uart = FakeUart(b'')
+	with pytest.raises(ValueError):
+		uart_cmd.run_commands(uart, commands, table=HOST_TABLE)
+	uart = FakeUart(run_host(exe, uart.written))
+	assert uart_cmd.run_commands(uart, commands, table=HOST_TABLE) == \
+		[['sum 103\n'], ['cpy 3 [pkt]\n'], ['arg 7 8\n']]
@@ -0,0 +1,8 @@
+"""
+Runs tests/uart_tx_host.c, which checks the buffered UART transmit FIFO in
+scm_v3c/uart_tx.c against a simulated UART and RF timer. Skipped if no C
+compiler is found.
+"""
+
+def test_uart_tx(build_and_run):
+	build_and_run(['tests/uart_tx_host.c', 'scm_v3c/uart_tx.c'], defines=['UART_TX_HOST'])
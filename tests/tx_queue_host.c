@@ -0,0 +1,94 @@
+// Host build of scm_v3c/tx_queue.c
+// Build with e.g. cc -O2 -I../scm_v3c tx_queue_host.c ../scm_v3c/tx_queue.c
+//   tx_queue_host   fills and drains the TX frame queue the way the main loop and RF_ISR do, and checks
+//                   the ack template staging
+
+#include <stdio.h>
+#include <string.h>
+#include "tx_queue.h"
+
+static int errors = 0;
+
+#define CHECK(cond) do { if(!(cond)) { printf("line %d: %s\n", __LINE__, #cond); errors++; } } while(0)
+
+// Main loop side: builds frame n in place
+static int build(unsigned int n) {
+	char* frame = tx_queue_alloc();
+	unsigned int i;
+	
+	if(frame == 0)
+		return 0;
+	for(i=0; i<n % 50 + 1; i++)
+		frame[i] = (char)(n + i);
+	tx_queue_commit(n % 50 + 1);
+	return 1;
+}
+
+// RF_ISR side: sends the oldest frame, returns its number or -1
+static int send(void) {
+	unsigned int length, i;
+	char* frame = tx_queue_peek(&length);
+	
+	if(frame == 0)
+		return -1;
+	for(i=1; i<length; i++)
+		CHECK(frame[i] == (char)(frame[0] + i));
+	tx_queue_sent();
+	return (unsigned char)frame[0];
+}
+
+int main(void) {
+	unsigned int n, i, length;
+	char* ack;
+	char header[3] = {0x41, 0x00, 0x00};
+	
+	// A burst up to the queue size goes out in order, then the queue is empty
+	for(n=0; n<TX_QUEUE_FRAMES-1; n++)
+		CHECK(build(n));
+	CHECK(tx_queue_count() == TX_QUEUE_FRAMES-1);
+	CHECK(!build(99));
+	for(n=0; n<TX_QUEUE_FRAMES-1; n++)
+		CHECK(send() == (int)n);
+	CHECK(send() == -1);
+	CHECK(tx_queue_count() == 0);
+	
+	// Interleaved, so the indexes wrap
+	for(n=10; n<200; n++) {
+		CHECK(build(n));
+		if(n % 3 == 0)
+			CHECK(build(1000));
+		while(tx_queue_count() > 1)
+			send();
+		CHECK(send() >= 0);
+	}
+	
+	// Oversized frames are cut to what the radio can send
+	build(0);
+	tx_queue_peek(&length);
+	tx_queue_sent();
+	CHECK(tx_queue_alloc() != 0);
+	tx_queue_commit(200);
+	CHECK(tx_queue_peek(&length) != 0 && length == TX_MAX_PAYLOAD);
+	tx_queue_sent();
+	
+	// Default ack: 802.15.4 frame control and the sequence number
+	CHECK(tx_ack_length() == TX_ACK_BYTES);
+	ack = tx_ack_stage(0x5A);
+	CHECK(ack[0] == 0x02 && ack[1] == 0x00 && ack[TX_ACK_SEQ_BYTE] == 0x5A);
+	for(i=TX_ACK_SEQ_BYTE+1; i<TX_ACK_BYTES; i++)
+		CHECK(ack[i] == 0);
+	ack = tx_ack_stage(0x5B);
+	CHECK(ack[TX_ACK_SEQ_BYTE] == 0x5B);
+	
+	// The ack has its own buffer
+	CHECK(build(7));
+	CHECK(ack != tx_queue_peek(&length));
+	
+	tx_ack_set(header, 3);
+	CHECK(tx_ack_length() == 3);
+	ack = tx_ack_stage(0x11);
+	CHECK(ack[0] == 0x41 && ack[TX_ACK_SEQ_BYTE] == 0x11);
+	
+	printf("%d errors\n", errors);
+	return errors != 0;
+}
@@ -0,0 +1,119 @@
+// Host build of scm_v3c/uart_cmd.c
+// Build with e.g. cc -O2 -I../scm_v3c uart_cmd_host.c ../scm_v3c/uart_cmd.c ../scm_v3c/crc32.c
+//   uart_cmd_host         plays UART_ISR with the bytes on stdin and runs uart_cmd_poll() every few bytes
+//                         against the test table below, whose commands print their arguments to stdout
+//   uart_cmd_host ring    checks the RX ring keeps bytes in order and counts the ones it has no room for,
+//                         and that only a "sft" line asks for the soft reset
+
+#include <stdio.h>
+#include <string.h>
+#include "uart_cmd.h"
+
+static void print_args(const char* name, const uart_cmd_args* args) {
+	unsigned int i;
+
+	printf("%s", name);
+	for(i=0; i<args->argc; i++)
+		printf(" %u", args->argv[i]);
+	printf("\n");
+}
+
+void cmd_add(const uart_cmd_args* args) {
+	printf("sum %u\n", uart_cmd_arg(args, 0, 0) + uart_cmd_arg(args, 1, 100));
+}
+
+void cmd_arg(const uart_cmd_args* args) {
+	print_args("arg", args);
+}
+
+void cmd_cpy(const uart_cmd_args* args) {
+	printf("cpy %u [", args->text_len);
+	fwrite(args->text, 1, args->text_len, stdout);
+	printf("]\n");
+}
+
+void cmd_nop(const uart_cmd_args* args) {
+	print_args("nop", args);
+}
+
+const uart_cmd_entry uart_cmds[] = {
+	{ "add", 0x01, 2, cmd_add },
+	{ "arg", 0x02, UART_CMD_MAX_ARGS, cmd_arg },
+	{ "cpy", 0x03, UART_CMD_TEXT, cmd_cpy },
+	{ "nop", 0x04, 0, cmd_nop },
+};
+const unsigned int uart_num_cmds = sizeof(uart_cmds) / sizeof(uart_cmds[0]);
+
+// In uart_cmd.c
+extern unsigned char uart_rx_buffer[UART_RX_BYTES];
+extern volatile unsigned int uart_rx_tail;
+
+// Number of soft resets UART_ISR would do for the len bytes of s
+static unsigned int sft_count_bytes(const char* s, unsigned int len) {
+	unsigned int count = 0;
+
+	for(; len; s++, len--)
+		count += uart_rx_soft_reset((unsigned char)*s);
+	return count;
+}
+
+static unsigned int sft_count(const char* s) {
+	return sft_count_bytes(s, strlen(s));
+}
+
+static int sft_check(void) {
+	int errors = 0;
+
+	if(sft_count("sft\n") != 1 || sft_count("nop\nsft\r\n") != 1 || sft_count("sft\nsft\n") != 2)
+		errors++;
+	if(sft_count("xsft\n") != 0 || sft_count("cpy sft\n") != 0 || sft_count("sft 1\n") != 0 || sft_count("sf\nt\n") != 0)
+		errors++;
+	// Binary cpy frames with "\nsft\n" in the payload, and a CRC ending in "\nsft\n" (not a valid one, only its
+	// bytes matter here); the text line after each frame still counts
+	if(sft_count_bytes("\xA5\x03\x05\nsft\nCRC!sft\n", 16) != 1 || sft_count_bytes("nop\n\xA5\x03\x00\nsft\nsft\n", 16) != 1)
+		errors++;
+	// 0xA5 within a text line is not a frame
+	if(sft_count_bytes("x\xA5\x03\x00\nsft\n", 9) != 1)
+		errors++;
+	if(errors)
+		printf("sft\n");
+	return errors;
+}
+
+static int ring_check(void) {
+	unsigned int i;
+	int errors = 0;
+
+	for(i=0; i<UART_RX_BYTES + 10; i++)
+		uart_rx_put((unsigned char)i);
+	if(uart_rx_drops != 11) {
+		printf("drops %u\n", uart_rx_drops);
+		errors++;
+	}
+	for(i=0; i<UART_RX_BYTES - 1; i++) {
+		if(uart_rx_buffer[uart_rx_tail] != (unsigned char)i) {
+			printf("byte %u\n", i);
+			errors++;
+		}
+		uart_rx_tail = (uart_rx_tail + 1) & (UART_RX_BYTES - 1);
+	}
+	errors += sft_check();
+	if(errors == 0)
+		printf("OK\n");
+	return errors != 0;
+}
+
+int main(int argc, char** argv) {
+	unsigned char chunk[7];
+	size_t n, i;
+
+	if(argc > 1 && strcmp(argv[1], "ring") == 0)
+		return ring_check();
+
+	while((n = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+		for(i=0; i<n; i++)
+			uart_rx_put(chunk[i]);
+		uart_cmd_poll();
+	}
+	return 0;
+}
@@ -0,0 +1,153 @@
+// Host build of scm_v3c/uart_tx.c
+// Build with e.g. cc -O2 -I../scm_v3c -DUART_TX_HOST uart_tx_host.c ../scm_v3c/uart_tx.c
+//   uart_tx_host   plays the UART and the RF timer COMPARE7 interrupt against uart_tx_put() and checks
+//                  the line sees the characters in order, with the full-FIFO policies, flush and a stale compare
+
+#include <stdio.h>
+#include <string.h>
+#include "uart_tx.h"
+
+static char line[4 * UART_TX_FIFO_BYTES];
+static unsigned int line_len = 0;
+static unsigned int tick_ok = 1;
+static unsigned int armed = 0;
+static unsigned int stale = 0;
+static unsigned int locked = 0;
+static int errors = 0;
+
+#define CHECK(cond) do { if(!(cond)) { printf("line %d: %s\n", __LINE__, #cond); errors++; } } while(0)
+
+// Hardware side
+void uart_tx_write(int ch) {
+	CHECK(locked);
+	line[line_len++] = (char)ch;
+}
+
+unsigned int uart_tx_tick_ok(void) {
+	return tick_ok;
+}
+
+void uart_tx_arm(void) {
+	armed = 1;
+}
+
+unsigned int uart_tx_stale(void) {
+	return stale;
+}
+
+void uart_tx_disarm(void) {
+	armed = 0;
+}
+
+unsigned int uart_tx_lock(void) {
+	unsigned int saved = locked;
+
+	locked = 1;
+	return saved;
+}
+
+void uart_tx_unlock(unsigned int saved) {
+	locked = saved;
+}
+
+// COMPARE7 matches until nothing is left, nothing else runs meanwhile
+static void run_ticks(void) {
+	while(armed) {
+		armed = 0;
+		locked = 1;
+		uart_tx_tick();
+		locked = 0;
+	}
+}
+
+static void put_string(const char* s) {
+	for(; *s; s++)
+		CHECK(uart_tx_put(*s) == *s);
+}
+
+int main(void) {
+	char expected[4 * UART_TX_FIFO_BYTES];
+	unsigned int i;
+
+	// The first character goes out at once, the rest one per tick
+	put_string("hello\n");
+	CHECK(line_len == 1 && line[0] == 'h');
+	CHECK(armed);
+	run_ticks();
+	CHECK(line_len == 6 && memcmp(line, "hello\n", 6) == 0);
+
+	// Blocking: a full FIFO sends its oldest character, nothing is lost or reordered
+	line_len = 0;
+	for(i=0; i<3 * UART_TX_FIFO_BYTES; i++)
+		expected[i] = (char)('a' + i % 26);
+	for(i=0; i<3 * UART_TX_FIFO_BYTES; i++)
+		uart_tx_put(expected[i]);
+	CHECK(line_len == 2 * UART_TX_FIFO_BYTES + 1);
+	run_ticks();
+	CHECK(line_len == 3 * UART_TX_FIFO_BYTES && memcmp(line, expected, line_len) == 0);
+	CHECK(uart_tx_drops == 0);
+
+	// Dropping: only what fits is kept, the rest is counted
+	line_len = 0;
+	uart_tx_policy = UART_TX_DROP;
+	for(i=0; i<3 * UART_TX_FIFO_BYTES; i++)
+		uart_tx_put(expected[i]);
+	CHECK(line_len == 1);
+	run_ticks();
+	CHECK(line_len == UART_TX_FIFO_BYTES && memcmp(line, expected, line_len) == 0);
+	CHECK(uart_tx_drops == 2 * UART_TX_FIFO_BYTES);
+	uart_tx_policy = UART_TX_BLOCK;
+
+	// Flush sends everything queued, the pending tick then finds the FIFO empty
+	line_len = 0;
+	put_string("flush me");
+	uart_tx_flush();
+	CHECK(line_len == 8 && memcmp(line, "flush me", 8) == 0);
+	run_ticks();
+	CHECK(line_len == 8);
+
+	// With the RF timer interrupt off, what was queued goes out before the new character
+	line_len = 0;
+	put_string("abc");
+	tick_ok = 0;
+	put_string("de");
+	CHECK(line_len == 5 && memcmp(line, "abcde", 5) == 0);
+	CHECK(!armed);
+	tick_ok = 1;
+	put_string("f");
+	CHECK(line_len == 6 && line[5] == 'f');
+	run_ticks();
+
+	// A compare that will not match is re-armed by the next character, which keeps its place
+	line_len = 0;
+	put_string("abc");
+	armed = 0;
+	stale = 1;
+	put_string("d");
+	CHECK(line_len == 2 && memcmp(line, "ab", 2) == 0);
+	CHECK(armed);
+	stale = 0;
+	run_ticks();
+	CHECK(line_len == 4 && memcmp(line, "abcd", 4) == 0);
+
+	// Same with nothing queued: the character goes out at once
+	line_len = 0;
+	put_string("e");
+	run_ticks();
+	stale = 1;
+	put_string("f");
+	CHECK(line_len == 2 && line[1] == 'f' && armed);
+	stale = 0;
+	run_ticks();
+
+	// Nested in a section that already has interrupts off
+	locked = 1;
+	put_string("xy");
+	uart_tx_flush();
+	CHECK(locked);
+	locked = 0;
+
+	if(errors == 0)
+		printf("OK\n");
+	return errors != 0;
+}